@@ -35,6 +35,8 @@ class BlockTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(reader);
   CPPUNIT_TEST(blocktilwrite);
   CPPUNIT_TEST(blocktilread);
+  CPPUNIT_TEST(sequences);
+  CPPUNIT_TEST(legacypoll);
   CPPUNIT_TEST_SUITE_END();
 
  
@@ -59,6 +61,8 @@ protected:
   void reader();
   void blocktilwrite();
   void blocktilread();
+  void sequences();
+  void legacypoll();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(BlockTest);
@@ -177,3 +181,65 @@ void BlockTest::blocktilread()
   EQ(0, WEXITSTATUS(status));  
 
 }
+// Puts and gets on a notifying ring should advance the futex sequence
+// numbers that the other side sleeps on.
+
+void BlockTest::sequences()
+{
+  CRingBuffer prod(SHM_TESTFILE, CRingBuffer::producer);
+  CRingBuffer cons(SHM_TESTFILE);
+  ASSERT(prod.canNotify());
+  ASSERT(cons.canNotify());
+
+  pRingBuffer pRing = reinterpret_cast<pRingBuffer>(mapRingBuffer(SHM_TESTFILE.c_str()));
+  pRingNotification pNotify = reinterpret_cast<pRingNotification>(
+    reinterpret_cast<char*>(pRing) + pRing->s_header.s_notifyOffset
+  );
+  uint32_t puts = pNotify->s_putSequence;
+  uint32_t gets = pNotify->s_getSequence;
+
+  char buffer[100];
+  memset(buffer, 0, sizeof(buffer));
+  prod.put(buffer, sizeof(buffer));
+  EQ(puts+1, (uint32_t)pNotify->s_putSequence);
+  EQ(gets,   (uint32_t)pNotify->s_getSequence);
+
+  cons.get(buffer, sizeof(buffer), sizeof(buffer));
+  EQ(puts+1, (uint32_t)pNotify->s_putSequence);
+  EQ(gets+1, (uint32_t)pNotify->s_getSequence);
+
+  // Nobody should be left registered as a waiter:
+
+  EQ((uint32_t)0, (uint32_t)pNotify->s_putWaiters);
+  EQ((uint32_t)0, (uint32_t)pNotify->s_getWaiters);
+
+  munmap(pRing, pRing->s_header.s_topOffset+1);
+}
+// Rings that look like they were made before notification blocks existed
+// must still work, by polling.
+
+void BlockTest::legacypoll()
+{
+  pRingBuffer pRing = reinterpret_cast<pRingBuffer>(mapRingBuffer(SHM_TESTFILE.c_str()));
+  memset(pRing->s_header.s_magicString, 0, sizeof(pRing->s_header.s_magicString));
+  strcpy(pRing->s_header.s_magicString, MAGICSTRING);
+  pRing->s_header.s_version      = RING_VERSION_LEGACY;
+  pRing->s_header.s_notifyOffset = 0;
+
+  ASSERT(CRingBuffer::isRing(SHM_TESTFILE));
+  CRingBuffer prod(SHM_TESTFILE, CRingBuffer::producer);
+  CRingBuffer cons(SHM_TESTFILE);
+  ASSERT(!prod.canNotify());
+  ASSERT(!cons.canNotify());
+
+  char buffer[100];
+  size_t nread = cons.get(buffer, sizeof(buffer), 1, 1); // polls then times out.
+  EQ((size_t)0, nread);
+
+  memset(buffer, 1, sizeof(buffer));
+  prod.put(buffer, sizeof(buffer));
+  nread = cons.get(buffer, sizeof(buffer), sizeof(buffer), 1);
+  EQ(sizeof(buffer), nread);
+
+  munmap(pRing, pRing->s_header.s_topOffset+1);
+}
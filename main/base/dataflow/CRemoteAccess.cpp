@@ -73,6 +73,17 @@ data that can be gotten from the remote host, regardless of size.
 */
 unsigned CRingAccess::m_Timeout(2);
 
+/*!
+   If true, proxy rings are fed with the bulk hoisting protocol
+   (ringtostdout --bulk | stdintoring --bulk) rather than the raw stream.
+*/
+bool CRingAccess::m_bulk(false);
+
+/*!
+   If true (and m_bulk), ask the remote end to compress the batches it sends.
+*/
+bool CRingAccess::m_compress(false);
+
 ///////////////////////////////////////////////////////////////////////////////////////
 //  Member functions that manipulate the defaults.
 
@@ -189,6 +200,52 @@ CRingAccess::getTimeout()
 {
   return m_Timeout;
 }
+/*!
+  Select the bulk hoisting protocol for pipelines started in the future.
+  The remote RingMaster must support REMOTEBULK.
+  \param enable - true to use it.
+  \return bool
+  \retval prior value of the parameter.
+*/
+bool
+CRingAccess::setBulkTransfer(bool enable)
+{
+  bool old = m_bulk;
+  m_bulk   = enable;
+  return old;
+}
+/*!
+   \return bool
+   \retval true if new pipelines use the bulk hoisting protocol.
+*/
+bool
+CRingAccess::getBulkTransfer()
+{
+  return m_bulk;
+}
+/*!
+  Ask for compressed batches in bulk pipelines started in the future.
+  This is only worth it if the network is slower than zlib.
+  \param enable - true to compress.
+  \return bool
+  \retval prior value of the parameter.
+*/
+bool
+CRingAccess::setCompression(bool enable)
+{
+  bool old   = m_compress;
+  m_compress = enable;
+  return old;
+}
+/*!
+   \return bool
+   \retval true if bulk pipelines ask for compression.
+*/
+bool
+CRingAccess::getCompression()
+{
+  return m_compress;
+}
 /*!
   This is the flagship entry of the class.  Connects to a ring buffer either local or remote,
   the ring buffer is designated by a URI of the form:
@@ -282,7 +339,11 @@ CRingAccess::startPipeline(string hostName, string remoteRingname, string localR
 
   int socket;
   CRingMaster master(hostName);
-  socket = master.requestData(remoteRingname);
+  if (m_bulk) {
+    socket = master.requestBulkData(remoteRingname);
+  } else {
+    socket = master.requestData(remoteRingname);
+  }
 
   // We have a socket on which data will be sent.
 
@@ -341,11 +402,19 @@ CRingAccess::startFeeder(string proxyName, int socket)
 
   // build up and do the execve:
 
-  char* const argv[10]  = {const_cast<char*>(program.c_str()), 
+  char* argv[10]  = {const_cast<char*>(program.c_str()), 
 			   mindataSw, 
 			   timeoutSw, 
-			   const_cast<char*>(proxyName.c_str()), 
 			 NULL};
+  int argc = 3;
+  if (m_bulk) {
+    argv[argc++] = const_cast<char*>("--bulk");
+    if (m_compress) {
+      argv[argc++] = const_cast<char*>("--compress");
+    }
+  }
+  argv[argc++] = const_cast<char*>(proxyName.c_str());
+  argv[argc]   = NULL;
   char* const env[1]  = {NULL};
 
   execve(program.c_str(), argv, env);
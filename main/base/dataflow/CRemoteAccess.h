@@ -54,6 +54,8 @@ private:
   static size_t   m_proxyMaxConsumers;
   static size_t   m_minData;
   static unsigned m_Timeout;
+  static bool     m_bulk;
+  static bool     m_compress;
   // Public interface:
 public:
   static size_t setProxyRingSize(size_t newSize);
@@ -68,6 +70,12 @@ public:
   static unsigned setTimeout(unsigned newTimeout);
   static unsigned getTimeout();
 
+  static bool setBulkTransfer(bool enable);
+  static bool getBulkTransfer();
+
+  static bool setCompression(bool enable);
+  static bool getCompression();
+
 
   static CRingBuffer* daqConsumeFrom(std::string uri);
   static bool local(std::string host);  
@@ -64,6 +64,43 @@ size_t CRingBuffer::m_defaultMaxConsumers(DEFAULT_MAX_CONSUMERS);
 CRingMaster* CRingBuffer::m_pMaster(NULL);
 pid_t        CRingBuffer::m_myPid(-1); // no pid has this.
 
+//////////////////////////////////////////////////////////////////////////////
+// Layout helpers for the current ring version.  Everything the clients write
+// frequently is put in its own cache line.
+
+static size_t cacheAlign(size_t n)
+{
+  return ((n + RING_CACHELINE - 1)/RING_CACHELINE)*RING_CACHELINE;
+}
+static size_t slotStride()
+{
+  return cacheAlign(sizeof(ClientInformation));
+}
+static size_t firstConsumerOffset()
+{
+  return cacheAlign(sizeof(RingHeader) + sizeof(ClientInformation));
+}
+static size_t notifyOffset(size_t maxConsumer)
+{
+  return firstConsumerOffset() + slotStride()*maxConsumer;
+}
+static size_t clientMapSize(size_t maxConsumer)
+{
+  size_t words = (maxConsumer + 63)/64;
+  return cacheAlign(sizeof(RingClientMap) + (words ? words-1 : 0)*sizeof(uint64_t));
+}
+static size_t pageAlign(size_t n)
+{
+  size_t pageSize = sysconf(_SC_PAGESIZE);
+  return ((n + pageSize - 1)/pageSize)*pageSize;
+}
+static bool mirroredLayout(RingHeader& header)
+{
+  return (strcmp(header.s_magicString, VERSIONEDMAGICSTRING) == 0) &&
+    (header.s_version >= RING_VERSION_NOTIFY)                     &&
+    ((header.s_flags & RING_FLAG_MIRRORED) != 0);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 // 
@@ -117,6 +154,9 @@ public:
                       then destroyed to register this ring.  This is done when
                       the client does not want the ring master fd to be
                       inherited by child processes that may be created.
+  \param mirrored   - If true, the data segment is page aligned and each
+                      client maps it twice, back to back, so that data never
+                      has to be copied in pieces at the top of the ring.
 
   \throw CErrnoException
 
@@ -125,7 +165,8 @@ void
 CRingBuffer::create(std::string name, 
 		     size_t dataBytes,
 		     size_t maxConsumer,
-		     bool   tempMasterConnection)
+		     bool   tempMasterConnection,
+		     bool   mirrored)
 {
 
     // Figure out the entire size of the shared memory region and truncate the file to that
@@ -133,7 +174,11 @@ CRingBuffer::create(std::string name,
     size_t headerSize = sizeof(RingHeader) +
       sizeof(ClientInformation)*(maxConsumer+1);
 
-    size_t rawSize   = dataBytes + headerSize;
+    size_t frontSize = layoutSize(maxConsumer);
+    if (mirrored) {
+      frontSize = pageAlign(frontSize);
+    }
+    size_t rawSize   = dataBytes + frontSize;
 
     long   pageSize  = sysconf(_SC_PAGESIZE);
     size_t pages     = (rawSize + (pageSize-1))/pageSize;
@@ -164,7 +209,7 @@ CRingBuffer::create(std::string name,
                                   0, headerSize); 
     if (created) {
 
-        unsynchedFormat(name, maxConsumer);
+        unsynchedFormat(name, maxConsumer, mirrored);
 
     }  else if (isRing(name)) {
         // If the memory region exists - and is a ring
@@ -227,6 +272,7 @@ CRingBuffer::create(std::string name,
  * @param maxConsumers - Maximum number of consumers.
  * @param tempMasterConnection - If true a temporary connection to the ring master is formed
  *                        then destroyed for the ring registration.
+ * @param mirrored      - If true the ring is created with a mirrored data segment.
  *
  * @note The parameters other than name are only used when the ring needs to be created.
  *
@@ -236,10 +282,10 @@ CRingBuffer::create(std::string name,
  */
 CRingBuffer*
 CRingBuffer::createAndProduce(std::string name, size_t dataBytes, size_t maxConsumer,
-			      bool   tempMasterConnection)
+			      bool   tempMasterConnection, bool mirrored)
 {
   if (!isRing(name)) {
-    create(name, dataBytes, maxConsumer, tempMasterConnection);
+    create(name, dataBytes, maxConsumer, tempMasterConnection, mirrored);
   }
   return new CRingBuffer(name, producer);
 
@@ -315,11 +361,13 @@ CRingBuffer::remove(string name)
 
    \param name         - Name of the ring buffer. (a / will be prepended).
    \param maxConsumers - Maximum number of supported consumers.
+   \param mirrored     - Lay the ring out for a mirrored data segment.
 
    \throw CErrnoException
 
 */
-void CRingBuffer::unsynchedFormat(std::string name, size_t maxConsumer)
+void CRingBuffer::unsynchedFormat(std::string name, size_t maxConsumer,
+                                  bool mirrored)
 {
     string fullName = shmName(name);
     size_t memSize = CDAQShm::size(fullName);
@@ -333,11 +381,12 @@ void CRingBuffer::unsynchedFormat(std::string name, size_t maxConsumer)
 
     pRingHeader        pHeader   = reinterpret_cast<pRingHeader>(pRing);
     pClientInformation pProducer = reinterpret_cast<pClientInformation>(pHeader + 1);
-    pClientInformation pClients  = pProducer + 1;
+    char*              pClients  = reinterpret_cast<char*>(pHeader) + firstConsumerOffset();
 
     // Fill in the header:
 
-    strcpy(pHeader->s_magicString, MAGICSTRING);
+    memset(pHeader->s_magicString, 0, sizeof(pHeader->s_magicString));
+    strcpy(pHeader->s_magicString, VERSIONEDMAGICSTRING);
 
     pHeader->s_maxConsumer       = maxConsumer;
     pHeader->s_producerInfo      = (reinterpret_cast<char*>(pProducer) -
@@ -345,19 +394,34 @@ void CRingBuffer::unsynchedFormat(std::string name, size_t maxConsumer)
     pHeader->s_firstConsumer     = (reinterpret_cast<char*>(pClients) -
                     reinterpret_cast<char*>(pHeader));
     pHeader->s_topOffset         = memSize-1;
-    pHeader->s_dataOffset        = sizeof(RingHeader) +
-                                   sizeof(ClientInformation)*(maxConsumer+1);
+    pHeader->s_dataOffset        = mirrored ? pageAlign(layoutSize(maxConsumer)) :
+                                              layoutSize(maxConsumer);
     pHeader->s_dataBytes         = memSize - pHeader->s_dataOffset;
 
+    // The notification block and client map sit between the consumers and
+    // the data:
+
+    pHeader->s_notifyOffset      = notifyOffset(maxConsumer);
+    pRingNotification pNotify    = reinterpret_cast<pRingNotification>(
+        reinterpret_cast<char*>(pHeader) + pHeader->s_notifyOffset
+    );
+    memset(pNotify, 0, sizeof(RingNotification));
+    pRingClientMap    pMap       = reinterpret_cast<pRingClientMap>(pNotify + 1);
+    memset(pMap, 0, clientMapSize(maxConsumer));
+    pMap->s_slotStride           = slotStride();
+    pHeader->s_version           = RING_VERSION_CURRENT;
+    pHeader->s_flags             = mirrored ? RING_FLAG_MIRRORED : 0;
+
     // Fill in the client information data structures:
 
     pProducer->s_offset          = pHeader->s_dataOffset;
     pProducer->s_pid             = -1;
 
     for (int i=0; i < maxConsumer; i++) {
-      pClients->s_offset         = pHeader->s_dataOffset;
-      pClients->s_pid            = -1;
-      pClients++;
+      pClientInformation pClient = reinterpret_cast<pClientInformation>(pClients);
+      pClient->s_offset          = pHeader->s_dataOffset;
+      pClient->s_pid             = -1;
+      pClients                  += pMap->s_slotStride;
     }
     CDAQShm::detach(pRing, fullName, memSize);
 }
@@ -374,13 +438,14 @@ void CRingBuffer::unsynchedFormat(std::string name, size_t maxConsumer)
 
    \param name         - Name of the ring buffer. (a / will be prepended).
    \param maxConsumers - Maximum number of supported consumers.
+   \param mirrored     - Lay the ring out for a mirrored data segment.
 
    \throw CErrnoException
 
 */
 void
 CRingBuffer::format(std::string name,
-		    size_t maxConsumer)
+		    size_t maxConsumer, bool mirrored)
 {
   // lock
     size_t headerSize = sizeof(RingHeader) +
@@ -393,7 +458,7 @@ CRingBuffer::format(std::string name,
 
     // need the memory size for initialization.
 
-    unsynchedFormat(name, maxConsumer);
+    unsynchedFormat(name, maxConsumer, mirrored);
 
 }
 /*!
@@ -553,6 +618,13 @@ void CRingBuffer::attach() {
 CRingBuffer::CRingBuffer(string name, CRingBuffer::ClientMode mode) :
   m_pRing(0),
   m_pClientInfo(0),
+  m_pNotify(0),
+  m_pClientMap(0),
+  m_slotStride(sizeof(ClientInformation)),
+  m_putSpaceCache(0),
+  m_pReserved(0),
+  m_nReserved(0),
+  m_mirrored(false),
   m_mode(mode),
   m_pollInterval(DEFAULT_POLLMS),
   m_ringName(name)
@@ -562,10 +634,11 @@ CRingBuffer::CRingBuffer(string name, CRingBuffer::ClientMode mode) :
       errno = ENOENT;
       throw CErrnoException("CRingBuffer::CRingBuffer - not a ring");
     }
-    m_pRing = mapRingBuffer(shmName(name));
+    m_pRing = mapRingBuffer(shmName(name), m_mirrored);
     if (m_pRing == nullptr) {
       throw std::string("CRingBuffer::CRingBuffer - failed to map shared memory region.");
     }
+    locateLayout();
 
     if (m_mode == manager) return;
 
@@ -623,7 +696,18 @@ CRingBuffer::~CRingBuffer()
                                   0, headerSize); 
 
     string ringname = m_ringName;
+
+    // Leave the live map before giving up the slot; once s_pid is -1 a new
+    // consumer can claim the slot and we'd clear its live bit.
+
+    if (m_mode == consumer) {
+      setLive(getSlot(), false);
+      __sync_synchronize();
+    }
     m_pClientInfo->s_pid = -1;
+    if (m_mode == consumer) {
+      notifyGet();		// Our departure may free space for the producer.
+    }
     // Let the ringmaster know we're disconnecting.
     // the client pointer is still valid as is the map so the notification
     // can still find the 'slot number.
@@ -644,6 +728,8 @@ CRingBuffer::~CRingBuffer()
 
   m_pRing       = 0;	      
   m_pClientInfo = 0;
+  m_pNotify     = 0;
+  m_pClientMap  = 0;
 
 }
 /////////////////////////////////////////////////////////////////////////
@@ -688,51 +774,108 @@ CRingBuffer::put(const void* pBuffer, size_t nBytes, unsigned long timeout)
 		      "CRingBuffer::put");
 
   }
-  // Block until we have space. 
-
-  CRingFreeSpacePredicate condition(nBytes);
-  int status = blockWhile(condition, timeout);
-  if (status) {
-    return 0;			// timed out.
+  // Block until we have space.  Free space can only shrink when we put, so
+  // m_putSpaceCache (maintained by Skip) is a safe lower bound and we only
+  // need to look at the consumers when it's not big enough.
+
+  if (nBytes > m_putSpaceCache) {
+    CRingFreeSpacePredicate condition(nBytes);
+    int status = blockWhile(condition, timeout);
+    if (status) {
+      return 0;			// timed out.
+    }
   }
-  // Now we need to figure out how to put the data in the ring.
-  // We may need to wrap the data across the top of the buffer.
-  //
-
-  off_t ringBase = m_pRing->s_header.s_dataOffset;
-  off_t ringTop  = m_pRing->s_header.s_topOffset;
-  char* pDataBase= reinterpret_cast<char*>(m_pRing) + ringBase;
-  char* pPut     = reinterpret_cast<char*>(m_pRing) + m_pClientInfo->s_offset;
+  copyToRing(pBuffer, nBytes);
+  Skip(nBytes);
 
-  if ((m_pClientInfo->s_offset + nBytes) <=  (ringTop+1)) {
+  // If we got this far success... issue a memory barrier to ensure this all is
+  // written to the shm:
 
-    // Can move all at once...
+  __sync_synchronize();
 
-    memcpy(pPut, pBuffer, nBytes);
+  return nBytes;
+}
 
+/*!
+   Reserve space in the ring for the producer to build data in place.
+   This blocks exactly like put until there's space for nBytes.  If the
+   space does not wrap the top of the ring (or the ring is mirrored), the
+   pointer returned is directly into the ring data segment and the subsequent
+   commit copies nothing.  If it would wrap, the pointer returned is to a
+   contiguous scratch area owned by this object that commit copies into the ring.
+
+   Only one reservation can be outstanding; a second reserve replaces the
+   first.  Nothing is visible to consumers until commit is called.
+
+   \param nBytes  - Number of bytes to reserve.
+   \param timeout - Seconds to block for space (ULONG_MAX - effectively forever,
+                    0 - don't block).
+
+   \return void*
+   \retval 0     - The wait for space timed out.
+   \retval other - Where the caller should put up to nBytes of data.
+
+   \throw CRangeError     - nBytes won't ever fit in the ring.
+   \throw CStateException - This object is not a producer.
+*/
+void*
+CRingBuffer::reserve(size_t nBytes, unsigned long timeout)
+{
+  validateTransferAccess(producer, "CRingBuffer::reserve");
 
+  if (nBytes > maxReserve()) {
+    throw CRangeError(0, maxReserve(), nBytes, "CRingBuffer::reserve");
+  }
+  m_pReserved = 0;
+  m_nReserved = 0;
+  if (nBytes > m_putSpaceCache) {
+    CRingFreeSpacePredicate condition(nBytes);
+    if (blockWhile(condition, timeout)) {
+      return 0;			// timed out.
+    }
   }
-  else {
-    // Need to move in two chunks:
-
-    size_t firstSize = ringTop+1 - m_pClientInfo->s_offset;
-    size_t secondSize= nBytes - firstSize;
-
-    
-
-    memcpy(pPut, pBuffer, firstSize);                     // Move the first chunk.
-
-    const char* pSecond = reinterpret_cast<const char*>(pBuffer) + firstSize;
-    memcpy(pDataBase, pSecond, secondSize);              // Move the second chunk. 
 
+  if (m_mirrored || (bytesToTop() >= nBytes)) {
+    m_pReserved = reinterpret_cast<char*>(getPointer());
+  } else {
+    if (m_reserveScratch.size() < nBytes) {
+      m_reserveScratch.resize(nBytes);
+    }
+    m_pReserved = m_reserveScratch.data();
   }
-  Skip(nBytes);
+  m_nReserved = nBytes;
+  return m_pReserved;
+}
+/*!
+   Publish data built in a reservation.  The producer's put pointer
+   is advanced by nBytes (which may be less than was reserved) and
+   blocked consumers are woken.  If the reservation was in the scratch
+   area, the data are first copied (wrapping) into the ring.
 
-  // If we got this far success... issue a memory barrier to ensure this all is
-  // written to the shm:
+   \param nBytes - Number of bytes to commit.  Zero abandons the reservation.
 
-  __sync_synchronize();
+   \return size_t - nBytes.
 
+   \throw CRangeError     - nBytes is more than was reserved (including
+                            when there's no reservation).
+   \throw CStateException - This object is not a producer.
+*/
+size_t
+CRingBuffer::commit(size_t nBytes)
+{
+  validateTransferAccess(producer, "CRingBuffer::commit");
+  if (nBytes > m_nReserved) {
+    throw CRangeError(0, m_nReserved, nBytes, "CRingBuffer::commit");
+  }
+  if (nBytes) {
+    if (m_pReserved == m_reserveScratch.data()) {
+      copyToRing(m_pReserved, nBytes);
+    }
+    Skip(nBytes);
+    __sync_synchronize();
+  }
+  m_pReserved = 0;
+  m_nReserved = 0;
   return nBytes;
 }
 
@@ -840,9 +983,10 @@ CRingBuffer::peek(void*   pBuffer,
   char* pGet     = reinterpret_cast<char*>(m_pRing) + 
                    m_pClientInfo->s_offset;	// get data starting here.
 
-  // Decide if this can be transferred in one or two chunks:
+  // Decide if this can be transferred in one or two chunks.  Mirrored
+  // rings can always be read in one chunk:
 
-  if (m_pClientInfo->s_offset + transferSize <= (ringTop+1)) {
+  if (m_mirrored || (m_pClientInfo->s_offset + transferSize <= (ringTop+1))) {
 
     // only need a single transfer:
 
@@ -941,11 +1085,14 @@ CRingBuffer::getPointer()
 /**
  * wouldWrap
  *   @param nBytes -number of bytes to check.
- *   @return bool - true if pGet + nBytes would wrap the buffer.
+ *   @return bool - true if pGet + nBytes would wrap the buffer.  This is
+ *                  always false for mirrored rings as the data are contiguous
+ *                  from the pointer no matter where it is.
  */
 bool
 CRingBuffer::wouldWrap(size_t nBytes)
 {
+ if (m_mirrored) return false;
  off_t ringTop  = m_pRing->s_header.s_topOffset;
  off_t desiredTop = m_pClientInfo->s_offset + nBytes;
  return desiredTop > ringTop;
@@ -959,6 +1106,41 @@ CRingBuffer::bytesToTop()
 {
   return m_pRing->s_header.s_topOffset - m_pClientInfo->s_offset + 1;
 }
+/**
+ * canNotify
+ *   @return bool - true if this ring has a notification block so that
+ *                  blocking operations are woken by the other side rather
+ *                  than polling every getPollInterval() ms.  False for rings
+ *                  created by software that predates the notification block.
+ */
+bool
+CRingBuffer::canNotify() const
+{
+  return m_pNotify != 0;
+}
+/**
+ * isMirrored
+ *   @return bool - true if the ring was created with a mirrored data segment.
+ *                  For these rings getPointer() is the start of all
+ *                  availableData() (consumers) or availablePutSpace()
+ *                  (producers) bytes without a wrap.
+ */
+bool
+CRingBuffer::isMirrored() const
+{
+  return m_mirrored;
+}
+/**
+ * maxReserve
+ *   @return size_t - The largest reservation that can ever be satisfied.
+ *                    One byte of the ring always stays free to tell a full
+ *                    ring from an empty one.
+ */
+size_t
+CRingBuffer::maxReserve() const
+{
+  return m_pRing->s_header.s_dataBytes - 1;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Inquiry member functions.
@@ -974,13 +1156,36 @@ CRingBuffer::availablePutSpace()
 {
   pRingHeader pHeader   = reinterpret_cast<pRingHeader>(m_pRing);
   size_t      consumers = pHeader->s_maxConsumer;
+  size_t      minFree   = pHeader->s_dataBytes-1;
+
+  // With a client map we only need to visit the claimed slots.  Slots that
+  // are still joining (s_pid == 0) are included as is: a joining consumer
+  // finishes by syncing to the put pointer so any offset it has now can only
+  // make us underestimate the free space.  No need to stall for it.
+
+  if (m_pClientMap) {
+    size_t words = (consumers + 63)/64;
+    for (size_t w = 0; w < words; w++) {
+      uint64_t live = m_pClientMap->s_liveMap[w];
+      while (live) {
+        size_t bit = __builtin_ctzll(live);
+        live      &= live - 1;
+        pClientInformation pClient = consumerSlot(w*64 + bit);
+        if (pClient->s_pid != -1) {
+          size_t avail     = availableData(pClient);
+          size_t freeBytes = pHeader->s_dataBytes - avail - 1;
+          if (freeBytes < minFree) minFree = freeBytes;
+        }
+      }
+    }
+    if (m_mode == producer) m_putSpaceCache = minFree;
+    return minFree;
+  }
 
-  pClientInformation pClients = reinterpret_cast<pClientInformation>(reinterpret_cast<char*>(m_pRing) + 
-								      pHeader->s_firstConsumer);
+  pClientInformation pClients = consumerSlot(0);
 
   // figure out the minimum free space:
 
-  size_t minFree =  pHeader->s_dataBytes-1;
   for (int i = 0; i < consumers;  i++) {
     // If the ring is in transition (a new consumer joining)... we need to 
     // wait a bit and try again so that we are not looking at get pointers in flux.
@@ -989,8 +1194,7 @@ CRingBuffer::availablePutSpace()
       Os::usleep(100);		// Wait 100usec.
       i = 0;			// and reset the loop.
       minFree  = pHeader->s_dataBytes-1;
-      pClients = reinterpret_cast<pClientInformation>(reinterpret_cast<char*>(m_pRing) + 
-						      pHeader->s_firstConsumer);
+      pClients = consumerSlot(0);
     }
     
     if(pClients->s_pid > 0) {	// -1  - unused 0 - initializing > 0 fully  in use.
@@ -999,8 +1203,11 @@ CRingBuffer::availablePutSpace()
       if (freeBytes < minFree) minFree = freeBytes;
     }
 
-    pClients++;
+    pClients = reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(pClients) + m_slotStride
+    );
   }
+  if (m_mode == producer) m_putSpaceCache = minFree;
   return minFree;
 }
 
@@ -1038,7 +1245,6 @@ CRingBuffer::getUsage()
 
   pRingHeader         pHead      = &(m_pRing->s_header);
   pClientInformation  pProducer  = &(m_pRing->s_producer);
-  pClientInformation  pConsumers = m_pRing->s_consumers;
 
   Usage  result;
   result.s_bufferSpace = pHead->s_dataBytes;
@@ -1049,13 +1255,13 @@ CRingBuffer::getUsage()
   // Get information about all the consumers:
 
   for (int i =0; i < result.s_maxConsumers; i++) {
-    if (pConsumers->s_pid != -1) {
+    pClientInformation pConsumer = consumerSlot(i);
+    if (pConsumer->s_pid != -1) {
       pair<pid_t, size_t> info;
-      info.first  = pConsumers->s_pid;
-      info.second = difference(*pProducer, *pConsumers);
+      info.first  = pConsumer->s_pid;
+      info.second = difference(*pProducer, *pConsumer);
       result.s_consumers.push_back(info);
     }
-    pConsumers++;
   }
   // Figure out the max/min data available.
   // Special case of no consumers means that the 0 space is available for both.
@@ -1090,7 +1296,7 @@ CRingBuffer::getSlot()
   if (m_mode == manager)  return -1;
 
   for (int i = 0; i < m_pRing->s_header.s_maxConsumer; i++) {
-    pClientInformation p = &(m_pRing->s_consumers[i]);
+    pClientInformation p = consumerSlot(i);
     if (p == m_pClientInfo) return i;
   }
   return -2;			// Really 'impossible'.
@@ -1105,6 +1311,11 @@ CRingBuffer::getSlot()
     is captured in the form of a functional object that is derived from 
     CRingBuffer::CRingBufferPredicate.
 
+    For versioned rings, producers and consumers sleep on the ring's futex
+    words and are woken when the other side moves its pointer.  Legacy rings
+    and manager connections fall back to calling pollblock() between
+    evaluations of the predicate.
+
     \param pred    - The redicate object that controls how long we block.
     \param timeout - The maximum number of seconds we'll block.  The
                      default value is ULONG_MAX which is about 136 years
@@ -1120,20 +1331,76 @@ CRingBuffer::blockWhile(CRingBuffer::CRingBufferPredicate& pred, unsigned long t
   // Lower the latencey by special casing the timeout == 0:
 
   if (timeout) {
-    time_t start = time(NULL);
+    time_t   start    = time(NULL);
+    int      status   = 0;
+    bool     notified = beginWait();            // false -> we must poll.
+    unsigned sequence = notified ? waitSequence() : 0;
+
     while (pred(*this)) {
       time_t now = time(NULL);
-      if ((now - start) >= timeout) 
-        return -1; // timeout
-      pollblock(); // wait a bit before checking condition.
+      if ((now - start) >= timeout) {
+        status = -1;		// timeout
+        break;
+      }
+      if (notified) {
+        waitNotification(sequence, DEFAULT_NOTIFYMS); // Until the other side moves.
+        sequence = waitSequence();
+      } else {
+        pollblock(); // wait a bit before checking condition.
+      }
     }
-    
-    return 0;			// condition no longer true.
+    if (notified) {
+      endWait();
+    }
+    return status;		// 0 if condition no longer true.
   }
   else {
     return pred(*this) ? -1 : 0;
   }
 }
+/*!
+    blockWhile with a timeout in milliseconds rather than seconds, for
+    callers that must not wait much longer than they asked to.  Futex
+    waits are cut short at the timeout; polling waits can overrun it by
+    up to the poll interval.
+
+    \param pred      - The predicate object that controls how long we block.
+    \param msTimeout - The maximum number of milliseconds we'll block.
+    \return int
+    \retval 0    - Blocking ended normally.
+    \retval -1   - Blocking timed out.
+*/
+int
+CRingBuffer::blockWhileMs(CRingBuffer::CRingBufferPredicate& pred,
+                          unsigned long msTimeout)
+{
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int      status   = 0;
+  bool     notified = beginWait();
+  unsigned sequence = notified ? waitSequence() : 0;
+
+  while (pred(*this)) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned long elapsed = (now.tv_sec - start.tv_sec)*1000 +
+      (now.tv_nsec - start.tv_nsec)/1000000;
+    if (elapsed >= msTimeout) {
+      status = -1;
+      break;
+    }
+    if (notified) {
+      unsigned long wait = msTimeout - elapsed;
+      waitNotification(sequence, (wait < DEFAULT_NOTIFYMS) ? wait : DEFAULT_NOTIFYMS);
+      sequence = waitSequence();
+    } else {
+      pollblock();
+    }
+  }
+  if (notified) {
+    endWait();
+  }
+  return status;
+}
 /*!
    Iterate in some way while a predicate is true.  This can be used
    to skip forward in the ring buffer until a specific chunk of data
@@ -1198,7 +1465,10 @@ CRingBuffer::forceConsumerRelease(unsigned slot)
 		      slot,
 		      "CRingBuffer::forceConsumerRelease");
   }
-  m_pRing->s_consumers[slot].s_pid = -1;
+  setLive(slot, false);		// Before the slot can be reclaimed.
+  __sync_synchronize();
+  consumerSlot(slot)->s_pid = -1;
+  notifyGet();			// The producer may have been waiting on that consumer.
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1233,16 +1503,26 @@ CRingBuffer::shmName(string rawName)
 }
 
 /*******************************************************************/
-/*  Maps to the specified full name ring buffer.                   */
+/*  Maps to the specified full name ring buffer.  Mirrored rings   */
+/*  are remapped with the data segment mapped a second time just   */
+/*  above the top of the ring.                                     */
 /*******************************************************************/
 
 RingBuffer* 
-CRingBuffer::mapRingBuffer(std::string fullName)
+CRingBuffer::mapRingBuffer(std::string fullName, bool& mirrored)
 {
-
-
-
-  return reinterpret_cast<RingBuffer*>(CDAQShm::attach(fullName));
+  RingBuffer* pRing = reinterpret_cast<RingBuffer*>(CDAQShm::attach(fullName));
+  mirrored          = false;
+
+  if (pRing && mirroredLayout(pRing->s_header)) {
+    size_t dataOffset = pRing->s_header.s_dataOffset;
+    CDAQShm::detach(pRing, fullName, CDAQShm::size(fullName));
+    pRing    = reinterpret_cast<RingBuffer*>(
+      CDAQShm::attachMirrored(fullName, dataOffset)
+    );
+    mirrored = true;
+  }
+  return pRing;
 
 }
 
@@ -1255,7 +1535,11 @@ void
 CRingBuffer::unMapRing()
 {
   std::string fullName = shmName(m_ringName);
-  CDAQShm::detach(m_pRing, fullName, CDAQShm::size(fullName));
+  if (m_mirrored) {
+    CDAQShm::detachMirrored(m_pRing, fullName, CDAQShm::size(fullName));
+  } else {
+    CDAQShm::detach(m_pRing, fullName, CDAQShm::size(fullName));
+  }
   
 }
 /******************************************************************/
@@ -1270,16 +1554,22 @@ CRingBuffer::allocateConsumer()
 {
   pRingHeader pHeader    = &(m_pRing->s_header);
   size_t      nConsumers = pHeader->s_maxConsumer;
-  pClientInformation p   = reinterpret_cast<pClientInformation>(reinterpret_cast<char*>(m_pRing) + 
-							   pHeader->s_firstConsumer);
   pClientInformation put= reinterpret_cast<pClientInformation>(reinterpret_cast<char*>(m_pRing) +
 							   pHeader->s_producerInfo);
 
   for (int i =0; i < nConsumers; i++) {
+    pClientInformation p = consumerSlot(i);
     if (p->s_pid == -1) {
       p->s_pid = 0;		// Claim it as in use but not active.
       __sync_synchronize();	// Flush to shm as well.
 
+      // With a client map, publish ourselves to the producer before we
+      // sync to the put pointer.  Until the sync is done our offset can only
+      // make the producer think there's less free space than there is.
+
+      p->s_offset = put->s_offset;
+      setLive(i, true);
+
       // The loop below deals with any cases where the put pointer moved
       // While we were joining up.
 
@@ -1293,8 +1583,6 @@ CRingBuffer::allocateConsumer()
       __sync_synchronize();	// Flush to shm as well.
       return;
     }
-
-    p++;
   }
   errno = ENOMEM;
   throw CErrnoException("CRingBuffer::allocateConsumer");
@@ -1326,6 +1614,39 @@ CRingBuffer::difference(ClientInformation& producer, ClientInformation& consumer
   return topSize + botSize;
 }
 
+/******************************************************************/
+/* Copy data to the producer's put pointer, wrapping as needed.   */
+/* The put pointer is not moved - see Skip for that.              */
+/******************************************************************/
+void
+CRingBuffer::copyToRing(const void* pBuffer, size_t nBytes)
+{
+  off_t ringBase = m_pRing->s_header.s_dataOffset;
+  off_t ringTop  = m_pRing->s_header.s_topOffset;
+  char* pDataBase= reinterpret_cast<char*>(m_pRing) + ringBase;
+  char* pPut     = reinterpret_cast<char*>(m_pRing) + m_pClientInfo->s_offset;
+
+  if (m_mirrored || ((m_pClientInfo->s_offset + nBytes) <=  (ringTop+1))) {
+
+    // Can move all at once...  Writes past the top of a mirrored ring land
+    // at the bottom of the data segment.
+
+    memcpy(pPut, pBuffer, nBytes);
+
+  }
+  else {
+    // Need to move in two chunks:
+
+    size_t firstSize = ringTop+1 - m_pClientInfo->s_offset;
+    size_t secondSize= nBytes - firstSize;
+
+    memcpy(pPut, pBuffer, firstSize);                     // Move the first chunk.
+
+    const char* pSecond = reinterpret_cast<const char*>(pBuffer) + firstSize;
+    memcpy(pDataBase, pSecond, secondSize);              // Move the second chunk. 
+
+  }
+}
 /******************************************************************/
 /* Move the object's pointer ahead the designated number of bytes */
 /* wrapping if needed.                                            */
@@ -1335,6 +1656,10 @@ CRingBuffer::Skip(size_t nBytes)
 {
   pRingHeader pHeader = &(m_pRing->s_header);
 
+  if (m_mode == producer) {
+    m_putSpaceCache = (nBytes < m_putSpaceCache) ? m_putSpaceCache - nBytes : 0;
+  }
+
   m_pClientInfo->s_offset += nBytes;
   if (m_pClientInfo->s_offset > pHeader->s_topOffset) {
     m_pClientInfo->s_offset = (m_pClientInfo->s_offset - pHeader->s_topOffset) +
@@ -1343,6 +1668,156 @@ CRingBuffer::Skip(size_t nBytes)
   // Issue a memory barrier to ensure this is flushed out to the shared memory?
 
   __sync_synchronize();
+
+  // Wake up anybody that's blocked waiting for us to move:
+
+  if (m_mode == producer) {
+    notifyPut();
+  } else if (m_mode == consumer) {
+    notifyGet();
+  }
+}
+/******************************************************************/
+/* Locate the version dependent parts of the ring: the            */
+/* notification block and the client map.  Legacy (unversioned)   */
+/* rings leave m_pNotify null so we'll poll and rings older than  */
+/* v2 have no client map and packed consumer slots.               */
+/******************************************************************/
+void
+CRingBuffer::locateLayout()
+{
+  pRingHeader pHeader = &(m_pRing->s_header);
+  m_pNotify    = 0;
+  m_pClientMap = 0;
+  m_slotStride = sizeof(ClientInformation);
+  if ((strcmp(pHeader->s_magicString, VERSIONEDMAGICSTRING) == 0) &&
+      (pHeader->s_version >= RING_VERSION_NOTIFY) && pHeader->s_notifyOffset) {
+    m_pNotify = reinterpret_cast<pRingNotification>(
+      reinterpret_cast<char*>(m_pRing) + pHeader->s_notifyOffset
+    );
+    if (pHeader->s_version >= RING_VERSION_PADDED) {
+      m_pClientMap = reinterpret_cast<pRingClientMap>(m_pNotify + 1);
+      m_slotStride = m_pClientMap->s_slotStride;
+    }
+  }
+}
+/******************************************************************/
+/* Return a pointer to the client information for a consumer slot */
+/******************************************************************/
+ClientInformation*
+CRingBuffer::consumerSlot(size_t slot)
+{
+  return reinterpret_cast<pClientInformation>(
+    reinterpret_cast<char*>(m_pRing) + m_pRing->s_header.s_firstConsumer +
+    slot*m_slotStride
+  );
+}
+/******************************************************************/
+/* Mark a consumer slot as claimed/free in the client map.  This  */
+/* is a no-op for rings without a client map.  The bit and count  */
+/* are updated atomically as the producer reads them unlocked.    */
+/******************************************************************/
+void
+CRingBuffer::setLive(size_t slot, bool live)
+{
+  if (!m_pClientMap) return;
+
+  volatile uint64_t* pWord = &(m_pClientMap->s_liveMap[slot/64]);
+  uint64_t           bit   = uint64_t(1) << (slot % 64);
+  if (live) {
+    if (!(__sync_fetch_and_or(pWord, bit) & bit)) {
+      __sync_fetch_and_add(&(m_pClientMap->s_liveCount), 1);
+    }
+  } else {
+    if (__sync_fetch_and_and(pWord, ~bit) & bit) {
+      __sync_fetch_and_sub(&(m_pClientMap->s_liveCount), 1);
+    }
+  }
+}
+/******************************************************************/
+/* The producer has put data, bump the put sequence and wake any  */
+/* consumers that are blocked on it.  The atomic increment is a   */
+/* full barrier so the waiter count read below can't be stale     */
+/* relative to the data/offset writes.                            */
+/******************************************************************/
+void
+CRingBuffer::notifyPut()
+{
+  if (m_pNotify) {
+    __sync_fetch_and_add(&(m_pNotify->s_putSequence), 1);
+    if (m_pNotify->s_putWaiters) {
+      Os::futexWake(&(m_pNotify->s_putSequence), INT_MAX);
+    }
+  }
+}
+/******************************************************************/
+/* A consumer has freed space; bump the get sequence and wake the */
+/* producer if it's blocked waiting for space.                    */
+/******************************************************************/
+void
+CRingBuffer::notifyGet()
+{
+  if (m_pNotify) {
+    __sync_fetch_and_add(&(m_pNotify->s_getSequence), 1);
+    if (m_pNotify->s_getWaiters) {
+      Os::futexWake(&(m_pNotify->s_getSequence), INT_MAX);
+    }
+  }
+}
+/******************************************************************/
+/* Register as a waiter.  Consumers wait on the put sequence,     */
+/* producers on the get sequence.  Returns false if we can't use  */
+/* notification (legacy ring or manager) and so must poll.        */
+/******************************************************************/
+bool
+CRingBuffer::beginWait()
+{
+  if (!m_pNotify) return false;
+  if (m_mode == consumer) {
+    __sync_fetch_and_add(&(m_pNotify->s_putWaiters), 1);
+  } else if (m_mode == producer) {
+    __sync_fetch_and_add(&(m_pNotify->s_getWaiters), 1);
+  } else {
+    return false;
+  }
+  return true;
+}
+/******************************************************************/
+/* Sample the sequence number we'd wait on.  Must be called before */
+/* the blocking predicate is evaluated so that a change between    */
+/* the evaluation and the futex wait is not missed.                */
+/******************************************************************/
+unsigned
+CRingBuffer::waitSequence()
+{
+  unsigned result = (m_mode == consumer) ?
+    m_pNotify->s_putSequence : m_pNotify->s_getSequence;
+  __sync_synchronize();
+  return result;
+}
+/******************************************************************/
+/* Sleep until the sequence we're waiting on changes from         */
+/* sequence.  The wait is capped at ms so that the caller's       */
+/* timeout gets checked from time to time.                        */
+/******************************************************************/
+void
+CRingBuffer::waitNotification(unsigned sequence, unsigned long ms)
+{
+  volatile uint32_t* pWord = (m_mode == consumer) ?
+    &(m_pNotify->s_putSequence) : &(m_pNotify->s_getSequence);
+  Os::futexWait(pWord, sequence, ms);
+}
+/******************************************************************/
+/* Deregister as a waiter.                                        */
+/******************************************************************/
+void
+CRingBuffer::endWait()
+{
+  if (m_mode == consumer) {
+    __sync_fetch_and_sub(&(m_pNotify->s_putWaiters), 1);
+  } else {
+    __sync_fetch_and_sub(&(m_pNotify->s_getWaiters), 1);
+  }
 }
 /***************************************************************/
 /* Return the stringified mode                                 */
@@ -1422,8 +1897,19 @@ CRingBuffer::notifyDisconnection()
 bool
 CRingBuffer::ringHeader(RingBuffer* p)
 {
-return strcmp(p->s_header.s_magicString, 
-	       MAGICSTRING) == 0;
+  return (strcmp(p->s_header.s_magicString, MAGICSTRING) == 0) ||
+         (strcmp(p->s_header.s_magicString, VERSIONEDMAGICSTRING) == 0);
+}
+/**********************************************************************/
+/* Return the number of bytes in front of the data segment for a ring */
+/* with maxConsumer consumers.  This is the header, client slots,     */
+/* notification block and client map.                                 */
+/**********************************************************************/
+size_t
+CRingBuffer::layoutSize(size_t maxConsumer)
+{
+  return notifyOffset(maxConsumer) + sizeof(RingNotification) +
+         clientMapSize(maxConsumer);
 }
 /**
  * validateTransferAccess
@@ -26,6 +26,8 @@
 
 typedef struct __RingBuffer        RingBuffer;
 typedef struct __ClientInformation ClientInformation;
+typedef struct __RingNotification  RingNotification;
+typedef struct __RingClientMap     RingClientMap;
 class CRingMaster;
 
 /*!
@@ -67,6 +69,14 @@ private:
 private:
   RingBuffer*         m_pRing;	       // Pointer to the actual ring.
   ClientInformation*  m_pClientInfo;   // Pointer to the object owner's client info.
+  RingNotification*   m_pNotify;       // Futex wakeup block (null for legacy rings).
+  RingClientMap*      m_pClientMap;    // Live consumer map (null before v2 layouts).
+  size_t              m_slotStride;    // Bytes between consumer slots.
+  size_t              m_putSpaceCache; // Producer's lower bound on free space.
+  char*               m_pReserved;     // Current reservation (ring or scratch).
+  size_t              m_nReserved;     // Bytes in the current reservation.
+  std::vector<char>   m_reserveScratch;// Reservations that would wrap go here.
+  bool                m_mirrored;      // Data segment mapped twice.
   ClientMode          m_mode;	       // What sort of client this is.
   unsigned long       m_pollInterval;  // ms between blocking polls.
   std::string         m_ringName;      // Name of ring we're connected to.
@@ -76,16 +86,19 @@ public:
   static void create(std::string name, 
 		     size_t dataBytes = m_defaultDataSize,
 		     size_t maxConsumer = m_defaultMaxConsumers,
-		     bool   tempMasterConnection = false);
+		     bool   tempMasterConnection = false,
+		     bool   mirrored = false);
   static CRingBuffer* createAndProduce(std::string name,
 				       size_t dataBytes = m_defaultDataSize,
 				       size_t maxConsumer = m_defaultMaxConsumers,
-				       bool   tempMasterConnection = false);
+				       bool   tempMasterConnection = false,
+				       bool   mirrored = false);
   static void remove(std::string name);
   static void format(std::string name,
-		     size_t maxConsumer = m_defaultMaxConsumers);
+		     size_t maxConsumer = m_defaultMaxConsumers,
+		     bool   mirrored = false);
   static void unsynchedFormat(std::string name,
-             size_t maxConsumer);
+             size_t maxConsumer, bool mirrored = false);
   static bool isRing(std::string name);
   static void   setDefaultRingSize(size_t byteCount);
   static size_t getDefaultRingSize();
@@ -122,6 +135,15 @@ public:
   void*  getPointer();                  // Return ring item get pointer.k
   bool   wouldWrap(size_t nBytes);      // True if nbytes from get pointer wraps.
   size_t bytesToTop();                  // Bytes from get pointer to ring buffer top.
+
+  bool   canNotify() const;             // True if blocking is futex driven.
+  bool   isMirrored() const;            // True if data never wraps for access.
+
+  // Producer reservations - build data in place then publish it:
+
+  void*  reserve(size_t nBytes, unsigned long timeout=ULONG_MAX);
+  size_t commit(size_t nBytes);
+  size_t maxReserve() const;            // Largest reservation that can be met.
   
   // Inquiry functions.
 
@@ -135,6 +157,7 @@ public:
   // blocking.
 
   int blockWhile(CRingBufferPredicate& pred, unsigned long timeout=ULONG_MAX);
+  int blockWhileMs(CRingBufferPredicate& pred, unsigned long msTimeout);
   virtual void pollblock();		// Block for the current poll interval.
 
   // Iteration (e.g. searching).
@@ -154,10 +177,21 @@ private:
   void        allocateConsumer();
   size_t      difference(ClientInformation& producer, ClientInformation& consumer);
   void        Skip(size_t nBytes);
+  void        copyToRing(const void* pBuffer, size_t nBytes);
+  void        locateLayout();
+  ClientInformation* consumerSlot(size_t slot);
+  void        setLive(size_t slot, bool live);
+  void        notifyPut();
+  void        notifyGet();
+  bool        beginWait();
+  unsigned    waitSequence();
+  void        waitNotification(unsigned sequence, unsigned long ms);
+  void        endWait();
 
   static std::string shmName(std::string rawName);
-  static RingBuffer* mapRingBuffer(std::string fullName);
+  static RingBuffer* mapRingBuffer(std::string fullName, bool& mirrored);
   static bool        ringHeader(RingBuffer* p);
+  static size_t      layoutSize(size_t maxConsumer);
 
   std::string        modeString() const;
 
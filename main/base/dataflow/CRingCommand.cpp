@@ -127,10 +127,11 @@ CRingCommand::operator()(CTCLInterpreter&    interp,
 
 /*************************************************************************/
 /* create a new ring buffer:                                             */
-/*  ringbuffer create  name ?size ?maxconsumers??                        */
+/*  ringbuffer create  name ?size ?maxconsumers ?mirrored???             */
 /*  name - the name of the ring buffer.                                  */
 /*  size - the optional size specification                               */
 /*  maxconsumers - the optional maximum consumer count.                  */
+/*  mirrored - optional, nonzero to mirror the data segment.             */
 /*                                                                       */
 /* Result:                                                               */
 /*   An error message if an error occurs.                                */
@@ -143,7 +144,7 @@ CRingCommand::create(CTCLInterpreter& interp,
 {
   // Validate the command count:
 
-  if ((objv.size() < 3) || (objv.size() > 5)) {
+  if ((objv.size() < 3) || (objv.size() > 6)) {
     string result;
     result += "Incorrect number of parameters for ringbuffer create\n";
     result += CommandUsage();
@@ -155,6 +156,7 @@ CRingCommand::create(CTCLInterpreter& interp,
   string name      = objv[2];
   size_t size      = CRingBuffer::getDefaultRingSize();
   size_t consumers = CRingBuffer::getDefaultMaxConsumers();
+  bool   mirrored  = false;
 
   // If present, update the size from the objv:
 
@@ -172,7 +174,7 @@ CRingCommand::create(CTCLInterpreter& interp,
   }
   // If present, update consumers from the objv:
 
-  if (objv.size() == 5) {
+  if (objv.size() >= 5) {
     try {
       consumers = (int)(objv[4]);
     }
@@ -185,10 +187,24 @@ CRingCommand::create(CTCLInterpreter& interp,
        
     }
   }
+  // If present, the mirrored flag:
+
+  if (objv.size() == 6) {
+    try {
+      mirrored = (int)(objv[5]) != 0;
+    }
+    catch(...) {
+      string result;
+      result += "Optional mirrored parameter must be numeric\n";
+      result += CommandUsage();
+      interp.setResult(result);
+      return TCL_ERROR;
+    }
+  }
   // Create the ring buffer:
 
   try {
-    CRingBuffer::create(name, size, consumers);
+    CRingBuffer::create(name, size, consumers, false, mirrored);
   }
   catch (CException& reason) {
     string result;
@@ -739,7 +755,7 @@ CRingCommand::CommandUsage()
 {
   string usage;
   usage += "Usage:\n";
-  usage += "  ringbuffer create name ?size ?maxconsumers??\n";
+  usage += "  ringbuffer create name ?size ?maxconsumers ?mirrored???\n";
   usage += "  ringbuffer format name ?maxconsumers?\n";
   usage += "  ringbuffer disconnect producer name\n";
   usage += "  ringbuffer disconnect consumer name index\n";
@@ -750,6 +766,7 @@ CRingCommand::CommandUsage()
   usage += "  name         - Is the name of a ring buffer\n";
   usage += "  size         - Is the number of data bytes a ring buffer can have\n";
   usage += "  maxconsumers - Is the maximum number of conumser clients that can connect\n";
+  usage += "  mirrored     - Nonzero to map the data segment twice so it never wraps\n";
   usage += "  index        - Is the consumer index for a connected consumer\n";
   usage += "And anything bracketed with ?'s is an optional parameter.\n";
 
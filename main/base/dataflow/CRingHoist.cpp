@@ -0,0 +1,133 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoist.cpp
+ *  @brief: Helpers for the bulk ring hoisting protocol.
+ */
+#include "CRingHoist.h"
+#include <io.h>
+
+#include <zlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+
+namespace RingHoist {
+
+/**
+ * now
+ *    @return uint64_t - the monotonic clock in ns.
+ */
+uint64_t
+now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return uint64_t(t.tv_sec)*1000000000ULL + t.tv_nsec;
+}
+/**
+ * compress
+ *    Compress a batch's data.  Speed matters more than size here so
+ *    the fastest zlib level is used.
+ *
+ * @param pData  - the data.
+ * @param nBytes - how many there are.
+ * @param out    - (output) the compressed data.
+ */
+void
+compress(const void* pData, size_t nBytes, std::vector<uint8_t>& out)
+{
+    uLongf n = compressBound(nBytes);
+    out.resize(n);
+    if (compress2(
+        out.data(), &n, static_cast<const Bytef*>(pData), nBytes, 1) != Z_OK
+    ) {
+        throw std::runtime_error("Failed to compress a ring hoisting batch");
+    }
+    out.resize(n);
+}
+/**
+ * decompress
+ *
+ * @param pData    - compressed data.
+ * @param nBytes   - how many bytes of them.
+ * @param pOut     - where the uncompressed data go.
+ * @param outBytes - how many bytes they should be.
+ * @throw std::runtime_error - corrupt batch.
+ */
+void
+decompress(const void* pData, size_t nBytes, void* pOut, size_t outBytes)
+{
+    uLongf n = outBytes;
+    if ((uncompress(
+            static_cast<Bytef*>(pOut), &n, static_cast<const Bytef*>(pData), nBytes
+         ) != Z_OK) || (n != outBytes)) {
+        throw std::runtime_error("Ring hoisting batch is corrupt");
+    }
+}
+/**
+ * readMessage
+ *    Read a message (or batch data) from a socket.
+ *
+ * @param fd       - socket.
+ * @param pMessage - where to put it.
+ * @param nBytes   - how big it is.
+ * @return bool    - false if the peer closed before any of it was sent.
+ * @throw std::runtime_error - read error or the peer closed partway.
+ */
+bool
+readMessage(int fd, void* pMessage, size_t nBytes)
+{
+    size_t nRead;
+    try {
+        nRead = io::readData(fd, pMessage, nBytes);
+    }
+    catch (int e) {
+        std::string msg = "Ring hoisting read failed: ";
+        msg += strerror(e);
+        throw std::runtime_error(msg);
+    }
+    if (nRead == 0) return false;
+    if (nRead != nBytes) {
+        throw std::runtime_error("Ring hoisting peer closed in the middle of a message");
+    }
+    return true;
+}
+/**
+ * writeMessage
+ *    Write a message to a socket.
+ *
+ * @param fd       - socket.
+ * @param pMessage - the message.
+ * @param nBytes   - its size.
+ * @throw std::runtime_error - the write failed.
+ */
+void
+writeMessage(int fd, const void* pMessage, size_t nBytes)
+{
+    try {
+        io::writeData(fd, pMessage, nBytes);
+    }
+    catch (int e) {
+        std::string msg = "Ring hoisting write failed: ";
+        msg += e ? strerror(e) : "peer closed";
+        throw std::runtime_error(msg);
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoist.h
+ *  @brief: Messages of the bulk ring hoisting protocol.
+ *
+ *  The bulk protocol replaces the raw byte stream of
+ *  ringtostdout | network | stdintoring for remote rings.  Both directions
+ *  of the socket are used:
+ *
+ *  - The receiver (stdintoring --bulk) opens with a Hello giving the
+ *    number of batch credits it grants, whether it wants compression and,
+ *    on a reconnect, the session and stream offset to resume from.
+ *  - The sender (ringtostdout --bulk) replies with a HelloReply: the
+ *    session, the offset it will send from and the port it listens on for
+ *    reconnects (0 if it can't take them).
+ *  - The sender then sends Batches: a BatchHeader followed by
+ *    s_wireSize bytes.  The data are a contiguous piece of the ring's byte
+ *    stream starting at s_offset; batches don't respect item boundaries.
+ *    A batch can only be sent with a credit in hand.
+ *  - The receiver returns a Credit for each batch once its data are in
+ *    the proxy ring.  The credit acknowledges the stream up to s_ackedOffset
+ *    (the sender can drop its copy of those data) and echoes the batch's
+ *    send time so the sender can measure the hop's latency on its own clock.
+ *
+ *  If the connection drops the sender keeps the unacknowledged batches and
+ *  waits a while for the receiver to reconnect to the reconnect port and
+ *  resume.  All fields are in the byte order of the sender (both ends are
+ *  expected to be the same architecture, as for ring items).
+ */
+#ifndef CRINGHOIST_H
+#define CRINGHOIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace RingHoist {
+    static const uint32_t HELLO_MAGIC  = 0x4f4c4548;    // "HELO"
+    static const uint32_t REPLY_MAGIC  = 0x594c5052;    // "RPLY"
+    static const uint32_t BATCH_MAGIC  = 0x48435442;    // "BTCH"
+    static const uint32_t CREDIT_MAGIC = 0x54445243;    // "CRDT"
+    static const uint32_t VERSION      = 1;
+
+    // Largest batch (uncompressed); receivers reject bigger ones.
+
+    static const uint32_t MAX_BATCH    = 64*1024*1024;
+
+    // Compression methods:
+
+    static const uint32_t NONE         = 0;
+    static const uint32_t ZLIB         = 1;
+
+    // HelloReply status:
+
+    static const uint32_t OK           = 0;
+    static const uint32_t CANT_RESUME  = 1;
+
+    typedef struct __attribute__((__packed__)) _Hello {
+        uint32_t s_magic;
+        uint32_t s_version;
+        uint32_t s_compression;     // Wanted.
+        uint32_t s_credits;         // Batches that can be outstanding.
+        uint64_t s_session;         // 0 for a new session.
+        uint64_t s_resumeOffset;    // Stream offset to resume from.
+    } Hello, *pHello;
+
+    typedef struct __attribute__((__packed__)) _HelloReply {
+        uint32_t s_magic;
+        uint32_t s_status;
+        uint32_t s_compression;     // What will be used.
+        uint32_t s_reconnectPort;   // 0 - can't resume.
+        uint64_t s_session;
+        uint64_t s_offset;          // First batch starts here.
+    } HelloReply, *pHelloReply;
+
+    typedef struct __attribute__((__packed__)) _BatchHeader {
+        uint32_t s_magic;
+        uint32_t s_compression;     // For this batch.
+        uint32_t s_wireSize;        // Bytes following this header.
+        uint32_t s_dataSize;        // Uncompressed bytes.
+        uint64_t s_offset;          // Stream offset of the data.
+        uint64_t s_sendTime;        // Sender's monotonic clock (ns).
+    } BatchHeader, *pBatchHeader;
+
+    typedef struct __attribute__((__packed__)) _Credit {
+        uint32_t s_magic;
+        uint32_t s_credits;         // Batches granted.
+        uint64_t s_ackedOffset;     // Stream data up to here are in the ring.
+        uint64_t s_sendTime;        // Echoed from the batch.
+    } Credit, *pCredit;
+
+    // Counters for one hop, kept by the sender:
+
+    typedef struct _Statistics {
+        uint64_t s_batches;
+        uint64_t s_bytes;           // Ring data.
+        uint64_t s_wireBytes;       // As sent (after compression).
+        uint64_t s_latencySum;      // ns, batch send to credit.
+        uint64_t s_latencyCount;
+        uint64_t s_maxLatency;      // ns.
+        uint32_t s_reconnects;
+    } Statistics, *pStatistics;
+
+    uint64_t now();
+    void compress(const void* pData, size_t nBytes, std::vector<uint8_t>& out);
+    void decompress(
+        const void* pData, size_t nBytes, void* pOut, size_t outBytes
+    );
+    bool readMessage(int fd, void* pMessage, size_t nBytes);
+    void writeMessage(int fd, const void* pMessage, size_t nBytes);
+}
+
+#endif
@@ -0,0 +1,274 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoistReceiver.cpp
+ *  @brief: Implement the receiving end of the bulk ring hoisting protocol.
+ */
+#include "CRingHoistReceiver.h"
+#include "CRingBuffer.h"
+#include "stdintoringUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+
+/**
+ * constructor
+ *
+ * @param ring     - the ring we put data into.
+ * @param fd       - socket connected to the sender.
+ * @param credits  - batches the sender may have outstanding.
+ * @param compress - ask for compressed batches.
+ */
+CRingHoistReceiver::CRingHoistReceiver(
+    CRingBuffer& ring, int fd, unsigned credits, bool compress
+) :
+    m_ring(ring), m_fd(fd), m_credits(credits ? credits : 1),
+    m_compression(compress ? RingHoist::ZLIB : RingHoist::NONE),
+    m_reconnectTimeout(60), m_session(0), m_reconnectPort(0),
+    m_peerSize(sizeof(m_peer)), m_offset(0), m_nPending(0)
+{
+    if (getpeername(fd, reinterpret_cast<sockaddr*>(&m_peer), &m_peerSize)) {
+        m_peerSize = 0;                   // Not a socket - no reconnects.
+    }
+    m_ringSize = m_ring.maxReserve();
+}
+/**
+ * destructor
+ */
+CRingHoistReceiver::~CRingHoistReceiver()
+{
+}
+
+/**
+ * handshake
+ *    Start a new session with the sender.
+ *
+ * @return bool - false if the sender refused.
+ */
+bool
+CRingHoistReceiver::handshake()
+{
+    return hello(0, 0);
+}
+/**
+ * receiveBatch
+ *    Get the next batch, put the complete items we now have in the ring
+ *    and return a credit.
+ *
+ * @return bool - false if the sender closed between batches.
+ * @throw std::runtime_error - the connection failed or the batch was bad.
+ * @throw std::length_error  - an item won't fit in the ring.
+ */
+bool
+CRingHoistReceiver::receiveBatch()
+{
+    RingHoist::BatchHeader h;
+    if (!RingHoist::readMessage(m_fd, &h, sizeof(h))) return false;
+    if ((h.s_magic != RingHoist::BATCH_MAGIC) || (h.s_offset != m_offset)) {
+        throw std::runtime_error("Ring hoisting batch is out of sequence");
+    }
+    bool sizeOk = (h.s_dataSize <= RingHoist::MAX_BATCH);
+    if (h.s_compression == RingHoist::ZLIB) {
+        sizeOk = sizeOk && (h.s_wireSize <= h.s_dataSize);  // Else it's sent raw.
+    } else if (h.s_compression == RingHoist::NONE) {
+        sizeOk = sizeOk && (h.s_wireSize == h.s_dataSize);
+    } else {
+        sizeOk = false;
+    }
+    if (!sizeOk) {
+        throw std::runtime_error("Ring hoisting batch header is corrupt");
+    }
+
+    if (m_pending.size() < m_nPending + h.s_dataSize) {
+        m_pending.resize(m_nPending + h.s_dataSize);
+    }
+    uint8_t* pDest = m_pending.data() + m_nPending;
+    if (h.s_compression == RingHoist::ZLIB) {
+        m_wire.resize(h.s_wireSize);
+        if (!RingHoist::readMessage(m_fd, m_wire.data(), h.s_wireSize)) {
+            throw std::runtime_error("Ring hoisting sender closed in a batch");
+        }
+        RingHoist::decompress(m_wire.data(), h.s_wireSize, pDest, h.s_dataSize);
+    } else {
+        if (!RingHoist::readMessage(m_fd, pDest, h.s_dataSize)) {
+            throw std::runtime_error("Ring hoisting sender closed in a batch");
+        }
+    }
+    m_nPending += h.s_dataSize;
+    m_offset   += h.s_dataSize;
+
+    checkItems();
+    m_nPending = putData(m_ring, m_pending.data(), m_nPending, m_ringSize);
+
+    RingHoist::Credit credit;
+    credit.s_magic       = RingHoist::CREDIT_MAGIC;
+    credit.s_credits     = 1;
+    credit.s_ackedOffset = m_offset;
+    credit.s_sendTime    = h.s_sendTime;
+    RingHoist::writeMessage(m_fd, &credit, sizeof(credit));
+    return true;
+}
+/**
+ * operator()
+ *    Receive batches until the sender is gone for good.
+ */
+void
+CRingHoistReceiver::operator()()
+{
+    while (1) {
+        try {
+            while (receiveBatch())
+                ;
+            std::cerr << "Ring hoisting sender closed the connection\n";
+        }
+        catch (std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        close(m_fd);
+        m_fd = -1;
+        if (!resume()) return;
+    }
+}
+
+/*---------------------------------------------------------------------------
+ * Protected methods:
+ */
+
+/**
+ * reconnect
+ *    Connect to the sender's reconnect port.
+ *
+ * @return int - the socket or -1 on failure.
+ */
+int
+CRingHoistReceiver::reconnect()
+{
+    if (!m_peerSize || !m_reconnectPort) return -1;
+
+    sockaddr_storage addr = m_peer;
+    if (addr.ss_family == AF_INET) {
+        reinterpret_cast<sockaddr_in*>(&addr)->sin_port = htons(m_reconnectPort);
+    } else if (addr.ss_family == AF_INET6) {
+        reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port = htons(m_reconnectPort);
+    } else {
+        return -1;
+    }
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), m_peerSize)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*---------------------------------------------------------------------------
+ * Private methods:
+ */
+
+/**
+ * checkItems
+ *    Make sure every item whose header we have can go in the ring; the
+ *    sender's batches aren't aligned to items so a too big one may be
+ *    anywhere in a batch.  Since putData leaves at most one partial item
+ *    pending, this looks at little more than the new batch.
+ *
+ * @throw std::runtime_error - an item is smaller than its header.
+ * @throw std::length_error  - an item won't fit in the ring.
+ */
+void
+CRingHoistReceiver::checkItems()
+{
+    size_t offset = 0;
+    while (offset + sizeof(struct header) <= m_nPending) {
+        uint32_t itemSize = computeSize(
+            reinterpret_cast<struct header*>(m_pending.data() + offset)
+        );
+        if (itemSize < sizeof(struct header)) {
+            throw std::runtime_error("Ring hoisting got a corrupt ring item");
+        }
+        if (itemSize > m_ringSize) {
+            throw std::length_error(
+                "Ring hoisting got an item that won't fit in the ring..enlarge the ring"
+            );
+        }
+        offset += itemSize;
+    }
+}
+/**
+ * hello
+ *    Send a Hello and process the reply.
+ *
+ * @param session - session to resume (0 for a new one).
+ * @param offset  - stream offset to resume from.
+ * @return bool   - true if the sender accepted.
+ */
+bool
+CRingHoistReceiver::hello(uint64_t session, uint64_t offset)
+{
+    RingHoist::Hello h;
+    h.s_magic        = RingHoist::HELLO_MAGIC;
+    h.s_version      = RingHoist::VERSION;
+    h.s_compression  = m_compression;
+    h.s_credits      = m_credits;
+    h.s_session      = session;
+    h.s_resumeOffset = offset;
+    RingHoist::writeMessage(m_fd, &h, sizeof(h));
+
+    RingHoist::HelloReply r;
+    if (!RingHoist::readMessage(m_fd, &r, sizeof(r)) ||
+        (r.s_magic != RingHoist::REPLY_MAGIC) || (r.s_status != RingHoist::OK)) {
+        return false;
+    }
+    m_session       = r.s_session;
+    m_reconnectPort = r.s_reconnectPort;
+    m_compression   = r.s_compression;
+    m_offset        = r.s_offset;
+    return true;
+}
+/**
+ * resume
+ *    Try to get back to the sender until the reconnect timeout.
+ *
+ * @return bool - true if the session was resumed.
+ */
+bool
+CRingHoistReceiver::resume()
+{
+    time_t giveUp = time(nullptr) + m_reconnectTimeout;
+    while (m_reconnectPort && (time(nullptr) < giveUp)) {
+        m_fd = reconnect();
+        if (m_fd >= 0) {
+            try {
+                if (hello(m_session, m_offset)) return true;
+                close(m_fd);
+                m_fd = -1;
+                return false;             // Sender can't resume us.
+            }
+            catch (std::runtime_error& e) {
+                close(m_fd);
+                m_fd = -1;
+            }
+        }
+        sleep(1);
+    }
+    return false;
+}
@@ -0,0 +1,94 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoistReceiver.h
+ *  @brief: Receiving end of the bulk ring hoisting protocol.
+ */
+#ifndef CRINGHOISTRECEIVER_H
+#define CRINGHOISTRECEIVER_H
+
+#include "CRingHoist.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <sys/socket.h>
+
+class CRingBuffer;
+
+/**
+ * @class CRingHoistReceiver
+ *    Takes batches from a CRingHoistSender and puts the ring items in them
+ *    into a (proxy) ring.  This is what stdintoring --bulk runs.
+ *
+ *    Batches are pieces of the sender's byte stream so items can span
+ *    batches; whole items go into the ring and the rest waits for the next
+ *    batch.  A credit goes back for each batch once its items are in the
+ *    ring, so a slow ring throttles the sender.
+ *
+ *    If the connection drops, we reconnect to the sender's reconnect port
+ *    (on the host the first connection came from) and resume the session
+ *    from the end of the last batch we got.  Attempts are made every
+ *    second until the reconnect timeout.
+ */
+class CRingHoistReceiver
+{
+private:
+    CRingBuffer&          m_ring;
+    int                   m_fd;
+    uint32_t              m_credits;
+    uint32_t              m_compression;
+    unsigned              m_reconnectTimeout;     // s.
+
+    uint64_t              m_session;
+    uint32_t              m_reconnectPort;
+    sockaddr_storage      m_peer;
+    socklen_t             m_peerSize;
+
+    uint64_t              m_offset;               // Next stream byte.
+    std::vector<uint8_t>  m_pending;              // Partial item(s).
+    size_t                m_nPending;
+    std::vector<uint8_t>  m_wire;
+    size_t                m_ringSize;
+
+public:
+    CRingHoistReceiver(CRingBuffer& ring, int fd, unsigned credits, bool compress);
+    virtual ~CRingHoistReceiver();
+
+private:
+    CRingHoistReceiver(const CRingHoistReceiver&);
+    CRingHoistReceiver& operator=(const CRingHoistReceiver&);
+
+public:
+    void setReconnectTimeout(unsigned seconds) { m_reconnectTimeout = seconds; }
+
+    bool handshake();
+    bool receiveBatch();
+    void operator()();
+
+    uint64_t getOffset() const { return m_offset; }
+    bool     isCompressed() const { return m_compression == RingHoist::ZLIB; }
+
+protected:
+    virtual int reconnect();
+
+private:
+    bool hello(uint64_t session, uint64_t offset);
+    void checkItems();
+    bool resume();
+};
+
+#endif
@@ -0,0 +1,461 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoistSender.cpp
+ *  @brief: Implement the sending end of the bulk ring hoisting protocol.
+ */
+#include "CRingHoistSender.h"
+#include "CRingBuffer.h"
+#include "CRingMaster.h"
+#include <io.h>
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+/*
+ * True while the ring has less than a batch for us.  Waiting on it with
+ * blockWhileMs sleeps on the ring's futex rather than polling.
+ */
+class CHoistNeedBatch : public CRingBuffer::CRingBufferPredicate
+{
+private:
+    size_t m_required;
+public:
+    CHoistNeedBatch(size_t required) : m_required(required) {}
+    virtual bool operator()(CRingBuffer& ring) {
+        return ring.availableData() < m_required;
+    }
+};
+
+/**
+ * constructor
+ *
+ * @param source    - ring we consume from.
+ * @param inFd      - receives the receiver's messages.
+ * @param outFd     - batches are written here (usually the same socket).
+ * @param batchSize - largest batch in bytes.
+ */
+CRingHoistSender::CRingHoistSender(
+    CRingBuffer& source, int inFd, int outFd, size_t batchSize
+) :
+    m_source(source), m_inFd(inFd), m_outFd(outFd), m_listenFd(-1),
+    m_reconnectPort(0),
+    m_batchSize((batchSize < RingHoist::MAX_BATCH) ? batchSize : RingHoist::MAX_BATCH),
+    m_maxLatency(10),
+    m_reconnectTimeout(60), m_session(0), m_compression(RingHoist::NONE),
+    m_credits(0), m_offset(0), m_data(m_batchSize),
+    m_pMaster(nullptr), m_reportInterval(0), m_lastReport(0),
+    m_lastReportBytes(0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+/**
+ * destructor
+ */
+CRingHoistSender::~CRingHoistSender()
+{
+    while (!m_unacked.empty()) {
+        delete m_unacked.front();
+        m_unacked.pop_front();
+    }
+    if (m_listenFd >= 0) close(m_listenFd);
+    delete m_pMaster;
+}
+
+/**
+ * setReporting
+ *    Report the hop's counters to the local RingMaster every interval
+ *    seconds.  If the RingMaster can't be reached reporting is just off.
+ *
+ * @param ring     - name of the ring being hoisted.
+ * @param client   - where it's going.
+ * @param interval - seconds between reports.
+ */
+void
+CRingHoistSender::setReporting(std::string ring, std::string client, unsigned interval)
+{
+    m_ringName       = ring;
+    m_client         = client;
+    m_reportInterval = interval;
+    try {
+        m_pMaster = new CRingMaster;
+    }
+    catch (...) {
+        std::cerr << "Unable to connect to the RingMaster; no hoist statistics\n";
+        m_pMaster = nullptr;
+    }
+}
+/**
+ * handshake
+ *    Read the receiver's Hello and reply, starting a new session.
+ *
+ * @return bool - false if the receiver closed or asked to resume a session
+ *                we don't have.
+ * @throw std::runtime_error - protocol errors.
+ */
+bool
+CRingHoistSender::handshake()
+{
+    RingHoist::Hello hello;
+    if (!RingHoist::readMessage(m_inFd, &hello, sizeof(hello))) return false;
+    if ((hello.s_magic != RingHoist::HELLO_MAGIC) ||
+        (hello.s_version != RingHoist::VERSION)) {
+        throw std::runtime_error("Ring hoisting receiver sent an invalid hello");
+    }
+    if (hello.s_session) {
+        reply(RingHoist::CANT_RESUME, 0);
+        return false;
+    }
+    m_session     = (RingHoist::now() ^ (uint64_t(getpid()) << 32)) | 1;
+    m_compression = (hello.s_compression == RingHoist::ZLIB) ?
+        RingHoist::ZLIB : RingHoist::NONE;
+    m_credits     = hello.s_credits ? hello.s_credits : 1;
+
+    if (m_reconnectTimeout) makeListener();
+    reply(RingHoist::OK, m_offset);
+    return true;
+}
+/**
+ * operator()
+ *    Send until the receiver is gone and does not come back.
+ */
+void
+CRingHoistSender::operator()()
+{
+    while (1) {
+        try {
+            sendLoop();
+        }
+        catch (std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        closeConnection();
+        if (!reconnect()) break;
+        m_stats.s_reconnects++;
+    }
+    report(true);
+}
+
+/*---------------------------------------------------------------------------
+ * Protected methods:
+ */
+
+/**
+ * awaitReconnect
+ *    Wait for the receiver to connect to the reconnect port.
+ *
+ * @return int - the new connection or -1 if none came in time.
+ */
+int
+CRingHoistSender::awaitReconnect()
+{
+    if (m_listenFd < 0) return -1;
+
+    pollfd p = {m_listenFd, POLLIN, 0};
+    if (poll(&p, 1, m_reconnectTimeout*1000) <= 0) return -1;
+    return accept(m_listenFd, nullptr, nullptr);
+}
+
+/*---------------------------------------------------------------------------
+ * Private methods:
+ */
+
+/**
+ * sendLoop
+ *    Take credits, fill batches and send them until something fails.
+ */
+void
+CRingHoistSender::sendLoop()
+{
+    while (1) {
+        serviceCredits(m_credits ? 0 : m_maxLatency);
+        if (m_credits) {
+            size_t n = fillBatch();
+            if (n) sendBatch(n);
+        }
+        report(false);
+    }
+}
+/**
+ * reconnect
+ *    Get the receiver back and resend what it doesn't have.  The receiver
+ *    resumes from the end of the last batch it got; that has to be one of
+ *    the batches we're holding (or the end of the stream).
+ *
+ * @return bool - true if we're connected again.
+ */
+bool
+CRingHoistSender::reconnect()
+{
+    int fd = awaitReconnect();
+    if (fd < 0) return false;
+    m_inFd = m_outFd = fd;
+
+    try {
+        RingHoist::Hello hello;
+        if (!RingHoist::readMessage(fd, &hello, sizeof(hello)) ||
+            (hello.s_magic != RingHoist::HELLO_MAGIC) ||
+            (hello.s_session != m_session)) {
+            closeConnection();
+            return false;
+        }
+        uint64_t resume = hello.s_resumeOffset;
+        while (!m_unacked.empty() &&
+               (m_unacked.front()->s_header.s_offset < resume)) {
+            delete m_unacked.front();
+            m_unacked.pop_front();
+        }
+        uint64_t first = m_unacked.empty() ?
+            m_offset : m_unacked.front()->s_header.s_offset;
+        if (first != resume) {
+            reply(RingHoist::CANT_RESUME, first);
+            closeConnection();
+            return false;
+        }
+        reply(RingHoist::OK, resume);
+
+        m_credits = hello.s_credits ? hello.s_credits : 1;
+        for (auto p = m_unacked.begin(); p != m_unacked.end(); p++) {
+            writeBatch(*p);
+            m_credits = m_credits ? m_credits - 1 : 0;
+        }
+    }
+    catch (std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        closeConnection();
+        return false;
+    }
+    return true;
+}
+/**
+ * makeListener
+ *    Listen for reconnects on an ephemeral port of the same address
+ *    family as the data connection.  If the connection isn't a socket,
+ *    reconnects aren't possible.
+ */
+void
+CRingHoistSender::makeListener()
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(m_outFd, reinterpret_cast<sockaddr*>(&addr), &len)) return;
+    if ((addr.ss_family != AF_INET) && (addr.ss_family != AF_INET6)) return;
+
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) return;
+
+    if (addr.ss_family == AF_INET) {
+        reinterpret_cast<sockaddr_in*>(&addr)->sin_port = 0;
+    } else {
+        reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port = 0;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), len) || listen(fd, 1) ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len)) {
+        close(fd);
+        return;
+    }
+    m_listenFd      = fd;
+    m_reconnectPort = ntohs(
+        (addr.ss_family == AF_INET) ?
+        reinterpret_cast<sockaddr_in*>(&addr)->sin_port :
+        reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port
+    );
+}
+/**
+ * fillBatch
+ *    Get a batch of data from the ring.  We wait for a full batch for up
+ *    to the maximum latency and then take what there is.
+ *
+ * @return size_t - bytes gotten (0 if the ring stayed empty).
+ */
+size_t
+CRingHoistSender::fillBatch()
+{
+    CHoistNeedBatch needBatch(m_batchSize);
+    m_source.blockWhileMs(needBatch, m_maxLatency);
+
+    size_t avail = m_source.availableData();
+    size_t n = (avail < m_batchSize) ? avail : m_batchSize;
+    if (n) {
+        m_source.get(m_data.data(), n, n);
+    }
+    return n;
+}
+/**
+ * sendBatch
+ *    Send the data just gotten from the ring as a batch, compressed if
+ *    that was asked for and it helps.
+ *
+ * @param nBytes - size of the data.
+ */
+void
+CRingHoistSender::sendBatch(size_t nBytes)
+{
+    Batch* pBatch = new Batch;
+    RingHoist::BatchHeader& h(pBatch->s_header);
+    h.s_magic       = RingHoist::BATCH_MAGIC;
+    h.s_compression = RingHoist::NONE;
+    h.s_dataSize    = nBytes;
+    h.s_offset      = m_offset;
+
+    if (m_compression == RingHoist::ZLIB) {
+        RingHoist::compress(m_data.data(), nBytes, pBatch->s_wire);
+        if (pBatch->s_wire.size() < nBytes) {
+            h.s_compression = RingHoist::ZLIB;
+        }
+    }
+    if (h.s_compression == RingHoist::NONE) {
+        pBatch->s_wire.assign(m_data.data(), m_data.data() + nBytes);
+    }
+    h.s_wireSize = pBatch->s_wire.size();
+
+    m_unacked.push_back(pBatch);
+    m_offset += nBytes;
+    m_credits--;
+    m_stats.s_batches++;
+    m_stats.s_bytes     += nBytes;
+    m_stats.s_wireBytes += h.s_wireSize + sizeof(h);
+
+    writeBatch(pBatch);
+}
+/**
+ * writeBatch
+ *    Put a batch on the wire, stamping the send time.
+ */
+void
+CRingHoistSender::writeBatch(Batch* pBatch)
+{
+    pBatch->s_header.s_sendTime = RingHoist::now();
+
+    iovec parts[2];
+    parts[0].iov_base = &(pBatch->s_header);
+    parts[0].iov_len  = sizeof(RingHoist::BatchHeader);
+    parts[1].iov_base = pBatch->s_wire.data();
+    parts[1].iov_len  = pBatch->s_wire.size();
+    try {
+        io::writeDataV(m_outFd, parts, 2);
+    }
+    catch (int e) {
+        std::string msg = "Ring hoisting write failed: ";
+        msg += e ? strerror(e) : "peer closed";
+        throw std::runtime_error(msg);
+    }
+}
+/**
+ * serviceCredits
+ *    Process credits from the receiver: add them, drop the batches they
+ *    acknowledge and accumulate the latency.
+ *
+ * @param timeout - ms to wait for the first credit.
+ * @throw std::runtime_error - the receiver closed or sent garbage.
+ */
+void
+CRingHoistSender::serviceCredits(int timeout)
+{
+    pollfd p = {m_inFd, POLLIN, 0};
+    while (poll(&p, 1, timeout) > 0) {
+        RingHoist::Credit credit;
+        if (!RingHoist::readMessage(m_inFd, &credit, sizeof(credit))) {
+            throw std::runtime_error("Ring hoisting receiver closed the connection");
+        }
+        if (credit.s_magic != RingHoist::CREDIT_MAGIC) {
+            throw std::runtime_error("Ring hoisting receiver sent an invalid credit");
+        }
+        m_credits += credit.s_credits;
+        while (!m_unacked.empty()) {
+            RingHoist::BatchHeader& h(m_unacked.front()->s_header);
+            if (h.s_offset + h.s_dataSize > credit.s_ackedOffset) break;
+            delete m_unacked.front();
+            m_unacked.pop_front();
+        }
+        uint64_t latency = RingHoist::now() - credit.s_sendTime;
+        m_stats.s_latencySum += latency;
+        m_stats.s_latencyCount++;
+        if (latency > m_stats.s_maxLatency) m_stats.s_maxLatency = latency;
+
+        timeout = 0;
+    }
+}
+/**
+ * report
+ *    Report the counters to the RingMaster if it's time.
+ *
+ * @param force - report even if it's not time.
+ */
+void
+CRingHoistSender::report(bool force)
+{
+    if (!m_pMaster) return;
+
+    uint64_t t = RingHoist::now();
+    if (!m_lastReport) {
+        m_lastReport = t;
+        return;
+    }
+    uint64_t elapsed = t - m_lastReport;
+    if (!force && (elapsed < uint64_t(m_reportInterval)*1000000000ULL)) return;
+
+    double rate = 0.0;
+    if (elapsed) {
+        rate = double(m_stats.s_bytes - m_lastReportBytes)*1.0e9/elapsed;
+    }
+    try {
+        m_pMaster->reportHoistStatistics(m_ringName, m_client, m_stats, rate);
+    }
+    catch (...) {
+        std::cerr << "Lost the RingMaster; no more hoist statistics\n";
+        delete m_pMaster;
+        m_pMaster = nullptr;
+    }
+    m_lastReport      = t;
+    m_lastReportBytes = m_stats.s_bytes;
+}
+/**
+ * reply
+ *    Send a HelloReply.
+ */
+void
+CRingHoistSender::reply(uint32_t status, uint64_t offset)
+{
+    RingHoist::HelloReply r;
+    r.s_magic         = RingHoist::REPLY_MAGIC;
+    r.s_status        = status;
+    r.s_compression   = m_compression;
+    r.s_reconnectPort = m_reconnectPort;
+    r.s_session       = m_session;
+    r.s_offset        = offset;
+    RingHoist::writeMessage(m_outFd, &r, sizeof(r));
+}
+/**
+ * closeConnection
+ */
+void
+CRingHoistSender::closeConnection()
+{
+    if (m_inFd >= 0) close(m_inFd);
+    if ((m_outFd >= 0) && (m_outFd != m_inFd)) close(m_outFd);
+    m_inFd = m_outFd = -1;
+}
@@ -0,0 +1,119 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHoistSender.h
+ *  @brief: Sending end of the bulk ring hoisting protocol.
+ */
+#ifndef CRINGHOISTSENDER_H
+#define CRINGHOISTSENDER_H
+
+#include "CRingHoist.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <deque>
+#include <string>
+
+class CRingBuffer;
+class CRingMaster;
+
+/**
+ * @class CRingHoistSender
+ *    Sends the data from a ring to a CRingHoistReceiver (see CRingHoist.h
+ *    for the protocol).  This is what ringtostdout --bulk runs.
+ *
+ *    Data are taken from the ring in batches of up to the batch size.  A
+ *    partial batch goes out once the oldest data in it have waited the
+ *    maximum latency.  Batches are only sent with credits from the
+ *    receiver and are kept until acknowledged so they can be resent if
+ *    the receiver reconnects.
+ *
+ *    If the connection drops, the sender waits up to the reconnect timeout
+ *    for the receiver to reconnect to its reconnect port.  In the meantime
+ *    our consumer slot holds the unsent data in the ring.
+ *
+ *    Counters for the hop can be reported periodically to the local
+ *    RingMaster (see setReporting).
+ */
+class CRingHoistSender
+{
+private:
+    typedef struct _Batch {
+        RingHoist::BatchHeader s_header;
+        std::vector<uint8_t>   s_wire;
+    } Batch;
+
+    CRingBuffer&          m_source;
+    int                   m_inFd;
+    int                   m_outFd;
+    int                   m_listenFd;
+    uint32_t              m_reconnectPort;
+    size_t                m_batchSize;
+    unsigned              m_maxLatency;          // ms.
+    unsigned              m_reconnectTimeout;    // s.
+
+    uint64_t              m_session;
+    uint32_t              m_compression;
+    uint32_t              m_credits;
+    uint64_t              m_offset;              // Next stream byte.
+    std::deque<Batch*>    m_unacked;
+    std::vector<uint8_t>  m_data;
+
+    RingHoist::Statistics m_stats;
+    CRingMaster*          m_pMaster;
+    std::string           m_ringName;
+    std::string           m_client;
+    unsigned              m_reportInterval;      // s.
+    uint64_t              m_lastReport;          // ns.
+    uint64_t              m_lastReportBytes;
+
+public:
+    CRingHoistSender(CRingBuffer& source, int inFd, int outFd, size_t batchSize);
+    virtual ~CRingHoistSender();
+
+private:
+    CRingHoistSender(const CRingHoistSender&);
+    CRingHoistSender& operator=(const CRingHoistSender&);
+
+public:
+    void setMaxLatency(unsigned ms) { m_maxLatency = ms; }
+    void setReconnectTimeout(unsigned seconds) { m_reconnectTimeout = seconds; }
+    void setReporting(std::string ring, std::string client, unsigned interval);
+
+    bool handshake();
+    void operator()();
+
+    const RingHoist::Statistics& getStatistics() const { return m_stats; }
+    uint64_t getOffset() const { return m_offset; }
+
+protected:
+    virtual int awaitReconnect();
+
+private:
+    void   sendLoop();
+    bool   reconnect();
+    void   makeListener();
+    size_t fillBatch();
+    void   sendBatch(size_t nBytes);
+    void   writeBatch(Batch* pBatch);
+    void   serviceCredits(int timeout);
+    void   report(bool force);
+    void   reply(uint32_t status, uint64_t offset);
+    void   closeConnection();
+};
+
+#endif
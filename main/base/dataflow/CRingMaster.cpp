@@ -37,6 +37,7 @@
 
 
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
@@ -290,6 +291,100 @@ CRingMaster::requestData(string ringname)
   }
  
 }
+/*!
+  Request that data from a ring be sent to us with the bulk hoisting
+  protocol (see CRingHoist.h).  As for requestData, on success this object
+  becomes a data connection and the socket, which carries the protocol in
+  both directions, is returned.
+
+  \param ringname - name of the ring in the remote host.
+  \return int - the socket.
+  \throw std::string - the RingMaster refused (e.g. no such ring, or an
+                       older RingMaster that does not know REMOTEBULK).
+*/
+int
+CRingMaster::requestBulkData(string ringname)
+{
+  transactionOk();
+
+  string message;
+  message += "REMOTEBULK ";
+  message += ringname;
+  message += "\n";
+  sendLine(message);
+  string reply  = getLine();
+
+  if (reply == "OK BULK FOLLOWS\r\n") {
+    m_isDataConnection = true;
+    return m_socket;
+  } 
+  else {
+    string exception;
+    exception += "On bulk data request, expected reply OK got : ";
+    exception += reply;
+    throw exception;
+  }
+}
+/**
+ * reportHoistStatistics
+ *    Bulk hoisters report the counters for their hop to their RingMaster.
+ *    The RingMaster keeps the last report until this connection closes.
+ *
+ * @param ringname       - ring being hoisted.
+ * @param client         - host the data go to.
+ * @param stats          - the hop's counters.
+ * @param bytesPerSecond - ring data rate since the last report.
+ */
+void
+CRingMaster::reportHoistStatistics(
+  std::string ringname, std::string client,
+  const RingHoist::Statistics& stats, double bytesPerSecond
+)
+{
+  transactionOk();
+  if (!m_isLocal) {
+    errno = ENOTSUP;
+    throw CErrnoException("CRingMaster hoist statistics nonlocal");
+  }
+  uint64_t meanLatency = 0;
+  if (stats.s_latencyCount) {
+    meanLatency = stats.s_latencySum/stats.s_latencyCount;
+  }
+  std::stringstream message;
+  message << "HOISTSTATS " << ringname << " " << client << " "
+          << stats.s_bytes << " " << stats.s_wireBytes << " "
+          << stats.s_batches << " " << meanLatency/1000 << " "
+          << stats.s_maxLatency/1000 << " " << uint64_t(bytesPerSecond) << " "
+          << stats.s_reconnects << "\n";
+  simpleTransaction(message.str());
+}
+/**
+ * requestHoistStatistics
+ *    Get the counters of the bulk hoisters sending data from this
+ *    RingMaster's host.
+ *
+ * @return std::string - A Tcl list with one element per hoister.  Each is a
+ *                       list of the ring name, the client host, ring bytes
+ *                       sent, bytes on the wire, batches sent, mean and
+ *                       maximum batch latency in microseconds, the ring
+ *                       data rate in bytes/sec and the number of reconnects.
+ * @throws std::string - error message on problems.
+ */
+std::string
+CRingMaster::requestHoistStatistics()
+{
+    transactionOk();
+    std::string message = "HOISTERS\n";
+    sendLine(message);
+    
+    std::string ok = getLine();
+    if(ok != "OK\r\n") {
+        std::string msg = "HOISTERS command did not return OK but: ";
+        msg += ok;
+        throw msg;
+    }
+    return getLine();
+}
 /**
  * requestUsage
  *    Return the usage string.  This is the output of the LIST command to the
@@ -18,6 +18,7 @@
 
 
 #include <string>
+#include "CRingHoist.h"
 
 // Forward class definitions.
 
@@ -67,6 +68,12 @@ public:
   void notifyCreate(std::string ringname);
   void notifyDestroy(std::string ringname);
   int  requestData(std::string ringname);
+  int  requestBulkData(std::string ringname);
+  void reportHoistStatistics(
+    std::string ringname, std::string client,
+    const RingHoist::Statistics& stats, double bytesPerSecond
+  );
+  std::string requestHoistStatistics();
   std::string requestUsage();
   
   // Utilities:
@@ -24,6 +24,22 @@
 
 #include <stdlib.h>
 
+/*
+ * Predicate that's true while there are fewer than the required number
+ * of bytes in the ring.  Using blockWhile lets notifying rings wake us as
+ * soon as the producer puts rather than polling.
+ */
+class CZCopyNeedData : public CRingBuffer::CRingBufferPredicate
+{
+private:
+    size_t m_required;
+public:
+    CZCopyNeedData(size_t required) : m_required(required) {}
+    virtual bool operator()(CRingBuffer& ring) {
+        return ring.availableData() < m_required;
+    }
+};
+
 /**
  * constructor.
  *   @param pRing -the ring buffer we'll be encapsulating.
@@ -45,6 +61,8 @@ CZCopyRingBuffer::~CZCopyRingBuffer()
  *    - Block until that much data is available in the ring buffer.
  *    - If the data doesn't wrap  just return a pointer into the ring.
  *      Otherwise, copy the data locally and return a pointer to it.
+ *      Data never wrap in mirrored rings (see CRingBuffer::wouldWrap) so
+ *      for those rings there's never a copy.
  *
  * @param size - Number of bytes desired.
  */
@@ -52,7 +70,8 @@ void*
 CZCopyRingBuffer::get(size_t nBytes)
 {
     void* pResult;
-    while (m_pRing->availableData() < nBytes) usleep(100); // Make this settable?
+    CZCopyNeedData needData(nBytes);
+    m_pRing->blockWhile(needData);
     
     if (m_pRing->wouldWrap(nBytes)) {
         if (m_nLocalDataSize < nBytes) {
@@ -77,4 +96,4 @@ CZCopyRingBuffer::done()
 {
     m_pRing->skip(m_nLastSize);
     m_nLastSize = 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
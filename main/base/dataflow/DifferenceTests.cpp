@@ -53,7 +53,9 @@ public:
     m_pRing   = (pRingBuffer)mapRingBuffer(SHM_TESTFILE.c_str());
     m_pHeader = reinterpret_cast<pRingHeader>(m_pRing);
     m_pPut    = &(m_pRing->s_producer);
-    m_pGet    = m_pRing->s_consumers;
+    m_pGet    = reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(m_pRing) + m_pRing->s_header.s_firstConsumer
+    );
 
   }
   void tearDown() {
@@ -25,6 +25,7 @@ class InfoTests : public CppUnit::TestFixture {
   CPPUNIT_TEST(usageempty);
   CPPUNIT_TEST(usage1consumer);
   CPPUNIT_TEST(usageconsumers);
+  CPPUNIT_TEST(livemap);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -47,6 +48,7 @@ protected:
   void usageempty();
   void usage1consumer();
   void usageconsumers();
+  void livemap();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(InfoTests);
@@ -171,3 +173,37 @@ void InfoTests::usageconsumers()
   EQ(sizeof(msg) - sizeof(msg)/4, use.s_maxGetSpace);
   EQ((size_t)0,                   use.s_minGetSpace);
 }
+
+// The client map should track which consumer slots are live and the
+// put space should only be limited by live consumers.
+
+void InfoTests::livemap()
+{
+  CRingBuffer prod(SHM_TESTFILE, CRingBuffer::producer);
+  pRingBuffer pRing = reinterpret_cast<pRingBuffer>(mapRingBuffer(SHM_TESTFILE.c_str()));
+  RingHeader& header(pRing->s_header);
+  pRingClientMap pMap = reinterpret_cast<pRingClientMap>(
+    reinterpret_cast<char*>(pRing) + header.s_notifyOffset + sizeof(RingNotification)
+  );
+  EQ((uint32_t)0, (uint32_t)pMap->s_liveCount);
+  EQ((uint64_t)0, (uint64_t)pMap->s_liveMap[0]);
+
+  char msg[100];
+  CRingBuffer* c1 = new CRingBuffer(SHM_TESTFILE);
+  CRingBuffer  c2(SHM_TESTFILE);
+  EQ((uint32_t)2, (uint32_t)pMap->s_liveCount);
+  EQ((uint64_t)3, (uint64_t)pMap->s_liveMap[0]);
+
+  prod.put(msg, sizeof(msg));
+  c2.get(msg, sizeof(msg));
+  EQ(header.s_dataBytes - sizeof(msg) - 1, prod.availablePutSpace());
+
+  // Once c1 leaves, nobody holds data back:
+
+  delete c1;
+  EQ((uint32_t)1, (uint32_t)pMap->s_liveCount);
+  EQ((uint64_t)2, (uint64_t)pMap->s_liveMap[0]);
+  EQ(header.s_dataBytes - 1, prod.availablePutSpace());
+
+  munmap(pRing, header.s_topOffset+1);
+}
@@ -48,6 +48,14 @@ exec tclsh ${0} ${@}
 #     Reports the deletion of an existing ring.
 #  REMOTE ring
 #     Requests ring from the data to be hoisted via a socket.
+#  REMOTEBULK ring
+#     Same as REMOTE but the data are hoisted with the bulk protocol
+#     (batches, credits, optional compression and resume).  See CRingHoist.h
+#  HOISTSTATS ring client bytes wirebytes batches meanlat maxlat rate reconnects
+#     A bulk hoister reports the counters for its hop.  The last report is kept
+#     until the hoister's connection closes.  Localhost only.
+#  HOISTERS
+#     Lists the counters of the bulk hoisters.
 #
 #  On success, CONNECT and DISCONNECT reply with
 #    "OK\n"
@@ -55,6 +63,8 @@ exec tclsh ${0} ${@}
 #  LIST replies with
 #     "OK\n"
 #  Followed by ring usage as described later.
+#  HOISTERS replies with "OK\n" followed by a list with an element per
+#  hoister, each the ring and client followed by the counters of HOISTSTATS.
 #
 #
 #   CONNECT and DISCONNECT are only allowed on sockets that are connected from localhost.
@@ -113,6 +123,7 @@ set localhost   [list "127.0.0.1" "::1"];		# IP address of localhost connections
 set knownRings  [list];			# Registered rings.
 
 array set ::RingUsage [list]
+array set ::HoistStats [list];		# Last counters from each bulk hoister.
 
 set rotateTime  [expr {60*60*24}];   #rotate time seconds.
 
@@ -230,6 +241,91 @@ proc RemoteHoist {socket client tail} {
     }
 
 
+}
+#-------------------------------------------------------------------------------
+#
+# Same as RemoteHoist but for REMOTEBULK ringname.  The hoister runs the bulk
+# protocol so it needs the socket as both stdin and stdout.
+#
+# Parameters:
+#   socket    - The socket requesting remote access to the ring data.
+#   client    - The IP address of the client.
+#   tail      - The command.. should look like REMOTEBULK ringname.
+#
+proc RemoteBulkHoist {socket client tail} {
+    emitLogMsg debug "RemoteBulkHoist $socket $client '$tail'"
+    emitLogMsg info "REMOTEBULK request from $client"
+
+    if {[llength $tail] != 2} {
+	emitLogMsg error "'$tail' is not a valid request"
+	puts $socket "ERROR Invalid message format"
+	releaseResources $socket $client
+	return
+    }
+    set ringname [lindex $tail 1]
+    if {[lsearch -exact $::knownRings $ringname] == -1} {
+	set msg "$ringname is not a known ringbuffer. "
+	append msg "bulk feeder pipeline cannot be started."
+	emitLogMsg error $msg
+	puts $socket "ERROR $ringname does not exist"
+    } else {
+	puts $socket "OK BULK FOLLOWS"
+	exec -- $::hoisterProgram --bulk $ringname $client <@ $socket >@ $socket  &
+	releaseResources $socket $client
+	emitLogMsg info "bulk feeder pipeline started to send data from local ring(=$ringname) to host(=$client)"
+    }
+}
+#-------------------------------------------------------------------------------
+#
+# Record the counters a bulk hoister reports for its hop:
+#   HOISTSTATS ring client bytes wirebytes batches meanlat maxlat rate reconnects
+#
+# Parameters:
+#   socket    - The hoister's connection.
+#   client    - The IP address of the hoister (must be local).
+#   message   - The full message.
+#
+proc HoistStats {socket client message} {
+    emitLogMsg debug "HoistStats $socket $client '$message'"
+
+    if {$client ni $::localhost} {
+	emitLogMsg error "Hoist statistics are only accepted from localhost"
+	puts $socket "ERROR Hoist statistics from remote hosts are forbidden"
+	releaseResources $socket $client
+	return
+    }
+    if {[llength $message] != 10} {
+	emitLogMsg error "'$message' is not a valid hoist statistics message"
+	puts $socket "ERROR Invalid message format"
+	releaseResources $socket $client
+	return
+    }
+    set ::HoistStats($socket) [lrange $message 1 end]
+    puts $socket "OK"
+}
+#-------------------------------------------------------------------------------
+#
+# Process the HOISTERS command; reply OK followed by the last statistics
+# reported by each bulk hoister.
+#
+# Parameters:
+#   socket      - connection to the client.
+#   client      - host f the client.
+#   message     - Full message text.
+#
+proc Hoisters {socket client message} {
+    emitLogMsg debug "Hoisters $socket $client '$message'"
+
+    if {$message ne "HOISTERS"} {
+	releaseResources $socket $client
+	return
+    }
+    set result [list]
+    foreach hoister [array names ::HoistStats] {
+	lappend result $::HoistStats($hoister)
+    }
+    puts $socket "OK"
+    puts $socket $result
 }
 #------------------------------------------------------------------------------
 # Kill clients of a specified ring.  This is done when a ring is being unregistered.
@@ -492,6 +588,9 @@ proc releaseResources {socket host} {
 
     }
   }
+  if {[array names ::HoistStats $socket] ne ""} {
+    unset ::HoistStats($socket)
+  }
 
   catch {close $socket}
 }
@@ -665,6 +764,12 @@ proc onMessage {socket client} {
 	Unregister $socket $client $message
     } elseif {$command eq "REMOTE"} {
 	RemoteHoist $socket $client $message
+    } elseif {$command eq "REMOTEBULK"} {
+	RemoteBulkHoist $socket $client $message
+    } elseif {$command eq "HOISTSTATS"} {
+	HoistStats $socket $client $message
+    } elseif {$command eq "HOISTERS"} {
+	Hoisters $socket $client $message
     } elseif {$command eq "DEBUG"} {
 	# Enable/disable debug logging.
 	set state [lindex $message 1]
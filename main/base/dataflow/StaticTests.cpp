@@ -26,6 +26,27 @@ static std::string SHM_TESTFILE;
 
 
 
+// Expected layout of the front of a current (padded) ring:
+
+static size_t cacheLines(size_t n)
+{
+  return ((n + RING_CACHELINE - 1)/RING_CACHELINE)*RING_CACHELINE;
+}
+static size_t firstConsumerAt()
+{
+  return cacheLines(sizeof(RingHeader) + sizeof(ClientInformation));
+}
+static size_t notifyAt(size_t ncons)
+{
+  return firstConsumerAt() + ncons*cacheLines(sizeof(ClientInformation));
+}
+static size_t dataAt(size_t ncons)
+{
+  size_t mapWords = (ncons + 63)/64;
+  return notifyAt(ncons) + sizeof(RingNotification) +
+    cacheLines(sizeof(RingClientMap) + (mapWords-1)*sizeof(uint64_t));
+}
+
 static string getFullName()
 {
   string fullname(SHM_DIRECTORY);
@@ -39,6 +60,7 @@ class StaticRingTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(defaults);
   CPPUNIT_TEST(create);
   CPPUNIT_TEST(format);
+  CPPUNIT_TEST(mirroredformat);
   CPPUNIT_TEST(remove);
   CPPUNIT_TEST(isring);
   CPPUNIT_TEST(ringname);
@@ -75,6 +97,7 @@ protected:
   void defaults();
   void create();
   void format();
+  void mirroredformat();
   void remove();
   void isring();
   void ringname();
@@ -123,8 +146,8 @@ void StaticRingTest::create() {
 
 
   size_t data = CRingBuffer::getDefaultRingSize();
-  size_t ncons= CRingBuffer::getDefaultMaxConsumers() + 1; // (+1 for the producer).
-  off_t  total= data + ncons*sizeof(ClientInformation) + sizeof(RingHeader);
+  size_t ncons= CRingBuffer::getDefaultMaxConsumers();
+  off_t  total= data + dataAt(ncons);
 
   // Align to pagesize:
 
@@ -161,7 +184,9 @@ void StaticRingTest::format()
   pRingBuffer        pRing         = reinterpret_cast<pRingBuffer>(map);
   pRingHeader        pHeader       = &(pRing->s_header);
   pClientInformation pProducer     = &(pRing->s_producer);
-  pClientInformation pConsumers    = (pRing->s_consumers);
+  pClientInformation pConsumers    = reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(pRing) + pRing->s_header.s_firstConsumer
+    );
 
   // Verify the header fields :
 
@@ -169,9 +194,17 @@ void StaticRingTest::format()
 
   EQ(CRingBuffer::getDefaultMaxConsumers(), max);
   EQ(sizeof(RingHeader), (size_t)pHeader->s_producerInfo);
-  EQ(sizeof(RingHeader)+sizeof(ClientInformation), (size_t)pHeader->s_firstConsumer);
-  EQ(sizeof(RingHeader) + (pHeader->s_maxConsumer+1)*sizeof(ClientInformation),
-     (size_t)pHeader->s_dataOffset);
+  EQ(firstConsumerAt(), (size_t)pHeader->s_firstConsumer);
+  EQ(notifyAt(max), (size_t)pHeader->s_notifyOffset);
+  EQ(dataAt(max), (size_t)pHeader->s_dataOffset);
+  EQ(string(VERSIONEDMAGICSTRING), string(pHeader->s_magicString));
+  EQ((uint32_t)RING_VERSION_CURRENT, (uint32_t)pHeader->s_version);
+
+  pRingClientMap pMap = reinterpret_cast<pRingClientMap>(
+    reinterpret_cast<char*>(pRing) + pHeader->s_notifyOffset + sizeof(RingNotification)
+  );
+  EQ((uint32_t)cacheLines(sizeof(ClientInformation)), (uint32_t)pMap->s_slotStride);
+  EQ((uint32_t)0, (uint32_t)pMap->s_liveCount);
   EQ(buf.st_size - pHeader->s_dataOffset, (long int)pHeader->s_dataBytes);
   off_t topoff = pHeader->s_topOffset;
   EQ(buf.st_size -1, topoff);
@@ -181,6 +214,35 @@ void StaticRingTest::format()
   
   
 }
+// Mirrored rings have a page aligned data segment of whole pages and
+// say they're mirrored in the flags:
+
+void StaticRingTest::mirroredformat()
+{
+  CRingBuffer::create(string(SHM_TESTFILE), 100000,
+                      CRingBuffer::getDefaultMaxConsumers(), false, true);
+  struct stat buf;
+  if(stat(getFullName().c_str(), &buf) == -1) {
+    FAIL("stat failed");
+  }
+  void* map = mapRingBuffer(SHM_TESTFILE.c_str());
+  pRingHeader pHeader = &(reinterpret_cast<pRingBuffer>(map)->s_header);
+  long pagesize       = sysconf(_SC_PAGESIZE);
+  size_t dataOffset   = pHeader->s_dataOffset;
+  size_t dataBytes    = pHeader->s_dataBytes;
+
+  EQ((uint32_t)RING_FLAG_MIRRORED, (uint32_t)pHeader->s_flags);
+  EQ((size_t)0, dataOffset % pagesize);
+  EQ((size_t)0, dataBytes  % pagesize);
+  ASSERT(dataOffset >= dataAt(pHeader->s_maxConsumer));
+  ASSERT(dataBytes  >= 100000);
+  EQ(buf.st_size - 1, (long int)pHeader->s_topOffset);
+
+  munmap(map, buf.st_size);
+
+  CRingBuffer ring(SHM_TESTFILE, CRingBuffer::consumer);
+  ASSERT(ring.isMirrored());
+}
 
 
 // Remove function
@@ -5,6 +5,8 @@
 #include "Asserts.h"
 #include <CRingBuffer.h>
 #include <ringbufint.h>
+#include <RangeError.h>
+#include <StateException.h>
 #include <string>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -42,6 +44,10 @@ class XferTests : public CppUnit::TestFixture {
   CPPUNIT_TEST(wrapget);
   CPPUNIT_TEST(edgewrapget);
   CPPUNIT_TEST(multi);
+  CPPUNIT_TEST(reserveinplace);
+  CPPUNIT_TEST(reservewrap);
+  CPPUNIT_TEST(commitrange);
+  CPPUNIT_TEST(mirrored);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -68,6 +74,10 @@ protected:
   void wrapget();
   void edgewrapget();
   void multi();
+  void reserveinplace();
+  void reservewrap();
+  void commitrange();
+  void mirrored();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(XferTests);
@@ -234,7 +244,9 @@ void XferTests::simpleget()
   // We should be the first consumer as there are no consumers and the
   // search strategy is linear:
 
-  pClientInformation pGet = pBuffer->s_consumers;
+  pClientInformation pGet = reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(pBuffer) + pBuffer->s_header.s_firstConsumer
+    );
   pid_t pid = getpid();
   pid_t cpid = pGet->s_pid;
   EQ(pid, cpid);
@@ -281,7 +293,9 @@ void XferTests::wrapget()
   // We should be the first consumer as there are no consumers and the
   // search strategy is linear:
 
-  pClientInformation pGet = pBuffer->s_consumers;
+  pClientInformation pGet = reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(pBuffer) + pBuffer->s_header.s_firstConsumer
+    );
 
   // Create the messages:
 
@@ -319,7 +333,9 @@ void XferTests::edgewrapget()
 
   pRingBuffer        pBuffer = reinterpret_cast<pRingBuffer>(mapRingBuffer(SHM_TESTFILE.c_str()));
   pClientInformation pPut    = &(pBuffer->s_producer);
-  pClientInformation pGet    =  pBuffer->s_consumers;
+  pClientInformation pGet    =  reinterpret_cast<pClientInformation>(
+      reinterpret_cast<char*>(pBuffer) + pBuffer->s_header.s_firstConsumer
+    );
   pRingHeader pHeader = &(pBuffer->s_header);
 
 
@@ -397,3 +413,135 @@ void XferTests::multi()
   
 }
 
+// A reservation that does not wrap is directly in the ring, and
+// nothing is visible to the consumer until the commit.
+//
+void XferTests::reserveinplace()
+{
+  CRingBuffer xmit(string(SHM_TESTFILE), CRingBuffer::producer);
+  CRingBuffer recv(string(SHM_TESTFILE), CRingBuffer::consumer);
+
+  char* p = static_cast<char*>(xmit.reserve(100));
+  EQ(xmit.getPointer(), static_cast<void*>(p));
+  for (int i=0; i < 100; i++) {
+    p[i] = i;
+  }
+  EQ((size_t)0, recv.availableData());
+
+  EQ((size_t)50, xmit.commit(50));    // Can commit less than reserved.
+  EQ((size_t)50, recv.availableData());
+
+  char got[50];
+  recv.get(got, sizeof(got), sizeof(got), 0);
+  for (int i = 0; i < sizeof(got); i++) {
+    EQ(i, (int)got[i]);
+  }
+}
+// A reservation that would wrap is in the scratch area and commit
+// copies it into the ring, wrapping as a put would.
+//
+void XferTests::reservewrap()
+{
+  CRingBuffer ring(string(SHM_TESTFILE), CRingBuffer::producer);
+
+  pRingBuffer        pBuffer = reinterpret_cast<pRingBuffer>(mapRingBuffer(SHM_TESTFILE.c_str()));
+  pClientInformation pPut    = &(pBuffer->s_producer);
+  pRingHeader        pHeader = &(pBuffer->s_header);
+
+  off_t startOffset = pHeader->s_topOffset - 50;
+  pPut->s_offset    = startOffset;
+
+  char* p = static_cast<char*>(ring.reserve(100));
+  ASSERT(p != ring.getPointer());
+  for (int i = 0; i < 100; i++) {
+    p[i] = i;
+  }
+  ring.commit(100);
+
+  off_t shouldBe = pHeader->s_dataOffset + 100 - 51;
+  EQ(shouldBe, pPut->s_offset);
+
+  char* pRing = reinterpret_cast<char*>(pBuffer);
+  for (int i = 0; i < 51; i++) {
+    EQ(i, (int)pRing[startOffset + i]);
+  }
+  for (int i = 51; i < 100; i++) {
+    EQ(i, (int)pRing[pHeader->s_dataOffset + i - 51]);
+  }
+
+  munmap(pBuffer, pBuffer->s_header.s_topOffset+1);
+}
+// Commits must be backed by a reservation and consumers can't reserve.
+//
+void XferTests::commitrange()
+{
+  CRingBuffer xmit(string(SHM_TESTFILE), CRingBuffer::producer);
+  CRingBuffer recv(string(SHM_TESTFILE), CRingBuffer::consumer);
+
+  bool thrown = false;
+  try {
+    xmit.commit(1);                     // No reservation.
+  }
+  catch (CRangeError& e) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+
+  xmit.reserve(10);
+  thrown = false;
+  try {
+    xmit.commit(11);
+  }
+  catch (CRangeError& e) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  EQ((size_t)10, xmit.commit(10));
+
+  thrown = false;
+  try {
+    recv.reserve(10);
+  }
+  catch (CStateException& e) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+}
+// In a mirrored ring, data that wraps are contiguous at the get pointer
+// and reservations that wrap are directly in the ring.
+//
+void XferTests::mirrored()
+{
+  string name = SHM_TESTFILE + "m";
+  CRingBuffer::create(name, 0x10000, CRingBuffer::getDefaultMaxConsumers(),
+                      false, true);
+  {
+    CRingBuffer xmit(name, CRingBuffer::producer);
+    CRingBuffer recv(name, CRingBuffer::consumer);
+    ASSERT(xmit.isMirrored());
+
+    // Push both pointers up near the top:
+
+    size_t toTop = xmit.bytesToTop();
+    xmit.skip(toTop - 50);
+    recv.skip(toTop - 50);
+
+    char* p = static_cast<char*>(xmit.reserve(100));
+    EQ(xmit.getPointer(), static_cast<void*>(p));
+    for (int i = 0; i < 100; i++) {
+      p[i] = i;
+    }
+    xmit.commit(100);
+    EQ((size_t)100, recv.availableData());
+
+    ASSERT(!recv.wouldWrap(100));
+    char* pGet = static_cast<char*>(recv.getPointer());
+    for (int i = 0; i < 100; i++) {
+      EQ(i, (int)pGet[i]);
+    }
+    char got[100];
+    EQ(sizeof(got), recv.get(got, sizeof(got), sizeof(got), 0));
+    EQ(0, memcmp(got, pGet, sizeof(got)));
+  }
+  CRingBuffer::remove(name);
+}
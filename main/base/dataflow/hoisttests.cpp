@@ -0,0 +1,380 @@
+// Tests for the bulk ring hoisting protocol.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include <CRingBuffer.h>
+
+#include "testcommon.h"
+#include "CRingHoist.h"
+#include "CRingHoistSender.h"
+#include "CRingHoistReceiver.h"
+#include "stdintoringUtils.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+// Make nItems ring items with a recognizable pattern.
+
+static void
+makeItems(vector<uint8_t>& data, unsigned nItems)
+{
+  data.clear();
+  for (unsigned i = 0; i < nItems; i++) {
+    header h;
+    h.s_size = sizeof(header) + 8 + (i % 57);
+    h.s_type = 30;
+    uint8_t* p = reinterpret_cast<uint8_t*>(&h);
+    data.insert(data.end(), p, p + sizeof(h));
+    for (unsigned b = sizeof(h); b < h.s_size; b++) {
+      data.push_back(uint8_t(i + b));
+    }
+  }
+}
+// Make a loopback TCP connection; the sender needs a real socket to
+// listen for reconnects.
+
+static void
+connectedPair(int& sender, int& receiver)
+{
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(listener, reinterpret_cast<sockaddr*>(&addr), len) ||
+      listen(listener, 1) ||
+      getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len)) {
+    throw runtime_error("Unable to make a test listener");
+  }
+  receiver = socket(AF_INET, SOCK_STREAM, 0);
+  if (connect(receiver, reinterpret_cast<sockaddr*>(&addr), len)) {
+    throw runtime_error("Unable to connect to the test listener");
+  }
+  sender = accept(listener, nullptr, nullptr);
+  close(listener);
+}
+// Get nBytes from a ring, giving up after a few seconds.
+
+static size_t
+drain(CRingBuffer& ring, vector<uint8_t>& data, size_t nBytes)
+{
+  data.resize(nBytes);
+  size_t n = 0;
+  time_t giveUp = time(nullptr) + 10;
+  while ((n < nBytes) && (time(nullptr) < giveUp)) {
+    n += ring.get(data.data() + n, nBytes - n, 1, 1);
+  }
+  return n;
+}
+
+// Sender that only allows a fixed number of reconnects:
+
+class TestSender : public CRingHoistSender
+{
+public:
+  int m_reconnects;
+  TestSender(CRingBuffer& source, int fd, size_t batchSize, int reconnects) :
+    CRingHoistSender(source, fd, fd, batchSize), m_reconnects(reconnects)
+  {}
+protected:
+  virtual int awaitReconnect() {
+    if (m_reconnects <= 0) return -1;
+    m_reconnects--;
+    return CRingHoistSender::awaitReconnect();
+  }
+};
+// Receiver that lets the test see its current socket:
+
+class TestReceiver : public CRingHoistReceiver
+{
+public:
+  std::atomic<int> m_fd;
+  TestReceiver(CRingBuffer& ring, int fd, unsigned credits, bool compress) :
+    CRingHoistReceiver(ring, fd, credits, compress), m_fd(fd)
+  {}
+protected:
+  virtual int reconnect() {
+    int fd = CRingHoistReceiver::reconnect();
+    if (fd >= 0) m_fd = fd;
+    return fd;
+  }
+};
+
+// Runs a sender to completion in a thread:
+
+static void
+runSender(
+  CRingBuffer* pSource, int fd, size_t batchSize, int reconnects,
+  bool* pShook, RingHoist::Statistics* pStats
+)
+{
+  TestSender sender(*pSource, fd, batchSize, reconnects);
+  sender.setReconnectTimeout(2);
+  sender.setMaxLatency(1);
+  *pShook = sender.handshake();
+  if (*pShook) sender();
+  *pStats = sender.getStatistics();
+}
+
+class hoistTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(hoistTest);
+  CPPUNIT_TEST(compress_1);
+  CPPUNIT_TEST(compress_2);
+  CPPUNIT_TEST(transfer_1);
+  CPPUNIT_TEST(transfer_2);
+  CPPUNIT_TEST(putlimit_1);
+  CPPUNIT_TEST(resume_1);
+  CPPUNIT_TEST(badbatch_1);
+  CPPUNIT_TEST(badbatch_2);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  CRingBuffer* m_pProducer;
+  CRingBuffer* m_pSource;
+  CRingBuffer* m_pProxy;
+  CRingBuffer* m_pConsumer;
+public:
+  void setUp() {
+    signal(SIGPIPE, SIG_IGN);             // As ringtostdout does.
+    m_pProducer = CRingBuffer::createAndProduce(uniqueRing("hoistsrc"));
+    m_pSource   = new CRingBuffer(uniqueRing("hoistsrc"));
+    m_pProxy    = CRingBuffer::createAndProduce(uniqueRing("hoistproxy"));
+    m_pConsumer = new CRingBuffer(uniqueRing("hoistproxy"));
+  }
+  void tearDown() {
+    delete m_pProducer;
+    delete m_pSource;
+    delete m_pProxy;
+    delete m_pConsumer;
+    CRingBuffer::remove(uniqueRing("hoistsrc"));
+    CRingBuffer::remove(uniqueRing("hoistproxy"));
+  }
+protected:
+  void compress_1();
+  void compress_2();
+  void transfer_1();
+  void transfer_2();
+  void putlimit_1();
+  void resume_1();
+  void badbatch_1();
+  void badbatch_2();
+private:
+  void transfer(bool compress);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(hoistTest);
+
+// Send a raw, uncompressed batch to a receiver as a sender would.
+
+static void
+sendBatch(int fd, const void* pData, uint32_t nBytes, uint32_t dataSize)
+{
+  RingHoist::BatchHeader h;
+  h.s_magic       = RingHoist::BATCH_MAGIC;
+  h.s_compression = RingHoist::NONE;
+  h.s_wireSize    = nBytes;
+  h.s_dataSize    = dataSize;
+  h.s_offset      = 0;
+  h.s_sendTime    = RingHoist::now();
+  RingHoist::writeMessage(fd, &h, sizeof(h));
+  if (nBytes) RingHoist::writeMessage(fd, pData, nBytes);
+}
+
+// Compression round trips.
+
+void hoistTest::compress_1()
+{
+  vector<uint8_t> data;
+  makeItems(data, 500);
+  vector<uint8_t> wire;
+  RingHoist::compress(data.data(), data.size(), wire);
+  ASSERT(wire.size() < data.size());
+
+  vector<uint8_t> out(data.size());
+  RingHoist::decompress(wire.data(), wire.size(), out.data(), out.size());
+  ASSERT(out == data);
+}
+// A corrupt (or wrong size) batch is an error.
+
+void hoistTest::compress_2()
+{
+  vector<uint8_t> data;
+  makeItems(data, 100);
+  vector<uint8_t> wire;
+  RingHoist::compress(data.data(), data.size(), wire);
+
+  vector<uint8_t> out(data.size() + 1);
+  EXCEPTION(
+    RingHoist::decompress(wire.data(), wire.size(), out.data(), out.size()),
+    std::runtime_error&
+  );
+  wire[wire.size()/2] ^= 0xff;
+  out.resize(data.size());
+  EXCEPTION(
+    RingHoist::decompress(wire.data(), wire.size(), out.data(), out.size()),
+    std::runtime_error&
+  );
+}
+
+// Hoist a bunch of items from the source ring to the proxy ring.
+
+void hoistTest::transfer(bool compress)
+{
+  vector<uint8_t> data;
+  makeItems(data, 1000);
+  m_pProducer->put(data.data(), data.size());
+
+  int senderFd, receiverFd;
+  connectedPair(senderFd, receiverFd);
+  bool shook(false);
+  RingHoist::Statistics stats;
+  std::thread sender(
+    runSender, m_pSource, senderFd, 4096, 0, &shook, &stats
+  );
+  {
+    CRingHoistReceiver receiver(*m_pProxy, receiverFd, 2, compress);
+    receiver.setReconnectTimeout(0);
+    ASSERT(receiver.handshake());
+    EQ(compress, receiver.isCompressed());
+    while (receiver.getOffset() < data.size()) {
+      ASSERT(receiver.receiveBatch());
+    }
+    EQ(uint64_t(data.size()), receiver.getOffset());
+    close(receiverFd);
+  }
+  sender.join();
+  ASSERT(shook);
+
+  vector<uint8_t> got;
+  EQ(data.size(), drain(*m_pConsumer, got, data.size()));
+  ASSERT(got == data);
+
+  EQ(uint64_t(data.size()), stats.s_bytes);
+  ASSERT(stats.s_batches >= data.size()/4096);
+  ASSERT(stats.s_latencyCount > 0);
+  EQ(uint32_t(0), stats.s_reconnects);
+  if (compress) {
+    ASSERT(stats.s_wireBytes < stats.s_bytes);
+  } else {
+    ASSERT(stats.s_wireBytes > stats.s_bytes);
+  }
+}
+
+void hoistTest::transfer_1()
+{
+  transfer(false);
+}
+void hoistTest::transfer_2()
+{
+  transfer(true);
+}
+
+// putData with a put limit splits the puts on item boundaries.
+
+void hoistTest::putlimit_1()
+{
+  vector<uint8_t> data;
+  makeItems(data, 200);
+  vector<uint8_t> buffer(data);
+  buffer.resize(data.size() + 4);         // Partial header left over.
+
+  EQ(size_t(4), putData(*m_pProxy, buffer.data(), buffer.size(), 256));
+
+  vector<uint8_t> got;
+  EQ(data.size(), drain(*m_pConsumer, got, data.size()));
+  ASSERT(got == data);
+}
+
+// Drop the connection partway and make sure the receiver resumes
+// without losing or duplicating data.
+
+void hoistTest::resume_1()
+{
+  vector<uint8_t> data;
+  makeItems(data, 2000);
+  m_pProducer->put(data.data(), data.size());
+
+  int senderFd, receiverFd;
+  connectedPair(senderFd, receiverFd);
+  bool shook(false);
+  RingHoist::Statistics stats;
+  std::thread sender(
+    runSender, m_pSource, senderFd, 1024, 1, &shook, &stats
+  );
+
+  TestReceiver receiver(*m_pProxy, receiverFd, 4, false);
+  receiver.setReconnectTimeout(2);
+  ASSERT(receiver.handshake());
+  ASSERT(receiver.receiveBatch());
+  ASSERT(receiver.receiveBatch());
+  ASSERT(receiver.getOffset() < data.size());
+  shutdown(receiverFd, SHUT_RDWR);        // Simulate the network dropping.
+
+  std::thread receiving([&receiver]() { receiver(); });
+
+  vector<uint8_t> got;
+  size_t n = drain(*m_pConsumer, got, data.size());
+
+  shutdown(receiver.m_fd, SHUT_RDWR);     // Sender won't take another reconnect.
+  sender.join();
+  receiving.join();
+
+  EQ(data.size(), n);
+  ASSERT(got == data);
+  ASSERT(shook);
+  EQ(uint32_t(1), stats.s_reconnects);
+  EQ(size_t(0), m_pConsumer->availableData());
+}
+
+// A batch header claiming more than MAX_BATCH is rejected before the
+// receiver allocates for it.
+
+void hoistTest::badbatch_1()
+{
+  int fds[2];
+  ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  CRingHoistReceiver receiver(*m_pProxy, fds[1], 1, false);
+
+  sendBatch(fds[0], nullptr, 0, RingHoist::MAX_BATCH + 1);
+  CPPUNIT_ASSERT_THROW(receiver.receiveBatch(), std::runtime_error);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// An item too big for the ring is caught even when it's not the first
+// item in the batch, and nothing from the batch gets into the ring.
+
+void hoistTest::badbatch_2()
+{
+  vector<uint8_t> data;
+  makeItems(data, 2);
+  header big;
+  big.s_size = m_pProxy->maxReserve() + 1;
+  big.s_type = 30;
+  uint8_t* p = reinterpret_cast<uint8_t*>(&big);
+  data.insert(data.end(), p, p + sizeof(big));
+
+  int fds[2];
+  ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  CRingHoistReceiver receiver(*m_pProxy, fds[1], 1, false);
+
+  sendBatch(fds[0], data.data(), data.size(), data.size());
+  CPPUNIT_ASSERT_THROW(receiver.receiveBatch(), std::length_error);
+  EQ(size_t(0), m_pConsumer->availableData());
+  close(fds[0]);
+  close(fds[1]);
+}
@@ -0,0 +1,150 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2005.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+// Put throughput as a function of the number of consumers.
+// This combines the producer and consumer timing programs:
+// For each consumer count, that many consumer processes are forked off
+// (each doing what consumer does).  Once they've all attached, the producer
+// puts fixed sized blocks for a fixed time and reports the rate.
+//
+// Usage:
+//    ringbench ?ringname? ?maxconsumers? ?putsize? ?seconds?
+//
+// Defaults are "timing", 64 consumers, 1024 byte puts and 5 seconds per
+// measurement.  Consumer counts run 0, 1, 2, 4 ... maxconsumers.
+//
+#include <string>
+#include <vector>
+#include <iostream>
+#include <CRingBuffer.h>
+
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// Consumers run until SIGTERM.  They then exit normally so the ring
+// destructor gives back their slot; a killed consumer would keep its slot
+// (and hold back the producer) until a ringmaster noticed.
+
+static volatile sig_atomic_t stopConsuming(0);
+
+static void
+stopHandler(int sig)
+{
+  stopConsuming = 1;
+}
+
+// Body of a consumer process.  Never returns.
+
+static void
+consume(string ringname, size_t putSize)
+{
+  signal(SIGTERM, stopHandler);
+  {
+    CRingBuffer ring(ringname, CRingBuffer::consumer);
+    vector<char> buffer(putSize);
+    while (!stopConsuming) {
+      ring.get(buffer.data(), buffer.size(), 1, 1);
+    }
+  }
+  _exit(EXIT_SUCCESS);
+}
+
+static double
+now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
+
+int main(int argc, char** argv)
+{
+  string   ringname("timing");
+  size_t   maxConsumers = 64;
+  size_t   putSize      = 1024;
+  double   seconds      = 5.0;
+
+  if (argc > 1) ringname     = argv[1];
+  if (argc > 2) maxConsumers = strtoul(argv[2], 0, 0);
+  if (argc > 3) putSize      = strtoul(argv[3], 0, 0);
+  if (argc > 4) seconds      = strtod(argv[4], 0);
+
+  if (!CRingBuffer::isRing(ringname)) {
+    CRingBuffer::create(ringname, CRingBuffer::getDefaultRingSize(),
+                        maxConsumers < CRingBuffer::getDefaultMaxConsumers() ?
+                        CRingBuffer::getDefaultMaxConsumers() : maxConsumers);
+  }
+  CRingBuffer ring(ringname, CRingBuffer::producer);
+
+  vector<char> buffer(putSize);
+  for (int i = 0; i < buffer.size(); i++) {
+    buffer[i] = i;
+  }
+
+  cout << "consumers  puts/sec      MB/sec\n";
+  size_t nConsumers = 0;
+  while (nConsumers <= maxConsumers) {
+    vector<pid_t> children;
+    for (int i = 0; i < nConsumers; i++) {
+      pid_t pid = fork();
+      if (pid == 0) {
+        consume(ringname, putSize);
+      }
+      children.push_back(pid);
+    }
+    while (ring.getUsage().s_consumers.size() < nConsumers) {
+      usleep(1000);
+    }
+
+    // Time the puts:
+
+    double        start = now();
+    double        end   = start;
+    unsigned long puts  = 0;
+    while ((end - start) < seconds) {
+      for (int i = 0; i < 1000; i++) {
+        ring.put(buffer.data(), buffer.size());
+      }
+      puts += 1000;
+      end   = now();
+    }
+    double rate = puts/(end - start);
+    cout << nConsumers << "  " << rate << "  "
+         << rate*putSize/(1024.0*1024.0) << endl;
+
+    // Stop the consumers before the next round.  Each gives back its
+    // slot as it exits:
+
+    for (int i = 0; i < children.size(); i++) {
+      kill(children[i], SIGTERM);
+    }
+    for (int i = 0; i < children.size(); i++) {
+      waitpid(children[i], 0, 0);
+    }
+
+    nConsumers = nConsumers ? nConsumers*2 : 1;
+    if ((nConsumers > maxConsumers) && (nConsumers/2 < maxConsumers)) {
+      nConsumers = maxConsumers;
+    }
+  }
+}
+void* gpTCLApplication(0);
@@ -22,7 +22,7 @@ exec tclsh ${0} ${@}
 #   command.  The ringbuffer command is a utility that provides
 #   shell access to ring buffer management.
 #   The following syntaxes are supported:
-#    ringbuffer create ?--datasize=n? ?--maxconsumers=n?   name
+#    ringbuffer create ?--datasize=n? ?--maxconsumers=n? ?--mirrored?  name
 #    ringbuffer format ?--maxconsumers=n?                  name
 #    ringbuffer delete                                     name
 #    ringbuffer status ?--host=hostname?                  ?pattern?
@@ -34,6 +34,9 @@ exec tclsh ${0} ${@}
 #                of 1024*1024 (e.g. 100m).
 #  --maxconsumers - sets the maximum number of cnosumers that can attach
 #                to the ring at any given time.
+#  --mirrored  - Creates the ring with its data segment mapped twice, back
+#                to back, so that consumers never see data split at the
+#                top of the ring.
 #  --host      - Sets the name of the host that is the target of the
 #                query.
 #  name        - The name of a ring buffer.
@@ -93,7 +96,7 @@ set defaultHostname     localhost
 #
 proc usage {} {
     puts stderr "Usage"
-    puts stderr " ringbuffer create ?--datasize=n? ?--maxconsumers=n?   name"
+    puts stderr " ringbuffer create ?--datasize=n? ?--maxconsumers=n? ?--mirrored?  name"
     puts stderr " ringbuffer format ?--maxconsumers=n?                  name"
     puts stderr " ringbuffer delete                                     name"
     puts stderr " ringbuffer status ?--host=hostname? ?--all? ?--user=user1,..?  ?name?"
@@ -326,7 +329,8 @@ proc filterRingStats {ringList opts}  {
 proc createRing tail {
     set options [list                                           \
 		     --datasize=$::defaultDataSize              \
-		     --maxconsumers=$::defaultMaxConsumers]
+		     --maxconsumers=$::defaultMaxConsumers      \
+		     --mirrored]
 
     set tail [lrange $tail 1 end]
     array set parse [decodeArgs $tail $options]
@@ -335,7 +339,9 @@ proc createRing tail {
 	usage
 	exit -1
     }
-    ringbuffer create $parse(Parameters) [size $parse(--datasize)] $parse(--maxconsumers)
+    set mirrored [expr {$parse(--mirrored) ? 1 : 0}]
+    ringbuffer create $parse(Parameters) [size $parse(--datasize)] $parse(--maxconsumers) \
+	$mirrored
 }
 
 #--------------------------------------------------------------------------
@@ -23,6 +23,7 @@
   be installed if possible.
 */
 #include <unistd.h>
+#include <stdint.h>
 
 
 /* constants - These are defined in this way so that they
@@ -41,16 +42,57 @@
 #define DEFAULT_POLLMS 3
 #endif
 
+/*  Longest single futex wait.  Waits are broken up into chunks no longer than
+    this so that blocking timeouts (in seconds) are honored reasonably closely.
+*/
+
+#ifndef DEFAULT_NOTIFYMS
+#define DEFAULT_NOTIFYMS 1000
+#endif
+
+/* Alignment of the notification block.  Keeps the producer and consumer
+   sides of it from sharing cache lines with each other or the client info.
+*/
+
+#ifndef RING_CACHELINE
+#define RING_CACHELINE 64
+#endif
+
 /*
    The front of each ring buffer consists of a header.
    The header helps the software locate important segments of the
    buffer as well as to know how big the buffer itself is:
 */
 
-#define MAGICSTRING "NSCLRing"
+#define MAGICSTRING "NSCLRing"            /* Original, unversioned rings.     */
+#define VERSIONEDMAGICSTRING "NSCLRingV"  /* Rings that have s_version >= 1.  */
+
+/*
+   Ring layout versions.  Rings made by software that predates versioning
+   have MAGICSTRING and zeroes in s_version/s_notifyOffset.  They are serviced
+   by polling.  Versioned rings use a different magic string so that older
+   software refuses them rather than misinterpreting the layout.
+*/
+
+#define RING_VERSION_LEGACY  0	/* Polled blocking only.                   */
+#define RING_VERSION_NOTIFY  1	/* Adds the RingNotification block.         */
+#define RING_VERSION_PADDED  2	/* Cache line consumer slots + RingClientMap */
+#define RING_VERSION_CURRENT RING_VERSION_PADDED
+
+/*
+   Layout options in s_flags.  A mirrored ring has a page aligned data
+   segment that clients map twice back to back, so that data starting
+   anywhere in the ring can be accessed contiguously.  Software that doesn't
+   know about the flag just uses the first mapping and still works.
+*/
+
+#define RING_FLAG_MIRRORED   1	/* Data segment is mapped twice.             */
 
 typedef struct __RingHeader {
-   char       s_magicString[32];	/* Should contain the text "NSCLRing" */
+   char       s_magicString[16];	/* "NSCLRing" or "NSCLRingV"                     */
+  volatile uint32_t   s_version;        /* RING_VERSION_* - 0 for unversioned rings.     */
+  volatile uint32_t   s_flags;          /* RING_FLAG_* layout options.                   */
+  volatile off_t      s_notifyOffset;   /* Offset to the RingNotification or 0 if none.  */
   volatile size_t     s_maxConsumer;	/* Maximum # of consumers. allowed by the ring.  */
   volatile size_t     s_dataBytes;      	/* Number of bytes of data in the data segment.  */
   volatile off_t      s_producerInfo;    /* Offset to the producer descriptor.            */
@@ -69,6 +111,40 @@ typedef struct __ClientInformation {
   volatile pid_t      s_pid;		/* Process Id of the client.                    */
 } ClientInformation, *pClientInformation;
 
+/*
+   Rings with s_version >= RING_VERSION_NOTIFY have a notification block between
+   the consumer information and the data segment.  The sequence numbers are
+   futex words.  The producer increments s_putSequence each time it advances its
+   put pointer and consumers increment s_getSequence each time they release
+   space.  Waiters bump the matching waiter count before sampling the sequence
+   so that the other side only makes the futex wake system call when someone
+   is actually sleeping.
+*/
+typedef struct __RingNotification {
+  volatile uint32_t   s_putSequence;	/* Producer put count (consumers wait on it).   */
+  volatile uint32_t   s_putWaiters;	/* Number of consumers blocked on s_putSequence.*/
+  char                s_putPad[RING_CACHELINE - 2*sizeof(uint32_t)];
+  volatile uint32_t   s_getSequence;	/* Consumer get count (producer waits on it).   */
+  volatile uint32_t   s_getWaiters;	/* Nonzero if the producer is blocked for space.*/
+  char                s_getPad[RING_CACHELINE - 2*sizeof(uint32_t)];
+} RingNotification, *pRingNotification;
+
+/*
+   Rings with s_version >= RING_VERSION_PADDED give each consumer its own
+   cache line (s_slotStride bytes between ClientInformation slots; the first
+   consumer is cache aligned) so that consumers updating their get offsets
+   don't invalidate lines other clients are reading.  A client map follows
+   the notification block.  It records which consumer slots are claimed so
+   the producer only looks at live consumers when computing free space.
+   The map is only written when consumers come and go.  s_liveMap is really
+   (s_maxConsumer + 63)/64 words long.
+*/
+typedef struct __RingClientMap {
+  volatile uint32_t   s_slotStride;	/* Bytes between consumer slots.               */
+  volatile uint32_t   s_liveCount;	/* Number of bits set in s_liveMap.            */
+  volatile uint64_t   s_liveMap[1];	/* Bit n set if consumer slot n is claimed.    */
+} RingClientMap, *pRingClientMap;
+
 /*
    This is the Ring buffer structure itself.  The only thing we won't be able
    to show is the data region because where that starts depends on the size of
@@ -78,7 +154,7 @@ typedef struct __RingBuffer {
   RingHeader         s_header;	     /* the ring buffer header.                     */
   ClientInformation  s_producer;     /* Client information for the single producer. */
   ClientInformation  s_consumers[1]; /* Client information for the consumers.       */
-} RingBuffer, *pRingBuffer;
+} RingBuffer, *pRingBuffer;       /* (s_consumers only indexes legacy/v1 rings).  */
 
 
 
@@ -13,7 +13,9 @@
 #include <stdio.h>
 #include <os.h>
 #include "stdintoringUtils.h"
+#include "CRingHoistSender.h"
 #include <fcntl.h>
+#include <stdexcept>
 
 using namespace std;
 /********************************************************************
@@ -47,30 +49,15 @@ writeData(int fd, void* pData, size_t size)
 }
 
 /********************************************************************
- * mainLoop                                                         *
- *  The application main loop.  We get data from the ring and shoot *
- *  it to stdout.  We attempt to read data in chunks of mindata     *
- *  but if that times out within the timeout period, we just read   *
- *  what's there and shovel it on out the pipe.                     *
- *                                                                  *
+ * attachRing                                                       *
+ *   Attach to the ring as a consumer.  If we fail, report the      *
+ *   error and exit.                                                *
  * Parameters:                                                      *
- *   std::string ringname  - Name of the ring we must attach to     *
- *   int         timeout   - ms to wait for the whole mindata chunk *
- *   size_t      mindata   - Minimum desired data chunk             *
+ *   std::string ring  - Name of the ring.                          *
  *******************************************************************/
-
-static void
-mainLoop(string ring, int timeout, size_t mindata)
+static CRingBuffer*
+attachRing(string ring)
 {
-  // If STDOUT is a pipe set the pipe buf bit but ignore failures since they're
-  // not important.
-  
-  fcntl(STDOUT_FILENO, F_SETPIPE_SZ, 1024*1024);
-  
-  // Attach to the ring. If we fail, report the error and exti.
-
- 
-
   CRingBuffer* pSource;
   try {
     pSource = new CRingBuffer(ring);
@@ -94,6 +81,33 @@ mainLoop(string ring, int timeout, size_t mindata)
     cerr << "ringtostdout Failed attach to " << ring << endl;
     exit(EXIT_FAILURE);
   }
+  return pSource;
+}
+
+/********************************************************************
+ * mainLoop                                                         *
+ *  The application main loop.  We get data from the ring and shoot *
+ *  it to stdout.  We attempt to read data in chunks of mindata     *
+ *  but if that times out within the timeout period, we just read   *
+ *  what's there and shovel it on out the pipe.                     *
+ *                                                                  *
+ * Parameters:                                                      *
+ *   std::string ringname  - Name of the ring we must attach to     *
+ *   int         timeout   - ms to wait for the whole mindata chunk *
+ *   size_t      mindata   - Minimum desired data chunk             *
+ *******************************************************************/
+
+static void
+mainLoop(string ring, int timeout, size_t mindata)
+{
+  // If STDOUT is a pipe set the pipe buf bit but ignore failures since they're
+  // not important.
+  
+  fcntl(STDOUT_FILENO, F_SETPIPE_SZ, 1024*1024);
+  
+  // Attach to the ring. If we fail, report the error and exti.
+
+  CRingBuffer* pSource = attachRing(ring);
 
   CRingBuffer& source(*pSource);
   CRingBuffer::Usage use = source.getUsage();
@@ -119,6 +133,52 @@ mainLoop(string ring, int timeout, size_t mindata)
   }
 }
 
+/********************************************************************
+ * bulkLoop                                                         *
+ *  Send the ring's data with the bulk hoisting protocol.  stdin    *
+ *  and stdout are the socket to the receiver (stdintoring --bulk). *
+ *                                                                  *
+ * Parameters:                                                      *
+ *   std::string ringname  - Name of the ring we must attach to     *
+ *   size_t      batchSize - Largest batch                          *
+ *   std::string client    - Where the data are going (for stats)   *
+ *   int         latency   - ms a partial batch waits               *
+ *   int         reconnect - s to wait for a reconnect              *
+ *******************************************************************/
+
+static void
+bulkLoop(string ring, size_t batchSize, string client, int latency, int reconnect)
+{
+  // A dropped connection must not kill us; we wait for the receiver to
+  // come back.
+
+  if (Os::blockSignal(SIGPIPE)) {
+    perror("Failed to block sigpipe");
+  }
+  CRingBuffer* pSource = attachRing(ring);
+  CRingBuffer::Usage use = pSource->getUsage();
+  if (batchSize > use.s_putSpace/2) {
+    batchSize = use.s_putSpace/2;
+  }
+
+  CRingHoistSender sender(*pSource, STDIN_FILENO, STDOUT_FILENO, batchSize);
+  sender.setMaxLatency(latency);
+  sender.setReconnectTimeout(reconnect);
+  sender.setReporting(ring, client, 5);
+  try {
+    if (!sender.handshake()) {
+      cerr << "ringtostdout: bulk receiver closed or asked for an unknown session\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  catch (std::runtime_error& e) {
+    cerr << "ringtostdout: " << e.what() << endl;
+    exit(EXIT_FAILURE);
+  }
+  sender();
+  delete pSource;
+}
+
 /*!
    The entry point parses the parameters and invokes
   the main loop which does all the grunt work.
@@ -159,8 +219,15 @@ int main(int argc, char** argv)
   int    timeout  = parsed.timeout_arg;
   size_t mindata  = integerize(parsed.mindata_arg);
 
-
-  mainLoop(ringname, timeout, mindata);
+  if (parsed.bulk_flag) {
+    string client = (parsed.inputs_num > 1) ? parsed.inputs[1] : "unknown";
+    bulkLoop(
+      ringname, integerize(parsed.batch_arg), client,
+      parsed.latency_arg, parsed.reconnect_arg
+    );
+  } else {
+    mainLoop(ringname, timeout, mindata);
+  }
   
 }
 
@@ -1,5 +1,6 @@
 #include "stdintoringsw.h"
 #include "stdintoringUtils.h"
+#include "CRingHoistReceiver.h"
 #include "CRingBuffer.h"
 #include "Exception.h"
 #include <stdint.h>
@@ -21,29 +22,20 @@
 #include <netinet/tcp.h>
 #include <io.h>
 #include <set>
+#include <stdexcept>
 
 
 using namespace std;
 
 
 /********************************************************************
- * mainLoop:                                                        *
- *     Main loop that takes data from stdin and puts it in the ring *
- * Parameters:                                                      *
- *   std::string ring       - Name of the target ring.              *
- *   int         timeout    - Maximum time to wait for data on stdin*
- *   int         mindata    - Chunk size for reads.. which are done *
- *                            with blocking off.                    *
+ * setKeepalive:                                                    *
+ *   If stdin is a socket set keepalive so we're given a SIGPIPE if *
+ *   the other end drops off (See Bug #6248).                       *
  *******************************************************************/
-
-int
-mainLoop(string ring, int timeout, unsigned  mindata)
+static void
+setKeepalive()
 {
-  // If stdin is a socket set keepalive so we're given a SIGPIPE if the other
-  // end drops off (See Bug #6248).
-
-
-  
   struct stat fdInfo;
   if (fstat(STDIN_FILENO, &fdInfo)) {
     perror("Unable to fstat stdin");
@@ -74,11 +66,18 @@ mainLoop(string ring, int timeout, unsigned  mindata)
       // exit(EXIT_FAILURE);
     }
   }
-  
-  
-  
-  // Attach to the ring:
-
+}
+/********************************************************************
+ * attachRing:                                                      *
+ *   Attach to the ring as its producer.                            *
+ * Parameters:                                                      *
+ *   std::string ring       - Name of the target ring.              *
+ * Returns:                                                         *
+ *   The ring or nullptr if that failed (and was reported).         *
+ *******************************************************************/
+static CRingBuffer*
+attachRing(string ring)
+{
   CRingBuffer* pSource;
   try {
     pSource = CRingBuffer::createAndProduce(ring);
@@ -87,20 +86,44 @@ mainLoop(string ring, int timeout, unsigned  mindata)
   catch (CException& error) {
     cerr << "stdintoring Failed to attach to " << ring << ":\n";
     cerr << error.ReasonText() << endl;
-    return (EXIT_FAILURE);
+    return nullptr;
   }
   catch (string msg) {
     cerr << "stdintoring Failed to attach to " << ring << ":\n";
     cerr << msg << endl;
-    return (EXIT_FAILURE);
+    return nullptr;
   }
   catch (const char* msg) {
     cerr << "stdintoring Failed to attach to " << ring << ":\n";
     cerr << msg <<endl;
-    return (EXIT_FAILURE);
+    return nullptr;
   }
   catch (...) {
     cerr << "stdintoring Failed to attach to " << ring << endl;
+    return nullptr;
+  }
+  return pSource;
+}
+
+/********************************************************************
+ * mainLoop:                                                        *
+ *     Main loop that takes data from stdin and puts it in the ring *
+ * Parameters:                                                      *
+ *   std::string ring       - Name of the target ring.              *
+ *   int         timeout    - Maximum time to wait for data on stdin*
+ *   int         mindata    - Chunk size for reads.. which are done *
+ *                            with blocking off.                    *
+ *******************************************************************/
+
+int
+mainLoop(string ring, int timeout, unsigned  mindata)
+{
+  setKeepalive();
+  
+  // Attach to the ring:
+
+  CRingBuffer* pSource = attachRing(ring);
+  if (!pSource) {
     return (EXIT_FAILURE);
   }
 
@@ -235,6 +258,41 @@ mainLoop(string ring, int timeout, unsigned  mindata)
 
 }
 
+/********************************************************************
+ * bulkLoop:                                                        *
+ *   Take data from a ringtostdout --bulk on the socket that is     *
+ *   stdin and put it in the ring.                                  *
+ * Parameters:                                                      *
+ *   std::string ring       - Name of the target ring.              *
+ *   int         credits    - Batches that can be in flight.        *
+ *   bool        compress   - Ask for compressed batches.           *
+ *   int         reconnect  - Seconds to try to reconnect.          *
+ *******************************************************************/
+int
+bulkLoop(string ring, int credits, bool compress, int reconnect)
+{
+  setKeepalive();
+  CRingBuffer* pSource = attachRing(ring);
+  if (!pSource) {
+    return (EXIT_FAILURE);
+  }
+  CRingHoistReceiver receiver(*pSource, STDIN_FILENO, credits, compress);
+  receiver.setReconnectTimeout(reconnect);
+  try {
+    if (!receiver.handshake()) {
+      cerr << "stdintoring: the bulk sender refused the session\n";
+      return (EXIT_FAILURE);
+    }
+    receiver();
+  }
+  catch (std::exception& e) {
+    cerr << "stdintoring: " << e.what() << endl;
+    return (EXIT_FAILURE);
+  }
+  cerr << "Exiting due to end of the bulk session\n";
+  return (EXIT_SUCCESS);
+}
+
 /*!
    Entry point.
 */
@@ -279,7 +337,13 @@ int main(int argc, char** argv)
 
   int exitStatus;
   try {
-    exitStatus = mainLoop(ringname, timeout, mindata);
+    if (parsed.bulk_flag) {
+      exitStatus = bulkLoop(
+        ringname, parsed.credits_arg, parsed.compress_flag, parsed.reconnect_arg
+      );
+    } else {
+      exitStatus = mainLoop(ringname, timeout, mindata);
+    }
   }
   catch (std::string msg) {
     std::cerr << "string exception caught: " << msg << std::endl;
@@ -151,23 +151,31 @@ void dumpWords(void* src, size_t nwords)
  * @param ring    - reference to the target ring buffer.
  * @param pBuffer - Pointer to the data buffer.
  * @param nBytes  - Number of bytes in the data buffer.
+ * @param maxPut  - Largest single put (the items are put in several pieces
+ *                  if need be).  Must be at least the largest item size.
  *
  * It is assumed that the total buffer size will be larger than
  * needed to hold the largest item.   That's controld by the 
  * --mindata switch in any event.
  */
 size_t 
-putData(CRingBuffer& ring, void* pBuffer, size_t nBytes)
+putData(CRingBuffer& ring, void* pBuffer, size_t nBytes, size_t maxPut)
 {
     // Figure out how many bytes of complete ring items we have and
-    // write them all out in one put:
+    // write them all out in as few puts as maxPut allows:
     
     size_t putSize(0);
     size_t bytesLeft(nBytes);
-    uint8_t* p = reinterpret_cast<uint8_t*>(pBuffer);
+    uint8_t* pPut = reinterpret_cast<uint8_t*>(pBuffer);
+    uint8_t* p = pPut;
     while (bytesLeft > sizeof(struct header)) {
         uint32_t itemSize = computeSize(reinterpret_cast<header*>(p));
         if (itemSize <= bytesLeft) {
+            if (putSize && (putSize + itemSize > maxPut)) {
+                ring.put(pPut, putSize);
+                pPut   += putSize;
+                putSize = 0;
+            }
             putSize   += itemSize;
             bytesLeft -= itemSize;
             p         += itemSize;
@@ -178,7 +186,7 @@ putData(CRingBuffer& ring, void* pBuffer, size_t nBytes)
     if (putSize > 0) {
         // There's data to put, a small read may well not give us this.
         
-        ring.put(pBuffer, putSize);
+        ring.put(pPut, putSize);
         
         // Have to slide any residual data down.
         
@@ -33,6 +33,8 @@ typedef struct header {
 int integerize(const char* str);
 uint32_t computeSize(struct header* pHeader);
 void dumpWords(void* src, size_t nwords);
-size_t putData(CRingBuffer& ring, void* pBuffer, size_t nBytes);
+size_t putData(
+  CRingBuffer& ring, void* pBuffer, size_t nBytes, size_t maxPut = SIZE_MAX
+);
 
 #endif
\ No newline at end of file
@@ -18,7 +18,7 @@
 
 #ifndef CBUFFEREDOUTPUT_H
 #define CBUFFEREDOUTPUT_H
-#include <CBufferQueue.h>
+#include <CRingQueue.h>
 #include <CSynchronizedThread.h>
 
 #include <stdint.h>
@@ -49,7 +49,7 @@ public:
         void* s_pBuffer;
     } QueueElement, *pQueueElement;
     
-    typedef CBufferQueue<QueueElement*> BufferQueue;
+    typedef CRingQueue<QueueElement*> BufferQueue;
     
 private:
     int      m_nFd;             // Data are written to this file descriptor
@@ -0,0 +1,67 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegment.cpp
+ *  @brief: Helpers for the compressed segment format.
+ */
+#include "CCompressedSegment.h"
+#include <string.h>
+
+namespace CompressedSegment {
+
+/**
+ * isCompressed
+ *    @param pData  - The first bytes of a file.
+ *    @param nBytes - How many there are.
+ *    @return bool  - true if they're a compressed segment file header.
+ */
+bool
+isCompressed(const void* pData, size_t nBytes)
+{
+    return (nBytes >= sizeof(FILE_MAGIC)) &&
+        (memcmp(pData, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0);
+}
+/**
+ * itemTimestamp
+ *    Get the timestamp of a ring item from its body header.  This is
+ *    done by layout rather than with the format library, which lives
+ *    above us: after the size and type, the word is the body header size
+ *    (0 or sizeof(uint32_t) if there's no body header) and the body
+ *    header starts with that size followed by the 64 bit timestamp.
+ *
+ * @param pItem - pointer to a ring item (need not be aligned).
+ * @return uint64_t - timestamp or NO_TIMESTAMP if the item has none.
+ */
+uint64_t
+itemTimestamp(const void* pItem)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(pItem);
+    const uint32_t bodyHeaderSize = 3*sizeof(uint32_t) + sizeof(uint64_t);
+    uint32_t size;
+    uint32_t bhSize;
+    memcpy(&size, p, sizeof(uint32_t));
+    if (size < 2*sizeof(uint32_t) + bodyHeaderSize) return NO_TIMESTAMP;
+
+    memcpy(&bhSize, p + 2*sizeof(uint32_t), sizeof(uint32_t));
+    if (bhSize < bodyHeaderSize) return NO_TIMESTAMP;
+
+    uint64_t ts;
+    memcpy(&ts, p + 3*sizeof(uint32_t), sizeof(uint64_t));
+    return ts;
+}
+
+}
@@ -0,0 +1,97 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegment.h
+ *  @brief: Layout of compressed event file segments.
+ *
+ *  A compressed segment is:
+ *  - A FileHeader.
+ *  - Blocks, each a BlockHeader followed by s_compressedSize bytes of
+ *    zlib (deflate) compressed data.  The uncompressed data of a block
+ *    are whole ring items, exactly as they'd be in an uncompressed file.
+ *  - An IndexHeader followed by one IndexEntry per block.
+ *  - A Trailer, so the index can be found from the end of the file.
+ *
+ *  Each BlockHeader has everything in its IndexEntry, so if the segment
+ *  was not closed properly (no index) the index can be rebuilt by
+ *  hopping from block header to block header.
+ *
+ *  All fields are in the byte order of the writing system, as are ring
+ *  items.
+ */
+#ifndef CCOMPRESSEDSEGMENT_H
+#define CCOMPRESSEDSEGMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace CompressedSegment {
+
+    // The file magic can't be mistaken for a ring item: as a ring item
+    // size it would be over a GByte.
+
+    static const char     FILE_MAGIC[8] = {'N', 'S', 'C', 'L', 'Z', 'S', 'E', 'G'};
+    static const char     TRAILER_MAGIC[8] = {'N', 'S', 'C', 'L', 'Z', 'I', 'D', 'X'};
+    static const uint32_t VERSION     = 1;
+    static const uint32_t ZLIB        = 1;      // Compression method.
+    static const uint32_t BLOCK_MAGIC = 0x4b4c425a;   // "ZBLK"
+    static const uint32_t INDEX_MAGIC = 0x5844495a;   // "ZIDX"
+
+    static const uint64_t NO_TIMESTAMP = 0xffffffffffffffffULL;
+
+    typedef struct __attribute__((__packed__)) _FileHeader {
+        char     s_magic[8];
+        uint32_t s_version;
+        uint32_t s_compression;
+    } FileHeader, *pFileHeader;
+
+    typedef struct __attribute__((__packed__)) _BlockHeader {
+        uint32_t s_magic;
+        uint32_t s_compressedSize;
+        uint32_t s_uncompressedSize;
+        uint32_t s_nItems;
+        uint64_t s_firstItem;       // Number of the first item in the segment.
+        uint64_t s_minTimestamp;    // NO_TIMESTAMP if no item has one.
+        uint64_t s_maxTimestamp;    // 0 if no item has a timestamp.
+    } BlockHeader, *pBlockHeader;
+
+    typedef struct __attribute__((__packed__)) _IndexHeader {
+        uint32_t s_magic;
+        uint32_t s_nBlocks;
+    } IndexHeader, *pIndexHeader;
+
+    typedef struct __attribute__((__packed__)) _IndexEntry {
+        uint64_t s_offset;          // File offset of the BlockHeader.
+        uint32_t s_compressedSize;
+        uint32_t s_uncompressedSize;
+        uint32_t s_nItems;
+        uint64_t s_firstItem;
+        uint64_t s_minTimestamp;
+        uint64_t s_maxTimestamp;
+    } IndexEntry, *pIndexEntry;
+
+    typedef struct __attribute__((__packed__)) _Trailer {
+        uint64_t s_indexOffset;     // File offset of the IndexHeader.
+        uint64_t s_nItems;          // Items in the segment.
+        char     s_magic[8];
+    } Trailer, *pTrailer;
+
+    bool isCompressed(const void* pData, size_t nBytes);
+    uint64_t itemTimestamp(const void* pItem);
+}
+
+#endif
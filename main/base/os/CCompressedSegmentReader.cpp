@@ -0,0 +1,341 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegmentReader.cpp
+ *  @brief: Implement the compressed segment reader.
+ */
+#include "CCompressedSegmentReader.h"
+#include "io.h"
+
+#include <zlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+using namespace CompressedSegment;
+
+/**
+ * constructor
+ *
+ * @param fd      - File descriptor open on the segment.
+ * @param pHeader - If not null, the caller already read the file header
+ *                  (e.g. to find out the file is compressed) and this is
+ *                  it.  Otherwise it's read here.
+ * @throw std::runtime_error - not a compressed segment we understand.
+ */
+CCompressedSegmentReader::CCompressedSegmentReader(
+    int fd, const FileHeader* pHeader
+) :
+    m_nFd(fd), m_nBase(-1), m_nCursor(0), m_fEnd(false),
+    m_fIndexLoaded(false), m_nItems(0)
+{
+    FileHeader header;
+    if (!pHeader) {
+        if (io::readData(m_nFd, &header, sizeof(header)) != sizeof(header)) {
+            throw std::runtime_error("Compressed segment has no file header");
+        }
+        pHeader = &header;
+    }
+    if (!isCompressed(pHeader, sizeof(FileHeader))) {
+        throw std::runtime_error("Not a compressed event segment");
+    }
+    if ((pHeader->s_version != VERSION) || (pHeader->s_compression != ZLIB)) {
+        throw std::runtime_error("Unsupported compressed event segment version");
+    }
+    off_t here = lseek(m_nFd, 0, SEEK_CUR);
+    if (here >= off_t(sizeof(FileHeader))) {
+        m_nBase = here - sizeof(FileHeader);
+    }
+}
+CCompressedSegmentReader::~CCompressedSegmentReader()
+{}
+
+/**
+ * read
+ *    Read uncompressed data.
+ *
+ * @param pBuffer - Where the data go.
+ * @param nBytes  - Maximum number of bytes.
+ * @return size_t - Number of bytes read; 0 at the end of the segment.
+ */
+size_t
+CCompressedSegmentReader::read(void* pBuffer, size_t nBytes)
+{
+    uint8_t* p = static_cast<uint8_t*>(pBuffer);
+    size_t   nRead = 0;
+    while (nBytes) {
+        if (m_nCursor == m_block.size()) {
+            if (!nextBlock()) break;
+        }
+        size_t n = std::min(nBytes, m_block.size() - m_nCursor);
+        memcpy(p, &m_block[m_nCursor], n);
+        m_nCursor += n;
+        p         += n;
+        nBytes    -= n;
+        nRead     += n;
+    }
+    return nRead;
+}
+/**
+ * seekToItem
+ *    Position so the next read starts at an item.
+ *
+ * @param item - Item number (the first item of the segment is 0).
+ * @return bool - false if there's no such item (positioned at the end).
+ * @throw std::logic_error if the file is not seekable.
+ */
+bool
+CCompressedSegmentReader::seekToItem(uint64_t item)
+{
+    const std::vector<IndexEntry>& index(getIndex());
+    for (size_t i = 0; i < index.size(); i++) {
+        if ((item >= index[i].s_firstItem) &&
+            (item < index[i].s_firstItem + index[i].s_nItems)) {
+            if (!seekToBlock(i)) return false;
+            for (uint64_t n = index[i].s_firstItem; n < item; n++) {
+                uint32_t size;
+                memcpy(&size, &m_block[m_nCursor], sizeof(uint32_t));
+                m_nCursor += size;
+            }
+            return true;
+        }
+    }
+    m_block.clear();
+    m_nCursor = 0;
+    m_fEnd    = true;
+    return false;
+}
+/**
+ * seekToTimestamp
+ *    Position at the first item, in file order, whose timestamp is at
+ *    least the one requested.  Only the block holding it is decompressed.
+ *
+ * @param timestamp - the timestamp.
+ * @return bool - false if no item has a timestamp that big.
+ * @throw std::logic_error if the file is not seekable.
+ */
+bool
+CCompressedSegmentReader::seekToTimestamp(uint64_t timestamp)
+{
+    const std::vector<IndexEntry>& index(getIndex());
+    for (size_t i = 0; i < index.size(); i++) {
+        if ((index[i].s_minTimestamp != NO_TIMESTAMP) &&
+            (index[i].s_maxTimestamp >= timestamp)) {
+            if (!seekToBlock(i)) return false;
+            for (uint32_t n = 0; n < index[i].s_nItems; n++) {
+                uint64_t ts = itemTimestamp(&m_block[m_nCursor]);
+                if ((ts != NO_TIMESTAMP) && (ts >= timestamp)) return true;
+                uint32_t size;
+                memcpy(&size, &m_block[m_nCursor], sizeof(uint32_t));
+                m_nCursor += size;
+            }
+        }
+    }
+    m_block.clear();
+    m_nCursor = 0;
+    m_fEnd    = true;
+    return false;
+}
+/**
+ * getIndex
+ *    @return the block index, loading (or rebuilding) it if needed.
+ *    @throw std::logic_error if the file is not seekable.
+ */
+const std::vector<IndexEntry>&
+CCompressedSegmentReader::getIndex()
+{
+    if (!m_fIndexLoaded) loadIndex();
+    return m_index;
+}
+/**
+ * getItemCount
+ *    @return uint64_t - number of items in the segment.
+ */
+uint64_t
+CCompressedSegmentReader::getItemCount()
+{
+    getIndex();
+    return m_nItems;
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * nextBlock
+ *    Read and decompress the block at the current file position.
+ *
+ * @return bool - false if there are no more blocks.
+ */
+bool
+CCompressedSegmentReader::nextBlock()
+{
+    if (m_fEnd) return false;
+
+    BlockHeader header;
+    if ((io::readData(m_nFd, &header, sizeof(header)) != sizeof(header)) ||
+        (header.s_magic != BLOCK_MAGIC)) {
+        m_fEnd = true;                 // End of file or the index.
+        return false;
+    }
+    loadBlock(header);
+    return true;
+}
+/**
+ * loadBlock
+ *    Read the compressed data for a block and decompress it into m_block.
+ *
+ * @param header - The block's header (already read).
+ * @throw std::runtime_error - truncated or corrupt block.
+ */
+void
+CCompressedSegmentReader::loadBlock(const BlockHeader& header)
+{
+    m_compressed.resize(header.s_compressedSize);
+    if (io::readData(m_nFd, m_compressed.data(), header.s_compressedSize) !=
+        header.s_compressedSize) {
+        throw std::runtime_error("Compressed event segment is truncated");
+    }
+    m_block.resize(header.s_uncompressedSize);
+    uLongf n = header.s_uncompressedSize;
+    if ((uncompress(m_block.data(), &n, m_compressed.data(), header.s_compressedSize) != Z_OK) ||
+        (n != header.s_uncompressedSize)) {
+        throw std::runtime_error("Compressed event segment block is corrupt");
+    }
+    m_nCursor = 0;
+}
+/**
+ * seekToBlock
+ *    Load a block given its index entry number.
+ *
+ * @param block - the index entry.
+ * @return bool - false if the block can't be read.
+ */
+bool
+CCompressedSegmentReader::seekToBlock(size_t block)
+{
+    if (lseek(m_nFd, m_nBase + m_index[block].s_offset, SEEK_SET) < 0) {
+        throw std::system_error(errno, std::generic_category(), "Seeking compressed segment");
+    }
+    m_fEnd = false;
+    return nextBlock();
+}
+/**
+ * loadIndex
+ *    Read the index from the end of the file, or rebuild it from the
+ *    block headers if it's not there.  The file position is not changed.
+ */
+void
+CCompressedSegmentReader::loadIndex()
+{
+    requireSeekable();
+    off_t here     = lseek(m_nFd, 0, SEEK_CUR);
+    off_t fileSize = lseek(m_nFd, 0, SEEK_END);
+    if ((here < 0) || (fileSize < 0)) {
+        throw std::system_error(errno, std::generic_category(), "Sizing compressed segment");
+    }
+    lseek(m_nFd, here, SEEK_SET);
+    fileSize -= m_nBase;
+
+    if (!readIndex(fileSize)) rebuildIndex(fileSize);
+
+    m_nItems = 0;
+    if (m_index.size()) {
+        m_nItems = m_index.back().s_firstItem + m_index.back().s_nItems;
+    }
+    m_fIndexLoaded = true;
+}
+/**
+ * readIndex
+ *    Read the index the writer put at the end of the segment.
+ *
+ * @param fileSize - size of the segment.
+ * @return bool - false if there's no valid index.
+ */
+bool
+CCompressedSegmentReader::readIndex(off_t fileSize)
+{
+    Trailer trailer;
+    if (fileSize < off_t(sizeof(FileHeader) + sizeof(IndexHeader) + sizeof(Trailer))) {
+        return false;
+    }
+    if (pread(m_nFd, &trailer, sizeof(trailer), m_nBase + fileSize - sizeof(trailer)) !=
+        sizeof(trailer)) {
+        return false;
+    }
+    if (memcmp(trailer.s_magic, TRAILER_MAGIC, sizeof(trailer.s_magic)) != 0) {
+        return false;
+    }
+    IndexHeader header;
+    if ((pread(m_nFd, &header, sizeof(header), m_nBase + trailer.s_indexOffset) !=
+         sizeof(header)) || (header.s_magic != INDEX_MAGIC)) {
+        return false;
+    }
+    m_index.resize(header.s_nBlocks);
+    ssize_t nBytes = header.s_nBlocks*sizeof(IndexEntry);
+    if (nBytes && (pread(
+            m_nFd, m_index.data(), nBytes,
+            m_nBase + trailer.s_indexOffset + sizeof(header)) != nBytes)) {
+        m_index.clear();
+        return false;
+    }
+    return true;
+}
+/**
+ * rebuildIndex
+ *    Hop along the block headers to make the index.  Stops at the first
+ *    thing that's not a whole block.
+ *
+ * @param fileSize - size of the segment.
+ */
+void
+CCompressedSegmentReader::rebuildIndex(off_t fileSize)
+{
+    m_index.clear();
+    off_t offset = sizeof(FileHeader);
+    BlockHeader header;
+    while ((offset + off_t(sizeof(header)) <= fileSize) &&
+           (pread(m_nFd, &header, sizeof(header), m_nBase + offset) == sizeof(header)) &&
+           (header.s_magic == BLOCK_MAGIC) &&
+           (offset + off_t(sizeof(header) + header.s_compressedSize) <= fileSize)) {
+        IndexEntry entry;
+        entry.s_offset           = offset;
+        entry.s_compressedSize   = header.s_compressedSize;
+        entry.s_uncompressedSize = header.s_uncompressedSize;
+        entry.s_nItems           = header.s_nItems;
+        entry.s_firstItem        = header.s_firstItem;
+        entry.s_minTimestamp     = header.s_minTimestamp;
+        entry.s_maxTimestamp     = header.s_maxTimestamp;
+        m_index.push_back(entry);
+
+        offset += sizeof(header) + header.s_compressedSize;
+    }
+}
+/**
+ * requireSeekable
+ *    @throw std::logic_error - if the segment isn't seekable.
+ */
+void
+CCompressedSegmentReader::requireSeekable()
+{
+    if (m_nBase < 0) {
+        throw std::logic_error("Compressed event segment is not seekable");
+    }
+}
@@ -0,0 +1,84 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegmentReader.h
+ *  @brief: Reads compressed event file segments.
+ */
+#ifndef CCOMPRESSEDSEGMENTREADER_H
+#define CCOMPRESSEDSEGMENTREADER_H
+
+#include "CCompressedSegment.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class CCompressedSegmentReader
+ *    Gives back the ring item data of a compressed segment (see
+ *    CCompressedSegment.h) as if it were an uncompressed file.  Blocks are
+ *    read in order from the current file position, so this works on pipes.
+ *    If the file is seekable the block index can be used to position at
+ *    an item number or a timestamp, only decompressing the block that
+ *    holds it.  If the segment has no index (e.g. the writer died) it's
+ *    rebuilt from the block headers.
+ *
+ *    The reader does not own (close) the file descriptor.
+ */
+class CCompressedSegmentReader
+{
+private:
+    int                   m_nFd;
+    off_t                 m_nBase;           // Offset of the file header, -1 if not seekable.
+    std::vector<uint8_t>  m_block;           // Current uncompressed block.
+    size_t                m_nCursor;         // Read position in m_block.
+    std::vector<uint8_t>  m_compressed;
+    bool                  m_fEnd;
+
+    bool                  m_fIndexLoaded;
+    std::vector<CompressedSegment::IndexEntry> m_index;
+    uint64_t              m_nItems;
+
+public:
+    CCompressedSegmentReader(
+        int fd, const CompressedSegment::FileHeader* pHeader = nullptr
+    );
+    virtual ~CCompressedSegmentReader();
+private:
+    CCompressedSegmentReader(const CCompressedSegmentReader&);
+    CCompressedSegmentReader& operator=(const CCompressedSegmentReader&);
+public:
+    size_t read(void* pBuffer, size_t nBytes);
+
+    bool seekToItem(uint64_t item);
+    bool seekToTimestamp(uint64_t timestamp);
+
+    const std::vector<CompressedSegment::IndexEntry>& getIndex();
+    uint64_t getItemCount();
+
+private:
+    bool nextBlock();
+    void loadBlock(const CompressedSegment::BlockHeader& header);
+    bool seekToBlock(size_t block);
+    void loadIndex();
+    bool readIndex(off_t fileSize);
+    void rebuildIndex(off_t fileSize);
+    void requireSeekable();
+};
+
+#endif
@@ -0,0 +1,392 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegmentWriter.cpp
+ *  @brief: Implement the compressed segment writer.
+ */
+#include "CCompressedSegmentWriter.h"
+#include "io.h"
+
+#include <zlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <system_error>
+
+using namespace CompressedSegment;
+
+/**
+ * constructor
+ *    Starts the compression threads.  Each has two jobs so one block can
+ *    be filled while the workers compress the others.
+ *
+ * @param nThreads  - Number of compression threads (at least 1).
+ * @param blockSize - Uncompressed block size target.
+ * @param level     - zlib compression level (1 fastest - 9 smallest).
+ * @param output    - If not empty, where compressed data go instead of
+ *                    the file descriptor.
+ */
+CCompressedSegmentWriter::CCompressedSegmentWriter(
+    unsigned nThreads, size_t blockSize, int level, Output output
+) :
+    m_nBlockSize(blockSize), m_nLevel(level), m_output(output), m_nFd(-1),
+    m_pCurrent(nullptr), m_nItemsEnd(0), m_nItems(0),
+    m_nBlocksSubmitted(0), m_nBlocksWritten(0), m_nItemsSubmitted(0),
+    m_nOffset(0), m_nRawBytes(0), m_nCompressedBytes(0)
+{
+    if (!nThreads) nThreads = 1;
+    for (unsigned i = 0; i < 2*nThreads; i++) {
+        Job* pJob = new Job;
+        pJob->s_data.reserve(m_nBlockSize + m_nBlockSize/4);
+        m_allJobs.push_back(pJob);
+        m_freeJobs.queue(pJob);
+    }
+    for (unsigned i = 0; i < nThreads; i++) {
+        Worker* pWorker = new Worker(*this);
+        m_workers.push_back(pWorker);
+        pWorker->start();
+    }
+}
+/**
+ * destructor
+ *    Close any open segment and stop the workers (a null job stops one).
+ */
+CCompressedSegmentWriter::~CCompressedSegmentWriter()
+{
+    if (isOpen()) {
+        try {
+            close();
+        }
+        catch (...) {}                    // Can't throw from a destructor.
+    }
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_jobs.queue(nullptr);
+    }
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->join();
+        delete m_workers[i];
+    }
+    for (int i = 0; i < m_allJobs.size(); i++) {
+        delete m_allJobs[i];
+    }
+}
+
+/**
+ * open
+ *    Start a segment: write the file header.
+ *
+ * @param fd - file descriptor open on the segment file.
+ */
+void
+CCompressedSegmentWriter::open(int fd)
+{
+    if (isOpen()) {
+        throw std::logic_error("Compressed segment writer is already open");
+    }
+    m_nFd              = fd;
+    m_nBlocksSubmitted = 0;
+    m_nBlocksWritten   = 0;
+    m_nItemsSubmitted  = 0;
+    m_nOffset          = 0;
+    m_index.clear();
+    m_error            = nullptr;
+
+    FileHeader header;
+    memcpy(header.s_magic, FILE_MAGIC, sizeof(header.s_magic));
+    header.s_version     = VERSION;
+    header.s_compression = ZLIB;
+    output(&header, sizeof(header));
+}
+/**
+ * write
+ *    Add ring item data to the segment.  The data need not be whole ring
+ *    items but blocks are only cut after whole items.
+ *
+ * @param pData  - the data.
+ * @param nBytes - number of bytes.
+ * @throw std::logic_error - data that can't be a ring item or not open.
+ * @throw std::runtime_error - a block failed to compress.
+ */
+void
+CCompressedSegmentWriter::write(const void* pData, size_t nBytes)
+{
+    if (!isOpen()) {
+        throw std::logic_error("Compressed segment writer is not open");
+    }
+    if (!m_pCurrent) newBlock();
+    const uint8_t* p = static_cast<const uint8_t*>(pData);
+    m_pCurrent->s_data.insert(m_pCurrent->s_data.end(), p, p + nBytes);
+    m_nRawBytes += nBytes;
+
+    // Find the item boundaries and cut a block once we have enough.
+    // Note submit() replaces m_pCurrent.
+
+    while ((m_nItemsEnd + sizeof(uint32_t)) <= m_pCurrent->s_data.size()) {
+        uint32_t itemSize;
+        memcpy(&itemSize, &m_pCurrent->s_data[m_nItemsEnd], sizeof(uint32_t));
+        if (itemSize < 2*sizeof(uint32_t)) {
+            throw std::logic_error("Compressed segment writer - data is not ring items");
+        }
+        if ((m_nItemsEnd + itemSize) > m_pCurrent->s_data.size()) break;
+        m_nItemsEnd += itemSize;
+        m_nItems++;
+
+        if (m_nItemsEnd >= m_nBlockSize) submit(true);
+    }
+    writeCompleted(false);
+    throwError();
+}
+/**
+ * close
+ *    Finish the segment: compress and write what's left and write the
+ *    index and trailer.  A partial item at the end is kept (as it would
+ *    be in an uncompressed file) but isn't counted as an item.
+ *    The file descriptor is not closed.
+ *
+ * @throw std::runtime_error - a block failed to compress; the segment is
+ *                             still finished without it.
+ */
+void
+CCompressedSegmentWriter::close()
+{
+    if (!isOpen()) return;
+
+    if (m_pCurrent && m_pCurrent->s_data.size()) {
+        m_nItemsEnd = m_pCurrent->s_data.size();     // Partial item stays.
+        submit(false);
+    } else if (m_pCurrent) {
+        m_freeJobs.queue(m_pCurrent);
+        m_pCurrent = nullptr;
+    }
+    while (m_nBlocksWritten < m_nBlocksSubmitted) {
+        writeCompleted(true);
+    }
+
+    Trailer trailer;
+    trailer.s_indexOffset = m_nOffset;
+    trailer.s_nItems      = m_nItemsSubmitted;
+    memcpy(trailer.s_magic, TRAILER_MAGIC, sizeof(trailer.s_magic));
+
+    IndexHeader index;
+    index.s_magic   = INDEX_MAGIC;
+    index.s_nBlocks = m_index.size();
+    output(&index, sizeof(index));
+    if (m_index.size()) {
+        output(m_index.data(), m_index.size()*sizeof(IndexEntry));
+    }
+    output(&trailer, sizeof(trailer));
+
+    m_nFd = -1;
+    throwError();
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * newBlock
+ *    Start a new, empty, current block.  Output completed blocks while
+ *    waiting for a free job.
+ */
+void
+CCompressedSegmentWriter::newBlock()
+{
+    Job* pJob;
+    while (!m_freeJobs.getnow(pJob)) {
+        writeCompleted(true);
+    }
+    pJob->s_data.clear();
+    m_pCurrent  = pJob;
+    m_nItemsEnd = 0;
+    m_nItems    = 0;
+}
+/**
+ * submit
+ *    Queue the current block (through its last whole item) to the
+ *    workers.
+ *
+ * @param next - If true start a new current block with the bytes
+ *               past the last whole item.
+ */
+void
+CCompressedSegmentWriter::submit(bool next)
+{
+    Job* pJob = m_pCurrent;
+    std::vector<uint8_t> tail(pJob->s_data.begin() + m_nItemsEnd, pJob->s_data.end());
+    pJob->s_data.resize(m_nItemsEnd);
+
+    pJob->s_index               = m_nBlocksSubmitted++;
+    pJob->s_header.s_nItems     = m_nItems;
+    pJob->s_header.s_firstItem  = m_nItemsSubmitted;
+    m_nItemsSubmitted          += m_nItems;
+    m_jobs.queue(pJob);
+    m_pCurrent = nullptr;
+
+    if (next) {
+        newBlock();
+        m_pCurrent->s_data.insert(m_pCurrent->s_data.end(), tail.begin(), tail.end());
+    }
+}
+/**
+ * writeCompleted
+ *    Output compressed blocks that are next in order.  A block that
+ *    failed to compress is dropped and its error saved for throwError().
+ *
+ * @param wait - if true, block until at least one job is done.
+ */
+void
+CCompressedSegmentWriter::writeCompleted(bool wait)
+{
+    Job* pJob;
+    if (wait) {
+        pJob = m_doneJobs.get();
+        m_outOfOrder[pJob->s_index] = pJob;
+    }
+    while (m_doneJobs.getnow(pJob)) {
+        m_outOfOrder[pJob->s_index] = pJob;
+    }
+    while (!m_outOfOrder.empty() &&
+           (m_outOfOrder.begin()->first == m_nBlocksWritten)) {
+        pJob = m_outOfOrder.begin()->second;
+        m_outOfOrder.erase(m_outOfOrder.begin());
+        if (pJob->s_error) {
+            if (!m_error) m_error = pJob->s_error;
+            pJob->s_error = nullptr;
+        } else {
+            writeJob(pJob);
+        }
+        m_nBlocksWritten++;
+        m_freeJobs.queue(pJob);
+    }
+}
+/**
+ * throwError
+ *    Rethrow, once, the first compression failure the workers reported.
+ */
+void
+CCompressedSegmentWriter::throwError()
+{
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+/**
+ * writeJob
+ *    Output a compressed block and add it to the index.
+ *
+ * @param pJob - the compressed block.
+ */
+void
+CCompressedSegmentWriter::writeJob(Job* pJob)
+{
+    IndexEntry entry;
+    entry.s_offset           = m_nOffset;
+    entry.s_compressedSize   = pJob->s_header.s_compressedSize;
+    entry.s_uncompressedSize = pJob->s_header.s_uncompressedSize;
+    entry.s_nItems           = pJob->s_header.s_nItems;
+    entry.s_firstItem        = pJob->s_header.s_firstItem;
+    entry.s_minTimestamp     = pJob->s_header.s_minTimestamp;
+    entry.s_maxTimestamp     = pJob->s_header.s_maxTimestamp;
+    m_index.push_back(entry);
+
+    output(&pJob->s_header, sizeof(BlockHeader));
+    output(pJob->s_compressed.data(), pJob->s_header.s_compressedSize);
+    m_nCompressedBytes += sizeof(BlockHeader) + pJob->s_header.s_compressedSize;
+}
+/**
+ * output
+ *    Write data to the segment.
+ */
+void
+CCompressedSegmentWriter::output(const void* pData, size_t nBytes)
+{
+    if (m_output) {
+        m_output(pData, nBytes);
+    } else {
+        io::writeData(m_nFd, pData, nBytes);
+    }
+    m_nOffset += nBytes;
+}
+/**
+ * compress
+ *    Runs in a worker: compress a block and fill in its header's sizes
+ *    and timestamp range.
+ *
+ * @param pJob  - the block.
+ * @param level - zlib compression level.
+ */
+void
+CCompressedSegmentWriter::compress(Job* pJob, int level)
+{
+    BlockHeader& h(pJob->s_header);
+    h.s_magic            = BLOCK_MAGIC;
+    h.s_uncompressedSize = pJob->s_data.size();
+    h.s_minTimestamp     = NO_TIMESTAMP;
+    h.s_maxTimestamp     = 0;
+
+    const uint8_t* p = pJob->s_data.data();
+    for (uint32_t i = 0; i < h.s_nItems; i++) {
+        uint64_t ts = itemTimestamp(p);
+        if (ts != NO_TIMESTAMP) {
+            if (ts < h.s_minTimestamp) h.s_minTimestamp = ts;
+            if (ts > h.s_maxTimestamp) h.s_maxTimestamp = ts;
+        }
+        uint32_t size;
+        memcpy(&size, p, sizeof(uint32_t));
+        p += size;
+    }
+
+    uLongf nCompressed = compressBound(pJob->s_data.size());
+    pJob->s_compressed.resize(nCompressed);
+    int status = compress2(
+        pJob->s_compressed.data(), &nCompressed,
+        pJob->s_data.data(), pJob->s_data.size(), level
+    );
+    if (status != Z_OK) {
+        throw std::runtime_error("Compressed segment writer - zlib compress2 failed");
+    }
+    h.s_compressedSize = nCompressed;
+}
+
+/*---------------------------------------------------------------------------
+ * Worker thread.
+ */
+CCompressedSegmentWriter::Worker::Worker(CCompressedSegmentWriter& owner) :
+    m_owner(owner)
+{}
+/**
+ * operator()
+ *    Compress blocks until a null one arrives.  A failure goes back with
+ *    the job so the writer's thread can report it; an exception escaping
+ *    here would terminate the program.
+ */
+void
+CCompressedSegmentWriter::Worker::operator()()
+{
+    while (1) {
+        Job* pJob = m_owner.m_jobs.get();
+        if (!pJob) return;
+        try {
+            compress(pJob, m_owner.m_nLevel);
+        }
+        catch (...) {
+            pJob->s_error = std::current_exception();
+        }
+        m_owner.m_doneJobs.queue(pJob);
+    }
+}
@@ -0,0 +1,134 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompressedSegmentWriter.h
+ *  @brief: Writes compressed event file segments.
+ */
+#ifndef CCOMPRESSEDSEGMENTWRITER_H
+#define CCOMPRESSEDSEGMENTWRITER_H
+
+#include "CCompressedSegment.h"
+#include <CSynchronizedThread.h>
+#include <CBufferQueue.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <map>
+#include <functional>
+#include <exception>
+
+/**
+ * @class CCompressedSegmentWriter
+ *    Turns a stream of ring items into a compressed segment (see
+ *    CCompressedSegment.h).  Data can be handed to write() in any size
+ *    pieces; they're cut into blocks of about the block size at ring item
+ *    boundaries.  Blocks are compressed by a pool of worker threads and
+ *    output in order by the thread calling write()/close().
+ *
+ *    By default output goes to the file descriptor.  An output function
+ *    can be supplied instead (e.g. to put the compressed data through a
+ *    write behind thread or a checksum).
+ *
+ *    One writer can do several segments in turn: open(), write()...,
+ *    close().
+ *
+ *    A block that fails to compress is left out of the segment and the
+ *    failure is rethrown by the write() or close() that finds it.  close()
+ *    still writes the index and trailer before rethrowing.
+ */
+class CCompressedSegmentWriter
+{
+public:
+    typedef std::function<void(const void*, size_t)> Output;
+private:
+    typedef struct _Job {
+        uint64_t                        s_index;   // Block number.
+        std::vector<uint8_t>            s_data;
+        std::vector<uint8_t>            s_compressed;
+        CompressedSegment::BlockHeader  s_header;
+        std::exception_ptr              s_error;   // compress() failed.
+    } Job;
+
+    class Worker : public CSynchronizedThread {
+        CCompressedSegmentWriter& m_owner;
+    public:
+        Worker(CCompressedSegmentWriter& owner);
+        virtual void operator()();
+    };
+
+    size_t                 m_nBlockSize;
+    int                    m_nLevel;
+    Output                 m_output;
+    int                    m_nFd;
+
+    std::vector<Worker*>   m_workers;
+    std::vector<Job*>      m_allJobs;
+    CBufferQueue<Job*>     m_freeJobs;
+    CBufferQueue<Job*>     m_jobs;
+    CBufferQueue<Job*>     m_doneJobs;
+
+    // The block being filled:
+
+    Job*                   m_pCurrent;
+    size_t                 m_nItemsEnd;      // Offset past its last whole item.
+    uint32_t               m_nItems;         // Whole items in it.
+
+    // Segment state:
+
+    uint64_t               m_nBlocksSubmitted;
+    uint64_t               m_nBlocksWritten;
+    uint64_t               m_nItemsSubmitted;
+    uint64_t               m_nOffset;        // Bytes output so far.
+    std::map<uint64_t, Job*>                 m_outOfOrder;
+    std::vector<CompressedSegment::IndexEntry> m_index;
+    std::exception_ptr     m_error;          // First failed block.
+
+    // Statistics:
+
+    uint64_t               m_nRawBytes;
+    uint64_t               m_nCompressedBytes;
+
+public:
+    CCompressedSegmentWriter(
+        unsigned nThreads = 1, size_t blockSize = 1024*1024, int level = 1,
+        Output output = Output()
+    );
+    virtual ~CCompressedSegmentWriter();
+private:
+    CCompressedSegmentWriter(const CCompressedSegmentWriter&);
+    CCompressedSegmentWriter& operator=(const CCompressedSegmentWriter&);
+public:
+    void open(int fd);
+    void write(const void* pData, size_t nBytes);
+    void close();
+    bool isOpen() const { return m_nFd >= 0; }
+
+    uint64_t getRawBytes() const        { return m_nRawBytes; }
+    uint64_t getCompressedBytes() const { return m_nCompressedBytes; }
+
+private:
+    void newBlock();
+    void submit(bool next);
+    void writeJob(Job* pJob);
+    void writeCompleted(bool wait);
+    void throwError();
+    void output(const void* pData, size_t nBytes);
+    static void compress(Job* pJob, int level);
+};
+
+#endif
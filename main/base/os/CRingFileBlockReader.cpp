@@ -6,6 +6,8 @@
  *  saved for the next read.
  */
 #include "CRingFileBlockReader.h"
+#include "CCompressedSegmentReader.h"
+#include "io.h"
 
 #include <stdlib.h>
 #include <sys/types.h>
@@ -29,7 +31,8 @@
  * 
  * @param filename - name of the file to open.
  */
-CRingFileBlockReader::CRingFileBlockReader(const char* filename) 
+CRingFileBlockReader::CRingFileBlockReader(const char* filename) :
+  m_fFormatKnown(false), m_pCompressed(nullptr), m_nPeekCursor(0)
 {
   std::string fName(filename);
   if (fName == "-") {
@@ -49,7 +52,7 @@ CRingFileBlockReader::CRingFileBlockReader(const char* filename)
  *            e.g. a socket or stdin for pipeline processing.
  */
 CRingFileBlockReader::CRingFileBlockReader(int fd) :
-  m_nFd(fd)
+  m_nFd(fd), m_fFormatKnown(false), m_pCompressed(nullptr), m_nPeekCursor(0)
 {
   
 }
@@ -60,6 +63,7 @@ CRingFileBlockReader::CRingFileBlockReader(int fd) :
  */
 CRingFileBlockReader::~CRingFileBlockReader()
 {
+  delete m_pCompressed;
   close(m_nFd);
 }
 
@@ -84,6 +88,48 @@ CRingFileBlockReader::readBlock(void* pBuffer, size_t nBytes)
  // while (poll(&polls, 1, 100000) == 0)     // 100 seconds should be fine.
  //   ;
     
+  if (!m_fFormatKnown) checkFormat();
+  if (m_pCompressed) {
+    return m_pCompressed->read(pBuffer, nBytes);
+  }
+  // Give back what we read to check the format first:
+  
+  if (m_nPeekCursor < m_peeked.size()) {
+    size_t n = m_peeked.size() - m_nPeekCursor;
+    if (n > nBytes) n = nBytes;
+    memcpy(pBuffer, &m_peeked[m_nPeekCursor], n);
+    m_nPeekCursor += n;
+    return n;
+  }
   return ::read(m_nFd, pBuffer, nBytes);
   
-}
\ No newline at end of file
+}
+/**
+ * checkFormat
+ *    Read enough of the file to see if it's a compressed segment.  If so
+ *    a reader for it is made, otherwise what was read is kept to be
+ *    handed back by readBlock.  This is done on the first read rather than
+ *    in the constructor so a reader on e.g. stdin doesn't block until
+ *    it's used.
+ */
+void
+CRingFileBlockReader::checkFormat()
+{
+  CompressedSegment::FileHeader header;
+  size_t n;
+  try {
+    n = io::readData(m_nFd, &header, sizeof(header));
+  }
+  catch (int err) {
+    errno = err;
+    throw std::system_error(std::make_error_code(static_cast<std::errc>(errno)),
+			    "Reading the ring item file");
+  }
+  if (CompressedSegment::isCompressed(&header, n)) {
+    m_pCompressed = new CCompressedSegmentReader(m_nFd, &header);
+  } else {
+    uint8_t* p = reinterpret_cast<uint8_t*>(&header);
+    m_peeked.assign(p, p + n);
+  }
+  m_fFormatKnown = true;
+}
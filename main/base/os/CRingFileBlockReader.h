@@ -5,15 +5,23 @@
 #include <cstdint>
 #include <stddef.h>
 #include <unistd.h>
+#include <vector>
 
+class CCompressedSegmentReader;
 
-
+/**
+ * Reads ring item files in blocks.  Compressed segments (see
+ * CCompressedSegment.h) are recognized by their header and
+ * decompressed transparently.
+ */
 class CRingFileBlockReader : public CRingBlockReader
 {
 private:
   int m_nFd;
-
-  
+  bool                      m_fFormatKnown;
+  CCompressedSegmentReader* m_pCompressed;   // Null if not compressed.
+  std::vector<uint8_t>      m_peeked;        // Read to check the format.
+  size_t                    m_nPeekCursor;
   
 
 public:
@@ -23,6 +31,8 @@ public:
 
 protected:
   ssize_t readBlock(void* pBuffer, size_t nBytes);
+private:
+  void checkFormat();
 };
 
 
@@ -14,6 +14,8 @@ class attachTests : public CppUnit::TestFixture {
   CPPUNIT_TEST(size);
   CPPUNIT_TEST(mapped);
   CPPUNIT_TEST(doublemapped);
+  CPPUNIT_TEST(mirrored);
+  CPPUNIT_TEST(mirroredbadoffset);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -32,6 +34,8 @@ protected:
   void size();
   void mapped();
   void doublemapped();
+  void mirrored();
+  void mirroredbadoffset();
 };
 
 const char* attachTests::shmName="/testshm";
@@ -81,3 +85,26 @@ void attachTests::doublemapped()
   CDAQShm::detach(p1, shmName, 0x10000);
   ASSERT(!CDAQShm::detach(p1, shmName, 0x10000)); // p1/p2 are the same map.
 }
+
+// The mirror follows the region and aliases the memory from the offset on:
+
+void attachTests::mirrored()
+{
+  size_t offset = sysconf(_SC_PAGESIZE);
+  char*  p      = static_cast<char*>(CDAQShm::attachMirrored(shmName, offset));
+  ASSERT(p);
+
+  p[offset] = 1;
+  EQ((char)1, p[0x10000]);
+  p[0x10000 + 10] = 2;
+  EQ((char)2, p[offset+10]);
+  
+  EQ(false, CDAQShm::detachMirrored(p, shmName, 0x10000));
+}
+// Offsets that can't be mapped fail:
+
+void attachTests::mirroredbadoffset()
+{
+  EQ((void*)0, CDAQShm::attachMirrored(shmName, 1));
+  EQ((void*)0, CDAQShm::attachMirrored(shmName, 0x10000));
+}
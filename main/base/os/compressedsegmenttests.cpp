@@ -0,0 +1,391 @@
+// Tests for compressed event segments.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CCompressedSegmentWriter.h"
+#include "CCompressedSegmentReader.h"
+#include "CRingFileBlockReader.h"
+#include "io.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace CompressedSegment;
+
+static const unsigned NITEMS(5000);
+
+// Make a physics item with a body header.  The timestamp is 10*n,
+// the payload is n repeated a varying number of times.
+
+static void
+addItem(std::vector<uint8_t>& data, uint32_t n)
+{
+  uint32_t nPayload = 1 + (n % 37);
+  uint32_t size     = 2*sizeof(uint32_t) + 20 + nPayload*sizeof(uint32_t);
+  uint32_t type     = 30;
+  uint32_t bhSize   = 20;
+  uint64_t ts       = 10*uint64_t(n);
+  uint32_t sid      = 1;
+  uint32_t barrier  = 0;
+
+  size_t start = data.size();
+  data.resize(start + size);
+  uint8_t* p = &data[start];
+  memcpy(p, &size, sizeof(size));       p += sizeof(size);
+  memcpy(p, &type, sizeof(type));       p += sizeof(type);
+  memcpy(p, &bhSize, sizeof(bhSize));   p += sizeof(bhSize);
+  memcpy(p, &ts, sizeof(ts));           p += sizeof(ts);
+  memcpy(p, &sid, sizeof(sid));         p += sizeof(sid);
+  memcpy(p, &barrier, sizeof(barrier)); p += sizeof(barrier);
+  for (int i = 0; i < nPayload; i++) {
+    memcpy(p, &n, sizeof(n));           p += sizeof(n);
+  }
+}
+// Item number from an item's payload:
+
+static uint32_t
+itemNumber(const void* pItem)
+{
+  uint32_t n;
+  memcpy(&n, static_cast<const uint8_t*>(pItem) + 28, sizeof(n));
+  return n;
+}
+
+class CompressedSegmentTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(CompressedSegmentTest);
+  CPPUNIT_TEST(detect);
+  CPPUNIT_TEST(roundtrip);
+  CPPUNIT_TEST(index);
+  CPPUNIT_TEST(seekitem);
+  CPPUNIT_TEST(seektimestamp);
+  CPPUNIT_TEST(notrailer);
+  CPPUNIT_TEST(pipe_1);
+  CPPUNIT_TEST(blockreader);
+  CPPUNIT_TEST(compressfail);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  std::string          m_name;
+  std::vector<uint8_t> m_data;
+public:
+  void setUp() {
+    char tplate[100];
+    memset(tplate, 0, sizeof(tplate));
+    strncpy(tplate, "TempXXXXXX", sizeof(tplate)-1);
+    int fd = mkstemp(tplate);
+    if (fd < 0) {
+      perror("Failed to make temp file");
+      exit(EXIT_FAILURE);
+    }
+    close(fd);
+    m_name = tplate;
+
+    m_data.clear();
+    for (uint32_t i = 0; i < NITEMS; i++) {
+      addItem(m_data, i);
+    }
+  }
+  void tearDown() {
+    unlink(m_name.c_str());
+    m_name.clear();
+  }
+protected:
+  void detect();
+  void roundtrip();
+  void index();
+  void seekitem();
+  void seektimestamp();
+  void notrailer();
+  void pipe_1();
+  void blockreader();
+  void compressfail();
+private:
+  void writeFile(size_t blockSize = 4096, unsigned nThreads = 2);
+  std::vector<uint8_t> readAll(CCompressedSegmentReader& reader);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CompressedSegmentTest);
+
+// Write m_data as a compressed segment in odd sized pieces.
+
+void
+CompressedSegmentTest::writeFile(size_t blockSize, unsigned nThreads)
+{
+  int fd = open(m_name.c_str(), O_WRONLY | O_TRUNC);
+  ASSERT(fd >= 0);
+  CCompressedSegmentWriter writer(nThreads, blockSize);
+  writer.open(fd);
+  size_t offset = 0;
+  size_t piece  = 1;
+  while (offset < m_data.size()) {
+    size_t n = std::min(piece, m_data.size() - offset);
+    writer.write(&m_data[offset], n);
+    offset += n;
+    piece   = (piece*7 + 3) % 10007;
+  }
+  writer.close();
+  close(fd);
+  EQ(uint64_t(m_data.size()), writer.getRawBytes());
+}
+// Read everything a reader gives back, in odd sized pieces:
+
+std::vector<uint8_t>
+CompressedSegmentTest::readAll(CCompressedSegmentReader& reader)
+{
+  std::vector<uint8_t> result;
+  uint8_t buffer[8192];
+  size_t  piece = 13;
+  while (size_t n = reader.read(buffer, piece)) {
+    result.insert(result.end(), buffer, buffer + n);
+    piece = 1 + (piece*5 + 11) % sizeof(buffer);
+  }
+  return result;
+}
+
+// The file header is recognized; ring items are not mistaken for it.
+
+void
+CompressedSegmentTest::detect()
+{
+  writeFile();
+  int fd = open(m_name.c_str(), O_RDONLY);
+  FileHeader header;
+  EQ(sizeof(header), io::readData(fd, &header, sizeof(header)));
+  close(fd);
+
+  ASSERT(isCompressed(&header, sizeof(header)));
+  ASSERT(!isCompressed(&header, sizeof(FILE_MAGIC) - 1));
+  ASSERT(!isCompressed(m_data.data(), sizeof(header)));
+
+  EQ(uint64_t(0), itemTimestamp(m_data.data()));
+}
+// What's read back is what was written and it is smaller.
+
+void
+CompressedSegmentTest::roundtrip()
+{
+  writeFile();
+
+  struct stat info;
+  stat(m_name.c_str(), &info);
+  ASSERT(size_t(info.st_size) < m_data.size());
+
+  int fd = open(m_name.c_str(), O_RDONLY);
+  CCompressedSegmentReader reader(fd);
+  std::vector<uint8_t> result = readAll(reader);
+  close(fd);
+
+  EQ(m_data.size(), result.size());
+  ASSERT(m_data == result);
+}
+// The index covers all items in order with the right timestamps.
+
+void
+CompressedSegmentTest::index()
+{
+  writeFile();
+  int fd = open(m_name.c_str(), O_RDONLY);
+  CCompressedSegmentReader reader(fd);
+
+  const std::vector<IndexEntry>& index(reader.getIndex());
+  ASSERT(index.size() > 1);
+  uint64_t next = 0;
+  for (int i = 0; i < index.size(); i++) {
+    EQ(next, index[i].s_firstItem);
+    EQ(10*index[i].s_firstItem, index[i].s_minTimestamp);
+    EQ(10*(index[i].s_firstItem + index[i].s_nItems - 1), index[i].s_maxTimestamp);
+    next += index[i].s_nItems;
+  }
+  EQ(uint64_t(NITEMS), reader.getItemCount());
+
+  // Loading the index must not disturb sequential reading:
+
+  std::vector<uint8_t> result = readAll(reader);
+  close(fd);
+  ASSERT(m_data == result);
+}
+// Seek to item numbers.
+
+void
+CompressedSegmentTest::seekitem()
+{
+  writeFile();
+  int fd = open(m_name.c_str(), O_RDONLY);
+  CCompressedSegmentReader reader(fd);
+
+  uint32_t items[] = {1234, 0, NITEMS-1, 4000, 17};
+  for (int i = 0; i < sizeof(items)/sizeof(uint32_t); i++) {
+    ASSERT(reader.seekToItem(items[i]));
+    uint8_t item[256];
+    EQ(size_t(32), reader.read(item, 32));
+    uint32_t size;
+    memcpy(&size, item, sizeof(size));
+    EQ(size_t(size - 32), reader.read(item + 32, size - 32));
+    EQ(items[i], itemNumber(item));
+  }
+  // Reading continues from there:
+
+  ASSERT(reader.seekToItem(NITEMS - 2));
+  std::vector<uint8_t> result = readAll(reader);
+  EQ(size_t(2*sizeof(uint32_t) + 20 + (1 + (NITEMS-2) % 37)*4 +
+            2*sizeof(uint32_t) + 20 + (1 + (NITEMS-1) % 37)*4), result.size());
+
+  ASSERT(!reader.seekToItem(NITEMS));
+  uint8_t byte;
+  EQ(size_t(0), reader.read(&byte, 1));
+  close(fd);
+}
+// Seek to timestamps.
+
+void
+CompressedSegmentTest::seektimestamp()
+{
+  writeFile();
+  int fd = open(m_name.c_str(), O_RDONLY);
+  CCompressedSegmentReader reader(fd);
+
+  uint8_t item[256];
+  ASSERT(reader.seekToTimestamp(12345));
+  EQ(size_t(32), reader.read(item, 32));
+  EQ(uint32_t(1235), itemNumber(item));
+
+  ASSERT(reader.seekToTimestamp(20000));
+  EQ(size_t(32), reader.read(item, 32));
+  EQ(uint32_t(2000), itemNumber(item));
+
+  ASSERT(reader.seekToTimestamp(0));
+  EQ(size_t(32), reader.read(item, 32));
+  EQ(uint32_t(0), itemNumber(item));
+
+  ASSERT(!reader.seekToTimestamp(10*NITEMS));
+  close(fd);
+}
+// A segment without its index (writer died) can still be read and
+// the index is rebuilt from the block headers.
+
+void
+CompressedSegmentTest::notrailer()
+{
+  writeFile();
+  int fd = open(m_name.c_str(), O_RDWR);
+  Trailer trailer;
+  struct stat info;
+  fstat(fd, &info);
+  pread(fd, &trailer, sizeof(trailer), info.st_size - sizeof(trailer));
+  ftruncate(fd, trailer.s_indexOffset);
+
+  CCompressedSegmentReader reader(fd);
+  EQ(uint64_t(NITEMS), reader.getItemCount());
+  ASSERT(reader.seekToItem(4321));
+  uint8_t item[256];
+  EQ(size_t(32), reader.read(item, 32));
+  EQ(uint32_t(4321), itemNumber(item));
+
+  ASSERT(reader.seekToItem(0));
+  std::vector<uint8_t> result = readAll(reader);
+  close(fd);
+  ASSERT(m_data == result);
+}
+// Segments can be read from a pipe but not positioned.
+
+void
+CompressedSegmentTest::pipe_1()
+{
+  m_data.clear();
+  for (int i = 0; i < 100; i++) {
+    addItem(m_data, i);                // Small enough to fit in a pipe.
+  }
+  writeFile(1024, 1);
+
+  int fd = open(m_name.c_str(), O_RDONLY);
+  uint8_t file[65536];
+  size_t nFile = io::readData(fd, file, sizeof(file));
+  close(fd);
+  ASSERT(nFile < sizeof(file));
+
+  int fds[2];
+  EQ(0, pipe(fds));
+  io::writeData(fds[1], file, nFile);
+  close(fds[1]);
+
+  CCompressedSegmentReader reader(fds[0]);
+  CPPUNIT_ASSERT_THROW(reader.seekToItem(10), std::logic_error);
+  std::vector<uint8_t> result = readAll(reader);
+  close(fds[0]);
+  ASSERT(m_data == result);
+}
+// CRingFileBlockReader reads compressed segments transparently.
+
+void
+CompressedSegmentTest::blockreader()
+{
+  writeFile();
+  std::vector<uint8_t> result;
+  unsigned nItems = 0;
+  {
+    CRingFileBlockReader reader(m_name.c_str());
+    while (1) {
+      CRingBlockReader::DataDescriptor d = reader.read(10000);
+      if (!d.s_nBytes) {
+        free(d.s_pData);
+        break;
+      }
+      uint8_t* p = static_cast<uint8_t*>(d.s_pData);
+      result.insert(result.end(), p, p + d.s_nBytes);
+      nItems += d.s_nItems;
+      free(d.s_pData);
+    }
+  }
+  EQ(NITEMS, nItems);
+  ASSERT(m_data == result);
+}
+// A block that fails to compress is reported by the writer's thread and
+// the segment still gets its index and trailer.
+
+void
+CompressedSegmentTest::compressfail()
+{
+  int fd = open(m_name.c_str(), O_RDWR | O_TRUNC);
+  ASSERT(fd >= 0);
+  bool failed = false;
+  {
+    CCompressedSegmentWriter writer(2, 4096, 42);   // 42 is not a zlib level.
+    writer.open(fd);
+    try {
+      writer.write(m_data.data(), m_data.size());
+    }
+    catch (std::runtime_error&) {
+      failed = true;
+    }
+    try {
+      writer.close();
+    }
+    catch (std::runtime_error&) {
+      failed = true;
+    }
+    ASSERT(!writer.isOpen());
+  }
+  ASSERT(failed);
+
+  Trailer trailer;
+  struct stat info;
+  fstat(fd, &info);
+  pread(fd, &trailer, sizeof(trailer), info.st_size - sizeof(trailer));
+  ASSERT(memcmp(trailer.s_magic, TRAILER_MAGIC, sizeof(trailer.s_magic)) == 0);
+
+  lseek(fd, 0, SEEK_SET);
+  CCompressedSegmentReader reader(fd);
+  EQ(size_t(0), reader.getIndex().size());
+  close(fd);
+}
@@ -57,6 +57,7 @@ const int CDAQShm::OtherWrite = 0x20;
 
 int CDAQShm::m_nLastError(CDAQShm::Success);
 CDAQShm::Attachments CDAQShm::m_attachMap;
+CDAQShm::Attachments CDAQShm::m_mirrorMap;
 
 
 // Error message:
@@ -239,6 +240,83 @@ CDAQShm::attach(std::string name)
   return pMemory;
 }
 
+/**
+ * Connect the program with a shared memory region, mapping the part of it
+ * from offset to the end a second time immediately following the first
+ * mapping.  The result is that a region that wraps (e.g. the data segment
+ * of a ring buffer) can be accessed contiguously from any starting point.
+ * Mirrored mappings are reference counted separately from those made by
+ * attach and must be released with detachMirrored.
+ *
+ * @param name   - Name of the shared memory region.
+ * @param offset - Start of the mirrored part.  This must be a multiple of the
+ *                 page size, as must the size of the region.
+ *
+ * @return void*
+ * @retval 0 - Error, see lastError() for reason.
+ * @retval non-zero - pointer to the base of the attached region.
+ */
+void*
+CDAQShm::attachMirrored(std::string name, size_t offset)
+{
+  m_nLastError = Success;
+
+  if (m_mirrorMap.find(name) != m_mirrorMap.end()) {
+    m_mirrorMap[name].refcount++;
+    return m_mirrorMap[name].pMappingAddress;
+  }
+
+  int  prot = PROT_READ | PROT_WRITE;
+  int  fd   = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    fd   = shm_open(name.c_str(), O_RDONLY, 0);
+    prot = PROT_READ;
+  }
+  if (fd < 0) {
+    setLastErrorFromErrno();
+    return 0;
+  }
+  ssize_t fileSize = fdSize(fd);
+  long    pageSize = sysconf(_SC_PAGESIZE);
+  if ((fileSize < 0) || (offset >= static_cast<size_t>(fileSize)) ||
+      (offset % pageSize) || (fileSize % pageSize)) {
+    close(fd);
+    m_nLastError = CheckOSError;
+    errno        = EINVAL;
+    return 0;
+  }
+  size_t mirrorSize = fileSize - offset;
+
+  // Reserve address space for both views then map the file over it:
+
+  char* pMemory = static_cast<char*>(mmap(
+    NULL, fileSize + mirrorSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+  ));
+  if (pMemory == reinterpret_cast<char*>(MAP_FAILED)) {
+    setLastErrorFromErrno();
+    close(fd);
+    return 0;
+  }
+  if ((mmap(pMemory, fileSize, prot, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+      (mmap(pMemory + fileSize, mirrorSize, prot, MAP_SHARED | MAP_FIXED,
+            fd, offset) == MAP_FAILED)) {
+    setLastErrorFromErrno();
+    int e = errno;
+    munmap(pMemory, fileSize + mirrorSize);
+    close(fd);
+    errno = e;
+    return 0;
+  }
+  close(fd);
+
+  attachInformation initialInfo = {
+    pMemory, static_cast<size_t>(fileSize), 1, mirrorSize
+  };
+  m_mirrorMap[name] = initialInfo;
+
+  return pMemory;
+}
+
 /**
  * Return the number of bytes in a shared memory region:
  *
@@ -303,6 +381,38 @@ CDAQShm::detach(void* p, std::string name, size_t size)
   return false;
 }
 
+/**
+ * Detach a mapping made by attachMirrored.  As with detach this only
+ * unmaps when the reference count drops to zero.
+ *
+ * @param p    - Pointer to mapped virtual address.
+ * @param name - Name of shared memory region.
+ * @param size - Size of shared memory region (not including the mirror).
+ *
+ * @return bool
+ * @retval false - success.
+ * @retval true  - Some sort of failure that can be analyzed by lastError().
+ */
+bool
+CDAQShm::detachMirrored(void* p, std::string name, size_t size)
+{
+  Attachments::iterator pEntry = m_mirrorMap.find(name);
+  if ((pEntry == m_mirrorMap.end())            ||
+      (p != pEntry->second.pMappingAddress)    ||
+      (size != pEntry->second.mapSize)) {
+    m_nLastError = NotAttached;
+    return true;
+  }
+
+  pEntry->second.refcount--;
+  if (pEntry->second.refcount == 0) {
+    munmap(pEntry->second.pMappingAddress,
+           pEntry->second.mapSize + pEntry->second.mirrorSize);
+    m_mirrorMap.erase(pEntry);
+  }
+  return false;
+}
+
 /**
  * Return the value of the last status:
  *
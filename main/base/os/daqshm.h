@@ -63,6 +63,8 @@ public:
   static bool        create(std::string name, size_t size, unsigned int flags);
   static void*       attach(std::string name);
   static bool        detach(void* pSharedMemory, std::string name, size_t size);
+  static void*       attachMirrored(std::string name, size_t offset);
+  static bool        detachMirrored(void* pSharedMemory, std::string name, size_t size);
   static bool        remove(std::string name);
   static ssize_t     size(std::string name);
   static int         lastError();
@@ -93,6 +95,7 @@ public:
     void*        pMappingAddress;
     size_t       mapSize;
     unsigned int refcount;
+    size_t       mirrorSize;      // Bytes mapped a second time after mapSize.
   } attachInformation, *pAttachInformation;
   typedef std::map<std::string,attachInformation> Attachments;
 
@@ -103,6 +106,7 @@ private:
   static const int    m_nMessages;
   static       int    m_nLastError;
   static       Attachments  m_attachMap;
+  static       Attachments  m_mirrorMap;
 };
 
 #endif
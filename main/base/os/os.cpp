@@ -24,6 +24,9 @@
 #include <signal.h>
 #include <stdexcept>
 #include <netdb.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 
 static const unsigned NSEC_PER_SEC(1000000000); // nanoseconds/second.
@@ -116,6 +119,55 @@ Os::usleep(useconds_t usec)
   return nanosleep(&delay, &remaining);
 
  
+}
+/**
+ * Os::futexWait
+ *
+ *    Block on a process shared futex word.  The caller is put to sleep
+ *    only if *pWord still has the value expected at the time the kernel
+ *    looks at it.  This is the waiting half of the wakeup scheme used by
+ *    ring buffers that live in shared memory.
+ *
+ * @param pWord     - Pointer to the 32 bit futex word (normally in shared memory).
+ * @param expected  - Value *pWord must have for us to block.
+ * @param timeoutMs - Maximum number of milliseconds to block.
+ *
+ * @return int - 0 if woken, -1 on error/timeout with errno set e.g.:
+ *               - EAGAIN    - *pWord no longer held expected.
+ *               - ETIMEDOUT - the timeout expired.
+ *               - EINTR     - a signal interrupted the wait.
+ * @note The word is deliberately not a FUTEX_PRIVATE_FLAG futex since
+ *       the waker is generally in a different process.
+ */
+int
+Os::futexWait(volatile uint32_t* pWord, uint32_t expected, unsigned long timeoutMs)
+{
+  struct timespec timeout;
+  timeout.tv_sec  = timeoutMs/1000;
+  timeout.tv_nsec = (timeoutMs % 1000)*1000000;
+
+  return syscall(
+    SYS_futex, const_cast<uint32_t*>(pWord), FUTEX_WAIT, expected, &timeout,
+    NULL, 0
+  );
+}
+/**
+ * Os::futexWake
+ *
+ *    Wake processes blocked in futexWait on a futex word.
+ *
+ * @param pWord    - Pointer to the futex word.
+ * @param nWaiters - Maximum number of waiters to wake (INT_MAX for all).
+ *
+ * @return int - Number of waiters woken or -1 on error (errno set).
+ */
+int
+Os::futexWake(volatile uint32_t* pWord, int nWaiters)
+{
+  return syscall(
+    SYS_futex, const_cast<uint32_t*>(pWord), FUTEX_WAKE, nWaiters, NULL,
+    NULL, 0
+  );
 }
 /**
  * Os::blockSignal
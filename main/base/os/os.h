@@ -30,6 +30,7 @@
 #include <string>
 
 #include <unistd.h>
+#include <stdint.h>
 
 /**
  * Static methods that encapsulate operating system calls.
@@ -39,6 +40,9 @@ public:
   static std::string whoami();		//< Logged in userm
   static bool authenticateUser(std::string sUser, std::string sPassword);
   static int  usleep(useconds_t usec);
+  static int  futexWait(volatile uint32_t* pWord, uint32_t expected,
+                        unsigned long timeoutMs);
+  static int  futexWake(volatile uint32_t* pWord, int nWaiters);
   static int  blockSignal(int sigNum);
   static int  checkStatus(int status, int checkStatus, std::string msg);
   static int  checkNegativeStatus(int returnCode);
@@ -0,0 +1,325 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingQueue.cpp
+ *  @brief: Template implementation of CRingQueue.
+ */
+#define COMPILINGCRINGQUEUE
+#include "CRingQueue.h"
+
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <sched.h>
+
+// Limits on the adaptive spin (iterations before blocking).
+
+static const unsigned CRINGQUEUE_MINSPIN(16);
+static const unsigned CRINGQUEUE_MAXSPIN(4096);
+
+/**
+ * constructor
+ *
+ * @param capacity  - Most elements the queue can hold.  This is rounded up
+ *                    to a power of two.
+ * @param wakeLevel - As for CBufferQueue; waiters are only woken when an
+ *                    insertion leaves more than this many elements queued.
+ */
+template<class T>
+CRingQueue<T>::CRingQueue(size_t capacity, size_t wakeLevel) :
+  m_enqueuePos(0), m_dequeuePos(0), m_pCells(nullptr), m_mask(0),
+  m_nWakeLevel(wakeLevel), m_spinLimit(0),
+  m_emptyWaiters(0), m_fullWaiters(0), m_wakeGeneration(0)
+{
+  size_t n = 2;
+  while (n < capacity) n <<= 1;
+  m_mask   = n - 1;
+  m_pCells = new Cell[n];
+  for (size_t i = 0; i < n; i++) {
+    m_pCells[i].s_sequence.store(i, std::memory_order_relaxed);
+  }
+  // Spinning on a single processor just delays the thread we're waiting for.
+
+  if (std::thread::hardware_concurrency() > 1) {
+    m_spinLimit = 256;
+  }
+}
+/**
+ * destructor
+ *    As with CBufferQueue, the destroyer must ensure nobody is using
+ *    the queue.
+ */
+template<class T>
+CRingQueue<T>::~CRingQueue()
+{
+  delete []m_pCells;
+}
+
+/**
+ * queue
+ *    Enter an element in the queue, blocking while the queue is full.
+ *
+ * @param object - the object to queue (copied).
+ */
+template<class T> void
+CRingQueue<T>::queue(T object)
+{
+  while (!queuenow(object)) {
+    if (!spinFor(false)) {
+      blockUntil(false, -1, m_wakeGeneration);
+    }
+  }
+}
+/**
+ * queuenow
+ *    Enter an element in the queue if there's room.
+ *
+ * @param object - the object to queue.
+ * @return bool  - false if the queue was full.
+ */
+template<class T> bool
+CRingQueue<T>::queuenow(T object)
+{
+  Cell*  pCell;
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  while (1) {
+    pCell = &m_pCells[pos & m_mask];
+    size_t   seq  = pCell->s_sequence.load(std::memory_order_acquire);
+    intptr_t diff = intptr_t(seq) - intptr_t(pos);
+    if (diff == 0) {
+      if (m_enqueuePos.compare_exchange_weak(
+          pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      return false;                     // Full.
+    } else {
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  pCell->s_element = object;
+  pCell->s_sequence.store(pos + 1, std::memory_order_release);
+
+  if (size() > m_nWakeLevel) {
+    notify(m_emptyWaiters, m_notEmpty);
+  }
+  return true;
+}
+/**
+ * get
+ *    Remove the front element, blocking until there is one.
+ *
+ * @return T - the element.
+ */
+template<class T> T
+CRingQueue<T>::get()
+{
+  T element;
+  while (!getnow(element)) {
+    wait();
+  }
+  return element;
+}
+/**
+ * getnow
+ *    Get the front element of the queue without waiting.
+ *
+ * @param element - (output) the element, valid only if there was one.
+ * @return bool   - true if an element was gotten.
+ */
+template<class T> bool
+CRingQueue<T>::getnow(T& element)
+{
+  Cell*  pCell;
+  size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  while (1) {
+    pCell = &m_pCells[pos & m_mask];
+    size_t   seq  = pCell->s_sequence.load(std::memory_order_acquire);
+    intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+    if (diff == 0) {
+      if (m_dequeuePos.compare_exchange_weak(
+          pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      return false;                     // Empty.
+    } else {
+      pos = m_dequeuePos.load(std::memory_order_relaxed);
+    }
+  }
+  element = pCell->s_element;
+  pCell->s_sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+  notify(m_fullWaiters, m_notFull);
+  return true;
+}
+/**
+ * getAll
+ *    Empty the queue.
+ *
+ * @return std::list<T> - the elements in queue order; empty if there were none.
+ */
+template<class T> std::list<T>
+CRingQueue<T>::getAll()
+{
+  std::list<T> result;
+  T element;
+  while (getnow(element)) {
+    result.push_back(element);
+  }
+  return result;
+}
+/**
+ * setWakeThreshold
+ *    See CBufferQueue::setWakeThreshold.
+ *
+ * @param level - the new wake level.
+ */
+template<class T> void
+CRingQueue<T>::setWakeThreshold(size_t level)
+{
+  m_nWakeLevel = level;
+}
+/**
+ * wait
+ *    Wait until more than the wake level elements are queued, wake() is
+ *    called or the timeout expires.  Unlike CBufferQueue this returns at
+ *    once if the wake level is already exceeded.  As with CBufferQueue,
+ *    there may be no elements on return if there are several consumers.
+ *
+ * @param timeout - ms to wait.  -1 means the same half second CBufferQueue
+ *                  uses to cover lost wakeups.
+ */
+template<class T> void
+CRingQueue<T>::wait(int timeout)
+{
+  unsigned generation = m_wakeGeneration;
+  if (!spinFor(true)) {
+    blockUntil(true, timeout, generation);
+  }
+}
+/**
+ * wake
+ *    Wake all threads in wait() (see CBufferQueue::wake).
+ */
+template<class T> void
+CRingQueue<T>::wake()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_wakeGeneration++;
+  }
+  m_notEmpty.notify_all();
+}
+/**
+ * size
+ *    @return size_t - the number of elements queued.  This is only a
+ *                     snapshot if other threads are using the queue.
+ */
+template<class T> size_t
+CRingQueue<T>::size() const
+{
+  size_t out = m_dequeuePos.load(std::memory_order_acquire);
+  size_t in  = m_enqueuePos.load(std::memory_order_acquire);
+  return in - out;
+}
+
+/*---------------------------------------------------------------------------
+ * Private methods:
+ */
+
+/**
+ * spinFor
+ *    Spin waiting for elements (or room).  The spin limit doubles each time
+ *    a spin succeeds and halves each time one doesn't.
+ *
+ * @param wantElements - true to wait for elements, false for room.
+ * @return bool        - true if the wait was satisfied.
+ */
+template<class T> bool
+CRingQueue<T>::spinFor(bool wantElements)
+{
+  unsigned limit = m_spinLimit.load(std::memory_order_relaxed);
+  if (!limit) return false;
+  for (unsigned i = 0; i < limit; i++) {
+    size_t n = size();
+    if (wantElements ? (n > m_nWakeLevel) : (n < capacity())) {
+      if (limit < CRINGQUEUE_MAXSPIN) {
+        m_spinLimit.store(limit*2, std::memory_order_relaxed);
+      }
+      return true;
+    }
+    pause();
+  }
+  if (limit > CRINGQUEUE_MINSPIN) {
+    m_spinLimit.store(limit/2, std::memory_order_relaxed);
+  }
+  return false;
+}
+/**
+ * blockUntil
+ *    Block on the appropriate condition variable.  The waiter count is
+ *    raised and the queue re-checked with the lock held; notify() looks at
+ *    the count after its update and takes the lock to signal, so a wakeup
+ *    can't fall between our check and our wait.
+ *
+ * @param wantElements - true to wait for elements, false for room.
+ * @param timeout      - ms to wait (-1 for the default half second).
+ * @param generation   - wake generation when the caller decided to wait.
+ */
+template<class T> void
+CRingQueue<T>::blockUntil(bool wantElements, int timeout, unsigned generation)
+{
+  std::atomic<unsigned>&   waiters(wantElements ? m_emptyWaiters : m_fullWaiters);
+  std::condition_variable& cond(wantElements ? m_notEmpty : m_notFull);
+  if (timeout < 0) timeout = 500;
+
+  std::unique_lock<std::mutex> guard(m_lock);
+  waiters++;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  cond.wait_for(guard, std::chrono::milliseconds(timeout), [&]() {
+    size_t n = size();
+    return (wantElements ? (n > m_nWakeLevel) : (n < capacity())) ||
+      (m_wakeGeneration != generation);
+  });
+  waiters--;
+}
+/**
+ * notify
+ *    Wake threads blocked on a condition, if there are any.
+ *
+ * @param waiters - count of threads blocked on the condition.
+ * @param cond    - the condition.
+ */
+template<class T> void
+CRingQueue<T>::notify(std::atomic<unsigned>& waiters, std::condition_variable& cond)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    cond.notify_all();
+  }
+}
+/**
+ * pause
+ *    Be polite to a hyperthread sibling while spinning.
+ */
+template<class T> void
+CRingQueue<T>::pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  sched_yield();
+#endif
+}
@@ -0,0 +1,117 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingQueue.h
+ *  @brief: Bounded lock free queue with the CBufferQueue interface.
+ */
+#ifndef CRINGQUEUE_H
+#define CRINGQUEUE_H
+
+#include <stddef.h>
+#include <list>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @class CRingQueue
+ *    A drop in replacement for CBufferQueue for queues on hot paths.
+ *    The elements live in a fixed circular array of cells each with a
+ *    sequence number (the bounded MPMC queue of D. Vyukov), so queue and
+ *    getnow take no lock, allocate nothing and any number of threads can
+ *    produce and consume.
+ *
+ *    The queue is bounded.  queue() blocks while the queue is full so the
+ *    capacity must be at least the number of elements that can be in the
+ *    queue at once (e.g. the size of a buffer pool that circulates through
+ *    it) or producers are throttled.
+ *
+ *    Threads that have to wait (get/wait on an empty queue, queue on a full
+ *    one) first spin a while and then block on a condition variable.  The
+ *    spin budget adapts: it grows when spinning pays off and shrinks when
+ *    it doesn't.  Waking blocked threads costs a lock only if some thread
+ *    is actually blocked.
+ *
+ *    Wake thresholds, wait() and wake() behave as for CBufferQueue.
+ */
+template<class T>
+class CRingQueue
+{
+private:
+  typedef struct _Cell {
+    std::atomic<size_t> s_sequence;
+    T                   s_element;
+  } Cell;
+  static const size_t CACHE_LINE = 64;
+
+  // Producers and consumers each get their own cache line:
+
+  alignas(CACHE_LINE) std::atomic<size_t> m_enqueuePos;
+  alignas(CACHE_LINE) std::atomic<size_t> m_dequeuePos;
+
+  alignas(CACHE_LINE) Cell*         m_pCells;
+  size_t                          m_mask;
+  size_t                          m_nWakeLevel;
+  std::atomic<unsigned>           m_spinLimit;
+
+  alignas(CACHE_LINE) std::mutex  m_lock;
+  std::condition_variable         m_notEmpty;
+  std::condition_variable         m_notFull;
+  std::atomic<unsigned>           m_emptyWaiters;
+  std::atomic<unsigned>           m_fullWaiters;
+  std::atomic<unsigned>           m_wakeGeneration;
+
+public:
+  CRingQueue(size_t capacity = 1024, size_t wakeLevel = 0);
+  virtual ~CRingQueue();
+
+  // Queues are not copyable.
+private:
+  CRingQueue(const CRingQueue<T>& rhs);
+  CRingQueue<T>& operator=(const CRingQueue<T>& rhs);
+  int operator==(const CRingQueue<T>& rhs) const;
+  int operator!=(const CRingQueue<T>& rhs) const;
+
+public:
+  void queue(T object);         //!< Add object to queue (blocks if full).
+  T    get();                   //!< dequeue object, blocking if needed.
+  bool getnow(T& element);      //!< Get without wait (nowait = now).
+  bool queuenow(T object);      //!< Queue without wait; false if full.
+  std::list<T> getAll();        //!< Empty the queue..
+  void setWakeThreshold(size_t level);
+  void wait(int timeout = -1);  //!< Wait for elements.
+  void wake();                  //!< Wake waiters.
+
+  size_t size() const;          //!< Approximate number of elements.
+  size_t capacity() const { return m_mask + 1; }
+
+private:
+  bool spinFor(bool wantElements);
+  void blockUntil(bool wantElements, int timeout, unsigned generation);
+  void notify(std::atomic<unsigned>& waiters, std::condition_variable& cond);
+  static void pause();
+};
+
+// As for CBufferQueue, the template implementation is included so that
+// inline instantiation works.
+
+#ifndef  COMPILINGCRINGQUEUE
+#include <CRingQueue.cpp>
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CWorkerPool.cpp
+ *  @brief: Implement the worker pool.
+ */
+#include "CWorkerPool.h"
+
+/**
+ * constructor
+ *
+ * @param nThreads - Threads that do work, counting the one that calls
+ *                   run.  0 or 1 means run() does everything itself.
+ */
+CWorkerPool::CWorkerPool(unsigned nThreads) :
+  m_generation(0), m_busy(0), m_exiting(false), m_pWork(0), m_nItems(0)
+{
+  for (unsigned i = 1; i < nThreads; i++) {
+    m_threads.emplace_back(&CWorkerPool::workerLoop, this, i);
+  }
+}
+/**
+ * destructor
+ *    Tell the workers to exit and wait for them.
+ */
+CWorkerPool::~CWorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_exiting = true;
+  }
+  m_start.notify_all();
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    m_threads[i].join();
+  }
+}
+
+/**
+ * run
+ *    Do work on all items, in parallel, and wait for it to be done.
+ *
+ * @param nItems - Number of items.
+ * @param work   - Called with ranges of item indices.
+ */
+void
+CWorkerPool::run(size_t nItems, const Work& work)
+{
+  if (m_threads.empty() || (nItems < 2)) {
+    if (nItems) work(0, nItems);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_pWork  = &work;
+    m_nItems = nItems;
+    m_busy   = m_threads.size();
+    m_error  = std::exception_ptr();
+    m_generation++;
+  }
+  m_start.notify_all();
+
+  doChunk(0);
+
+  std::unique_lock<std::mutex> guard(m_lock);
+  m_done.wait(guard, [this]() { return m_busy == 0; });
+  m_pWork = 0;
+  if (m_error) {
+    std::exception_ptr error = m_error;
+    m_error = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+/*---------------------------------------------------------------------------
+ * Private methods:
+ */
+
+/**
+ * workerLoop
+ *    Worker thread: wait for a run, do our chunk, report we're done.
+ *
+ * @param index - Our chunk number.
+ */
+void
+CWorkerPool::workerLoop(unsigned index)
+{
+  unsigned seen = 0;
+  while (1) {
+    {
+      std::unique_lock<std::mutex> guard(m_lock);
+      m_start.wait(guard, [&]() { return m_exiting || (m_generation != seen); });
+      if (m_exiting) return;
+      seen = m_generation;
+    }
+    doChunk(index);
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_busy--;
+    }
+    m_done.notify_one();
+  }
+}
+/**
+ * doChunk
+ *    Do one thread's share of the items.  Exceptions are saved for run.
+ *
+ * @param index - Chunk number.
+ */
+void
+CWorkerPool::doChunk(unsigned index)
+{
+  size_t nChunks = size();
+  size_t first   = (m_nItems * index)/nChunks;
+  size_t last    = (m_nItems * (index + 1))/nChunks;
+  if (first == last) return;
+  try {
+    (*m_pWork)(first, last);
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_error = std::current_exception();
+  }
+}
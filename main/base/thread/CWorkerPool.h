@@ -0,0 +1,79 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CWorkerPool.h
+ *  @brief: Fixed pool of threads that share out index ranges of work.
+ */
+#ifndef CWORKERPOOL_H
+#define CWORKERPOOL_H
+
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/**
+ * @class CWorkerPool
+ *    Runs a function over the items 0..n-1 of some array of independent
+ *    work in parallel.  The items are split into contiguous chunks, one per
+ *    thread; the thread calling run() does the first chunk itself and
+ *    returns when all chunks are done.  Since each item has a fixed place
+ *    in the caller's array, the order of the results is the order of the
+ *    items no matter which thread finishes first.
+ *
+ *    run() must only be called by one thread at a time.  An exception
+ *    thrown by the work in any thread is rethrown by run() (if several
+ *    threw, one of them).
+ */
+class CWorkerPool
+{
+public:
+  typedef std::function<void(size_t first, size_t last)> Work; // [first, last)
+
+private:
+  std::vector<std::thread>  m_threads;
+  std::mutex                m_lock;
+  std::condition_variable   m_start;
+  std::condition_variable   m_done;
+  unsigned                  m_generation;   // Bumped for each run.
+  unsigned                  m_busy;         // Workers not done this run.
+  bool                      m_exiting;
+  const Work*               m_pWork;
+  size_t                    m_nItems;
+  std::exception_ptr        m_error;
+
+public:
+  CWorkerPool(unsigned nThreads);
+  virtual ~CWorkerPool();
+
+private:
+  CWorkerPool(const CWorkerPool&);
+  CWorkerPool& operator=(const CWorkerPool&);
+
+public:
+  unsigned size() const { return m_threads.size() + 1; } // Includes the caller.
+  void     run(size_t nItems, const Work& work);
+
+private:
+  void   workerLoop(unsigned index);
+  void   doChunk(unsigned index);
+};
+
+#endif
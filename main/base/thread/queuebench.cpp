@@ -0,0 +1,132 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+// Compare CBufferQueue and CRingQueue hand offs.
+// Each measurement circulates a pool of buffers the way the readout
+// programs do: producer threads get a buffer from a free queue and queue
+// it to a filled queue; consumer threads get it from the filled queue
+// and return it to the free queue.  Throughput in hand offs/second is
+// reported for each queue type and thread count.
+//
+// Usage:
+//    queuebench ?seconds? ?poolsize? ?maxthreads?
+//
+// Defaults are 2 seconds per measurement, a 32 buffer pool (the VM-USB
+// pool size) and up to 4 producers and 4 consumers.
+//
+#include <CBufferQueue.h>
+#include <CRingQueue.h>
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdlib.h>
+#include <time.h>
+
+static double
+now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
+
+// Run one measurement.  Returns hand offs per second.
+// The buffers are just integers; a 0 tells a consumer to exit.
+
+template<class Q> double
+measure(Q& freeQ, Q& filledQ, unsigned pool, unsigned nProducers,
+        unsigned nConsumers, double seconds)
+{
+  for (unsigned i = 1; i <= pool; i++) {
+    freeQ.queue(i);
+  }
+  std::atomic<bool>          done(false);
+  std::atomic<unsigned long> handoffs(0);
+  std::vector<std::thread>   threads;
+
+  for (unsigned i = 0; i < nProducers; i++) {
+    threads.emplace_back([&]() {
+      unsigned long n = 0;
+      while (!done) {
+        unsigned long b = freeQ.get();
+        filledQ.queue(b);
+        n++;
+      }
+      handoffs += n;
+    });
+  }
+  for (unsigned i = 0; i < nConsumers; i++) {
+    threads.emplace_back([&]() {
+      while (1) {
+        unsigned long b = filledQ.get();
+        if (!b) break;
+        freeQ.queue(b);
+      }
+    });
+  }
+  double start = now();
+  usleep(seconds*1.0e6);
+  done = true;
+  double elapsed = now() - start;
+
+  // Producers may be blocked in get; feed them until they've all seen done.
+
+  for (unsigned i = 0; i < nProducers; i++) {
+    freeQ.queue(pool + 1 + i);
+  }
+  for (unsigned i = 0; i < nProducers; i++) {
+    threads[i].join();
+  }
+  for (unsigned i = 0; i < nConsumers; i++) {
+    filledQ.queue(0);
+  }
+  for (unsigned i = 0; i < nConsumers; i++) {
+    threads[nProducers + i].join();
+  }
+  freeQ.getAll();
+  filledQ.getAll();
+
+  return handoffs/elapsed;
+}
+
+int main(int argc, char** argv)
+{
+  double   seconds    = 2.0;
+  unsigned pool       = 32;
+  unsigned maxThreads = 4;
+
+  if (argc > 1) seconds    = strtod(argv[1], 0);
+  if (argc > 2) pool       = strtoul(argv[2], 0, 0);
+  if (argc > 3) maxThreads = strtoul(argv[3], 0, 0);
+
+  std::cout << "producers consumers CBufferQueue/s CRingQueue/s ratio\n";
+  for (unsigned n = 1; n <= maxThreads; n *= 2) {
+    CBufferQueue<unsigned long> lockedFree, lockedFilled;
+    double locked = measure(lockedFree, lockedFilled, pool, n, n, seconds);
+
+    // Room for the pool plus the shutdown buffers:
+
+    CRingQueue<unsigned long> ringFree(2*(pool + n)), ringFilled(2*(pool + n));
+    double ring = measure(ringFree, ringFilled, pool, n, n, seconds);
+
+    std::cout << n << " " << n << " " << locked << " " << ring << " "
+              << ring/locked << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -17,10 +17,12 @@
 #include "CDataSourceFactory.h"
 
 #include "CFileDataSource.h"
+#include "CMappedFileDataSource.h"
 #include "CRingDataSource.h"
 
 #include <URL.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 /**
  * makeSource
@@ -91,3 +93,35 @@ CDataSourceFactory::makeSource(std::string uri,
 
   return pSource;
 }
+/**
+ * makeMappedSource
+ *
+ *  Same as makeSource but file: URIs for regular, uncompressed files
+ *  produce a CMappedFileDataSource.  That maps the file rather than
+ *  reading it, which is much faster for offline processing of big files.
+ *
+ * @param uri  - Uniform resource identifier of the source.
+ * @param sample - Vector of data types that are sampled.
+ * @param exclude - Vector of data types not to be returned from the source.
+ *
+ * @return CDataSource* - Pointer to the returned data  source.
+ * @throw - see makeSource.
+ */
+CDataSource*
+CDataSourceFactory::makeMappedSource(std::string uri,
+				     std::vector<uint16_t> sample, std::vector<uint16_t>exclude)
+{
+  if (uri != std::string("-")) {
+    URL parsedURI(uri);
+    if (parsedURI.getProto() == std::string("file")) {
+      int fd = open(parsedURI.getPath().c_str(), O_RDONLY);
+      if (fd >= 0) {
+	if (CMappedFileDataSource::canMap(fd)) {
+	  return new CMappedFileDataSource(fd, exclude);
+	}
+	close(fd);
+      }
+    }
+  }
+  return makeSource(uri, sample, exclude);
+}
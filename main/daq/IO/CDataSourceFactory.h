@@ -42,6 +42,8 @@ class CDataSourceFactory {
 public:
   static CDataSource* makeSource(std::string uri, 
 				     std::vector<uint16_t> sample, std::vector<uint16_t>exclude);
+  static CDataSource* makeMappedSource(std::string uri,
+				     std::vector<uint16_t> sample, std::vector<uint16_t>exclude);
 };
 
 #endif
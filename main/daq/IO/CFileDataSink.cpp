@@ -18,11 +18,13 @@
 #include <CRingItem.h>
 #include <DataFormat.h>
 #include <io.h>
+#include <CCompressedSegmentWriter.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <string.h>
 #include <iostream>
+#include <stdexcept>
 
 /**! Construct from a file descriptor
 * Ownership of this file descriptor is transferred to the
@@ -33,7 +35,7 @@
 * \throw std::string
 */
 CFileDataSink::CFileDataSink(int fd)
-    : m_fd(fd)
+    : m_fd(fd), m_pCompressor(0)
 {
   if (!isWritable()) {
     throw std::string("CFileDataSink::CFileDataSink(int) file descriptor is not write only");
@@ -57,7 +59,7 @@ CFileDataSink::CFileDataSink(int fd)
 *        errno so the user can know why the file could not be opened.
 */
 CFileDataSink::CFileDataSink(std::string fname)
-    : m_fd(-1)
+    : m_fd(-1), m_pCompressor(0)
 {
 
   // Open or create if the file doesn't exist
@@ -85,6 +87,17 @@ CFileDataSink::CFileDataSink(std::string fname)
 */
 CFileDataSink::~CFileDataSink()
 {
+  // Finish off the compressed segment (writes the index):
+
+  if (m_pCompressor) {
+    try {
+      m_pCompressor->close();
+    }
+    catch (...) {
+      std::cerr << "CFileDataSink - failed to finish the compressed segment\n";
+    }
+    delete m_pCompressor;
+  }
 
   // Can't close stdout
   if (m_fd!=STDOUT_FILENO && m_fd>0) {
@@ -131,7 +144,11 @@ void CFileDataSink::putItem(const CRingItem& item)
 void CFileDataSink::put(const void* pData, size_t nBytes)
 {
     try {
-        io::writeData(m_fd, pData, nBytes);
+        if (m_pCompressor) {
+            m_pCompressor->write(pData, nBytes);
+        } else {
+            io::writeData(m_fd, pData, nBytes);
+        }
     } catch (int err) {
       errno = err;                    // CErrnoException captures the global errno.
       std::string errmsg("CFileDataSink::putItem(const CRingItem&)"); 
@@ -142,6 +159,33 @@ void CFileDataSink::put(const void* pData, size_t nBytes)
 }
 
 
+/**
+ * compress
+ *    Write the rest of the file as a compressed event segment.  Must be
+ *    called before anything is put.  The data put must be whole ring items
+ *    (though they can be split across calls to put).
+ *
+ *   @param nThreads - number of threads that compress blocks.
+ *
+ * @throw std::logic_error if already compressing.
+ */
+void CFileDataSink::compress(unsigned nThreads)
+{
+    if (m_pCompressor) {
+        throw std::logic_error("CFileDataSink::compress - already compressing");
+    }
+    m_pCompressor = new CCompressedSegmentWriter(nThreads);
+    try {
+        m_pCompressor->open(m_fd);
+    } catch (int err) {
+        delete m_pCompressor;
+        m_pCompressor = 0;
+        errno = err;
+        throw CErrnoException("CFileDataSink::compress writing the segment header");
+    }
+}
+
+
 /**! Check if write operates are allowed on file
 *
 * \throw CErrnoException if fcntl failed while checking
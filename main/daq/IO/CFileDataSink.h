@@ -24,6 +24,7 @@
 #include <CErrnoException.h>
 
 class CRingItem;
+class CCompressedSegmentWriter;
 
 ///! \brief A "file" data sink
 /**!
@@ -31,11 +32,16 @@ class CRingItem;
 *   prefer constructing from a filename rather than a file
 *   descriptor because this reduces the risk for leaking a 
 *   file.
+*
+*   If compress() is called before the first put, the file is written
+*   as a compressed event segment (see CCompressedSegment.h) which
+*   CFileDataSource reads transparently.
 */
 class CFileDataSink : public CDataSink
 {
 private: 
     int m_fd;  ///!< The file descriptor
+    CCompressedSegmentWriter* m_pCompressor; ///!< Null if not compressing.
 
 public:
     /**! Constructors
@@ -62,6 +68,8 @@ public:
     virtual void putItem(const CRingItem& item);
     virtual void put(const void* pData, size_t nBytes);
 
+    void compress(unsigned nThreads = 1);
+
     /**! Flush file to syncronize
     */
     void flush()
@@ -25,9 +25,13 @@
 #include <ErrnoException.h>
 #include <CInvalidArgumentException.h>
 #include <io.h>
+#include <CCompressedSegmentReader.h>
+#include <CRingItemIndex.h>
 
 #include <string>
 #include <string.h>
+#include <errno.h>
+#include <stdexcept>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -53,7 +57,8 @@ using std::string;
 */
 CFileDataSource::CFileDataSource(URL& url, vector<uint16_t> exclusionList) :
   m_fd(-1),
-  m_url(*(new URL(url)))
+  m_url(*(new URL(url))),
+  m_formatKnown(false), m_pCompressed(0), m_peekCursor(0), m_pIndex(0)
 {
   for (int i=0; i < exclusionList.size(); i++) {
     m_exclude.insert(exclusionList[i]);
@@ -64,7 +69,8 @@ CFileDataSource::CFileDataSource(URL& url, vector<uint16_t> exclusionList) :
  * construtor from fd:
  */
 CFileDataSource::CFileDataSource(int fd, vector<uint16_t> exclusionlist) :
-  m_fd(fd),  m_url(*(new URL("file://stdin/junk")))
+  m_fd(fd),  m_url(*(new URL("file://stdin/junk"))),
+  m_formatKnown(false), m_pCompressed(0), m_peekCursor(0), m_pIndex(0)
 {
   for (int i=0; i < exclusionlist.size(); i++) {
     m_exclude.insert(exclusionlist[i]);
@@ -79,6 +85,8 @@ CFileDataSource::CFileDataSource(int fd, vector<uint16_t> exclusionlist) :
 CFileDataSource::~CFileDataSource()
 {
   delete &m_url;
+  delete m_pCompressed;
+  delete m_pIndex;
   close(m_fd);
 }
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -116,13 +124,124 @@ CFileDataSource::getItem()
 void CFileDataSource::read(char* pBuffer, size_t nBytes)
 {
   if (! eof() ) {
-    size_t nRead = io::readData(m_fd, pBuffer, nBytes);
+    size_t nRead = readData(pBuffer, nBytes);
 
     if (nRead != nBytes) {
       setEOF(true);
     }
   }
 }
+/*!
+  Position the file so that the next item read is item number item
+  (the first item in the file is 0).  Compressed segments use their
+  block index.  Uncompressed files are skipped through from the closest
+  indexed item before it or, if there's no index, from the start.
+
+  \param item - number of the item.
+  \return bool - false if there is no such item (the source is then at
+                 end of file).
+  \throw CErrnoException - if the file can't be positioned (e.g. a pipe).
+*/
+bool
+CFileDataSource::seekToItem(uint64_t item)
+{
+  if (!m_formatKnown) checkFormat();
+  setEOF(false);
+  if (m_pCompressed) {
+    bool found;
+    try {
+      found = m_pCompressed->seekToItem(item);
+    }
+    catch (std::logic_error& e) {
+      errno = ESPIPE;
+      throw CErrnoException("Seeking a compressed file data source");
+    }
+    if (!found) setEOF(true);
+    return found;
+  }
+  const CRingItemIndex::Entry* pStart = indexUsable() ? m_pIndex->findItem(item) : 0;
+  position(pStart ? pStart->s_offset : 0);
+  RingItemHeader header;
+  for (uint64_t i = pStart ? pStart->s_itemNumber : 0; i < item; i++) {
+    if (io::readData(m_fd, &header, sizeof(header)) != sizeof(header)) {
+      setEOF(true);
+      return false;
+    }
+    off_t skip = getItemSize(header) - sizeof(header);
+    if (lseek(m_fd, skip, SEEK_CUR) < 0) {
+      throw CErrnoException("Seeking file data source");
+    }
+  }
+  return true;
+}
+/*!
+  Position the file at the first item, in file order, whose body header
+  timestamp is at least timestamp.  Compressed segments use the
+  timestamp range in their block index to only look at one block.
+  Uncompressed files are read from the closest indexed item before it or,
+  if there's no index, from the start.
+
+  \param timestamp - the timestamp.
+  \return bool - false if no item has a timestamp that big (the source is
+                 then at end of file).
+  \throw CErrnoException - if the file can't be positioned (e.g. a pipe).
+*/
+bool
+CFileDataSource::seekToTimestamp(uint64_t timestamp)
+{
+  if (!m_formatKnown) checkFormat();
+  setEOF(false);
+  if (m_pCompressed) {
+    bool found;
+    try {
+      found = m_pCompressed->seekToTimestamp(timestamp);
+    }
+    catch (std::logic_error& e) {
+      errno = ESPIPE;
+      throw CErrnoException("Seeking a compressed file data source");
+    }
+    if (!found) setEOF(true);
+    return found;
+  }
+  const CRingItemIndex::Entry* pStart =
+    indexUsable() ? m_pIndex->findTimestamp(timestamp) : 0;
+  position(pStart ? pStart->s_offset : 0);
+  while (1) {
+    off_t here = lseek(m_fd, 0, SEEK_CUR);
+    CRingItem* pItem = getItemFromFile();
+    if (!pItem) {
+      setEOF(true);
+      return false;
+    }
+    bool found = pItem->hasBodyHeader() &&
+      (pItem->getEventTimestamp() != CompressedSegment::NO_TIMESTAMP) &&
+      (pItem->getEventTimestamp() >= timestamp);
+    delete pItem;
+    if (found) {
+      lseek(m_fd, here, SEEK_SET);
+      return true;
+    }
+  }
+}
+/*!
+  Use a ring item index to speed up seeks.  This is done automatically
+  for file URLs if the index sidecar is next to the file.
+
+  \param indexFile - the index sidecar file.
+  \return bool - false if the index could not be read.
+*/
+bool
+CFileDataSource::loadIndex(const std::string& indexFile)
+{
+  CRingItemIndex* pIndex = new CRingItemIndex;
+  if (!pIndex->read(indexFile)) {
+    delete pIndex;
+    return false;
+  }
+  delete m_pIndex;
+  m_pIndex = pIndex;
+  return true;
+}
 //////////////////////////////////////////////////////////////////////////////////////////
 //
 // Private utilties.
@@ -142,7 +261,7 @@ CFileDataSource::getItemFromFile()
 
   RingItemHeader header;
 
-  int nRead = io::readData(m_fd, &header, sizeof(header));
+  int nRead = readData(&header, sizeof(header));
   if (nRead != sizeof(header)) {
     return reinterpret_cast<CRingItem*>(NULL);
   }
@@ -152,7 +271,7 @@ CFileDataSource::getItemFromFile()
   // Read the remainder of the data:
 
   uint8_t* pBody = new uint8_t[bodysize];
-  nRead          = io::readData(m_fd, pBody, bodysize);
+  nRead          = readData(pBody, bodysize);
   if (nRead != bodysize) {
     delete []pBody;
     return reinterpret_cast<CRingItem*>(NULL);
@@ -216,6 +335,7 @@ CFileDataSource::openFile()
   if (m_fd == -1) {
     throw CErrnoException("Opening file data source");
   }
+  loadIndex(CRingItemIndex::indexFileName(fullPath)); // Optional.
 }
 /*
 **  Return the size of an item.  This does the right thing in the presence
@@ -233,3 +353,87 @@ CFileDataSource::getItemSize(RingItemHeader& header)
 
   return size;
 }
+/*
+** Read data from the file.  The first read checks for a compressed
+** segment.  If the file is one, data come from the decompressor.
+** Otherwise the bytes read to check are given back first.
+**
+** Parameters:
+**    pBuffer - where the data go.
+**    nBytes  - how many bytes are wanted.
+** Returns:
+**    number of bytes read (less than nBytes only at end of file).
+*/
+size_t
+CFileDataSource::readData(void* pBuffer, size_t nBytes)
+{
+  if (!m_formatKnown) checkFormat();
+  if (m_pCompressed) {
+    return m_pCompressed->read(pBuffer, nBytes);
+  }
+  uint8_t* p     = reinterpret_cast<uint8_t*>(pBuffer);
+  size_t   nRead = 0;
+  if (m_peekCursor < m_peeked.size()) {
+    nRead = m_peeked.size() - m_peekCursor;
+    if (nRead > nBytes) nRead = nBytes;
+    memcpy(p, &m_peeked[m_peekCursor], nRead);
+    m_peekCursor += nRead;
+  }
+  if (nRead < nBytes) {
+    nRead += io::readData(m_fd, p + nRead, nBytes - nRead);
+  }
+  return nRead;
+}
+/*
+** Read the start of the file to see if it's a compressed segment.
+** If so the decompressor is created.  Otherwise the bytes read are saved
+** to be given back by readData.
+*/
+void
+CFileDataSource::checkFormat()
+{
+  CompressedSegment::FileHeader header;
+  size_t n = io::readData(m_fd, &header, sizeof(header));
+  if (CompressedSegment::isCompressed(&header, n)) {
+    m_pCompressed = new CCompressedSegmentReader(m_fd, &header);
+  } else {
+    uint8_t* p = reinterpret_cast<uint8_t*>(&header);
+    m_peeked.assign(p, p + n);
+    m_peekCursor = 0;
+  }
+  m_formatKnown = true;
+}
+/*
+** Position an uncompressed file.  The saved format check bytes are no
+** longer needed.
+**
+** Parameters:
+**    offset - file offset of a ring item.
+*/
+void
+CFileDataSource::position(off_t offset)
+{
+  if (lseek(m_fd, offset, SEEK_SET) < 0) {
+    throw CErrnoException("Positioning file data source");
+  }
+  m_peeked.clear();
+  m_peekCursor = 0;
+}
+/*
+** Determine if there's an index that describes this (uncompressed) file.
+** An index for a different size file (e.g. the file was still being
+** written when it was made) is dropped.
+*/
+bool
+CFileDataSource::indexUsable()
+{
+  if (!m_pIndex) return false;
+
+  struct stat info;
+  if ((fstat(m_fd, &info) < 0) || (uint64_t(info.st_size) != m_pIndex->getByteCount())) {
+    delete m_pIndex;
+    m_pIndex = 0;
+    return false;
+  }
+  return true;
+}
@@ -22,19 +22,29 @@
 
 #include <set>
 #include <vector>
+#include <string>
 #include <stdint.h>
+#include <sys/types.h>
 
 // Forward class definitions:
 
 class URL;
 class CRingItem;
 struct _RingItemHeader;
+class CCompressedSegmentReader;
+class CRingItemIndex;
 
 /*!
   Provide a data source from an event file.  This allows users to directly dump
   an event file to stdout.  The data source returns sequential ring items
   that are not in the excluded set of data types.
 
+  Compressed event segments (see CCompressedSegment.h) are recognized
+  and decompressed transparently.  If the file is seekable,
+  seekToItem and seekToTimestamp can position it.  If an uncompressed
+  file has a ring item index (see CRingItemIndex.h) that's used to
+  avoid reading the file from the start.
+
 */
 
 class CFileDataSource : public CDataSource
@@ -45,6 +55,11 @@ private:
   int                  m_fd;	  // File descriptor open on the event source.
   std::set<uint16_t>   m_exclude; // item types to exclude from the return set.
   URL&                 m_url;	  // URI that points to the file.
+  bool                 m_formatKnown;
+  CCompressedSegmentReader* m_pCompressed; // Null if the file is not compressed.
+  std::vector<uint8_t> m_peeked;    // Read when checking the format.
+  size_t               m_peekCursor;
+  CRingItemIndex*      m_pIndex;    // Null if there's no index.
 
   // Constructors and other canonicals:
 
@@ -66,6 +81,10 @@ public:
 
   void read(char* pBuffer, size_t nBytes);
 
+  bool seekToItem(uint64_t item);
+  bool seekToTimestamp(uint64_t timestamp);
+  bool loadIndex(const std::string& indexFile);
+
   // utilities:
 
 private:
@@ -73,6 +92,10 @@ private:
   bool       acceptable(CRingItem* item) const;
   void       openFile();
   uint32_t   getItemSize(_RingItemHeader& header);
+  size_t     readData(void* pBuffer, size_t nBytes);
+  void       checkFormat();
+  void       position(off_t offset);
+  bool       indexUsable();
 };
 
 #endif
@@ -0,0 +1,282 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CMappedFileDataSource.cpp
+ *  @brief: Implement the memory mapped file data source.
+ */
+#include <config.h>
+#include "CMappedFileDataSource.h"
+
+#include <URL.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <ErrnoException.h>
+#include <CInvalidArgumentException.h>
+#include <CCompressedSegment.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+/**
+ * constructor
+ *    Open and map a file given its URL.
+ *
+ * @param url           - file: URL of the event file.
+ * @param exclusionlist - item types not to return.
+ * @param windowSize    - Most of the file mapped at any time.
+ * @throw CInvalidArgumentException - not a file URL or a file that can't
+ *                                    be mapped.
+ * @throw CErrnoException - the file can't be opened.
+ */
+CMappedFileDataSource::CMappedFileDataSource(
+    URL& url, std::vector<uint16_t> exclusionlist, size_t windowSize
+) :
+    m_fd(-1), m_exclude(exclusionlist.begin(), exclusionlist.end()),
+    m_nWindowBudget(windowSize)
+{
+    if (url.getProto() != std::string("file")) {
+        throw CInvalidArgumentException(std::string(url), "A file URL only",
+                                        "Opening a mapped file data source");
+    }
+    std::string path = url.getPath();
+    m_fd = open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        throw CErrnoException("Opening mapped file data source");
+    }
+    try {
+        init();
+    }
+    catch (...) {
+        close(m_fd);
+        throw;
+    }
+}
+/**
+ * constructor
+ *    Map an open file.  The data source owns (closes) the file
+ *    descriptor.
+ *
+ * @param fd            - file descriptor open on a regular file.
+ * @param exclusionlist - item types not to return.
+ * @param windowSize    - Most of the file mapped at any time.
+ * @throw CInvalidArgumentException - the file can't be mapped.
+ */
+CMappedFileDataSource::CMappedFileDataSource(
+    int fd, std::vector<uint16_t> exclusionlist, size_t windowSize
+) :
+    m_fd(fd), m_exclude(exclusionlist.begin(), exclusionlist.end()),
+    m_nWindowBudget(windowSize)
+{
+    init();
+}
+/**
+ * destructor
+ */
+CMappedFileDataSource::~CMappedFileDataSource()
+{
+    unmap();
+    close(m_fd);
+}
+
+/**
+ * getItem
+ *    Copy the next acceptable item into a new ring item.
+ *
+ * @return CRingItem* - dynamically allocated item, null at end of file.
+ */
+CRingItem*
+CMappedFileDataSource::getItem()
+{
+    const RingItem* pRaw = nextItem();
+    if (!pRaw) return reinterpret_cast<CRingItem*>(0);
+
+    uint32_t   size  = itemSize(pRaw);
+    CRingItem* pItem = new CRingItem(1, size);     // Type gets overwritten.
+    pRingItem  pDest = pItem->getItemPointer();
+    memcpy(pDest, pRaw, size);
+    pItem->setBodyCursor(reinterpret_cast<uint8_t*>(pDest) + size);
+    return pItem;
+}
+/**
+ * read
+ *    Copy raw bytes out of the file.  If there aren't enough, the
+ *    source is at end of file.
+ *
+ * @param pBuffer - where the data go.
+ * @param nBytes  - how many bytes.
+ */
+void
+CMappedFileDataSource::read(char* pBuffer, size_t nBytes)
+{
+    if (eof()) return;
+
+    if (!available(nBytes)) {
+        nBytes = m_nFileSize - m_nCursor;
+        setEOF(true);
+    }
+    // Go through the window a budget's worth at a time:
+
+    while (nBytes) {
+        size_t n = std::min(nBytes, m_nWindowBudget);
+        memcpy(pBuffer, map(m_nCursor, n), n);
+        pBuffer   += n;
+        nBytes    -= n;
+        m_nCursor += n;
+    }
+}
+/**
+ * nextItem
+ *    Get the next acceptable item without copying it.
+ *
+ * @return const RingItem* - Pointer to the item in the mapping, null at
+ *                           end of file (including a truncated last item).
+ */
+const RingItem*
+CMappedFileDataSource::nextItem()
+{
+    while (!eof()) {
+        if (!available(sizeof(RingItemHeader))) break;
+
+        const RingItem* p =
+            reinterpret_cast<const RingItem*>(map(m_nCursor, sizeof(RingItemHeader)));
+        uint32_t size = itemSize(p);
+        if ((size < sizeof(RingItemHeader)) || !available(size)) break;
+
+        p = reinterpret_cast<const RingItem*>(map(m_nCursor, size));
+        m_nCursor += size;
+        if (m_exclude.find(itemType(p)) == m_exclude.end()) {
+            return p;
+        }
+    }
+    setEOF(true);
+    return nullptr;
+}
+/**
+ * canMap
+ *    @param fd - an open file.
+ *    @return bool - true if it's a file this class can handle: a regular
+ *                   file that's not a compressed event segment.
+ */
+bool
+CMappedFileDataSource::canMap(int fd)
+{
+    struct stat info;
+    if ((fstat(fd, &info) < 0) || !S_ISREG(info.st_mode)) return false;
+
+    CompressedSegment::FileHeader header;
+    ssize_t n = pread(fd, &header, sizeof(header), 0);
+    return (n >= 0) && !CompressedSegment::isCompressed(&header, n);
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * init
+ *    Common construction: check the file can be mapped and get its size.
+ *    Nothing is mapped until the first item is needed.
+ */
+void
+CMappedFileDataSource::init()
+{
+    if (!canMap(m_fd)) {
+        throw CInvalidArgumentException(
+            "file descriptor", "Must be a regular, uncompressed event file",
+            "Opening a mapped file data source"
+        );
+    }
+    struct stat info;
+    fstat(m_fd, &info);
+    m_nFileSize     = info.st_size;
+    m_nCursor       = 0;
+    m_pWindow       = nullptr;
+    m_nWindowOffset = 0;
+    m_nWindowSize   = 0;
+    m_nPageSize     = sysconf(_SC_PAGESIZE);
+    if (m_nWindowBudget < m_nPageSize) m_nWindowBudget = m_nPageSize;
+}
+/**
+ * map
+ *    Make sure a range of the file is in the window, sliding the window
+ *    forward if not.
+ *
+ * @param offset - file offset of the data.
+ * @param nBytes - how much is needed (must be in the file).
+ * @return const uint8_t* - pointer to the data.
+ * @throw CErrnoException - mmap failed.
+ */
+const uint8_t*
+CMappedFileDataSource::map(off_t offset, size_t nBytes)
+{
+    if (!m_pWindow || (offset < m_nWindowOffset) ||
+        ((offset + nBytes) > (m_nWindowOffset + m_nWindowSize))) {
+        unmap();
+
+        // The window starts at the page holding offset and is at least
+        // the budget (or enough for a huge item) but not past the end
+        // of the file:
+
+        off_t  base = offset - (offset % m_nPageSize);
+        size_t size = std::max(m_nWindowBudget, size_t(offset + nBytes - base));
+        size        = std::min(size, size_t(m_nFileSize - base));
+
+        void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, base);
+        if (p == MAP_FAILED) {
+            throw CErrnoException("Mapping event file");
+        }
+        madvise(p, size, MADV_SEQUENTIAL);
+        m_pWindow       = static_cast<uint8_t*>(p);
+        m_nWindowOffset = base;
+        m_nWindowSize   = size;
+    }
+    return m_pWindow + (offset - m_nWindowOffset);
+}
+/**
+ * unmap
+ *    Get rid of the current window, if there is one.
+ */
+void
+CMappedFileDataSource::unmap()
+{
+    if (m_pWindow) {
+        munmap(m_pWindow, m_nWindowSize);
+        m_pWindow     = nullptr;
+        m_nWindowSize = 0;
+    }
+}
+/**
+ * available
+ *    Determine if there are enough bytes left in the file.  If not, the
+ *    file size is checked again in case it's still being written.
+ *
+ * @param nBytes - bytes needed past the cursor.
+ * @return bool
+ */
+bool
+CMappedFileDataSource::available(size_t nBytes)
+{
+    if ((m_nCursor + off_t(nBytes)) <= m_nFileSize) return true;
+
+    struct stat info;
+    if (fstat(m_fd, &info) == 0) m_nFileSize = info.st_size;
+    return (m_nCursor + off_t(nBytes)) <= m_nFileSize;
+}
@@ -0,0 +1,98 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CMappedFileDataSource.h
+ *  @brief: Data source that maps an event file into memory.
+ */
+#ifndef CMAPPEDFILEDATASOURCE_H
+#define CMAPPEDFILEDATASOURCE_H
+
+#include "CDataSource.h"
+
+#include <set>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+
+class URL;
+class CRingItem;
+struct _RingItem;
+
+/**
+ * @class CMappedFileDataSource
+ *    A file data source for uncompressed event files that maps the file
+ *    rather than reading it.  nextItem() gives a pointer to the next
+ *    acceptable item right where it is in the mapping, so no copy or
+ *    allocation is needed per item.  getItem() and read() are supported
+ *    for compatibility but copy out of the mapping.
+ *
+ *    The file is mapped through a window that slides forward as items are
+ *    consumed so files bigger than the address space budget can be
+ *    processed.  The kernel is told the mapping is read sequentially
+ *    so it reads ahead aggressively.
+ *
+ *    Items returned by nextItem() stay valid until the next call to
+ *    nextItem(), getItem() or read() (any of which may slide the window).
+ */
+class CMappedFileDataSource : public CDataSource
+{
+public:
+    static const size_t DEFAULT_WINDOW = 256*1024*1024;
+private:
+    int                  m_fd;
+    std::set<uint16_t>   m_exclude;
+    size_t               m_nWindowBudget;
+    size_t               m_nPageSize;
+
+    off_t                m_nFileSize;
+    off_t                m_nCursor;          // File offset of the next item.
+    uint8_t*             m_pWindow;          // Mapped part of the file.
+    off_t                m_nWindowOffset;    // Its file offset.
+    size_t               m_nWindowSize;
+
+public:
+    CMappedFileDataSource(
+        URL& url, std::vector<uint16_t> exclusionlist,
+        size_t windowSize = DEFAULT_WINDOW
+    );
+    CMappedFileDataSource(
+        int fd, std::vector<uint16_t> exclusionlist,
+        size_t windowSize = DEFAULT_WINDOW
+    );
+    virtual ~CMappedFileDataSource();
+
+private:
+    CMappedFileDataSource(const CMappedFileDataSource& rhs);
+    CMappedFileDataSource& operator=(const CMappedFileDataSource& rhs);
+
+public:
+    virtual CRingItem* getItem();
+    virtual void read(char* pBuffer, size_t nBytes);
+
+    const _RingItem* nextItem();
+
+    static bool canMap(int fd);
+
+private:
+    void     init();
+    const uint8_t* map(off_t offset, size_t nBytes);
+    void     unmap();
+    bool     available(size_t nBytes);
+};
+
+#endif
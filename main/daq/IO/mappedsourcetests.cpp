@@ -0,0 +1,235 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  mappedsourcetests.cpp
+ *  @brief: Tests for the memory mapped file data source.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CMappedFileDataSource.h"
+#include "CFileDataSource.h"
+#include "CDataSourceFactory.h"
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <CCompressedSegment.h>
+#include <io.h>
+#include <Exception.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+class CMappedFileDataSourceTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CMappedFileDataSourceTest);
+  CPPUNIT_TEST(items_1);
+  CPPUNIT_TEST(exclude_1);
+  CPPUNIT_TEST(getitem_1);
+  CPPUNIT_TEST(read_1);
+  CPPUNIT_TEST(truncated_1);
+  CPPUNIT_TEST(canmap_1);
+  CPPUNIT_TEST(factory_1);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::string             m_name;
+  std::vector<uint8_t>    m_data;
+  std::vector<size_t>     m_offsets;        // Item offsets in m_data.
+  size_t                  m_pageSize;
+
+public:
+  void setUp();
+  void tearDown();
+protected:
+  void items_1();
+  void exclude_1();
+  void getitem_1();
+  void read_1();
+  void truncated_1();
+  void canmap_1();
+  void factory_1();
+private:
+  void append(void* pItem);
+  int  openFile();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CMappedFileDataSourceTest);
+
+// Make a file of items with one bigger than a page so it can't fit
+// a one page window.
+
+void CMappedFileDataSourceTest::setUp()
+{
+  m_pageSize = sysconf(_SC_PAGESIZE);
+  m_data.clear();
+  m_offsets.clear();
+
+  append(formatStateChange(time(nullptr), 0, 1, "Mapped", BEGIN_RUN));
+  for (uint32_t i = 0; i < 1000; i++) {
+    uint32_t payload[4] = {i, i, i, i};
+    append(formatTimestampedEventItem(i, 1, 0, (i % 4 + 1)*sizeof(uint32_t), payload));
+    if (i == 500) {
+      std::vector<uint32_t> big(m_pageSize, i);
+      append(formatTimestampedEventItem(i, 1, 0, big.size()*sizeof(uint32_t), big.data()));
+    }
+  }
+  append(formatStateChange(time(nullptr), 10, 1, "Mapped", END_RUN));
+
+  char name[] = "mappedXXXXXX";
+  int fd = mkstemp(name);
+  io::writeData(fd, m_data.data(), m_data.size());
+  close(fd);
+  m_name = name;
+}
+void CMappedFileDataSourceTest::tearDown()
+{
+  unlink(m_name.c_str());
+}
+void CMappedFileDataSourceTest::append(void* pItem)
+{
+  uint8_t* p = static_cast<uint8_t*>(pItem);
+  m_offsets.push_back(m_data.size());
+  m_data.insert(m_data.end(), p, p + itemSize(static_cast<pRingItem>(pItem)));
+  free(pItem);
+}
+int CMappedFileDataSourceTest::openFile()
+{
+  return open(m_name.c_str(), O_RDONLY);
+}
+
+// Items come back in order, in place, with a window that has to slide
+// and sometimes grow:
+
+void CMappedFileDataSourceTest::items_1()
+{
+  CMappedFileDataSource source(openFile(), std::vector<uint16_t>(), m_pageSize);
+  for (int i = 0; i < m_offsets.size(); i++) {
+    const RingItem* p = source.nextItem();
+    CPPUNIT_ASSERT(p);
+    uint32_t size = itemSize(p);
+    CPPUNIT_ASSERT_EQUAL(0, memcmp(p, &m_data[m_offsets[i]], size));
+  }
+  CPPUNIT_ASSERT(!source.nextItem());
+  CPPUNIT_ASSERT(source.eof());
+}
+// Excluded types are skipped:
+
+void CMappedFileDataSourceTest::exclude_1()
+{
+  std::vector<uint16_t> exclude;
+  exclude.push_back(PHYSICS_EVENT);
+  CMappedFileDataSource source(openFile(), exclude);
+
+  const RingItem* p = source.nextItem();
+  CPPUNIT_ASSERT(p);
+  CPPUNIT_ASSERT_EQUAL(uint16_t(BEGIN_RUN), itemType(p));
+  p = source.nextItem();
+  CPPUNIT_ASSERT(p);
+  CPPUNIT_ASSERT_EQUAL(uint16_t(END_RUN), itemType(p));
+  CPPUNIT_ASSERT(!source.nextItem());
+}
+// getItem copies to a ring item:
+
+void CMappedFileDataSourceTest::getitem_1()
+{
+  CMappedFileDataSource source(openFile(), std::vector<uint16_t>(), m_pageSize);
+  for (int i = 0; i < m_offsets.size(); i++) {
+    CRingItem* pItem = source.getItem();
+    CPPUNIT_ASSERT(pItem);
+    CPPUNIT_ASSERT_EQUAL(
+      uint32_t(itemSize(reinterpret_cast<pRingItem>(&m_data[m_offsets[i]]))),
+      pItem->size()
+    );
+    CPPUNIT_ASSERT_EQUAL(0, memcmp(
+      pItem->getItemPointer(), &m_data[m_offsets[i]], pItem->size()
+    ));
+    delete pItem;
+  }
+  CPPUNIT_ASSERT(!source.getItem());
+}
+// Raw reads, including one that runs off the end:
+
+void CMappedFileDataSourceTest::read_1()
+{
+  CMappedFileDataSource source(openFile(), std::vector<uint16_t>(), m_pageSize);
+  std::vector<char> buffer(m_data.size() + 100);
+
+  source.read(buffer.data(), 10);
+  source.read(buffer.data() + 10, 3*m_pageSize);
+  CPPUNIT_ASSERT(!source.eof());
+  source.read(buffer.data() + 10 + 3*m_pageSize, m_data.size() - 10 - 3*m_pageSize + 100);
+  CPPUNIT_ASSERT(source.eof());
+  CPPUNIT_ASSERT_EQUAL(0, memcmp(buffer.data(), m_data.data(), m_data.size()));
+}
+// A partial item at the end is end of file:
+
+void CMappedFileDataSourceTest::truncated_1()
+{
+  truncate(m_name.c_str(), m_offsets.back() + 10);
+  CMappedFileDataSource source(openFile(), std::vector<uint16_t>());
+  for (int i = 0; i < m_offsets.size() - 1; i++) {
+    CPPUNIT_ASSERT(source.nextItem());
+  }
+  CPPUNIT_ASSERT(!source.nextItem());
+  CPPUNIT_ASSERT(source.eof());
+}
+// Only regular uncompressed files can be mapped:
+
+void CMappedFileDataSourceTest::canmap_1()
+{
+  int fd = openFile();
+  CPPUNIT_ASSERT(CMappedFileDataSource::canMap(fd));
+  close(fd);
+
+  int fds[2];
+  pipe(fds);
+  CPPUNIT_ASSERT(!CMappedFileDataSource::canMap(fds[0]));
+  bool thrown = false;
+  try {
+    CMappedFileDataSource source(fds[0], std::vector<uint16_t>());
+  }
+  catch (CException& e) {
+    thrown = true;
+  }
+  CPPUNIT_ASSERT(thrown);
+  close(fds[1]);
+
+  fd = open(m_name.c_str(), O_WRONLY | O_TRUNC);
+  io::writeData(fd, CompressedSegment::FILE_MAGIC, sizeof(CompressedSegment::FILE_MAGIC));
+  close(fd);
+  fd = openFile();
+  CPPUNIT_ASSERT(!CMappedFileDataSource::canMap(fd));
+  close(fd);
+}
+// The factory makes mapped sources for files only:
+
+void CMappedFileDataSourceTest::factory_1()
+{
+  std::vector<uint16_t> none;
+  std::string uri = "file://./" + m_name;
+  CDataSource* pSource = CDataSourceFactory::makeMappedSource(uri, none, none);
+  CPPUNIT_ASSERT(dynamic_cast<CMappedFileDataSource*>(pSource));
+  delete pSource;
+
+  pSource = CDataSourceFactory::makeMappedSource("-", none, none);
+  CPPUNIT_ASSERT(dynamic_cast<CFileDataSource*>(pSource));
+  delete pSource;
+}
@@ -20,6 +20,8 @@
 
 #include "CConfigure.h"
 #include "CFragmentHandler.h"
+#include "COutputThread.h"
+#include "CSortThread.h"
 #include <TCLInterpreter.h>
 #include <TCLObject.h>
 #include <Exception.h>
@@ -170,7 +172,50 @@ CConfigure::Set(CTCLInterpreter& interp, std::string name, CTCLObject& value)
     int size = value;
     pHandler->setPerQXonThreshold(size);
 
+  } else if (name == "outputCoalesceBytes") {
+    
+    int size = value;
+    if (size < 0) {
+      std::string errorMsg = "Output coalescing bytes must be >= 0 was ";
+      errorMsg += static_cast<std::string>(value);
+      throw errorMsg;
+    }
+    pHandler->getOutputThread()->setCoalesceBytes(size);
+    
+  } else if (name == "outputCoalesceMs") {
+    
+    int ms = value;
+    if (ms < 0) {
+      std::string errorMsg = "Output coalescing wait must be >= 0 was ";
+      errorMsg += static_cast<std::string>(value);
+      throw errorMsg;
+    }
+    pHandler->getOutputThread()->setCoalesceMs(ms);
   
+  } else if (name == "inflightByteLimit") {
+    
+    // Can be more than an int holds:
+    
+    Tcl_WideInt nBytes;
+    if ((Tcl_GetWideIntFromObj(
+          interp.getInterpreter(), value.getObject(), &nBytes) != TCL_OK) ||
+        (nBytes < 0)) {
+      std::string errorMsg = "In flight byte limit must be an integer >= 0 was ";
+      errorMsg += static_cast<std::string>(value);
+      throw errorMsg;
+    }
+    pHandler->setInflightByteLimit(nBytes);
+    
+  } else if (name == "sortThreads") {
+    
+    int nThreads = value;
+    if (nThreads <= 0) {
+      std::string errorMsg = "Number of sort threads must be > 0 was ";
+      errorMsg += static_cast<std::string>(value);
+      throw errorMsg;
+    }
+    pHandler->getSortThread()->setMergeThreads(nThreads);
+    
   } else {
     std::string errorMsg = "Illegal configuration parametr name: ";
     errorMsg  += name;
@@ -203,6 +248,26 @@ CConfigure::Get(CTCLInterpreter& interp, std::string name)
     oValue.Bind(interp);
     oValue = static_cast<int>(value);
     interp.setResult(oValue);
+  } else if (name == "outputCoalesceBytes") {
+    CTCLObject oValue;
+    oValue.Bind(interp);
+    oValue = static_cast<int>(pHandler->getOutputThread()->getCoalesceBytes());
+    interp.setResult(oValue);
+  } else if (name == "outputCoalesceMs") {
+    CTCLObject oValue;
+    oValue.Bind(interp);
+    oValue = pHandler->getOutputThread()->getCoalesceMs();
+    interp.setResult(oValue);
+  } else if (name == "inflightByteLimit") {
+    CTCLObject oValue;
+    oValue.Bind(interp);
+    oValue = static_cast<Tcl_WideInt>(pHandler->getInflightByteLimit());
+    interp.setResult(oValue);
+  } else if (name == "sortThreads") {
+    CTCLObject oValue;
+    oValue.Bind(interp);
+    oValue = static_cast<int>(pHandler->getSortThread()->getMergeThreads());
+    interp.setResult(oValue);
   } else {
     std::string errorMsg = "Illegal configuration parameter: ";
     errorMsg += name;
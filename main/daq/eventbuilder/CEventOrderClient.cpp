@@ -49,7 +49,9 @@ CEventOrderClient::CEventOrderClient(std::string host, uint16_t port) :
   m_pConnection(0),
   m_fConnected(false),
   m_nIovecSize(0),
-  m_pIovec(nullptr)
+  m_pIovec(nullptr),
+  m_fCreditFlow(false),
+  m_nCredits(0)
 {
    m_nIovecMaxSize = sysconf(_SC_IOV_MAX);   // Maximum number of iovs for write.
    if ( m_nIovecMaxSize == -1) {
@@ -115,6 +117,9 @@ CEventOrderClient::Lookup(std::string host, const char* pName)
  * Connect to a server.
  *
  * See eventorderer(5daq) for protocol information.
+ * We first ask for credit based flow control (CREDITCONNECT).  Servers
+ * that don't know about that refuse it and drop the connection, in which
+ * case we reconnect with a plain CONNECT and the OK per message protocol.
  *
  * @param[in] description - the description used in the CONNECT message
  *                      to describe the client to the server.
@@ -124,56 +129,19 @@ CEventOrderClient::Lookup(std::string host, const char* pName)
 void
 CEventOrderClient::Connect(std::string description, std::list<int> sources)
 {
-  char portNumber[32];
-  uint8_t* connectionBody(0);
-  sprintf(portNumber, "%u", m_port);
-  m_pConnection = new CSocket();
-
   try {
-    m_pConnection->Connect(m_host, std::string(portNumber));
-    
-    // Now ensure the socket does not get propagated to anything we exec
-    // (or fork/exec for that matter).  This ensures that if we
-    // access a remote ring, the socket won't get duplicated into a
-    // stdintoring causing no harm but consternation.
-    
-    int fd = m_pConnection->getSocketFd();
-    int fdFlags;
-    fdFlags = fcntl(fd, F_GETFD, NULL);
-    fdFlags |= FD_CLOEXEC;                    // Close on exec.
-    fcntl(fd, F_SETFD, fdFlags);
-
-    // Message header:
-    
-    EVB::ClientMessageHeader hdr = {0 , EVB::CONNECT};
-    
-    // Figure out the total body size, allocate it, fill in hdr.s_bodySize:
-    
-    uint32_t bodySize = EVB_MAX_DESCRIPTION + (sources.size() + 1)*sizeof(uint32_t);
-    EVB::pConnectBody pBody = static_cast<EVB::pConnectBody>(malloc(bodySize));
-    if (!pBody) {
-      throw CErrnoException("Unable to allocated connect msg body");
+    openConnection();
+    try {
+      sendConnect(EVB::CREDITCONNECT, description, sources);
+      m_fCreditFlow = true;
     }
-    hdr.s_bodySize = bodySize;
-    memset(pBody->s_description, 0, EVB_MAX_DESCRIPTION);
-    strncpy(pBody->s_description, description.c_str(), EVB_MAX_DESCRIPTION);
-    pBody->s_nSids = sources.size();
-    int i(0);
-    for (auto p = sources.begin(); p != sources.end(); p++) {
-      pBody->s_sids[i] = *p;
-      i++;
+    catch (std::string reply) {       // Older server.
+      delete m_pConnection;
+      m_pConnection = nullptr;
+      openConnection();
+      sendConnect(EVB::CONNECT, description, sources);
+      m_fCreditFlow = false;
     }
-    // We'll need to I/O vectors, one for the header, one for the body:
-    
-    iovec d[2];
-    d[0].iov_base = &hdr;
-    d[0].iov_len  = sizeof(EVB::ClientMessageHeader);
-    
-    d[1].iov_base = pBody;
-    d[1].iov_len  = bodySize;
-    
-    message(2, d);          // Send and process reply.
-    free(pBody);
   }
   catch (CTCPConnectionFailed& e) {
     errno = ECONNREFUSED;
@@ -185,6 +153,7 @@ CEventOrderClient::Connect(std::string description, std::list<int> sources)
     m_fConnected = false;
     throw;
   }
+  m_nCredits   = 0;               // Server sends the initial grant.
   m_fConnected = true;
 
 }
@@ -208,7 +177,17 @@ CEventOrderClient::disconnect()
     iovec d;
     d.iov_base = &hdr;
     d.iov_len  = sizeof(EVB::ClientMessageHeader);
-    message(1, &d);
+    if (m_fCreditFlow) {
+      
+      // Skip any grants still in flight; the server acknowledges with
+      // a zero grant:
+      
+      io::writeDataVUnlimited(m_pConnection->getSocketFd(), &d, 1);
+      while (readCredits() != 0)
+        ;
+    } else {
+      message(1, &d);
+    }
   }
   catch (...) {
     delete m_pConnection;
@@ -256,7 +235,7 @@ CEventOrderClient::submitFragments(EVB::pFragmentChain pChain)
 
       // The -1 below is because we don't relay the null terminator on the strings.
 
-      message(nIovsInChain+1, pDescription);
+      sendFragments(nIovsInChain+1, pDescription);
       free(pDescription);
     
     }
@@ -476,6 +455,124 @@ CEventOrderClient::message(size_t nItems, iovec* parts)
     throw reply;
   }
 }
+/**
+ * openConnection
+ *    Create the socket and connect it to the server.  The socket is marked
+ *    close on exec.
+ *
+ * @throw CTCPConnectionFailed - if the connection could not be made.
+ */
+void
+CEventOrderClient::openConnection()
+{
+  char portNumber[32];
+  sprintf(portNumber, "%u", m_port);
+  m_pConnection = new CSocket();
+  m_pConnection->Connect(m_host, std::string(portNumber));
+    
+  // Now ensure the socket does not get propagated to anything we exec
+  // (or fork/exec for that matter).  This ensures that if we
+  // access a remote ring, the socket won't get duplicated into a
+  // stdintoring causing no harm but consternation.
+    
+  int fd = m_pConnection->getSocketFd();
+  int fdFlags;
+  fdFlags = fcntl(fd, F_GETFD, NULL);
+  fdFlags |= FD_CLOEXEC;                    // Close on exec.
+  fcntl(fd, F_SETFD, fdFlags);
+}
+/**
+ * sendConnect
+ *    Send a connect message and process the reply.
+ *
+ * @param type        - EVB::CONNECT or EVB::CREDITCONNECT.
+ * @param description - Client description.
+ * @param sources     - Source ids we'll send.
+ * @throw std::string - the server's reply if it was not OK.
+ */
+void
+CEventOrderClient::sendConnect(
+  uint32_t type, std::string description, std::list<int>& sources
+)
+{
+  // Message header:
+    
+  EVB::ClientMessageHeader hdr = {0 , type};
+    
+  // Figure out the total body size, allocate it, fill in hdr.s_bodySize:
+    
+  uint32_t bodySize = EVB_MAX_DESCRIPTION + (sources.size() + 1)*sizeof(uint32_t);
+  EVB::pConnectBody pBody = static_cast<EVB::pConnectBody>(malloc(bodySize));
+  if (!pBody) {
+    throw CErrnoException("Unable to allocated connect msg body");
+  }
+  hdr.s_bodySize = bodySize;
+  memset(pBody->s_description, 0, EVB_MAX_DESCRIPTION);
+  strncpy(pBody->s_description, description.c_str(), EVB_MAX_DESCRIPTION);
+  pBody->s_nSids = sources.size();
+  int i(0);
+  for (auto p = sources.begin(); p != sources.end(); p++) {
+    pBody->s_sids[i] = *p;
+    i++;
+  }
+  // We'll need to I/O vectors, one for the header, one for the body:
+    
+  iovec d[2];
+  d[0].iov_base = &hdr;
+  d[0].iov_len  = sizeof(EVB::ClientMessageHeader);
+    
+  d[1].iov_base = pBody;
+  d[1].iov_len  = bodySize;
+  try {
+    message(2, d);          // Send and process reply.
+  }
+  catch (...) {
+    free(pBody);
+    throw;
+  }
+  free(pBody);
+}
+/**
+ * sendFragments
+ *    Send a FRAGMENTS message.  With credit flow control we only wait
+ *    for the server when we've used up our credits.  Otherwise each
+ *    message waits for its OK.
+ *
+ *  @param nItems  - Number of iovec structs used to describe the message.
+ *  @param parts   - Pointer to the iovecs.
+ */
+void
+CEventOrderClient::sendFragments(size_t nItems, iovec* parts)
+{
+  if (m_fCreditFlow) {
+    while (m_nCredits == 0) {
+      m_nCredits = readCredits();
+    }
+    io::writeDataVUnlimited(m_pConnection->getSocketFd(), parts, nItems);
+    m_nCredits--;
+  } else {
+    message(nItems, parts);
+  }
+}
+/**
+ * readCredits
+ *    Read a credit grant from the server.  Grants are binary uint32_t
+ *    counts of the number of additional FRAGMENTS messages we may send.
+ *    A grant of zero acknowledges a DISCONNECT.
+ *
+ * @return uint32_t - the grant.
+ * @throw std::string - if the server closed the connection.
+ */
+uint32_t
+CEventOrderClient::readCredits()
+{
+  uint32_t credits;
+  if (io::readData(m_pConnection->getSocketFd(), &credits, sizeof(credits))
+      != sizeof(credits)) {
+    throw std::string("Event builder closed the connection");
+  }
+  return credits;
+}
 /**
  * bytesInChain
  *   @param pFrags   - a fragment chain.
@@ -38,6 +38,7 @@ namespace EVB {
   static const uint32_t CONNECT   =1;
   static const uint32_t FRAGMENTS =2;
   static const uint32_t DISCONNECT=4;
+  static const uint32_t CREDITCONNECT=8;   // CONNECT asking for credit flow control.
 }
 
 /**  A connect message body has has a fixed size info string and a set of connection ids.
@@ -75,6 +76,8 @@ private:
   int         m_nIovecMaxSize; // System limit on iov size.
   size_t      m_nIovecSize; // Number of elements allocated below.
   iovec*      m_pIovec;     // Pre-allocated iovector for writev.
+  bool        m_fCreditFlow; // Server grants credits rather than ACKing each message.
+  uint32_t    m_nCredits;    // FRAGMENTS messages we can send before waiting.
   
   // construction/destruction/canonicals
 public:
@@ -106,6 +109,10 @@ private:
   static size_t message(void** msg, const void* request, size_t requestSize, const  void* body, size_t bodySize);
   
   std::string getReplyString();	
+  void openConnection();
+  void sendConnect(uint32_t type, std::string description, std::list<int>& sources);
+  void sendFragments(size_t nItems, iovec* parts);
+  uint32_t readCredits();
   static void freeChain(EVB::pFragmentChain pChain);
   iovec* makeIoVec(EVB::Fragment& Frag, iovec* pVecs);
   
@@ -55,6 +55,7 @@ static const  size_t defaultXoffLimit(4000000);    /// Default total fragment co
 
 static const size_t defaultPerQXoffLimit(400000);  // Default number of fragment count per source queue for xoff
 static const size_t defaultPerQXonLimit  (50000);  // Default number of fragment count per source queue for xon
+static const size_t defaultInflightByteLimit(1024*1024*1024); // Default bytes being sorted/output for xoff
 
 /*---------------------------------------------------------------------
  * Debugging
@@ -123,8 +124,10 @@ CFragmentHandler::CFragmentHandler() :
     m_nXoffLimit = defaultXoffLimit;
     m_nPerQXonLimit = defaultPerQXonLimit;
     m_nPerQXoffLimit = defaultPerQXoffLimit;
+    m_nInflightByteLimit = defaultInflightByteLimit;
     m_fXoffed    = false;
     m_nTotalFragmentSize = 0;
+    m_fOldestHeapValid   = false;
 }
 /**
  * Destructor - for now just kill off the timer -- don't worry about
@@ -184,6 +187,29 @@ static bool first(true);
 void
 CFragmentHandler::addFragments(size_t nSize, const EVB::FlatFragment* pFragments)
 {
+    // The fragments are copied, in one go, into a block the queued
+    // fragments will point into:
+    
+    EVB::pFragmentBlock pBlock = allocateFragmentBlock(nSize);
+    memcpy(fragmentBlockData(pBlock), pFragments, nSize);
+    addFragments(pBlock, nSize);
+}
+/**
+ * addFragments
+ *    Same as above but the fragments are already in a fragment block
+ *    (see allocateFragmentBlock).  This lets a caller that reads
+ *    messages into blocks avoid the copy.
+ *
+ * @param pBlock - Block containing the fragments.  We take over the
+ *                 caller's reference to it, even if we throw.
+ * @param nSize  - Number of bytes of fragments in the block.
+ */
+void
+CFragmentHandler::addFragments(EVB::pFragmentBlock pBlock, size_t nSize)
+{
+  const EVB::FlatFragment* pFragments =
+    reinterpret_cast<const EVB::FlatFragment*>(fragmentBlockData(pBlock));
+  try {
   
     m_nNow = time(NULL);
     if (m_nNow < m_nOldestReceived) {
@@ -211,7 +237,7 @@ CFragmentHandler::addFragments(size_t nSize, const EVB::FlatFragment* pFragments
 
 
 
-      addFragment(pFragments);
+      addFragment(pBlock, pFragments);
       
       // Point to the next fragment.
       
@@ -232,6 +258,12 @@ CFragmentHandler::addFragments(size_t nSize, const EVB::FlatFragment* pFragments
   
     
     checkXoff();         
+  }
+  catch (...) {
+    releaseFragmentBlock(pBlock);
+    throw;
+  }
+  releaseFragmentBlock(pBlock);   // The queued fragments keep it alive.
 }
 /**
  * setBuildWindow
@@ -333,6 +365,27 @@ void
 CFragmentHandler::setPerQXoffThreshold(size_t nSize) {
     m_nPerQXoffLimit = nSize;
 }
+/**
+ * setInflightByteLimit
+ *    Sets the limit on the bytes of fragment data that have been handed to
+ *    the sort and output threads but not yet output.  Above this the
+ *    system is Xoffed.  It is Xoned once it drops below half this (and the
+ *    in flight fragment count is below the Xon threshold).
+ *
+ * @param nBytes - the limit, 0 means no limit.
+ */
+void
+CFragmentHandler::setInflightByteLimit(size_t nBytes) {
+    m_nInflightByteLimit = nBytes;
+}
+/**
+ * getInflightByteLimit
+ * @return size_t - the in flight byte limit (0 means none).
+ */
+size_t
+CFragmentHandler::getInflightByteLimit() const {
+    return m_nInflightByteLimit;
+}
 
 /**
  * addObserver
@@ -866,12 +919,13 @@ CFragmentHandler::clearQueues()
   for (Sources::iterator s = m_FragmentQueues.begin(); s != m_FragmentQueues.end(); s++) {
     SourceQueue& q(s->second);
     while (!q.s_queue.empty()) {
-      delete q.s_queue.front().second;
+      freeFragment(q.s_queue.front().second);
       q.s_queue.pop_front();
       
     }
   }
   m_FragmentQueues.clear();
+  invalidateOldestHeap();
 }
 
 /*---------------------------------------------------------------------
@@ -895,6 +949,7 @@ CFragmentHandler::clearQueues()
 void
 CFragmentHandler::flushQueues(bool completely)
 {
+  invalidateOldestHeap();
  
   CSortThread::Fragments* pFrags = new CSortThread::Fragments;
   std::list<std::pair<SourceQueue*, CSortThread::FragmentList*>> statcopy;
@@ -1004,82 +1059,85 @@ CFragmentHandler::flushQueues(bool completely)
  *
  *   Remove an oldest fragment from the sources queue and update m_nOldest
  *
- *   @return ::EVB::pFragment - pointer to a fragment whose timestamp
- *           matches m_nOldest
- *   @retval - Null is returned if there are no non-barrier events in the
- *             queues.
- *
- *   @note this is all very brute force.  A much quicker algorithm to find
- *         the oldest fragment would be to retain in addtion to m_nOldest
- *         the queue that it was put in...however we still need to iterate
- *         over the queues to update m_nOldest.  This is a bit
- *         short circuited by:
- *         - Keeping track of it as we search for the first match to m_nOldest
- *         - short circuiting the loop if we find another queue with
- *           an m_nOldest match as there can't be anything older than that
- *           by definition.
- */
-std::pair<time_t, ::EVB::pFragment>*
-CFragmentHandler::popOldest()
-{
-    uint64_t nextOldest = UINT64_MAX;   // Must be older than that.
-    Sources::iterator   pOldestQ;       // Iterator indicating the oldest fragment.
- 
-    /*
-      Find the oldest fragment:
-      *  Barrier fragments are immune from return.
-      *  If indeed we find one, it's removed from it's queue.
-      *  If indeed we find one, the oldest info is recomputed 
-      */
-
+ *   @param[out] oldest - receives the received time/fragment pair of the
+ *                        oldest non-barrier fragment.
+ *   @return bool
+ *   @retval true  - oldest was filled in and removed from its queue.
+ *   @retval false - there are no non-barrier fragments at the queue heads
+ *                   (all queues are empty or headed by barriers).
+ *
+ *   @note The queue heads are kept in a min-heap (m_oldestHeap) so
+ *         successive pops cost O(log nsources) and allocate nothing rather
+ *         than scanning all the queues.  Anything else that modifies the
+ *         queues just marks the heap stale via invalidateOldestHeap() and
+ *         the next popOldest rebuilds it in one pass.
+ *         Queues headed by a barrier are left out of the heap and mark the
+ *         barrier pending as before.
+ *   @note m_nOldestReceived is only recomputed when the heap is rebuilt.
+ */
+bool
+CFragmentHandler::popOldest(std::pair<time_t, ::EVB::pFragment>& oldest)
+{
+    if (!m_fOldestHeapValid) {
+      buildOldestHeap();
+    }
+    if (m_oldestHeap.empty()) {
+      return false;                     // Either all barriers or all empty.
+    }
+    SourceQueue* pOldestQ = m_oldestHeap.top().s_value;
+    oldest = pOldestQ->s_queue.front();
+    uint64_t fragmentTimestamp  = oldest.second->s_header.s_timestamp;
+      
+    pOldestQ->s_lastPoppedTimestamp = fragmentTimestamp;
+    pOldestQ->s_bytesDeQd          += oldest.second->s_header.s_size;
+    pOldestQ->s_bytesInQ           -= oldest.second->s_header.s_size;
+    pOldestQ->s_queue.pop_front();
+
+    // Put the queue's new head in the heap...unless there isn't one or
+    // it's a barrier:
+
+    if (pOldestQ->s_queue.empty()) {
+      m_nMostRecentlyEmptied = time(NULL);
+      m_oldestHeap.pop();
+    } else if (pOldestQ->s_queue.front().second->s_header.s_barrier) {
+      m_fBarrierPending = true;         // Mark a pending barrier.
+      m_oldestHeap.pop();
+    } else {
+      m_oldestHeap.replaceTop(
+        pOldestQ->s_queue.front().second->s_header.s_timestamp
+      );
+    }
+    if (!m_oldestHeap.empty()) {
+      m_nOldest = m_oldestHeap.top().s_key;
+    }
 
-    int i = 1;
+    return true;
+}
+/**
+ * buildOldestHeap
+ *    Rebuild m_oldestHeap from the heads of the fragment queues.
+ *    Queues headed by barriers set m_fBarrierPending and are not put in
+ *    the heap. m_nOldest and m_nOldestReceived are recomputed as well.
+ */
+void
+CFragmentHandler::buildOldestHeap()
+{
+    m_oldestHeap.clear();
+    m_oldestHeap.reserve(m_FragmentQueues.size());
     for (Sources::iterator p = m_FragmentQueues.begin(); 
         p != m_FragmentQueues.end(); p++) {
       if (!p->second.s_queue.empty()) {
-        std::pair<time_t, ::EVB::pFragment> frag = p->second.s_queue.front();   // head of queue.
-        if (frag.second->s_header.s_barrier == 0) {                             // only non-barriers.
-          if (frag.second->s_header.s_timestamp < nextOldest) {                 // Oldest one yet.
-            pOldestQ = p;
-            nextOldest = frag.second->s_header.s_timestamp;
-          } 
+        ::EVB::pFragment pFront = p->second.s_queue.front().second;
+        if (pFront->s_header.s_barrier == 0) {                             // only non-barriers.
+          m_oldestHeap.push(pFront->s_header.s_timestamp, p->first, &(p->second));
         } else {
           m_fBarrierPending = true; // Mark a pending barrier.
         } 
       }
-
-      i++;
-    }
-
-
-
-    if (nextOldest != UINT64_MAX) { // Found one in pOldestQ.
-      std::pair<time_t, ::EVB::pFragment> oldestFrag = pOldestQ->second.s_queue.front();
-      uint64_t fragmentTimestamp  = oldestFrag.second->s_header.s_timestamp;
-      
-      pOldestQ->second.s_lastPoppedTimestamp = fragmentTimestamp;
-      pOldestQ->second.s_bytesDeQd          += oldestFrag.second->s_header.s_size;
-      pOldestQ->second.s_bytesInQ           -= oldestFrag.second->s_header.s_size;
-      pOldestQ->second.s_queue.pop_front();
-
-      // If this queue has been emptied mark that time:
-
-      if (pOldestQ->second.s_queue.empty()) {
-        m_nMostRecentlyEmptied = time(NULL);
-      }
-      findOldest();
-
-
-      return new std::pair<time_t, ::EVB::pFragment>(oldestFrag);
-    } else {			    // Either all barriers or all empty.
-      return 0;
     }
-
-    // Should not get here but...
-    return 0;
-
+    findOldest();
+    m_fOldestHeapValid = true;
 }
-
 /**
  * observe
  *
@@ -1158,18 +1216,19 @@ CFragmentHandler::dataLate(const ::EVB::Fragment& fragment)
  * addFragment
  *
  * Add a single event fragment to the appropriate event queue.
- * The fragment is copied so that ownership of the parameter remains
- * with the caller.  allocateFragment is used to create the fragment
- * storage adnfreeFragment should be used to release that storage
- * (and that is done by buildEvent() typically).
+ * The fragment header is copied, its body stays where it is in the
+ * fragment block.  allocateFragmentInBlock is used to create the fragment
+ * and freeFragment should be used to release it
+ * (and that is done by the output thread typically).
  *
- * @param pFragment - Pointer to the flattened fragment.
+ * @param pBlock    - Fragment block holding the fragment.
+ * @param pFragment - Pointer to the flattened fragment in pBlock.
  * 
  * @note This method can also alter the value of m_nNewest if its
  *       timestamp says it is the newest fragment.
  */
 void
-CFragmentHandler::addFragment(const EVB::FlatFragment* pFragment)
+CFragmentHandler::addFragment(EVB::pFragmentBlock pBlock, const EVB::FlatFragment* pFragment)
 {
   
     bool     assigned            = false;
@@ -1177,15 +1236,13 @@ CFragmentHandler::addFragment(const EVB::FlatFragment* pFragment)
 
     m_nFragmentsLastPeriod++;	//  We were not idle.
 
-    // Allocate the fragmentand copy it:
+    // Allocate the fragment - the body is left in the block:
     
     const EVB::FragmentHeader* pHeader = &pFragment->s_header;
-    EVB::pFragment pFrag         = allocateFragment(pHeader); // Copies the header.
+    EVB::pFragment pFrag         = allocateFragmentInBlock(pBlock, pFragment); // Copies the header.
     uint64_t timestamp           = pHeader->s_timestamp;
     m_fBarrierPending           |= (pHeader->s_barrier != 0);   //Mark there's a barrier pending
 
-    memcpy(pFrag->s_pBody, pFragment->s_body, pFrag->s_header.s_size);
-
     // Get a reference to the fragment queue, creating it if needed:
     // Note that queues should get created by connection from the
     // fragment maker.  We'll give this queue a "" for an id.
@@ -1474,6 +1531,7 @@ CFragmentHandler::generateBarrier(EvbFragments& outputList)
   }
 
   m_fBarrierPending = false;
+  invalidateOldestHeap();
   findOldest();
 
   return result;
@@ -1640,6 +1698,7 @@ CFragmentHandler::getSourceQueue(std::string sockName, uint32_t id)
   if (p  == m_FragmentQueues.end()) {	       // Need to create.
     
     SourceQueue& queue = m_FragmentQueues[id]; // Does most of the creation.
+    invalidateOldestHeap();
     queue.setId(sockName.c_str());
     return queue;
   }  else {			              // already exists.
@@ -1771,6 +1830,15 @@ CFragmentHandler::inFlightFragmentCount()
   
   return  m_outputThread.getInflightCount() + m_sorter.getInflightCount();
 }
+/**
+ * inFlightByteCount
+ *    @return size_t number of bytes of fragment data in flight.
+ */
+size_t
+CFragmentHandler::inFlightByteCount()
+{
+  return m_outputThread.getInflightBytes() + m_sorter.getInflightBytes();
+}
 /**
  *  checkXoff
  *    If appropriate, Xoff the senders:
@@ -1778,7 +1846,9 @@ CFragmentHandler::inFlightFragmentCount()
 void
 CFragmentHandler::checkXoff()
 {
-  if ((inFlightFragmentCount() > m_nXoffLimit) && (!m_fXoffed)) {
+  bool tooManyBytes =
+    m_nInflightByteLimit && (inFlightByteCount() > m_nInflightByteLimit);
+  if (((inFlightFragmentCount() > m_nXoffLimit) || tooManyBytes) && (!m_fXoffed)) {
     Xoff();
   }
 }
@@ -1790,7 +1860,9 @@ CFragmentHandler::checkXoff()
  void
  CFragmentHandler::checkXon()
 {
-  if ((inFlightFragmentCount() < m_nXonLimit) && m_fXoffed) {
+  bool fewEnoughBytes =
+    (!m_nInflightByteLimit) || (inFlightByteCount() < m_nInflightByteLimit/2);
+  if ((inFlightFragmentCount() < m_nXonLimit) && fewEnoughBytes && m_fXoffed) {
     Xon();
   }
 }
@@ -2054,6 +2126,7 @@ CFragmentHandler::insertFragment(
 {
   std::pair<time_t, EVB::pFragment> entry = {clockTime, pFrag};
   uint64_t entryTimestamp = pFrag->s_header.s_timestamp;
+  invalidateOldestHeap();
   
   if (dest.s_queue.empty()) {                  // queue empty.
     dest.s_queue.push_back(entry);
@@ -29,6 +29,7 @@
 #include <cstdint>
 
 #include <limits>
+#include "CTimestampHeap.h"
 
 class COutputThread;
 class CSortThread;
@@ -43,6 +44,9 @@ namespace EVB {
   
   struct _Fragment;
   typedef struct _Fragment Fragment, *pFragment;
+
+  struct _FragmentBlock;
+  typedef struct _FragmentBlock FragmentBlock, *pFragmentBlock;
 };
 
 
@@ -244,6 +248,8 @@ private:
 
   Sources                      m_FragmentQueues;
   bool                         m_fBarrierPending;      //< True if at least one queue has a barrier event.
+  CTimestampHeap<SourceQueue*> m_oldestHeap;           //< Non-barrier queue heads for popOldest.
+  bool                         m_fOldestHeapValid;     //< False if the queues changed since m_oldestHeap was built.
   std::set<std::uint32_t>           m_liveSources;	       //< sources that are live.
   std::map<std::string, std::list<std::uint32_t> > m_socketSources; //< Each socket name has a list of source ids.
   std::map<std::string, std::list<std::uint32_t> > m_deadSockets;   //< same as above but for dead sockets.
@@ -254,6 +260,7 @@ private:
   size_t                       m_nXoffLimit;
   size_t                       m_nPerQXonLimit;
   size_t                       m_nPerQXoffLimit;
+  size_t                       m_nInflightByteLimit;   // 0 - no limit.
   bool                         m_fXoffed;
   size_t                       m_nTotalFragmentSize;
 
@@ -284,6 +291,7 @@ public:
 
 public:
   void addFragments(size_t nSize, const EVB::FlatFragment* pFragments);
+  void addFragments(EVB::pFragmentBlock pBlock, size_t nSize);
 
   void setBuildWindow(time_t windowWidth);
   time_t getBuildWindow() const;
@@ -297,6 +305,9 @@ public:
   void setPerQXoffThreshold(size_t nSize);
   void setPerQXonThreshold(size_t nSize);
   
+  void setInflightByteLimit(size_t nBytes);
+  size_t getInflightByteLimit() const;
+  
   
   // Observer management:
   
@@ -306,6 +317,9 @@ public:
   CSortThread* getSortThread() {
     return &m_sorter;
   }
+  bool isXoffed() const {
+    return m_fXoffed;
+  }
 public:
 
   void addObserver(Observer* pObserver);
@@ -357,9 +371,11 @@ public:
 
 private:
   void flushQueues(bool completely=false);
-  std::pair<time_t, ::EVB::pFragment>* popOldest();
+  bool popOldest(std::pair<time_t, ::EVB::pFragment>& oldest);
+  void buildOldestHeap();
+  void invalidateOldestHeap() { m_fOldestHeapValid = false; }
   void   dataLate(const ::EVB::Fragment& fragment);		    // Data late handler.
-  void   addFragment(const EVB::FlatFragment* pFragment);
+  void   addFragment(EVB::pFragmentBlock pBlock, const EVB::FlatFragment* pFragment);
   size_t totalFragmentSize(const EVB::FragmentHeader* pHeader);
   bool   queuesEmpty();
   bool   noEmptyQueue();
@@ -397,6 +413,7 @@ private:
   time_t oldestBarrier();
 
   size_t inFlightFragmentCount();
+  size_t inFlightByteCount();
   void checkXoff();
   void checkXon();
   
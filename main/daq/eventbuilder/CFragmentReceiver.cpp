@@ -0,0 +1,395 @@
+/**
+
+#    This software is Copyright by the Board of Trustees of Michigan
+#    State University (c) Copyright 2013-2018
+#
+#    You may use this software under the terms of the GNU public license
+#    (GPL).  The terms of this license are described at:
+#
+#     http://www.gnu.org/licenses/gpl.txt
+#
+#    Author:
+#            Ron Fox
+#            NSCL
+#            Michigan State University
+#            East Lansing, MI 48824-1321
+
+##
+# @file   CFragmentReceiver.cpp
+# @brief  Implementation of the native credit flow controlled receiver.
+# @author <fox@nscl.msu.edu>
+*/
+
+#include "CFragmentReceiver.h"
+#include "CEventOrderClient.h"
+#include "fragment.h"
+#include <io.h>
+#include <Exception.h>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <stdexcept>
+#include <iostream>
+
+// Events queued to the interpreter thread:
+
+typedef struct _ReceivedBufferEvent {
+    Tcl_Event                   s_event;
+    CFragmentReceiver*          s_pReceiver;
+    CFragmentReceiver::Buffer*  s_pBuffer;
+} ReceivedBufferEvent, *pReceivedBufferEvent;
+
+typedef struct _ReceiverClosedEvent {
+    Tcl_Event                   s_event;
+    CFragmentReceiver*          s_pReceiver;
+} ReceiverClosedEvent, *pReceiverClosedEvent;
+
+/**
+ * constructor
+ *    The buffers are allocated here; one per credit.  The thread is not
+ *    started - that's up to the creator, once we're registered as a flow
+ *    control observer.
+ *
+ * @param pInterp        - Interpreter the close/activity scripts run in.
+ * @param interpThread   - Thread that interpreter runs in.
+ * @param sockName       - Name of the Tcl channel (identifies the queues).
+ * @param fd             - Socket file descriptor.  We own (close) it.
+ * @param credits        - Number of messages the client may have in flight.
+ * @param closeScript    - Script run when the connection ends.
+ * @param activityScript - Script run (at most once a second) as data arrive.
+ */
+CFragmentReceiver::CFragmentReceiver(
+    Tcl_Interp* pInterp, Tcl_ThreadId interpThread, std::string sockName,
+    int fd, uint32_t credits, std::string closeScript,
+    std::string activityScript
+) :
+    Thread(std::string("FragmentReceiver")),
+    m_pInterp(pInterp), m_interpThread(interpThread), m_sockName(sockName),
+    m_fd(fd), m_nCredits(credits), m_fXoffed(false), m_fQueueXoffed(false),
+    m_nWithheld(0), m_closeScript(closeScript), m_activityScript(activityScript),
+    m_lastActivity(0), m_pFinalState("LOST")
+{
+    for (int i = 0; i < m_nCredits; i++) {
+        m_freeBuffers.queue(new Buffer);
+    }
+    m_fXoffed = CFragmentHandler::getInstance()->isXoffed();
+}
+/**
+ * destructor
+ *    Only called in the interpreter thread after the receive thread
+ *    exited and all of its events have been processed.
+ */
+CFragmentReceiver::~CFragmentReceiver()
+{
+    CFragmentHandler::getInstance()->removeFlowControlObserver(this);
+    close(m_fd);
+
+    Buffer* pBuffer;
+    while (m_freeBuffers.getnow(pBuffer)) {
+        delete pBuffer;
+    }
+}
+/**
+ * run
+ *    Thread entry point.  Grant the initial credits (or hold them for Xon
+ *    if flow is already off) then read messages until DISCONNECT, end of
+ *    file or error.
+ */
+void
+CFragmentReceiver::run()
+{
+    const char* state = "LOST";
+    try {
+        uint32_t initial = m_nCredits;
+        {
+            CriticalSection c(m_grantLock);
+            if (m_fXoffed || m_fQueueXoffed) {
+                m_nWithheld += initial;
+                initial      = 0;
+            }
+        }
+        if (initial) grant(initial);
+        while (1) {
+            EVB::ClientMessageHeader hdr;
+            if (io::readData(m_fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+                break;                              // Lost the client.
+            }
+            if (hdr.s_msgType == EVB::FRAGMENTS) {
+
+                // Only blocks if the client ignores its credits:
+
+                Buffer* pBuffer = m_freeBuffers.get();
+                pBuffer->s_pBlock = allocateFragmentBlock(hdr.s_bodySize);
+                pBuffer->s_nBytes = hdr.s_bodySize;
+                bool complete;
+                try {
+                    complete = io::readData(
+                        m_fd, fragmentBlockData(pBuffer->s_pBlock), hdr.s_bodySize
+                    ) == hdr.s_bodySize;
+                }
+                catch (int e) {
+                    complete = false;
+                }
+                if (!complete) {
+                    releaseFragmentBlock(pBuffer->s_pBlock);
+                    m_freeBuffers.queue(pBuffer);
+                    break;
+                }
+                postBuffer(pBuffer);
+            } else if (hdr.s_msgType == EVB::DISCONNECT) {
+                grant(0);
+                state = "CLOSED";
+                break;
+            } else {
+                std::cerr << "Fragment receiver for " << m_sockName
+                    << " got unexpected message type " << hdr.s_msgType
+                    << " closing the connection\n";
+                state = "ERROR";
+                break;
+            }
+        }
+    }
+    catch (int e) {                  // errno from io::readData.
+    }
+    postClose(state);
+}
+/*-------------------------------------------------------------------------
+ *  Flow control - these are called in the interpreter thread by the
+ *  fragment handler.
+ */
+
+/**
+ * Xon
+ *    Global flow on - grant the credits we've been holding unless our
+ *    queues are still Xoffed.
+ */
+void
+CFragmentReceiver::Xon()
+{
+    uint32_t withheld = 0;
+    {
+        CriticalSection c(m_grantLock);
+        m_fXoffed = false;
+        if (!m_fQueueXoffed) {
+            withheld    = m_nWithheld;
+            m_nWithheld = 0;
+        }
+    }
+    if (withheld) grant(withheld);
+}
+void
+CFragmentReceiver::Xon(std::string qid)
+{
+    if (qid != m_sockName) return;
+
+    uint32_t withheld = 0;
+    {
+        CriticalSection c(m_grantLock);
+        m_fQueueXoffed = false;
+        if (!m_fXoffed) {
+            withheld    = m_nWithheld;
+            m_nWithheld = 0;
+        }
+    }
+    if (withheld) grant(withheld);
+}
+/**
+ * Xoff
+ *    Stop granting credits.  The client can still send what it already
+ *    has credits for.
+ */
+void
+CFragmentReceiver::Xoff()
+{
+    CriticalSection c(m_grantLock);
+    m_fXoffed = true;
+}
+void
+CFragmentReceiver::Xoff(std::string qid)
+{
+    if (qid != m_sockName) return;
+    CriticalSection c(m_grantLock);
+    m_fQueueXoffed = true;
+}
+/*-------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * postBuffer
+ *    Queue a filled buffer to the interpreter thread.
+ * @param pBuffer - the buffer.
+ */
+void
+CFragmentReceiver::postBuffer(Buffer* pBuffer)
+{
+    pReceivedBufferEvent pEvent =
+        reinterpret_cast<pReceivedBufferEvent>(Tcl_Alloc(sizeof(ReceivedBufferEvent)));
+    pEvent->s_event.proc = handleBuffer;
+    pEvent->s_pReceiver  = this;
+    pEvent->s_pBuffer    = pBuffer;
+
+    Tcl_ThreadQueueEvent(
+        m_interpThread, reinterpret_cast<Tcl_Event*>(pEvent), TCL_QUEUE_TAIL
+    );
+    Tcl_ThreadAlert(m_interpThread);
+}
+/**
+ * postClose
+ *    Queue the end of connection event.  Since it's queued after all of our
+ *    buffers, all the data have been handled by the time it runs.
+ *
+ * @param state - final connection state.
+ */
+void
+CFragmentReceiver::postClose(const char* state)
+{
+    m_pFinalState = state;
+    pReceiverClosedEvent pEvent =
+        reinterpret_cast<pReceiverClosedEvent>(Tcl_Alloc(sizeof(ReceiverClosedEvent)));
+    pEvent->s_event.proc = handleClose;
+    pEvent->s_pReceiver  = this;
+
+    Tcl_ThreadQueueEvent(
+        m_interpThread, reinterpret_cast<Tcl_Event*>(pEvent), TCL_QUEUE_TAIL
+    );
+    Tcl_ThreadAlert(m_interpThread);
+}
+/**
+ * grant
+ *    Send a credit grant to the client.  Failures are ignored; the receive
+ *    thread will see the connection loss.
+ *
+ * @param credits - number of credits to grant.
+ */
+void
+CFragmentReceiver::grant(uint32_t credits)
+{
+    CriticalSection c(m_grantLock);
+    send(m_fd, &credits, sizeof(credits), MSG_NOSIGNAL);
+}
+/**
+ * releaseBuffer
+ *    Return a buffer to the free list and grant the client the credit
+ *    back, or hold onto it if flow is off.
+ *
+ * @param pBuffer - the buffer.
+ */
+void
+CFragmentReceiver::releaseBuffer(Buffer* pBuffer)
+{
+    m_freeBuffers.queue(pBuffer);
+    {
+        CriticalSection c(m_grantLock);
+        if (m_fXoffed || m_fQueueXoffed) {
+            m_nWithheld++;
+            return;
+        }
+    }
+    grant(1);
+}
+/**
+ * processBuffer
+ *    Pass a buffer's fragment block to the fragment handler, which takes it
+ *    over, and free the buffer. Errors are
+ *    reported as background errors as they would be if
+ *    EVB::handleFragments failed in a fileevent.
+ *
+ * @param pBuffer - the buffer.
+ */
+void
+CFragmentReceiver::processBuffer(Buffer* pBuffer)
+{
+    std::string error;
+    try {
+        CFragmentHandler::getInstance()->addFragments(
+            pBuffer->s_pBlock, pBuffer->s_nBytes
+        );
+    }
+    catch (std::string msg) {
+        error = msg;
+    }
+    catch (const char* msg) {
+        error = msg;
+    }
+    catch (CException& e) {
+        error = e.ReasonText();
+    }
+    catch (std::exception& e) {
+        error = e.what();
+    }
+    releaseBuffer(pBuffer);
+    if (error != "") {
+        Tcl_SetObjResult(m_pInterp, Tcl_NewStringObj(error.c_str(), -1));
+        Tcl_BackgroundError(m_pInterp);
+    } else {
+        activity();
+    }
+}
+/**
+ * activity
+ *    Run the activity script if it has not been run in this second.
+ *    This keeps the connection manager's source timeouts up to date without
+ *    a script per message.
+ */
+void
+CFragmentReceiver::activity()
+{
+    time_t now = time(NULL);
+    if ((now != m_lastActivity) && (m_activityScript != "")) {
+        m_lastActivity = now;
+        if (Tcl_EvalEx(m_pInterp, m_activityScript.c_str(), -1, TCL_EVAL_GLOBAL) != TCL_OK) {
+            Tcl_BackgroundError(m_pInterp);
+        }
+    }
+}
+/**
+ * closed
+ *    Connection is done; reap the thread, run the close script and
+ *    delete ourself.
+ */
+void
+CFragmentReceiver::closed()
+{
+    join();
+    std::string script = m_closeScript;
+    script += " ";
+    script += m_pFinalState;
+    Tcl_Interp* pInterp = m_pInterp;
+    delete this;
+
+    if (Tcl_EvalEx(pInterp, script.c_str(), -1, TCL_EVAL_GLOBAL) != TCL_OK) {
+        Tcl_BackgroundError(pInterp);
+    }
+}
+
+/**
+ * handleBuffer
+ *    Tcl event handler for received buffers.
+ *
+ * @param pEvent - actually a pReceivedBufferEvent.
+ * @param flags  - event flags (unused).
+ * @return int 1 - the event can be freed.
+ */
+int
+CFragmentReceiver::handleBuffer(Tcl_Event* pEvent, int flags)
+{
+    pReceivedBufferEvent p = reinterpret_cast<pReceivedBufferEvent>(pEvent);
+    p->s_pReceiver->processBuffer(p->s_pBuffer);
+    return 1;
+}
+/**
+ * handleClose
+ *    Tcl event handler for the end of the connection.
+ *
+ * @param pEvent - actually a pReceiverClosedEvent.
+ * @param flags  - event flags (unused).
+ * @return int 1 - the event can be freed.
+ */
+int
+CFragmentReceiver::handleClose(Tcl_Event* pEvent, int flags)
+{
+    pReceiverClosedEvent p = reinterpret_cast<pReceiverClosedEvent>(pEvent);
+    p->s_pReceiver->closed();
+    return 1;
+}
@@ -0,0 +1,119 @@
+/**
+
+#    This software is Copyright by the Board of Trustees of Michigan
+#    State University (c) Copyright 2013-2018
+#
+#    You may use this software under the terms of the GNU public license
+#    (GPL).  The terms of this license are described at:
+#
+#     http://www.gnu.org/licenses/gpl.txt
+#
+#    Author:
+#            Ron Fox
+#            NSCL
+#            Michigan State University
+#            East Lansing, MI 48824-1321
+
+##
+# @file   CFragmentReceiver.h
+# @brief  Native (non Tcl) receiver for a credit flow controlled client.
+# @author <fox@nscl.msu.edu>
+*/
+#ifndef CFRAGMENTRECEIVER_H
+#define CFRAGMENTRECEIVER_H
+
+#include <Thread.h>
+#include <CBufferQueue.h>
+#include <CMutex.h>
+#include "CFragmentHandler.h"
+#include "fragment.h"
+
+#include <tcl.h>
+#include <string>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @class CFragmentReceiver
+ *
+ *    Receives FRAGMENTS messages from one client that connected with
+ *    EVB::CREDITCONNECT.  The CONNECT handshake is done by the Tcl
+ *    connection manager, which then hands the socket to one of these.
+ *
+ *    The receive thread reads messages directly from the socket into
+ *    fragment blocks (see allocateFragmentBlock) described by one of a
+ *    fixed set of buffers.  Filled buffers are queued as Tcl events to the
+ *    interpreter thread, which hands their blocks to
+ *    CFragmentHandler::addFragments, without copying them, and returns the
+ *    buffers to the free list.
+ *
+ *    Flow control is by credits.  The client may have one FRAGMENTS message
+ *    in flight per credit.  One credit per buffer is granted initially and
+ *    a credit is granted back each time a buffer is freed.  While the
+ *    fragment handler has us Xoffed (globally or our socket's queues), the
+ *    grants are withheld until Xon.
+ *
+ *    Grants are binary uint32_t credit counts.  A zero grant acknowledges
+ *    DISCONNECT.
+ *
+ *    The receiver deletes itself, in the interpreter thread, once the
+ *    connection ends.  Its close script is then run with the final
+ *    connection state (CLOSED, LOST or ERROR) appended.
+ */
+class CFragmentReceiver : public Thread, public CFragmentHandler::FlowControlObserver
+{
+public:
+    typedef struct _Buffer {
+        EVB::pFragmentBlock s_pBlock;
+        uint32_t            s_nBytes;
+    } Buffer;
+private:
+    Tcl_Interp*            m_pInterp;
+    Tcl_ThreadId           m_interpThread;
+    std::string            m_sockName;        // Tcl channel name - the queue id.
+    int                    m_fd;              // dup of the channel's socket.
+    uint32_t               m_nCredits;
+    CBufferQueue<Buffer*>  m_freeBuffers;
+    CMutex                 m_grantLock;       // Grants come from both threads.
+    bool                   m_fXoffed;
+    bool                   m_fQueueXoffed;
+    uint32_t               m_nWithheld;
+    std::string            m_closeScript;
+    std::string            m_activityScript;
+    time_t                 m_lastActivity;
+    const char*            m_pFinalState;
+public:
+    CFragmentReceiver(
+        Tcl_Interp* pInterp, Tcl_ThreadId interpThread, std::string sockName,
+        int fd, uint32_t credits, std::string closeScript,
+        std::string activityScript
+    );
+    virtual ~CFragmentReceiver();
+private:
+    CFragmentReceiver(const CFragmentReceiver&);
+    CFragmentReceiver& operator=(const CFragmentReceiver&);
+
+public:
+    virtual void run();
+
+    // CFragmentHandler::FlowControlObserver interface (interpreter thread):
+
+    virtual void Xon();
+    virtual void Xon(std::string qid);
+    virtual void Xoff();
+    virtual void Xoff(std::string qid);
+
+private:
+    void postBuffer(Buffer* pBuffer);
+    void postClose(const char* state);
+    void grant(uint32_t credits);
+    void releaseBuffer(Buffer* pBuffer);
+    void processBuffer(Buffer* pBuffer);
+    void activity();
+    void closed();
+
+    static int handleBuffer(Tcl_Event* pEvent, int flags);
+    static int handleClose(Tcl_Event* pEvent, int flags);
+};
+
+#endif
@@ -0,0 +1,490 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CGlomOutput.cpp
+ *  @brief: Implement the in-process glom output observer.
+ */
+#include "CGlomOutput.h"
+#include "fragment.h"
+#include <CRingBuffer.h>
+#include <CRingItemFactory.h>
+#include <CRingScalerItem.h>
+#include <CRingPhysicsEventCountItem.h>
+#include <CAbnormalEndItem.h>
+
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * dump
+ *    Hex dump of the start of an unrecognized payload (as glom does).
+ */
+static void
+dump(std::ostream& o, void* pData, size_t nBytes)
+{
+    uint16_t* p(reinterpret_cast<uint16_t*>(pData));
+
+    o << std::hex;
+    for (int l = 0; l < nBytes; l += 8) {
+        for (int i = 0; i < 8; i++) {
+            if (l+i >= nBytes) break;
+            o << *p << " ";
+            p++;
+        }
+        o << std::endl;
+    }
+    o << std::dec << std::endl;
+}
+
+/**
+ * constructor
+ *    Save the parameters, register as an observer and emit the
+ *    ring format item glom starts its output with.
+ *
+ * @param pRing        - Producer on the output ring.  We own it.
+ *                       May be null if reserve/commit are overridden.
+ * @param dt           - Coincidence interval in timestamp ticks.
+ * @param build        - True to build events, false to output each fragment.
+ * @param policy       - Timestamp policy for built events.
+ * @param sourceId     - Source id of built events.
+ * @param maxFragments - Flush an event with more than this many fragments.
+ */
+CGlomOutput::CGlomOutput(
+    CRingBuffer* pRing, uint64_t dt, bool build, TimestampPolicy policy,
+    uint32_t sourceId, unsigned maxFragments
+) :
+    m_pRing(pRing), m_dt(dt), m_fBuilding(build), m_policy(policy),
+    m_sourceId(sourceId), m_nMaxFragments(maxFragments),
+    m_fFirstEvent(true), m_firstTimestamp(0), m_lastTimestamp(0),
+    m_timestampSum(0), m_fragmentCount(0), m_nPendingBytes(0),
+    m_nOutputEvents(0), m_fFirstBarrier(true), m_nStateChangeNesting(0)
+{
+    CFragmentHandler::getInstance()->addObserver(this);
+    if (m_pRing) outputEventFormat();
+}
+/**
+ * destructor
+ *    Stop observing, output the last event and, if a run is in progress,
+ *    an abnormal end (glom does this on end of file).
+ */
+CGlomOutput::~CGlomOutput()
+{
+    CFragmentHandler::getInstance()->removeObserver(this);
+    if (m_pRing) {
+        flushEvent();
+        if (m_nStateChangeNesting) emitAbnormalEnd();
+    }
+    delete m_pRing;
+}
+/**
+ * operator()
+ *    Called by the output thread with a batch of ordered fragments.
+ *    Fragments of the event still being built are copied out of the
+ *    batch before we return since the fragments are then freed.
+ *
+ * @param event - the fragments.
+ */
+void
+CGlomOutput::operator()(const EvbFragments& event)
+{
+    for (auto p = event.begin(); p != event.end(); p++) {
+        handleFragment(p->second);
+    }
+    stagePending();
+}
+/**
+ * policyFromString
+ *    Translate a glom --timestamp-policy value into a policy.
+ *
+ * @param policy - earliest, latest or average.
+ * @return TimestampPolicy
+ * @throw std::string - invalid policy.
+ */
+CGlomOutput::TimestampPolicy
+CGlomOutput::policyFromString(std::string policy)
+{
+    if (policy == "earliest") return earliest;
+    if (policy == "latest")   return latest;
+    if (policy == "average")  return average;
+
+    std::string msg = "Invalid timestamp policy: ";
+    msg += policy;
+    msg += " must be earliest, latest or average";
+    throw msg;
+}
+/*---------------------------------------------------------------------------
+ * Output hooks:
+ */
+
+/**
+ * reserve
+ *    Get space for an output ring item.
+ *
+ * @param nBytes - size of the item.
+ * @return void* - where to put it.
+ */
+void*
+CGlomOutput::reserve(size_t nBytes)
+{
+    return m_pRing->reserve(nBytes);
+}
+/**
+ * commit
+ *    Publish the item built in the last reservation.
+ *
+ * @param nBytes - size of the item.
+ */
+void
+CGlomOutput::commit(size_t nBytes)
+{
+    m_pRing->commit(nBytes);
+}
+/**
+ * maxItemSize
+ *    The biggest item reserve can ever give space for.
+ *
+ * @return size_t
+ */
+size_t
+CGlomOutput::maxItemSize()
+{
+    return m_pRing->maxReserve();
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.  These follow glom's main loop.
+ */
+
+/**
+ * handleFragment
+ *    Dispatch one fragment:
+ *    - Barriers flush the event and are output.  The first begin run
+ *      barrier is followed by a GlomParameters item.
+ *    - Physics events are accumulated.
+ *    - Other ring items are output without disturbing the event.
+ *    - Payloads that aren't ring items are output as EVB_UNKNOWN_PAYLOAD items.
+ *
+ * @param p - the fragment.
+ */
+void
+CGlomOutput::handleFragment(EVB::pFragment p)
+{
+    if (p->s_header.s_barrier) {
+        flushEvent();
+        outputBarrier(p);
+        if (m_fFirstBarrier && (p->s_header.s_barrier == BARRIER_START)) {
+            outputGlomParameters();
+            m_fFirstBarrier = false;
+        }
+    } else {
+        // Re-arm the GlomParameters for the next run (persistent mode).
+
+        m_fFirstBarrier = true;
+
+        pRingItemHeader pH = reinterpret_cast<pRingItemHeader>(p->s_pBody);
+        if (CRingItemFactory::isKnownItemType(p->s_pBody)) {
+            if (pH->s_type == PHYSICS_EVENT) {
+                accumulateEvent(p);
+            } else {
+                outputBarrier(p);
+            }
+        } else {
+            std::cerr << "GLOM: Unknown ring item type encountered: \n";
+            dump(std::cerr, pH, pH->s_size < 100 ? pH->s_size : 100);
+            outputBarrier(p);
+        }
+    }
+}
+/**
+ * accumulateEvent
+ *    Add a fragment to the event being built, first flushing that event if:
+ *    - We're not building (fragments are events).
+ *    - The fragment is outside the coincidence interval of the event's
+ *      first fragment (in either direction - see glom).
+ *    - The event has too many fragments.
+ *
+ * @param p - the fragment.
+ */
+void
+CGlomOutput::accumulateEvent(EVB::pFragment p)
+{
+    uint64_t timestamp = p->s_header.s_timestamp;
+    uint64_t tsdiff1   = timestamp - m_firstTimestamp;
+    uint64_t tsdiff2   = m_firstTimestamp - timestamp;
+    uint64_t tsdiff    = (tsdiff1 < tsdiff2) ? tsdiff1 : tsdiff2;
+
+    if (!m_fBuilding || (!m_fFirstEvent && (tsdiff > m_dt)) ||
+        (m_fragmentCount > m_nMaxFragments)) {
+        flushEvent();
+    }
+    if (m_fFirstEvent) {
+        m_firstTimestamp = timestamp;
+        m_fFirstEvent    = false;
+        m_fragmentCount  = 0;
+        m_timestampSum   = 0;
+    }
+    m_lastTimestamp = timestamp;
+    m_fragmentCount++;
+    m_timestampSum += timestamp;
+
+    m_pending.push_back(p);
+    m_nPendingBytes += sizeof(EVB::FragmentHeader) + p->s_header.s_size;
+}
+/**
+ * flushEvent
+ *    Build the accumulated event, if there is one, as a PHYSICS_EVENT
+ *    directly in the output ring.  An event too big for the ring is
+ *    reported and dropped.
+ */
+void
+CGlomOutput::flushEvent()
+{
+    size_t eventBytes = m_staged.size() + m_nPendingBytes;
+    if (!eventBytes) return;
+
+    uint64_t eventTimestamp;
+    switch (m_policy) {
+    case latest:
+        eventTimestamp = m_lastTimestamp;
+        break;
+    case average:
+        eventTimestamp = m_timestampSum/m_fragmentCount;
+        break;
+    case earliest:
+    default:
+        eventTimestamp = m_firstTimestamp;
+        break;
+    }
+    size_t itemSize = sizeof(RingItemHeader) + sizeof(BodyHeader) +
+        sizeof(uint32_t) + eventBytes;
+    if (fits(itemSize, "built event")) {
+        buildEvent(itemSize, eventTimestamp);
+        m_nOutputEvents++;
+    }
+    m_staged.clear();
+    m_pending.clear();
+    m_nPendingBytes = 0;
+    m_fFirstEvent   = true;
+}
+/**
+ * buildEvent
+ *    Build the accumulated event in the output ring.
+ *
+ * @param itemSize       - Size of the PHYSICS_EVENT item.
+ * @param eventTimestamp - Its body header timestamp.
+ */
+void
+CGlomOutput::buildEvent(size_t itemSize, uint64_t eventTimestamp)
+{
+    size_t eventBytes = itemSize -
+        (sizeof(RingItemHeader) + sizeof(BodyHeader) + sizeof(uint32_t));
+    uint8_t* pItem = static_cast<uint8_t*>(reserve(itemSize));
+
+    pRingItemHeader pHeader = reinterpret_cast<pRingItemHeader>(pItem);
+    pHeader->s_size = itemSize;
+    pHeader->s_type = PHYSICS_EVENT;
+    pItem += sizeof(RingItemHeader);
+
+    pBodyHeader pBHeader = reinterpret_cast<pBodyHeader>(pItem);
+    pBHeader->s_size      = sizeof(BodyHeader);
+    pBHeader->s_timestamp = eventTimestamp;
+    pBHeader->s_sourceId  = m_sourceId;
+    pBHeader->s_barrier   = 0;
+    pItem += sizeof(BodyHeader);
+
+    uint32_t eventSize = eventBytes + sizeof(uint32_t);
+    memcpy(pItem, &eventSize, sizeof(uint32_t));
+    pItem += sizeof(uint32_t);
+
+    if (!m_staged.empty()) {
+        memcpy(pItem, m_staged.data(), m_staged.size());
+        pItem += m_staged.size();
+    }
+    for (auto p = m_pending.begin(); p != m_pending.end(); p++) {
+        EVB::pFragment pFrag = *p;
+        memcpy(pItem, &(pFrag->s_header), sizeof(EVB::FragmentHeader));
+        pItem += sizeof(EVB::FragmentHeader);
+        memcpy(pItem, pFrag->s_pBody, pFrag->s_header.s_size);
+        pItem += pFrag->s_header.s_size;
+    }
+    commit(itemSize);
+}
+/**
+ * stagePending
+ *    Copy the fragments of the event being built out of the current batch.
+ */
+void
+CGlomOutput::stagePending()
+{
+    for (auto p = m_pending.begin(); p != m_pending.end(); p++) {
+        EVB::pFragment pFrag = *p;
+        uint8_t* pHeader = reinterpret_cast<uint8_t*>(&(pFrag->s_header));
+        uint8_t* pBody   = static_cast<uint8_t*>(pFrag->s_pBody);
+        m_staged.insert(m_staged.end(), pHeader, pHeader + sizeof(EVB::FragmentHeader));
+        m_staged.insert(m_staged.end(), pBody, pBody + pFrag->s_header.s_size);
+    }
+    m_pending.clear();
+    m_nPendingBytes = 0;
+}
+/**
+ * fits
+ *    Check that an item can go in the output ring.  Items that can't are
+ *    reported and dropped rather than stopping the event builder.
+ *
+ * @param nBytes - size of the item.
+ * @param what   - what it is, for the message.
+ * @return bool  - true if it fits.
+ */
+bool
+CGlomOutput::fits(size_t nBytes, const char* what)
+{
+    size_t max = maxItemSize();
+    if (nBytes <= max) return true;
+
+    std::cerr << "GLOM: Dropping a " << nBytes << " byte " << what
+              << "; the output ring can only hold " << max << " byte items\n";
+    return false;
+}
+/**
+ * outputItem
+ *    Put a complete item in the ring.
+ *
+ * @param pItem  - the item.
+ * @param nBytes - its size.
+ */
+void
+CGlomOutput::outputItem(const void* pItem, size_t nBytes)
+{
+    if (!fits(nBytes, "ring item")) return;
+    void* pDest = reserve(nBytes);
+    memcpy(pDest, pItem, nBytes);
+    commit(nBytes);
+}
+/**
+ * outputBarrier
+ *    Output a fragment whose payload is not part of a physics event.
+ *    Ring items are output as is (and counted as state changes or used to
+ *    trigger event count items).  Anything else is wrapped, fragment header
+ *    and all, in an EVB_UNKNOWN_PAYLOAD item.
+ *
+ * @param p - the fragment.
+ */
+void
+CGlomOutput::outputBarrier(EVB::pFragment p)
+{
+    pRingItemHeader pH = reinterpret_cast<pRingItemHeader>(p->s_pBody);
+    if (CRingItemFactory::isKnownItemType(p->s_pBody)) {
+        outputItem(pH, pH->s_size);
+
+        if (pH->s_type == BEGIN_RUN) {
+            m_nOutputEvents = 0;
+            m_nStateChangeNesting++;
+        }
+        if (pH->s_type == END_RUN) {
+            m_nStateChangeNesting--;
+        }
+        if (pH->s_type == PERIODIC_SCALERS) {
+            outputEventCount(pH);
+        }
+        if (pH->s_type == ABNORMAL_ENDRUN) m_nStateChangeNesting = 0;
+    } else {
+        std::cerr << "Unknown barrier payload: \n";
+        dump(std::cerr, pH, pH->s_size < 100 ? pH->s_size : 100);
+
+        uint32_t size = sizeof(RingItemHeader) +
+            sizeof(EVB::FragmentHeader) + p->s_header.s_size;
+        if (!fits(size, "unknown payload item")) return;
+        uint8_t* pItem = static_cast<uint8_t*>(reserve(size));
+
+        pRingItemHeader pUnknown = reinterpret_cast<pRingItemHeader>(pItem);
+        pUnknown->s_size = size;
+        pUnknown->s_type = EVB_UNKNOWN_PAYLOAD;
+        pItem += sizeof(RingItemHeader);
+        memcpy(pItem, &(p->s_header), sizeof(EVB::FragmentHeader));
+        pItem += sizeof(EVB::FragmentHeader);
+        memcpy(pItem, p->s_pBody, p->s_header.s_size);
+
+        commit(size);
+    }
+}
+/**
+ * outputEventCount
+ *    Output a PHYSICS_EVENT_COUNT item with the number of events we've built,
+ *    timed like the periodic scaler item that triggered it.
+ *
+ * @param pItem - the periodic scaler item.
+ */
+void
+CGlomOutput::outputEventCount(pRingItemHeader pItem)
+{
+    CRingItem* pRaw = CRingItemFactory::createRingItem(pItem);
+    CRingScalerItem* pScaler = dynamic_cast<CRingScalerItem*>(pRaw);
+    if (!pScaler) {
+        delete pRaw;
+        return;
+    }
+    uint32_t tOffset = pScaler->getEndTime();
+    uint32_t divisor = pScaler->getTimeDivisor();
+    delete pRaw;
+
+    CRingPhysicsEventCountItem counters(
+        NULL_TIMESTAMP, m_sourceId, 0, m_nOutputEvents, tOffset,
+        time(nullptr), divisor
+    );
+    pRingItem pCounters = counters.getItemPointer();
+    outputItem(pCounters, pCounters->s_header.s_size);
+}
+/**
+ * outputGlomParameters
+ *    Output the item that describes how events are being built.
+ */
+void
+CGlomOutput::outputGlomParameters()
+{
+    pGlomParameters p = formatGlomParameters(m_dt, m_fBuilding ? 1 : 0, m_policy);
+    outputItem(p, p->s_header.s_size);
+    free(p);
+}
+/**
+ * outputEventFormat
+ *    Output the RING_FORMAT item.
+ */
+void
+CGlomOutput::outputEventFormat()
+{
+    DataFormat format;
+    format.s_header.s_size = sizeof(DataFormat);
+    format.s_header.s_type = RING_FORMAT;
+    format.s_mbz           = 0;
+    format.s_majorVersion  = FORMAT_MAJOR;
+    format.s_minorVersion  = FORMAT_MINOR;
+
+    outputItem(&format, sizeof(format));
+}
+/**
+ * emitAbnormalEnd
+ *    Output an abnormal end run item.
+ */
+void
+CGlomOutput::emitAbnormalEnd()
+{
+    CAbnormalEndItem end;
+    pRingItem pItem = end.getItemPointer();
+    outputItem(pItem, pItem->s_header.s_size);
+    m_nStateChangeNesting = 0;
+}
@@ -0,0 +1,122 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CGlomOutput.h
+ *  @brief: Orderer output observer that builds events into a ring (in-process glom).
+ */
+#ifndef CGLOMOUTPUT_H
+#define CGLOMOUTPUT_H
+
+#include "CFragmentHandler.h"
+#include <DataFormat.h>
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+class CRingBuffer;
+
+/**
+ * @class CGlomOutput
+ *    Does what the orderer -> glom -> stdintoring pipeline does, but inside
+ *    the orderer.  Registered as a fragment handler observer, it is handed
+ *    the ordered fragments by the output thread and:
+ *    - Glues physics event fragments whose timestamps are within the
+ *      coincidence interval (dt) of the first fragment into PHYSICS_EVENT
+ *      ring items (unless building is off, in which case each fragment is
+ *      an event).
+ *    - Timestamps built events according to the timestamp policy.
+ *    - Passes barriers and non physics ring items through as is, emitting
+ *      PHYSICS_EVENT_COUNT items for periodic scalers and a GlomParameters
+ *      item after the first begin run barrier, exactly as glom does.
+ *
+ *    Built events are constructed directly in the output ring using
+ *    CRingBuffer::reserve/commit.  Only the fragments of an event that
+ *    spans output batches get copied before that, since fragment storage
+ *    is recycled once an observer returns.
+ */
+class CGlomOutput : public CFragmentHandler::Observer
+{
+public:
+    typedef enum _TimestampPolicy {       // Same values as GLOM_TIMESTAMP_*
+        earliest = GLOM_TIMESTAMP_FIRST,
+        latest   = GLOM_TIMESTAMP_LAST,
+        average  = GLOM_TIMESTAMP_AVERAGE
+    } TimestampPolicy;
+private:
+    CRingBuffer*     m_pRing;
+    uint64_t         m_dt;
+    bool             m_fBuilding;
+    TimestampPolicy  m_policy;
+    uint32_t         m_sourceId;
+    unsigned         m_nMaxFragments;
+
+    // The event being accumulated:
+
+    bool             m_fFirstEvent;
+    uint64_t         m_firstTimestamp;
+    uint64_t         m_lastTimestamp;
+    uint64_t         m_timestampSum;
+    uint64_t         m_fragmentCount;
+    std::vector<EVB::pFragment> m_pending;  // Its fragments from this batch.
+    size_t           m_nPendingBytes;
+    std::vector<uint8_t>        m_staged;   // Its data from earlier batches.
+
+    // Run state:
+
+    uint64_t         m_nOutputEvents;
+    bool             m_fFirstBarrier;
+    unsigned         m_nStateChangeNesting;
+
+public:
+    CGlomOutput(
+        CRingBuffer* pRing, uint64_t dt, bool build, TimestampPolicy policy,
+        uint32_t sourceId, unsigned maxFragments
+    );
+    virtual ~CGlomOutput();
+private:
+    CGlomOutput(const CGlomOutput&);
+    CGlomOutput& operator=(const CGlomOutput&);
+
+public:
+    virtual void operator()(const EvbFragments& event);
+
+    static TimestampPolicy policyFromString(std::string policy);
+
+    // Output hooks - these are virtual so tests can capture the output.
+
+protected:
+    virtual void* reserve(size_t nBytes);
+    virtual void  commit(size_t nBytes);
+    virtual size_t maxItemSize();
+
+private:
+    void handleFragment(EVB::pFragment p);
+    void accumulateEvent(EVB::pFragment p);
+    void flushEvent();
+    void buildEvent(size_t itemSize, uint64_t eventTimestamp);
+    void stagePending();
+    bool fits(size_t nBytes, const char* what);
+    void outputItem(const void* pItem, size_t nBytes);
+    void outputBarrier(EVB::pFragment p);
+    void outputEventCount(pRingItemHeader pItem);
+    void outputGlomParameters();
+    void outputEventFormat();
+    void emitAbnormalEnd();
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2009.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/**
+ * @file CGlomOutputCommand.cpp
+ * @brief Implementation of the CGlomOutputCommand class.
+ */
+
+#include "CGlomOutputCommand.h"
+#include "TCLInterpreter.h"
+#include "TCLObject.h"
+#include "COrdererOutput.h"
+#include "CGlomOutput.h"
+#include <CRingBuffer.h>
+#include <Exception.h>
+
+/*----------------------------------------------------------------------
+** Canonical method implementations.
+*/
+
+/**
+ * constructor
+ *
+ * @param interp      - reference to the encapsulated interpreter the command will be registered on.
+ * @param name        - Command name.
+ * @param pPipeOutput - The normal output stage; deleted when we set up the
+ *                      ring output.
+ */
+CGlomOutputCommand::CGlomOutputCommand(
+  CTCLInterpreter& interp, std::string name, COrdererOutput* pPipeOutput
+) :
+  CTCLObjectProcessor(interp, name),
+  m_pPipeOutput(pPipeOutput),
+  m_pGlom(nullptr)
+{
+}
+/**
+ * destructor
+ *
+ *   The base class destructor agains does everyting for us:
+ */
+CGlomOutputCommand::~CGlomOutputCommand()
+{}
+
+/*---------------------------------------------------------------------------
+** public interface
+*/
+
+/**
+ *  operator()
+ *
+ *   Called in response to the command.  See the class comments for the
+ *   parameters.  The glom output is registered before the pipe output is
+ *   removed so that no fragments can fall between the two.  Nothing
+ *   should be flowing at this point anyway.
+ *
+ * @param interp - the interpreter that is running the command.
+ * @param objv   - The command words.
+ */
+int
+CGlomOutputCommand::operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+  bindAll(interp, objv);
+  try {
+    requireExactly(objv, 7);
+
+    if (m_pGlom) {
+      throw std::string("glomOutput - output is already going to a ring");
+    }
+    std::string ringName = static_cast<std::string>(objv[1]);
+    int         dt       = objv[2];
+    int         build;
+    if (Tcl_GetBooleanFromObj(
+          interp.getInterpreter(), objv[3].getObject(), &build) != TCL_OK) {
+      throw std::string("glomOutput - build must be a boolean");
+    }
+    CGlomOutput::TimestampPolicy policy =
+      CGlomOutput::policyFromString(static_cast<std::string>(objv[4]));
+    int         sourceId = objv[5];
+    int         maxFrags = objv[6];
+
+    if (dt < 0) {
+      throw std::string("glomOutput - Coincidence window must be >= 0");
+    }
+    if (maxFrags <= 0) {
+      throw std::string("glomOutput - maxfragments must be positive");
+    }
+
+    if (!CRingBuffer::isRing(ringName)) {
+      CRingBuffer::create(ringName);
+    }
+    CRingBuffer* pRing = new CRingBuffer(ringName, CRingBuffer::producer);
+    m_pGlom = new CGlomOutput(pRing, dt, build, policy, sourceId, maxFrags);
+    
+    delete m_pPipeOutput;
+    m_pPipeOutput = nullptr;
+  }
+  catch (std::string msg) {
+    interp.setResult(msg);
+    return TCL_ERROR;
+  }
+  catch (CException& e) {
+    interp.setResult(e.ReasonText());
+    return TCL_ERROR;
+  }
+
+  return TCL_OK;
+}
@@ -0,0 +1,83 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2009.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/**
+ * @file CGlomOutputCommand.h
+ * @brief Defines the class that implements the glomOutput command
+ */
+#ifndef __CGLOMOUTPUTCOMMAND_H
+#define __CGLOMOUTPUTCOMMAND_H
+
+#include <TCLObjectProcessor.h>
+
+// forward definitions
+
+class CTCLInterpreter;
+class CTCLObject;
+class COrdererOutput;
+class CGlomOutput;
+
+
+/**
+ * @class CGlomOutputCommand
+ *
+ *  The glomOutput command replaces the orderer's output to stdout (which
+ *  normally feeds glom and stdintoring) with a CGlomOutput that builds
+ *  events straight into a ring buffer.  The format of the command is:
+ *
+ * \verbatim
+ *   glomOutput ringname dt build policy sourceid maxfragments
+ *
+ * \endverbatim
+ *  
+ * -  ringname  - Name of the output ring.  It's created if it does not exist.
+ * -  dt        - Coincidence interval in timestamp ticks (glom --dt).
+ * -  build     - Boolean, false is the same as glom --nobuild.
+ * -  policy    - Timestamp policy: earliest, latest or average.
+ * -  sourceid  - Source id of built events (glom --sourceid).
+ * -  maxfragments - Maximum fragments in an event (glom --maxfragments).
+ *
+ *  This can only be done once.
+ */
+class CGlomOutputCommand : public CTCLObjectProcessor
+{
+private:
+  COrdererOutput* m_pPipeOutput;
+  CGlomOutput*    m_pGlom;
+  
+  // Implemented canonicals:
+
+ public:
+  CGlomOutputCommand(
+    CTCLInterpreter& interp, std::string name, COrdererOutput* pPipeOutput
+  );
+  virtual ~CGlomOutputCommand();
+
+  // canonicals that are forbidden:
+
+private:
+  CGlomOutputCommand(const  CGlomOutputCommand&);
+  CGlomOutputCommand& operator=(const  CGlomOutputCommand&);
+  int operator==(const  CGlomOutputCommand&) const;
+  int operator!=(const  CGlomOutputCommand&) const;
+
+  // public methods (command implementation):
+
+public:
+  int operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+};
+#endif
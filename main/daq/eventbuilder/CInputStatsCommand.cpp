@@ -15,6 +15,7 @@
 */
 #include "CInputStatsCommand.h"
 #include "CFragmentHandler.h"
+#include "CSortThread.h"
 
 #include <TCLInterpreter.h>
 #include <TCLObject.h>
@@ -131,6 +132,24 @@ CInputStatsCommand::operator()(CTCLInterpreter& interp, std::vector<CTCLObject>&
 
   wideInt = (Tcl_WideInt)stats.s_inflight;  // 4
   result += wideInt;                       // Total in flight frags.
+
+  // Sort stage throughput:
+
+  CSortThread::Statistics sortStats = pQueues->getSortThread()->getStatistics();
+  CTCLObject sortStatList;
+  sortStatList.Bind(interp);
+
+  wideInt = (Tcl_WideInt)sortStats.s_nBatches;      // 5.0
+  sortStatList += wideInt;
+  wideInt = (Tcl_WideInt)sortStats.s_nFragments;    // 5.1
+  sortStatList += wideInt;
+  wideInt = (Tcl_WideInt)sortStats.s_nBytes;        // 5.2
+  sortStatList += wideInt;
+  wideInt = (Tcl_WideInt)sortStats.s_nBusyUsec;     // 5.3
+  sortStatList += wideInt;
+  wideInt = (Tcl_WideInt)sortStats.s_nQueuedBytes;  // 5.4
+  sortStatList += wideInt;
+  result += sortStatList;
   
   interp.setResult(result);
   return TCL_OK;
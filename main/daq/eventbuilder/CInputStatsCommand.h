@@ -35,7 +35,8 @@ class CTCLObject;
  *     describe the queues in a summary way.
  *     The command returns a list of the following form:
  * \verbatim
- *   {oldestTimestamp newestTimestamp totalFragcount queue-statistics}
+ *   {oldestTimestamp newestTimestamp totalFragcount queue-statistics inflight
+ *    sort-statistics}
  * \endverbatim
  *    Where:
  *    - oldestTimestamp is the timestamp of the oldest queued fragment and
@@ -51,6 +52,13 @@ class CTCLObject;
  *      # bytes - the number of bytes in the queue.
  *      # dequeued -Number of bytes dequeued from the queue.
  *      # totalqueued - Cumulative bytes that have been put in the queue.
+ *    - inflight is the number of fragments being sorted or output.
+ *    - sort-statistics are the sort stage throughput counters:
+ *      # batches - Number of merges done.
+ *      # fragments - Number of fragments merged.
+ *      # bytes   - Bytes of fragments merged.
+ *      # busy    - Microseconds spent merging.
+ *      # queued  - Bytes waiting to be merged.
  *
  */
 class CInputStatsCommand : public CTCLObjectProcessor 
@@ -0,0 +1,124 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2009.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/**
+ * @file CNativeInputCommand.cpp
+ * @brief Implementation of the CNativeInputCommand class.
+ */
+
+#include "CNativeInputCommand.h"
+#include "TCLInterpreter.h"
+#include "TCLObject.h"
+#include "CFragmentHandler.h"
+#include "CFragmentReceiver.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------
+** Canonical method implementations.
+*/
+
+/**
+ * constructor
+ *
+ *   The base class does the heavy lifting of registering us so that our operator()
+ *   is invoked in response to the command.  We are constructed in the
+ *   interpreter's thread, which is where the receivers send their data.
+ *
+ * @param interp - reference to the encapsulated interpreter the command will be registered on.
+ * @param name   - Command name.
+ */
+CNativeInputCommand::CNativeInputCommand(CTCLInterpreter& interp, std::string name) :
+  CTCLObjectProcessor(interp, name),
+  m_interpThread(Tcl_GetCurrentThread())
+{
+}
+/**
+ * destructor
+ *
+ *   The base class destructor agains does everyting for us:
+ */
+CNativeInputCommand::~CNativeInputCommand()
+{}
+
+/*---------------------------------------------------------------------------
+** public interface
+*/
+
+/**
+ *  operator()
+ *
+ *   Called in response to the command.  See the class comments for the
+ *   parameters.  The socket's file descriptor is duplicated so that the
+ *   receiver's lifetime does not depend on the Tcl channel.
+ *
+ * @param interp - the interpreter that is running the command.
+ * @param objv   - The command words.
+ */
+int
+CNativeInputCommand::operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
+{
+  bindAll(interp, objv);
+  try {
+    requireAtLeast(objv, 4);
+    requireAtMost(objv, 5);
+
+    std::string sockName    = static_cast<std::string>(objv[1]);
+    int         credits     = objv[2];
+    std::string closeScript = static_cast<std::string>(objv[3]);
+    std::string activityScript;
+    if (objv.size() == 5) {
+      activityScript = static_cast<std::string>(objv[4]);
+    }
+    if (credits <= 0) {
+      throw std::string("nativeInput - credits must be positive");
+    }
+
+    Tcl_Channel chan = Tcl_GetChannel(interp.getInterpreter(), sockName.c_str(), NULL);
+    if (!chan) {
+      throw std::string("nativeInput - Tcl does not know about this channel name");
+    }
+    ClientData handle;
+    if (Tcl_GetChannelHandle(chan, TCL_READABLE, &handle) != TCL_OK) {
+      throw std::string("nativeInput - channel has no readable file descriptor");
+    }
+    int fd = dup(static_cast<int>(reinterpret_cast<intptr_t>(handle)));
+    if (fd < 0) {
+      throw std::string("nativeInput - could not dup the socket");
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);  // The thread blocks.
+
+    CFragmentReceiver* pReceiver = new CFragmentReceiver(
+      interp.getInterpreter(), m_interpThread, sockName, fd, credits,
+      closeScript, activityScript
+    );
+    CFragmentHandler::getInstance()->addFlowControlObserver(pReceiver);
+    pReceiver->start();
+  }
+  catch (std::string msg) {
+    interp.setResult(msg);
+    return TCL_ERROR;
+  }
+  catch (CException& e) {
+    interp.setResult(e.ReasonText());
+    return TCL_ERROR;
+  }
+
+  return TCL_OK;
+}
@@ -0,0 +1,78 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2009.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/**
+ * @file CNativeInputCommand.h
+ * @brief Defines the class that implements the nativeInput command
+ */
+#ifndef __CNATIVEINPUTCOMMAND_H
+#define __CNATIVEINPUTCOMMAND_H
+
+#include <TCLObjectProcessor.h>
+#include <tcl.h>
+
+// forward definitions
+
+class CTCLInterpreter;
+class CTCLObject;
+
+
+/**
+ * @class CNativeInputCommand
+ *
+ *  The nativeInput command hands a connected client socket to a
+ *  CFragmentReceiver.  From then on the socket is read by the receiver's
+ *  thread and fragments go to the fragment handler without going through
+ *  Tcl.  The client must have connected with EVB::CREDITCONNECT and been
+ *  sent its OK.  The format of the command is:
+ *
+ * \verbatim
+ *   nativeInput socketname credits closescript ?activityscript?
+ *
+ * \endverbatim
+ *  
+ * -  socketname - The Tcl name of the socket.  The caller must no longer
+ *                 read from it (remove any readable fileevent).
+ * -  credits    - Number of FRAGMENTS messages the client can have in flight.
+ * -  closescript - Run when the connection ends with the final state
+ *                 (CLOSED, LOST or ERROR) appended.
+ * -  activityscript - Run, at most once a second, as fragments arrive.
+ */
+class CNativeInputCommand : public CTCLObjectProcessor
+{
+private:
+  Tcl_ThreadId m_interpThread;
+  
+  // Implemented canonicals:
+
+ public:
+  CNativeInputCommand(CTCLInterpreter& interp, std::string name);
+  virtual ~CNativeInputCommand();
+
+  // canonicals that are forbidden:
+
+private:
+  CNativeInputCommand(const  CNativeInputCommand&);
+  CNativeInputCommand& operator=(const  CNativeInputCommand&);
+  int operator==(const  CNativeInputCommand&) const;
+  int operator!=(const  CNativeInputCommand&) const;
+
+  // public methods (command implementation):
+
+public:
+  int operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
+};
+#endif
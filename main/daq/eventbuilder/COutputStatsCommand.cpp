@@ -17,6 +17,8 @@
 #include <TCLInterpreter.h>
 #include <TCLObject.h>
 #include "COutputStatsObserver.h"
+#include "CFragmentHandler.h"
+#include "COutputThread.h"
 
 
 
@@ -98,9 +100,12 @@ COutputStatsCommand::operator()(CTCLInterpreter& interp, std::vector<CTCLObject>
 
 /**
  * get
- *   Retrive the statistics.  The are returned as a two element Tcl list
+ *   Retrive the statistics.  The are returned as a three element Tcl list
  *   - Total output fragments
  *   - List of source-id, output fragment count pairs.
+ *   - Output stage throughput counters; batches, fragments, bytes, microseconds
+ *     spent in the output observers and bytes in flight.  These are
+ *     not cleared by clear.
  *
  * @param interp - Encapsualted interpreter.
  * @param objv   - Reference to a vector of encapsulated Tcl_Obj's that make up the 
@@ -137,6 +142,24 @@ COutputStatsCommand::get(CTCLInterpreter& interp, std::vector<CTCLObject>& objv)
   }
   result += fragList;
 
+  COutputThread::Statistics threadStats =
+    CFragmentHandler::getInstance()->getOutputThread()->getStatistics();
+  CTCLObject threadList;
+  threadList.Bind(interp);
+  CTCLObject wideInt;
+  wideInt.Bind(interp);
+  wideInt = (Tcl_WideInt)threadStats.s_nBatches;         // 2.0
+  threadList += wideInt;
+  wideInt = (Tcl_WideInt)threadStats.s_nFragments;       // 2.1
+  threadList += wideInt;
+  wideInt = (Tcl_WideInt)threadStats.s_nBytes;           // 2.2
+  threadList += wideInt;
+  wideInt = (Tcl_WideInt)threadStats.s_nBusyUsec;        // 2.3
+  threadList += wideInt;
+  wideInt = (Tcl_WideInt)threadStats.s_nInflightBytes;   // 2.4
+  threadList += wideInt;
+  result += threadList;
+
   interp.setResult(result);
 
   return TCL_OK;
@@ -24,6 +24,32 @@
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
+#include <time.h>
+
+static const size_t DEFAULT_COALESCE_BYTES(1024*1024);
+
+/**
+ * msNow
+ *   @return long - monotonic time in ms.
+ */
+static long
+msNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec*1000 + now.tv_nsec/1000000;
+}
+/**
+ * usecNow
+ *   @return uint64_t - monotonic time in microseconds.
+ */
+static uint64_t
+usecNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec)*1000000 + now.tv_nsec/1000;
+}
 
 /**
  * Constructor
@@ -32,7 +58,11 @@
  */
 COutputThread::COutputThread() :
 Thread(*(new std::string("OutputThread"))),
-m_nInflightCount(0)
+m_nInflightCount(0),
+m_nInflightBytes(0),
+m_nBatches(0), m_nFragments(0), m_nBytes(0), m_nBusyUsec(0),
+m_nCoalesceBytes(DEFAULT_COALESCE_BYTES),
+m_nCoalesceMs(0)
 {
     
 }
@@ -51,8 +81,10 @@ void
 COutputThread::run()
 {
     while (1) {
-        auto pFrags = getFragments();
+        size_t nBytes;
+        auto pFrags = getFragments(nBytes);
         m_nInflightCount -= (pFrags->size());
+        uint64_t start = usecNow();
         {
             CriticalSection c(m_observerGuard);
             for (auto p = m_observers.begin(); p != m_observers.end(); p++) {
@@ -60,7 +92,13 @@ COutputThread::run()
                 (*pO)(*pFrags);
             }
         }
+        m_nBusyUsec += usecNow() - start;
+        m_nBatches++;
+        m_nFragments += pFrags->size();
+        m_nBytes     += nBytes;
+        
         freeFragments(pFrags);
+        m_nInflightBytes -= nBytes;
     }
 }
 /*---------------------------------------------------------------------------
@@ -105,11 +143,13 @@ COutputThread::removeObserver(CFragmentHandler::Observer* o)
  *
  *  @param pFrags - pointer to a vector of fragment pointers we queue for
  *                  processing.
+ *  @param nBytes - Bytes of fragment data (headers and bodies) in pFrags.
  */
 void
-COutputThread::queueFragments(EvbFragments* pFrags)
+COutputThread::queueFragments(EvbFragments* pFrags, size_t nBytes)
 {
     m_nInflightCount += pFrags->size();
+    m_nInflightBytes += nBytes;
     m_inputQueue.queue(pFrags);
 }
 /**
@@ -123,6 +163,76 @@ COutputThread::getInflightCount() const
 {
     return m_nInflightCount;
 }
+/**
+ * getInflightBytes
+ *    Return the number of bytes of fragment data queued or being output.
+ *
+ * @return size_t
+ */
+size_t
+COutputThread::getInflightBytes() const
+{
+    return m_nInflightBytes;
+}
+/**
+ * getStatistics
+ *    Return the throughput counters of the output stage.
+ *
+ * @return COutputThread::Statistics
+ */
+COutputThread::Statistics
+COutputThread::getStatistics() const
+{
+    Statistics result;
+    result.s_nBatches       = m_nBatches;
+    result.s_nFragments     = m_nFragments;
+    result.s_nBytes         = m_nBytes;
+    result.s_nBusyUsec      = m_nBusyUsec;
+    result.s_nInflightBytes = m_nInflightBytes;
+    return result;
+}
+/**
+ * setCoalesceBytes
+ *    Set the number of bytes of fragment data beyond which queued batches
+ *    are no longer coalesced.
+ *
+ * @param nBytes - the limit, 0 turns off coalescing.
+ */
+void
+COutputThread::setCoalesceBytes(size_t nBytes)
+{
+    m_nCoalesceBytes = nBytes;
+}
+/**
+ * getCoalesceBytes
+ * @return size_t - the coalescing byte limit.
+ */
+size_t
+COutputThread::getCoalesceBytes() const
+{
+    return m_nCoalesceBytes;
+}
+/**
+ * setCoalesceMs
+ *    Set how long we'll wait for more batches when the batch we have
+ *    is smaller than the coalescing byte limit.
+ *
+ * @param ms - milliseconds, 0 means only coalesce what's already queued.
+ */
+void
+COutputThread::setCoalesceMs(int ms)
+{
+    m_nCoalesceMs = ms;
+}
+/**
+ * getCoalesceMs
+ * @return int - the coalescing wait in milliseconds.
+ */
+int
+COutputThread::getCoalesceMs() const
+{
+    return m_nCoalesceMs;
+}
 
 /*----------------------------------------------------------------------------
  * private utilities
@@ -131,18 +241,57 @@ COutputThread::getInflightCount() const
 /**
  * getFragments
  *    Return the next set of fragments that were queued for processing by our
- *    observers.
+ *    observers.  Batches are coalesced as described in the class comments.
+ * @param[out] nBytes - bytes of fragment data in the batch.
  * @return std::vector<EVB::pFragment>*
  */
 EvbFragments*
-COutputThread::getFragments()
+COutputThread::getFragments(size_t& nBytes)
 {
     auto pFragmentList = m_inputQueue.get();
     
-   
+    nBytes = 0;
+    appendFragments(*pFragmentList, nullptr, nBytes);
+    size_t maxBytes = m_nCoalesceBytes;
+    if (maxBytes) {
+        long deadline = msNow() + m_nCoalesceMs;
+        
+        while (nBytes < maxBytes) {
+            EvbFragments* pMore;
+            if (m_inputQueue.getnow(pMore)) {
+                appendFragments(*pFragmentList, pMore, nBytes);
+            } else {
+                long remaining = deadline - msNow();
+                if (remaining <= 0) break;
+                m_inputQueue.wait(remaining);
+            }
+        }
+    }
     return pFragmentList;        // result is a ref dynamically created so this is ok.
     
     
+}
+/**
+ * appendFragments
+ *    Coalesce a batch of fragments into another one, keeping track of the
+ *    bytes of fragment data in the result.
+ *
+ * @param to     - Batch being built up.
+ * @param from   - Batch to append to it (deleted).  If nullptr, only the
+ *                 bytes in to are counted.
+ * @param nBytes - Running byte count (updated).
+ */
+void
+COutputThread::appendFragments(EvbFragments& to, EvbFragments* from, size_t& nBytes)
+{
+    EvbFragments& counted(from ? *from : to);
+    for (auto p = counted.begin(); p != counted.end(); p++) {
+        nBytes += sizeof(EVB::FragmentHeader) + p->second->s_header.s_size;
+    }
+    if (from) {
+        to.insert(to.end(), from->begin(), from->end());
+        delete from;
+    }
 }
 /**
  * freeFragments
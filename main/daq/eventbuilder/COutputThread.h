@@ -50,9 +50,31 @@
  *         in turn, would mislead the user about how the event builder was
  *         performing.
  *
+ *     Batches of fragments that are already queued when the thread looks for
+ *     work are coalesced into a single batch (up to a byte limit).  This lets
+ *     output observers like COrdererOutput make fewer, larger writes when
+ *     the sort thread produces many small batches.  Optionally the thread
+ *     can wait a few milliseconds for more batches to arrive before passing
+ *     an undersized batch on to the observers.
+ *
+ *     The thread keeps the number of bytes of fragment data in flight so
+ *     that the fragment handler can apply back-pressure on them, as well as
+ *     throughput counters.
+ *
  */
 class COutputThread : public Thread
 {
+public:
+    // Throughput counters for the output stage:
+    
+    typedef struct _Statistics {
+        std::uint64_t s_nBatches;        // Batches passed to the observers.
+        std::uint64_t s_nFragments;      // Fragments passed to the observers.
+        std::uint64_t s_nBytes;          // Bytes of those fragments.
+        std::uint64_t s_nBusyUsec;       // Time spent in the observers.
+        std::uint64_t s_nInflightBytes;  // Bytes queued or being output.
+    } Statistics;
+    
     // Local data:
     
 private:
@@ -68,6 +90,19 @@ private:
     // Book keeping for in-flight fragments.
     
     std::atomic<size_t>   m_nInflightCount;
+    std::atomic<size_t>   m_nInflightBytes;
+    
+    // Statistics:
+    
+    std::atomic<std::uint64_t> m_nBatches;
+    std::atomic<std::uint64_t> m_nFragments;
+    std::atomic<std::uint64_t> m_nBytes;
+    std::atomic<std::uint64_t> m_nBusyUsec;
+    
+    // Output coalescing parameters:
+    
+    std::atomic<size_t>   m_nCoalesceBytes;   // 0 means don't coalesce.
+    std::atomic<int>      m_nCoalesceMs;      // Max wait for more batches.
     
 public:
     COutputThread();
@@ -85,13 +120,23 @@ public:
 
     // Make fragments available to the thread:
 public:
-    void queueFragments(EvbFragments* pFrags);
+    void queueFragments(EvbFragments* pFrags, size_t nBytes);
     size_t getInflightCount() const;
+    size_t getInflightBytes() const;
+    Statistics getStatistics() const;
+    
+    // Output coalescing:
+public:
+    void setCoalesceBytes(size_t nBytes);
+    size_t getCoalesceBytes() const;
+    void setCoalesceMs(int ms);
+    int  getCoalesceMs() const;
     
     // Private utilities:
     
 private:
-    EvbFragments* getFragments();
+    EvbFragments* getFragments(size_t& nBytes);
+    void          appendFragments(EvbFragments& to, EvbFragments* from, size_t& nBytes);
     void freeFragments(EvbFragments* frags);
     
 };
@@ -23,6 +23,13 @@
 #include "CSortThread.h"
 #include "COutputThread.h"
 #include <map>
+#include <algorithm>
+#include <time.h>
+
+// A merge is only split if each merge thread gets at least this many
+// fragments:
+
+static const size_t DEFAULT_MIN_PARALLEL_FRAGMENTS(16384);
 
 // Timestamp comparison for sorted merge:
 
@@ -31,6 +38,54 @@ TsCompare(std::pair<time_t, EVB::pFragment>& q1, std::pair<time_t, EVB::pFragmen
 {
   return q1.second->s_header.s_timestamp < q2.second->s_header.s_timestamp ;
 }
+// Timestamp of a fragment list element:
+
+static inline uint64_t
+stamp(const std::pair<time_t, EVB::pFragment>& f)
+{
+  return f.second->s_header.s_timestamp;
+}
+// For std::lower_bound - is the element earlier than the timestamp?
+
+static bool
+TsBefore(const std::pair<time_t, EVB::pFragment>& f, uint64_t ts)
+{
+  return stamp(f) < ts;
+}
+// Microsecond clock for the busy time statistic:
+
+static uint64_t
+usecNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return uint64_t(now.tv_sec)*1000000 + now.tv_nsec/1000;
+}
+
+/**
+ * @class CSortThread::MergeWorker
+ *    A merge thread.  It merges the subranges queued to it and hands them
+ *    back on the sort thread's done queue.  A null job stops it.
+ */
+class CSortThread::MergeWorker : public Thread
+{
+private:
+    CBufferQueue<MergeJob*>  m_jobs;
+    CBufferQueue<MergeJob*>& m_done;
+    CTimestampHeap<size_t>   m_heap;
+public:
+    MergeWorker(CBufferQueue<MergeJob*>& done) :
+        Thread(std::string("SortMergeThread")), m_done(done) {}
+    
+    void queue(MergeJob* pJob) { m_jobs.queue(pJob); }
+    
+    virtual void run() {
+        while (MergeJob* pJob = m_jobs.get()) {
+            CSortThread::mergeRange(*pJob, m_heap);
+            m_done.queue(pJob);
+        }
+    }
+};
 
 
 /**
@@ -38,18 +93,25 @@ TsCompare(std::pair<time_t, EVB::pFragment>& q1, std::pair<time_t, EVB::pFragmen
  *   Just need to salt away the fragment handler:
  */
 CSortThread::CSortThread() : Thread(*(new std::string("SortThread"))),
-m_pHandler(0), m_nQueuedFrags(0)
+m_pHandler(0), m_nQueuedFrags(0), m_nQueuedBytes(0), m_nMergeThreads(1),
+m_nMinParallelFragments(DEFAULT_MIN_PARALLEL_FRAGMENTS),
+m_nBatches(0), m_nFragments(0), m_nBytes(0), m_nBusyUsec(0)
 {}
 
 /**
  * destruction
  *    Clear the buffer queue.  The assumption is that no data is coming in
- *    in other threads, so once it's empty we're done.
+ *    in other threads, so once it's empty we're done.  The merge threads
+ *    are stopped.
  */
 CSortThread::~CSortThread()
 {
     clearBufferQueue();
-
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->queue(nullptr);
+        m_workers[i]->join();
+        delete m_workers[i];
+    }
 }
 
 /**
@@ -71,15 +133,23 @@ CSortThread::run()
         if (!m_pHandler)
             m_pHandler = CFragmentHandler::getInstance(); // We know frag handler construction is done.
         FragmentList* mergedFrags = new FragmentList;  // Deleted by output thread.
+        uint64_t start = usecNow();
         merge(*mergedFrags, *newData);
+        m_nBusyUsec += usecNow() - start;
         
         
         //m_pHandler->observe(*mergedFrags);
         
+        size_t nBytes = countBytes(*mergedFrags);
+        m_nBatches++;
+        m_nFragments += mergedFrags->size();
+        m_nBytes     += nBytes;
+        
         COutputThread* pOutput = m_pHandler->getOutputThread();
         releaseFragments(*newData); 
         m_nQueuedFrags -= mergedFrags->size();
-        pOutput->queueFragments(mergedFrags);
+        m_nQueuedBytes -= nBytes;
+        pOutput->queueFragments(mergedFrags, nBytes);
 
     }
 }
@@ -94,12 +164,54 @@ CSortThread::run()
 void
 CSortThread::queueFragments(Fragments& frags)
 {
+    size_t nBytes(0);
     for (int i = 0; i < frags.size(); i++) {
       m_nQueuedFrags += frags[i]->size();
+      nBytes         += countBytes(*frags[i]);
     }
+    m_nQueuedBytes += nBytes;
     m_fragmentQueue.queue(&frags);
   
 }
+/**
+ * setMergeThreads
+ *    Set the number of threads used for large merges.  This includes the
+ *    sort thread so 1 means merges are never split.  The merge threads are
+ *    started when they're first needed.
+ *
+ * @param nThreads - number of threads (0 is treated as 1).
+ */
+void
+CSortThread::setMergeThreads(unsigned nThreads)
+{
+    m_nMergeThreads = nThreads ? nThreads : 1;
+}
+/**
+ * getMergeThreads
+ * @return unsigned - the number of threads large merges are split across.
+ */
+unsigned
+CSortThread::getMergeThreads() const
+{
+    return m_nMergeThreads;
+}
+/**
+ * getStatistics
+ *    Return the throughput counters of the sort stage.
+ *
+ * @return CSortThread::Statistics
+ */
+CSortThread::Statistics
+CSortThread::getStatistics() const
+{
+    Statistics result;
+    result.s_nBatches     = m_nBatches;
+    result.s_nFragments   = m_nFragments;
+    result.s_nBytes       = m_nBytes;
+    result.s_nBusyUsec    = m_nBusyUsec;
+    result.s_nQueuedBytes = m_nQueuedBytes;
+    return result;
+}
 /**
  * dequeueFragments
  *    Returns the least recently queued fragment.  Blocks if needed.
@@ -116,6 +228,13 @@ CSortThread::dequeueFragments()
  *    Uses the minheap merge algorithm.  Note that lists will be empty when we're
  *    done.
  *
+ *    The heap is a member so that once it has grown to the number of
+ *    sources, merging does no per fragment allocation; each fragment
+ *    costs one sift down (O(log nlists)).  Equal timestamps are taken in
+ *    list order.
+ *
+ *    Large merges may be split across the merge threads (see parallelMerge).
+ *
  *  @param[out] result - list into which the fragments will be merged
  *                      (could be empty).
  *  @param[in] lists - vector of fragment lists to merge
@@ -129,97 +248,210 @@ CSortThread::merge(FragmentList& result, Fragments& lists)
     merge(result, *(lists[0]));
     return;
   }
-  // If there's two lists we have the fast(?) two way merge:
-  
-  if (lists.size() == 2) {
-    merge(result, *(lists[0]), *(lists[1]));
+  size_t nFrags(0);
+  for (int i = 0; i < lists.size(); i++) {
+    nFrags += lists[i]->size();
+  }
+  if (parallelMerge(result, lists, nFrags)) {
     return;
   }
   
-  // Build the minheap for the merge.  Note that the timestamp is a minimum
-  // at the front of each queue.  We make the minheap a map keyed on the
-  // timestamp that contains a pointer to the dequeue from which the
-  // timestamp came.
+  // Build the minheap for the merge.  The key is the timestamp
+  // at the front of each list.  Empty lists are never put in the heap.
 
-  
-  std::multimap<uint64_t, FragmentList*> minheap;  // dup timestamps are possible.
+  m_mergeHeap.clear();
   for (int i =0; i < lists.size(); i++) {
-    uint64_t ts = lists[i]->front().second->s_header.s_timestamp;
-    minheap.emplace(std::make_pair(ts, lists[i]));
+    if (!lists[i]->empty()) {
+      uint64_t ts = lists[i]->front().second->s_header.s_timestamp;
+      m_mergeHeap.push(ts, i, lists[i]);
+    }
   }
-  // Once the map size is 2 we can drop through to the special 2-way merge
-  // which in turn drops into the append when it's down to one list:
+  // Once there's only one list left we can append what's left of it:
   
-  while(minheap.size() > 2) {
-    auto q = minheap.begin();
-    result.push_back(q->second->front());
-    q->second->pop_front();
-    minheap.erase(q);
+  while(m_mergeHeap.size() > 1) {
+    FragmentList* q = m_mergeHeap.top().s_value;
+    result.push_back(q->front());
+    q->pop_front();
     
-    // If there are more elements in q.second - put its timestamp into the minheap:
+    // If there are more elements in q - its new head timestamp replaces
+    // the old key, otherwise it drops out of the heap:
     
-    if (!q->second->empty()) {
-      uint64_t ts = q->second->front().second->s_header.s_timestamp;
-      minheap.emplace(std::make_pair(ts, q->second));
+    if (!q->empty()) {
+      m_mergeHeap.replaceTop(q->front().second->s_header.s_timestamp);
+    } else {
+      m_mergeHeap.pop();
     }
   }
-  if (minheap.size() == 2) {         // last two:
-    merge(result, *(minheap.begin()->second), *(minheap.rbegin()->second));
-    return;
-    
-  } else if (minheap.size() == 1) {   // Don't think this is possible.
-    merge(result, *(minheap.begin()->second));  
+  if (!m_mergeHeap.empty()) {
+    merge(result, *(m_mergeHeap.top().s_value));
+    m_mergeHeap.clear();
   }
 
 }
 /**
- * merge -two way
- *    Merge data from two lists of fragments.  This can be done more efficiently
- *    than the minheap by direct comparison of frons of queues.
- *    When we're down to the last queue we just do the one-way 'merge'.
+ * merge - 1-way.
+ *   Just append the remaining fragments to the result. queue.
  *
- * @param result -reference to the output list.
- * @param list1 - Reference to the first list oif fragments.
- * @param list2 - References the second list of fragments.
+ *   @result - the resulting sorted list.
+ *   @list   - the remaining fragmnets.
  */
 void
-CSortThread::merge(FragmentList& result, FragmentList& list1, FragmentList& list2)
+CSortThread::merge(FragmentList& result, FragmentList& list)
 {
-  auto f1 = list1.front();
-  auto f2 = list2.front();
-  while(1) {
-    
-    if (f1.second->s_header.s_timestamp < f2.second->s_header.s_timestamp) {  // f1 goes.
-      result.push_back(f1);
-      list1.pop_front();
-      f1 = list1.front();
-      if (list1.empty()) {          // Only lis2 left.
-        merge(result, list2);
-        return;
-      }
-    } else {             // F2 goes:
-      
-      result.push_back(f2);
-      list2.pop_front();
-      f2 = list2.front();
-      if (list2.empty()) {             // only list1 left.
-        merge(result, list1);
-        return;
-      }
+  result.insert(result.end(), list.begin(), list.end());
+}
+/**
+ * parallelMerge
+ *    Split a merge across the merge threads if it's big enough.
+ *    The longest list supplies timestamps that cut the merge into subranges.
+ *    Each list is cut at the first fragment at or after each of those
+ *    timestamps so each subrange can be merged independently of the
+ *    others, and into a known part of the result.  This gives the same
+ *    result as the serial merge, ties included.
+ *
+ *    A list that isn't in timestamp order still gets cut into contiguous
+ *    pieces, so no fragments are lost or reordered within the list.
+ *
+ *  @param[out] result - list into which the fragments will be merged.
+ *  @param[in] lists   - the fragment lists (emptied on success).
+ *  @param nFrags      - Total number of fragments in the lists.
+ *  @return bool - false if the merge was not split and still must be done.
+ */
+bool
+CSortThread::parallelMerge(FragmentList& result, Fragments& lists, size_t nFrags)
+{
+  unsigned nThreads    = m_nMergeThreads;
+  size_t   maxThreads  = nFrags/(m_nMinParallelFragments ? m_nMinParallelFragments : 1);
+  if (nThreads > maxThreads) nThreads = maxThreads;
+  if (nThreads < 2) return false;
+  startWorkers(nThreads - 1);
+  
+  // Pick the timestamps at which the merge is cut.  Duplicates
+  // just mean fewer subranges:
+  
+  FragmentList* pLongest = lists[0];
+  for (int i = 1; i < lists.size(); i++) {
+    if (lists[i]->size() > pLongest->size()) pLongest = lists[i];
+  }
+  std::vector<uint64_t> cuts;
+  for (unsigned t = 1; t < nThreads; t++) {
+    uint64_t ts = stamp((*pLongest)[t*pLongest->size()/nThreads]);
+    if (cuts.empty() || (ts > cuts.back())) cuts.push_back(ts);
+  }
+  size_t nJobs = cuts.size() + 1;
+  if (nJobs < 2) return false;
+  
+  // Cut the lists into the job ranges:
+  
+  m_jobs.resize(nJobs);
+  for (int j = 0; j < nJobs; j++) {
+    m_jobs[j].s_ranges.clear();
+  }
+  for (int i = 0; i < lists.size(); i++) {
+    FragmentList& list(*lists[i]);
+    FragmentList::iterator begin = list.begin();
+    for (int j = 0; j < nJobs; j++) {
+      FragmentList::iterator end = (j < cuts.size()) ?
+        std::lower_bound(begin, list.end(), cuts[j], TsBefore) : list.end();
+      m_jobs[j].s_ranges.push_back(Range(begin, end));
+      begin = end;
+    }
+  }
+  // Size the result and figure out where each job's fragments go.
+  // Iterators into result are only valid once it's been resized.
+  
+  size_t base = result.size();
+  result.resize(base + nFrags);
+  FragmentList::iterator dest = result.begin() + base;
+  for (int j = 0; j < nJobs; j++) {
+    m_jobs[j].s_dest = dest;
+    for (int i = 0; i < m_jobs[j].s_ranges.size(); i++) {
+      dest += m_jobs[j].s_ranges[i].second - m_jobs[j].s_ranges[i].first;
     }
   }
+  // Farm out all but the first job, which we do ourselves:
+  
+  for (int j = 1; j < nJobs; j++) {
+    m_workers[j-1]->queue(&m_jobs[j]);
+  }
+  mergeRange(m_jobs[0], m_rangeHeap);
+  for (int j = 1; j < nJobs; j++) {
+    m_doneJobs.get();
+  }
+  
+  for (int i = 0; i < lists.size(); i++) {
+    lists[i]->clear();
+  }
+  return true;
 }
 /**
- * merge - 1-way.
- *   Just append the remaining fragments to the result. queue.
+ * startWorkers
+ *    Make sure there are at least the requested number of merge threads.
+ *    Merge threads are never stopped (except on destruction); idle ones
+ *    just block on their job queues.
  *
- *   @result - the resulting sorted list.
- *   @list   - the remaining fragmnets.
+ *  @param nWorkers - number of merge threads needed.
  */
 void
-CSortThread::merge(FragmentList& result, FragmentList& list)
+CSortThread::startWorkers(unsigned nWorkers)
 {
-  result.insert(result.end(), list.begin(), list.end());
+  while (m_workers.size() < nWorkers) {
+    MergeWorker* pWorker = new MergeWorker(m_doneJobs);
+    pWorker->start();
+    m_workers.push_back(pWorker);
+  }
+}
+/**
+ * mergeRange
+ *    Merge one subrange of a parallel merge.  This is the same minheap
+ *    merge as merge() but it consumes ranges rather than popping lists
+ *    and writes over the job's part of the result.
+ *
+ *  @param job  - The ranges to merge and where to put them.
+ *  @param heap - Heap to use (each merge thread has its own).
+ */
+void
+CSortThread::mergeRange(MergeJob& job, CTimestampHeap<size_t>& heap)
+{
+  std::vector<Range>& ranges(job.s_ranges);
+  FragmentList::iterator dest = job.s_dest;
+  
+  heap.clear();
+  for (int i = 0; i < ranges.size(); i++) {
+    if (ranges[i].first != ranges[i].second) {
+      heap.push(stamp(*(ranges[i].first)), i, i);
+    }
+  }
+  while (heap.size() > 1) {
+    Range& r(ranges[heap.top().s_value]);
+    *dest++ = *(r.first++);
+    if (r.first != r.second) {
+      heap.replaceTop(stamp(*(r.first)));
+    } else {
+      heap.pop();
+    }
+  }
+  if (!heap.empty()) {
+    Range& r(ranges[heap.top().s_value]);
+    std::copy(r.first, r.second, dest);
+    heap.clear();
+  }
+}
+/**
+ * countBytes
+ *    Count the bytes of fragment data (headers and bodies) in a list.
+ *
+ *  @param list - the fragments.
+ *  @return size_t
+ */
+size_t
+CSortThread::countBytes(FragmentList& list)
+{
+  size_t nBytes(0);
+  for (FragmentList::iterator p = list.begin(); p != list.end(); p++) {
+    nBytes += sizeof(EVB::FragmentHeader) + p->second->s_header.s_size;
+  }
+  return nBytes;
 }
 /**
  * clearBufferQueue
@@ -257,7 +489,7 @@ void
 CSortThread::releaseFragmentList(FragmentList& frags)
 {
     while(!frags.empty()) {
-        delete frags.front().second;
+        freeFragment(frags.front().second);
         frags.pop_front();
     }
     delete &frags;
@@ -28,6 +28,7 @@
 #include <vector>
 #include <CBufferQueue.h>
 #include "fragment.h"
+#include "CTimestampHeap.h"
 
 #include <atomic>
 
@@ -38,6 +39,14 @@
  *    merged list is passed on to the output thread for further processing.
  *
  *    Normally, this is run by the fragment handler thread.
+ *
+ *    Large merges can be split across merge threads.  The timestamp range
+ *    of the merge is cut into independent subranges, one per thread, and each
+ *    thread merges its subrange directly into its part of the result.  The
+ *    sort thread itself merges one of the subranges.
+ *
+ *    The bytes of fragment data queued to us but not yet merged are kept
+ *    so that the fragment handler can apply back-pressure on them.
  */
 
 class CSortThread : public Thread
@@ -47,10 +56,48 @@ class CSortThread : public Thread
 public:
     typedef EvbFragments FragmentList;
     typedef std::deque<FragmentList*> Fragments;
+    
+    // One subrange of a parallel merge.  s_ranges has the part of each
+    // input list in the subrange, the merged fragments go to s_dest on.
+    
+    typedef std::pair<FragmentList::iterator, FragmentList::iterator> Range;
+    typedef struct _MergeJob {
+        std::vector<Range>     s_ranges;
+        FragmentList::iterator s_dest;
+    } MergeJob;
+    class MergeWorker;
+    
+    // Throughput counters for the sort stage:
+    
+    typedef struct _Statistics {
+        std::uint64_t s_nBatches;        // Merges done.
+        std::uint64_t s_nFragments;      // Fragments merged.
+        std::uint64_t s_nBytes;          // Bytes of fragments merged.
+        std::uint64_t s_nBusyUsec;       // Time spent merging.
+        std::uint64_t s_nQueuedBytes;    // Bytes waiting to be merged.
+    } Statistics;
 private:
     CBufferQueue<Fragments*> m_fragmentQueue;
     CFragmentHandler*       m_pHandler;
     std::atomic<size_t>     m_nQueuedFrags;
+    std::atomic<size_t>     m_nQueuedBytes;
+    CTimestampHeap<FragmentList*> m_mergeHeap;   // Reused across merges.
+    CTimestampHeap<size_t>  m_rangeHeap;         // For our parallel subrange.
+    
+    // Parallel merge:
+    
+    std::atomic<unsigned>     m_nMergeThreads;   // Including this one.
+    size_t                    m_nMinParallelFragments;
+    std::vector<MergeWorker*> m_workers;
+    CBufferQueue<MergeJob*>   m_doneJobs;
+    std::vector<MergeJob>     m_jobs;
+    
+    // Statistics:
+    
+    std::atomic<std::uint64_t> m_nBatches;
+    std::atomic<std::uint64_t> m_nFragments;
+    std::atomic<std::uint64_t> m_nBytes;
+    std::atomic<std::uint64_t> m_nBusyUsec;
 public:
     CSortThread();
     virtual ~CSortThread();
@@ -59,11 +106,19 @@ public:
     
     void queueFragments(Fragments& frags);
     size_t getInflightCount() const { return m_nQueuedFrags; }
+    size_t getInflightBytes() const { return m_nQueuedBytes; }
+    
+    void setMergeThreads(unsigned nThreads);
+    unsigned getMergeThreads() const;
+    Statistics getStatistics() const;
 private:
     Fragments* dequeueFragments();
     void merge(FragmentList& result, Fragments& lists);
-    void merge(FragmentList& result, FragmentList& list1, FragmentList& list2);
     void merge(FragmentList& result, FragmentList& list);
+    bool parallelMerge(FragmentList& result, Fragments& lists, size_t nFrags);
+    void startWorkers(unsigned nWorkers);
+    static void mergeRange(MergeJob& job, CTimestampHeap<size_t>& heap);
+    static size_t countBytes(FragmentList& list);
     void clearBufferQueue();
     void releaseFragments(Fragments& frags);
     void releaseFragmentList(FragmentList& frags);
@@ -0,0 +1,147 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Jeromy Tompkins
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CTimestampHeap.h
+ *  @brief: Allocation free binary min-heap keyed on fragment timestamps.
+ */
+
+#ifndef CTIMESTAMPHEAP_H
+#define CTIMESTAMPHEAP_H
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+/**
+ * CTimestampHeap
+ *    Min-heap used to pick the next oldest of a set of timestamp ordered
+ *    sources (fragment queues or lists).  Each entry holds the timestamp of
+ *    the head of its source, a tie-breaker (normally the source id or
+ *    index) so that equal timestamps come out in a deterministic order, and
+ *    a value that identifies the source.
+ *
+ *    Storage is a vector that only ever grows.  Once it has grown to the
+ *    number of sources (see reserve) push/pop/replaceTop never allocate.
+ *    The usual K-way merge pattern is:
+ *
+ * \verbatim
+ *    while (!heap.empty()) {
+ *       consume the head of heap.top().s_value
+ *       if that source is not empty:
+ *           heap.replaceTop(new head timestamp, ...)   // one sift down.
+ *       else
+ *           heap.pop();
+ *    }
+ * \endverbatim
+ *
+ * @param T - type of the value associated with each entry.  Must be
+ *            cheaply copyable (normally a pointer).
+ */
+template <class T>
+class CTimestampHeap
+{
+public:
+    typedef struct _Entry {
+        std::uint64_t s_key;
+        std::uint32_t s_tiebreak;
+        T             s_value;
+    } Entry;
+private:
+    std::vector<Entry> m_heap;
+public:
+    void reserve(size_t n) { m_heap.reserve(n); }
+    void clear()           { m_heap.clear(); }
+    bool empty() const     { return m_heap.empty(); }
+    size_t size() const    { return m_heap.size(); }
+
+    /**
+     * top
+     *   @return const Entry& - the entry with the smallest key.
+     *   @note the heap must not be empty.
+     */
+    const Entry& top() const { return m_heap.front(); }
+
+    /**
+     * push
+     *    Add a new source to the heap.
+     *
+     * @param key      - timestamp of the head of the source.
+     * @param tiebreak - Smaller tiebreaks win ties in key.
+     * @param value    - Identifies the source.
+     */
+    void push(std::uint64_t key, std::uint32_t tiebreak, T value)
+    {
+        Entry e = {key, tiebreak, value};
+        m_heap.push_back(e);
+        siftUp(m_heap.size() - 1);
+    }
+    /**
+     * pop
+     *   Remove the top entry (source exhausted).
+     */
+    void pop()
+    {
+        m_heap.front() = m_heap.back();
+        m_heap.pop_back();
+        if (!m_heap.empty()) siftDown(0);
+    }
+    /**
+     * replaceTop
+     *    Replace the key of the top entry (its source has a new head).
+     *    This is cheaper than a pop followed by a push.
+     *
+     * @param key - new timestamp for the top entry's source.
+     */
+    void replaceTop(std::uint64_t key)
+    {
+        m_heap.front().s_key = key;
+        siftDown(0);
+    }
+private:
+    static bool less(const Entry& a, const Entry& b)
+    {
+        return (a.s_key < b.s_key) ||
+            ((a.s_key == b.s_key) && (a.s_tiebreak < b.s_tiebreak));
+    }
+    void siftUp(size_t i)
+    {
+        Entry e = m_heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1)/2;
+            if (!less(e, m_heap[parent])) break;
+            m_heap[i] = m_heap[parent];
+            i = parent;
+        }
+        m_heap[i] = e;
+    }
+    void siftDown(size_t i)
+    {
+        size_t n = m_heap.size();
+        Entry  e = m_heap[i];
+        while (1) {
+            size_t child = 2*i + 1;
+            if (child >= n) break;
+            if ((child + 1 < n) && less(m_heap[child+1], m_heap[child])) child++;
+            if (!less(m_heap[child], e)) break;
+            m_heap[i] = m_heap[child];
+            i = child;
+        }
+        m_heap[i] = e;
+    }
+};
+
+#endif
@@ -52,8 +52,10 @@ namespace eval EVB {
     variable CONNECT    1
     variable FRAGMENTS  2
     variable DISCONNECT 4
+    variable CREDITCONNECT 8;        # CONNECT for credit flow controlled clients.
     
     variable HeaderSize 8;           # two uint32_t items in the header.
+    variable NativeCredits 8;        # FRAGMENTS messages a native client can have in flight.
 }
 
 
@@ -81,6 +83,7 @@ snit::type EVB::Connection {
     option -fragmentcommand   -default [list] -configuremethod _SetCallback
 
     variable alive 0
+    variable native 0;                  # 1 if a CFragmentReceiver reads the socket.
     variable callbacks
     variable expecting ""
     variable stateMethods -array [list FORMING _Connect ACTIVE _Fragments]
@@ -113,7 +116,7 @@ snit::type EVB::Connection {
     #    and if so dispatch.  During this , the -fragmentcommand is disabled.
     #
     method tryRead {} {
-        if {$options(-socket) eq "-1"} {
+        if {($options(-socket) eq "-1") || $native} {
             return
         }
         catch {
@@ -129,6 +132,7 @@ snit::type EVB::Connection {
     #   Called to disable reception of data.
     #
     method flowOff {} {
+        if {$native} return;             # Receiver withholds credits itself.
         fileevent $options(-socket) readable [list]
     }
     ##
@@ -136,6 +140,7 @@ snit::type EVB::Connection {
     #   Called to enable reception of data.
     #
     method flowOn {} {
+        if {$native} return;             # Receiver grants credits itself.
         set method $stateMethods($options(-state))
         fileevent $options(-socket) readable [mymethod $method $options(-socket)] 
     }
@@ -333,7 +338,7 @@ snit::type EVB::Connection {
         # Must be a CONNECT message with a non-zero body.
         #
     
-        if {$msgType ne $EVB::CONNECT} {
+        if {($msgType ne $EVB::CONNECT) && ($msgType ne $EVB::CREDITCONNECT)} {
             catch {puts $socket "ERROR {Expected CONNECT}"}
             $self _Close ERROR
             return
@@ -361,8 +366,44 @@ snit::type EVB::Connection {
     
     
         EVB::source $socket {*}$sourceIds
+        
+        # Credit flow controlled clients are read natively from here on:
+        
+        if {$msgType == $EVB::CREDITCONNECT} {
+            $self _GoNative
+        }
      
     }
+    ##
+    # _GoNative
+    #    Hand the socket to a native receiver thread (EVB::nativeInput).
+    #    We stop reading it; the receiver tells us when the connection ends.
+    #    The OK reply must already have been sent as the receiver's first
+    #    output is the initial credit grant.
+    #
+    method _GoNative {} {
+        fileevent $options(-socket) readable [list]
+        set native 1
+        EVB::nativeInput $options(-socket) $EVB::NativeCredits \
+            [mymethod _NativeClosed] [mymethod _NativeActivity]
+    }
+    ##
+    # _NativeClosed
+    #    Called when the native receiver is done with the connection.
+    #
+    # @param state - CLOSED, LOST or ERROR.
+    #
+    method _NativeClosed state {
+        set native 0
+        $self _Close $state
+    }
+    ##
+    # _NativeActivity
+    #    Called periodically by the native receiver while fragments arrive.
+    #
+    method _NativeActivity {} {
+        $callbacks invoke -fragmentcommand [list] [list]
+    }
     #
     # Expecting fragments if the next message is
     # DISCONNECT, close the socket after responding.
@@ -44,6 +44,8 @@
 #include "CFragmentHandler.h"
 #include "BarrierAbortCommand.h"
 #include "COutOfOrderStatsCommand.h"
+#include "CNativeInputCommand.h"
+#include "CGlomOutputCommand.h"
 
 static const char* version = "1.0"; // package version string.
 
@@ -82,11 +84,16 @@ int Eventbuilder_Init(Tcl_Interp* pInterp)
   new COutOfOrderTraceCommand(*pInterpObject, "EVB::ootrace");
   new CBarrierAbortCommand(*pInterpObject, "EVB::abortbarrier");
   new COutOfOrderStatsCommand(*pInterpObject, "EVB::getoostats");
+  new CNativeInputCommand(*pInterpObject, "EVB::nativeInput");
   // Setup the output stage:
 
   
   CFragmentHandler* pInstance = CFragmentHandler::getInstance();
-  new COrdererOutput(STDOUT_FILENO);
+  COrdererOutput* pPipeOutput = new COrdererOutput(STDOUT_FILENO);
+  
+  // Which can be replaced by building events in-process:
+  
+  new CGlomOutputCommand(*pInterpObject, "EVB::glomOutput", pPipeOutput);
 
   return TCL_OK;
 }
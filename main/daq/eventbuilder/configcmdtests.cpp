@@ -10,6 +10,8 @@
 
 #include <TCLInterpreter.h>
 #include "CConfigure.h"
+#include "COutputThread.h"
+#include "CSortThread.h"
 #include <stdlib.h>
 #include <fragment.h>
 
@@ -19,6 +21,8 @@ class ConfigCmdTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(ConfigCmdTest);
   CPPUNIT_TEST(setxon);
   CPPUNIT_TEST(setxoff);
+  CPPUNIT_TEST(coalesce);
+  CPPUNIT_TEST(sort);
 //  CPPUNIT_TEST(xoffObserved);
 //  CPPUNIT_TEST(xonObserved);
   CPPUNIT_TEST_SUITE_END();
@@ -39,6 +43,8 @@ public:
 protected:
   void setxon();
   void setxoff();
+  void coalesce();
+  void sort();
   void xoffObserved();
   void xonObserved();
 };
@@ -57,6 +63,37 @@ void ConfigCmdTest::setxoff() {
     m_pInterp->Eval("config set XoffThreshold 1234");
     EQ(static_cast<size_t>(1234), m_pHandler->m_nXoffLimit);
 }
+void ConfigCmdTest::coalesce() {
+    CConfigure cmd(*m_pInterp, "config");
+    
+    m_pInterp->Eval("config set outputCoalesceBytes 65536");
+    m_pInterp->Eval("config set outputCoalesceMs 5");
+    EQ(static_cast<size_t>(65536), m_pHandler->getOutputThread()->getCoalesceBytes());
+    EQ(5, m_pHandler->getOutputThread()->getCoalesceMs());
+    
+    Tcl_Interp* pInterp = m_pInterp->getInterpreter();
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config get outputCoalesceBytes"));
+    EQ(std::string("65536"), std::string(Tcl_GetStringResult(pInterp)));
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config get outputCoalesceMs"));
+    EQ(std::string("5"), std::string(Tcl_GetStringResult(pInterp)));
+}
+void ConfigCmdTest::sort() {
+    CConfigure cmd(*m_pInterp, "config");
+    Tcl_Interp* pInterp = m_pInterp->getInterpreter();
+    
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config set inflightByteLimit 4294967296"));
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config set sortThreads 4"));
+    EQ(static_cast<size_t>(4294967296), m_pHandler->getInflightByteLimit());
+    EQ(4U, m_pHandler->getSortThread()->getMergeThreads());
+    
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config get inflightByteLimit"));
+    EQ(std::string("4294967296"), std::string(Tcl_GetStringResult(pInterp)));
+    EQ(TCL_OK, Tcl_Eval(pInterp, "config get sortThreads"));
+    EQ(std::string("4"), std::string(Tcl_GetStringResult(pInterp)));
+    
+    EQ(TCL_ERROR, Tcl_Eval(pInterp, "config set sortThreads 0"));
+    EQ(TCL_ERROR, Tcl_Eval(pInterp, "config set inflightByteLimit -1"));
+}
 
 class XonOffObserver : public CFragmentHandler::FlowControlObserver {
 public:
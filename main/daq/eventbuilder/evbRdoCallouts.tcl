@@ -101,6 +101,9 @@ namespace eval ::EVBC {
 #    * -glomid    - Source id to assign to built physics events
 #    * -maxfragments - maximum number of fragments glombuilds into an event.
 #                   prevents stuck timestamps from crashing.
+#    * -inprocessglom - If true the orderer builds events into -destring itself
+#                   (EVB::glomOutput) rather than piping through glom and
+#                   stdintoring.  -teering is ignored in that case.
 #
 snit::type EVBC::StartOptions {
     option -teering   0
@@ -111,6 +114,7 @@ snit::type EVBC::StartOptions {
     option -glomtspolicy -configuremethod checkTsPolicy -default latest
     option -destring -default $::tcl_platform(user) -configuremethod updateLoggerRing
     option -maxfragments -default 1000;    #Same default as program.
+    option -inprocessglom -default 0
     
     variable policyValues [list earliest latest average]
     
@@ -273,29 +277,34 @@ proc EVBC::start args {
     set pipecommand "$program 2> orderer.err ";        # TODO - this should be @TCLSH_CMD@
     #  If -teering is not null hook teering into the pipeline:
     
-    set intermediateRing [$options cget -teering]
-    if {$intermediateRing} {
-        set teering "[file join $bindir teering] --ring=[$options cget -teeringname]"
-        append pipecommand " | " $teering
-    }
-    #
-    #  Figure out the glom command and hook it in.
-    #
-    
-    # set glom "valgrind --tool=callgrind [file join $bindir glom] --dt=[$options cget -glomdt] "
-    set glom "[file join $bindir glom] --dt=[$options cget -glomdt]"
-    if {![$options cget -glombuild]} {
-        append glom " --nobuild "
+    set inProcess [$options cget -inprocessglom]
+    if {$inProcess} {
+        append pipecommand " |& cat "
+    } else {
+        set intermediateRing [$options cget -teering]
+        if {$intermediateRing} {
+            set teering "[file join $bindir teering] --ring=[$options cget -teeringname]"
+            append pipecommand " | " $teering
+        }
+        #
+        #  Figure out the glom command and hook it in.
+        #
+        
+        # set glom "valgrind --tool=callgrind [file join $bindir glom] --dt=[$options cget -glomdt] "
+        set glom "[file join $bindir glom] --dt=[$options cget -glomdt]"
+        if {![$options cget -glombuild]} {
+            append glom " --nobuild "
+        }
+        append glom " --sourceid=[$options cget -glomid]"
+        append glom " --timestamp-policy=[$options cget -glomtspolicy] "
+        append glom "  --maxfragments [$options cget -maxfragments]"
+        append pipecommand " | $glom  "
+        #
+        #  Ground the pipeline in the -destring 
+        #
+        set stdintoring "[file join $bindir stdintoring] [$options cget -destring]"
+        append pipecommand " | $stdintoring |& cat  "; # The cat captures stderr.
     }
-    append glom " --sourceid=[$options cget -glomid]"
-    append glom " --timestamp-policy=[$options cget -glomtspolicy] "
-    append glom "  --maxfragments [$options cget -maxfragments]"
-    append pipecommand " | $glom  "
-    #
-    #  Ground the pipeline in the -destring 
-    #
-    set stdintoring "[file join $bindir stdintoring] [$options cget -destring]"
-    append pipecommand " | $stdintoring |& cat  "; # The cat captures stderr.
     
     #
     #  Create the pipeline:
@@ -315,6 +324,14 @@ proc EVBC::start args {
     ::flush $EVBC::pipefd
     puts $EVBC::pipefd "set ::OutputRing [$options cget -destring]"
     ::flush $EVBC::pipefd
+    if {$inProcess} {
+        set glomOutput [list EVB::glomOutput [$options cget -destring]    \
+            [$options cget -glomdt] [$options cget -glombuild]           \
+            [$options cget -glomtspolicy] [$options cget -glomid]        \
+            [$options cget -maxfragments]]
+        puts $EVBC::pipefd $glomOutput
+        ::flush $EVBC::pipefd
+    }
     puts $EVBC::pipefd "start $::EVBC::appNameSuffix"
     ::flush $EVBC::pipefd
     
@@ -630,7 +647,8 @@ proc EVBC::onBegin {} {
             -glomdt    [$EVBC::applicationOptions cget -glomdt]    \
             -glomid    [$EVBC::applicationOptions cget -glomid]    \
             -glomtspolicy [$EVBC::applicationOptions cget -glomtspolicy] \
-            -destring  $destring -maxfragments [$EVBC::applicationOptions cget -maxfragments]
+            -destring  $destring -maxfragments [$EVBC::applicationOptions cget -maxfragments] \
+            -inprocessglom [$EVBC::applicationOptions cget -inprocessglom]
         
         
         if {[::EVBC::_guiExists]} {
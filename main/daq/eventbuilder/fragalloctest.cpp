@@ -5,6 +5,7 @@
 #include "Asserts.h"
 
 #include "fragment.h"
+#include <string.h>
 
 namespace EVB {
 extern void resetFragmentPool();            // Frees fragments in pools.
@@ -16,6 +17,9 @@ class Fragalloctest : public CppUnit::TestFixture {
   
   CPPUNIT_TEST(bodypool_1);
   CPPUNIT_TEST(bodypool_2);
+  
+  CPPUNIT_TEST(block_1);
+  CPPUNIT_TEST(block_2);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -32,6 +36,9 @@ protected:
   
   void bodypool_1();
   void bodypool_2();
+  
+  void block_1();
+  void block_2();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(Fragalloctest);
@@ -83,4 +90,76 @@ void Fragalloctest::bodypool_2()
   ASSERT(pBody1 != frag2->s_pBody);
   
   freeFragment(frag2);
-}
\ No newline at end of file
+}
+// Fragments carved from a block have their bodies in the block and
+// the block is only recycled once it and all its fragments are freed.
+
+void Fragalloctest::block_1()
+{
+  uint8_t msg[2*sizeof(EVB::FlatFragment) + 20];
+  EVB::pFlatFragment f1 = reinterpret_cast<EVB::pFlatFragment>(msg);
+  f1->s_header.s_timestamp = 1;
+  f1->s_header.s_sourceId  = 2;
+  f1->s_header.s_size      = 10;
+  f1->s_header.s_barrier   = 0;
+  EVB::pFlatFragment f2 = reinterpret_cast<EVB::pFlatFragment>(
+    msg + sizeof(EVB::FlatFragment) + 10
+  );
+  f2->s_header = f1->s_header;
+  f2->s_header.s_timestamp = 3;
+  
+  EVB::pFragmentBlock pBlock = allocateFragmentBlock(sizeof(msg));
+  uint8_t* pData = static_cast<uint8_t*>(fragmentBlockData(pBlock));
+  memcpy(pData, msg, sizeof(msg));
+  
+  EVB::pFragment frag1 = allocateFragmentInBlock(
+    pBlock, reinterpret_cast<EVB::pFlatFragment>(pData)
+  );
+  EVB::pFragment frag2 = allocateFragmentInBlock(
+    pBlock, reinterpret_cast<EVB::pFlatFragment>(pData + sizeof(EVB::FlatFragment) + 10)
+  );
+  releaseFragmentBlock(pBlock);
+  
+  EQ(uint64_t(1), frag1->s_header.s_timestamp);
+  EQ(uint64_t(3), frag2->s_header.s_timestamp);
+  EQ((void*)(pData + sizeof(EVB::FragmentHeader)), frag1->s_pBody);
+  EQ(
+    (void*)(pData + 2*sizeof(EVB::FragmentHeader) + 10), frag2->s_pBody
+  );
+  
+  // Block is still referenced by frag2 so a new one must be different:
+  
+  freeFragment(frag1);
+  EVB::pFragmentBlock pBlock2 = allocateFragmentBlock(sizeof(msg));
+  ASSERT(pBlock2 != pBlock);
+  releaseFragmentBlock(pBlock2);               // pBlock2 is recycled.
+  
+  freeFragment(frag2);                         // Now so is pBlock.
+  EVB::pFragmentBlock pBlock3 = allocateFragmentBlock(sizeof(msg));
+  ASSERT((pBlock3 == pBlock) || (pBlock3 == pBlock2));
+  releaseFragmentBlock(pBlock3);
+}
+// A block fragment's header is recycled and then acts like an ordinary
+// fragment (its body comes from the body pools when freed).
+
+void Fragalloctest::block_2()
+{
+  EVB::FlatFragment flat = {{0, 0, 0, 0}};
+  EVB::pFragmentBlock pBlock = allocateFragmentBlock(sizeof(flat));
+  memcpy(fragmentBlockData(pBlock), &flat, sizeof(flat));
+  EVB::pFragment frag = allocateFragmentInBlock(
+    pBlock, static_cast<EVB::pFlatFragment>(fragmentBlockData(pBlock))
+  );
+  releaseFragmentBlock(pBlock);
+  freeFragment(frag);
+  
+  EVB::FragmentHeader hdr = {0, 0, 100, 0};
+  EVB::pFragment frag2 = allocateFragment(&hdr);
+  EQ(frag, frag2);
+  void* pBody = frag2->s_pBody;
+  freeFragment(frag2);
+  
+  frag2 = allocateFragment(&hdr);
+  EQ(pBody, frag2->s_pBody);
+  freeFragment(frag2);
+}
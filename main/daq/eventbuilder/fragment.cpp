@@ -16,6 +16,7 @@
 #include "fragment.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 
 #include <list>
 #include <vector>
@@ -50,10 +51,40 @@ bool threadsafe=true;   // By default threadsafe.
  *    pool into which the block is returned.  The set of pools itself is
  *    resized as needed to ensure we have sufficient pools to satsify the
  *    memory request so far.
+ *
+ *    The fragment handler does better still.  Each input message is
+ *    copied once into a fragment block (whose storage also comes from the
+ *    body pools) and the bodies of the fragments in that message point
+ *    into the block rather than having their own storage.  Blocks are
+ *    reference counted;  each fragment holds a reference and the block
+ *    goes back to its pool when the last of its fragments is freed.
+ *    The fragment headers we give out have space after them for the
+ *    block pointer so that freeFragment knows what to do with the body.
  */ 
   
 // The pool below is for fragment headers:
 
+// What fragment headers really are (see above).  s_pBlock is null if the
+// body is from a body pool:
+
+typedef struct _PooledFragment {
+  Fragment        s_fragment;
+  pFragmentBlock  s_pBlock;
+} PooledFragment, *pPooledFragment;
+
+// The block pointer of a pooled fragment.  Fragment is packed, so rather
+// than cast to a PooledFragment we find s_pBlock by its offset; the header
+// itself came from malloc so s_pBlock is aligned.
+
+static pFragmentBlock&
+fragmentBlock(pFragment p)
+{
+  uint8_t* pBytes = reinterpret_cast<uint8_t*>(p);
+  return *reinterpret_cast<pFragmentBlock*>(
+    pBytes + offsetof(PooledFragment, s_pBlock)
+  );
+}
+
 typedef std::vector<pFragment> FragmentHeaderPool;
 typedef std::vector<void*>     FragmentBodyPool;
 
@@ -66,6 +97,19 @@ std::vector<FragmentBodyPool> fragmentBodyPools;
 
 CMutex poolProtector;             // So we're threadsafe.
 
+}                                 // namespace EVB.
+
+// Fragment blocks.  s_data is the input message.  The reference count is
+// protected by the poolProtector.
+
+struct EVB::_FragmentBlock {
+  size_t    s_allocated;          // Bytes requested from the body pools.
+  uint32_t  s_references;
+  uint8_t   s_data[0];
+};
+
+namespace EVB {
+
 /**
  *  resetFragmentPool
  *     For testing purposes - frees all elements of the header and body pools:
@@ -165,8 +209,9 @@ getFragmentDescription()
     result = fragmentHeaderPool.back();
     fragmentHeaderPool.pop_back();
   } else {
-    result = static_cast<pFragment>(malloc(sizeof(Fragment)));
+    result = static_cast<pFragment>(malloc(sizeof(PooledFragment)));
   }
+  fragmentBlock(result) = 0;
   return result;
 }
 
@@ -222,6 +267,22 @@ freeFragmentBody(pFragment pFrag)
   FragmentBodyPool& pool(getPool(poolNo));
   pool.push_back(pFrag->s_pBody);
 }
+/**
+ * dereferenceBlock
+ *    Drop a reference to a fragment block.  The block's storage goes back
+ *    to its body pool when the last reference is dropped.
+ *
+ * @param pBlock - the block.
+ */
+static void
+dereferenceBlock(pFragmentBlock pBlock)
+{
+  pBlock->s_references--;
+  if (pBlock->s_references == 0) {
+    FragmentBodyPool& pool(getPool(getPoolNumber(pBlock->s_allocated)));
+    pool.push_back(pBlock);
+  }
+}
 /**
  * Free a fragment.  The assumption is that  both the header and the body 
  * are dynamically allocated.
@@ -234,7 +295,13 @@ void freeFragment(pFragment p)
 {
   std::unique_ptr<CriticalSection> l;
   if (threadsafe) l.reset(new CriticalSection(poolProtector));
-  freeFragmentBody(p);
+  pFragmentBlock& pBlock(fragmentBlock(p));
+  if (pBlock) {
+    dereferenceBlock(pBlock);
+    pBlock = 0;
+  } else {
+    freeFragmentBody(p);
+  }
   p->s_pBody = 0;
   freeFragmentHeader(p);
 
@@ -299,4 +366,79 @@ fragmentChainLength(pFragmentChain p)
   return result;
 }
 }
-}
\ No newline at end of file
+/**
+ * allocateFragmentBlock
+ *    Get storage for an input message whose fragments will be carved out
+ *    with allocateFragmentInBlock.  The caller fills in the data
+ *    (see fragmentBlockData) and holds one reference to the block which it
+ *    must give up with releaseFragmentBlock once all the fragments have
+ *    been allocated.
+ *
+ * @param nBytes - Size of the message.
+ * @return pFragmentBlock
+ */
+extern "C" {
+pFragmentBlock allocateFragmentBlock(size_t nBytes)
+{
+  std::unique_ptr<CriticalSection> l;
+  if (threadsafe) l.reset(new CriticalSection(poolProtector));
+
+  size_t allocated = sizeof(FragmentBlock) + nBytes;
+  pFragmentBlock pBlock = static_cast<pFragmentBlock>(getFragmentBody(allocated));
+  pBlock->s_allocated  = allocated;
+  pBlock->s_references = 1;
+  return pBlock;
+}
+}
+/**
+ * fragmentBlockData
+ *
+ * @param pBlock - a fragment block.
+ * @return void* - Pointer to the block's message storage.
+ */
+extern "C" {
+void* fragmentBlockData(pFragmentBlock pBlock)
+{
+  return pBlock->s_data;
+}
+}
+/**
+ * allocateFragmentInBlock
+ *    Create a fragment whose body is in a fragment block.  Only the header
+ *    is copied.  The fragment holds a reference to the block and is released,
+ *    as usual, with freeFragment.
+ *
+ * @param pBlock    - The block.
+ * @param pFlat     - Flat fragment in the block's data.
+ * @return pFragment
+ */
+extern "C" {
+pFragment allocateFragmentInBlock(pFragmentBlock pBlock, const FlatFragment* pFlat)
+{
+  std::unique_ptr<CriticalSection> l;
+  if (threadsafe) l.reset(new CriticalSection(poolProtector));
+  pFragment p = getFragmentDescription();
+  memcpy(&(p->s_header), &(pFlat->s_header), sizeof(FragmentHeader));
+  p->s_pBody = const_cast<int*>(pFlat->s_body);
+
+  fragmentBlock(p) = pBlock;
+  pBlock->s_references++;
+
+  return p;
+}
+}
+/**
+ * releaseFragmentBlock
+ *    Give up the reference allocateFragmentBlock gave its caller.
+ *
+ * @param pBlock - The block.
+ */
+extern "C" {
+void releaseFragmentBlock(pFragmentBlock pBlock)
+{
+  std::unique_ptr<CriticalSection> l;
+  if (threadsafe) l.reset(new CriticalSection(poolProtector));
+  dereferenceBlock(pBlock);
+}
+}
+}
@@ -96,6 +96,12 @@ namespace EVB {
     int            s_body[0];
   } FlatFragment, *pFlatFragment;
 
+  /**
+   * Reference counted storage for the fragments of one input message.
+   * The contents are private to fragment.cpp; see allocateFragmentBlock.
+   */
+  typedef struct _FragmentBlock FragmentBlock, *pFragmentBlock;
+
 #ifdef __cplusplus
 }
 #endif
@@ -114,6 +120,13 @@ namespace EVB {
     NS(pFragment) newFragment(uint64_t timestamp, uint32_t sourceId, uint32_t size);
 
     size_t fragmentChainLength(NS(pFragmentChain) p);
+
+    NS(pFragmentBlock) allocateFragmentBlock(size_t nBytes);
+    void*         fragmentBlockData(NS(pFragmentBlock) pBlock);
+    NS(pFragment) allocateFragmentInBlock(
+      NS(pFragmentBlock) pBlock, const NS(FlatFragment*) pFragment
+    );
+    void          releaseFragmentBlock(NS(pFragmentBlock) pBlock);
 #ifdef __cplusplus
   }
 #endif
@@ -0,0 +1,309 @@
+// Tests of the in-process glom output observer.
+// The CFragmentHandler mocks are in outputTests.cpp
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include "CGlomOutput.h"
+#include "fragment.h"
+#include <DataFormat.h>
+
+#include <vector>
+#include <string.h>
+
+// Capture the output items rather than putting them in a ring:
+
+class TestGlom : public CGlomOutput
+{
+public:
+  std::vector<std::vector<uint8_t> > m_items;
+  std::vector<uint8_t>               m_reservation;
+  size_t                             m_maxItem;
+public:
+  TestGlom(uint64_t dt, bool build, TimestampPolicy policy) :
+    CGlomOutput(nullptr, dt, build, policy, 5, 1000), m_maxItem(1024*1024) {}
+protected:
+  size_t maxItemSize() {
+    return m_maxItem;
+  }
+  void* reserve(size_t nBytes) {
+    m_reservation.resize(nBytes);
+    return m_reservation.data();
+  }
+  void commit(size_t nBytes) {
+    m_items.push_back(
+      std::vector<uint8_t>(m_reservation.begin(), m_reservation.begin() + nBytes)
+    );
+  }
+};
+
+// A fragment whose payload is a ring item with a body header and
+// one uint32_t of body:
+
+struct TestFragment {
+  EVB::Fragment s_fragment;
+  struct __attribute__((__packed__)) {
+    RingItemHeader s_header;
+    BodyHeader     s_bodyHeader;
+    uint32_t       s_body;
+  } s_item;
+};
+
+static void
+makeFragment(TestFragment& f, uint64_t ts, uint32_t type, uint32_t body, uint32_t barrier = 0)
+{
+  f.s_item.s_header.s_size = sizeof(f.s_item);
+  f.s_item.s_header.s_type = type;
+  f.s_item.s_bodyHeader.s_size      = sizeof(BodyHeader);
+  f.s_item.s_bodyHeader.s_timestamp = ts;
+  f.s_item.s_bodyHeader.s_sourceId  = 1;
+  f.s_item.s_bodyHeader.s_barrier   = barrier;
+  f.s_item.s_body = body;
+
+  f.s_fragment.s_header.s_timestamp = ts;
+  f.s_fragment.s_header.s_sourceId  = 1;
+  f.s_fragment.s_header.s_size      = sizeof(f.s_item);
+  f.s_fragment.s_header.s_barrier   = barrier;
+  f.s_fragment.s_pBody              = &f.s_item;
+}
+
+class GlomOutputTests : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(GlomOutputTests);
+  CPPUNIT_TEST(build_1);
+  CPPUNIT_TEST(build_2);
+  CPPUNIT_TEST(spanbatch);
+  CPPUNIT_TEST(nobuild);
+  CPPUNIT_TEST(average);
+  CPPUNIT_TEST(beginbarrier);
+  CPPUNIT_TEST(policy);
+  CPPUNIT_TEST(toobig);
+  CPPUNIT_TEST_SUITE_END();
+
+protected:
+  void build_1();
+  void build_2();
+  void spanbatch();
+  void nobuild();
+  void average();
+  void beginbarrier();
+  void policy();
+  void toobig();
+private:
+  void checkEvent(
+    std::vector<uint8_t>& item, uint64_t ts, TestFragment* pFrags, size_t n
+  );
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GlomOutputTests);
+
+// Check that an output item is a physics event with the given timestamp
+// built from the given fragments:
+
+void
+GlomOutputTests::checkEvent(
+  std::vector<uint8_t>& item, uint64_t ts, TestFragment* pFrags, size_t n
+)
+{
+  size_t fragBytes = sizeof(EVB::FragmentHeader) + sizeof(pFrags[0].s_item);
+  size_t expected  = sizeof(RingItemHeader) + sizeof(BodyHeader) +
+    sizeof(uint32_t) + n*fragBytes;
+  EQ(expected, item.size());
+
+  pRingItemHeader pH = reinterpret_cast<pRingItemHeader>(item.data());
+  EQ(PHYSICS_EVENT, pH->s_type);
+  EQ(uint32_t(expected), pH->s_size);
+
+  pBodyHeader pB = reinterpret_cast<pBodyHeader>(pH+1);
+  EQ(ts, pB->s_timestamp);
+  EQ(uint32_t(5), pB->s_sourceId);
+
+  uint32_t* pSize = reinterpret_cast<uint32_t*>(pB+1);
+  EQ(uint32_t(sizeof(uint32_t) + n*fragBytes), *pSize);
+
+  uint8_t* p = reinterpret_cast<uint8_t*>(pSize+1);
+  for (size_t i = 0; i < n; i++) {
+    EQ(0, memcmp(p, &(pFrags[i].s_fragment.s_header), sizeof(EVB::FragmentHeader)));
+    p += sizeof(EVB::FragmentHeader);
+    EQ(0, memcmp(p, &(pFrags[i].s_item), sizeof(pFrags[i].s_item)));
+    p += sizeof(pFrags[i].s_item);
+  }
+}
+
+// Fragments in the coincidence window make one event.  It's output
+// when a fragment outside the window arrives.
+
+void GlomOutputTests::build_1()
+{
+  TestGlom glom(10, true, CGlomOutput::earliest);
+  TestFragment frags[3];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 105, PHYSICS_EVENT, 2);
+  makeFragment(frags[2], 200, PHYSICS_EVENT, 3);
+
+  EvbFragments batch;
+  for (int i = 0; i < 3; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(1), glom.m_items.size());
+  checkEvent(glom.m_items[0], 100, frags, 2);
+}
+// Latest policy and the out of window fragment becomes the next event.
+
+void GlomOutputTests::build_2()
+{
+  TestGlom glom(10, true, CGlomOutput::latest);
+  TestFragment frags[4];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 105, PHYSICS_EVENT, 2);
+  makeFragment(frags[2], 200, PHYSICS_EVENT, 3);
+  makeFragment(frags[3], 300, PHYSICS_EVENT, 4);
+
+  EvbFragments batch;
+  for (int i = 0; i < 4; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(2), glom.m_items.size());
+  checkEvent(glom.m_items[0], 105, frags, 2);
+  checkEvent(glom.m_items[1], 200, frags+2, 1);
+}
+// An event that spans batches is kept even if the first batch's
+// fragments are reused.
+
+void GlomOutputTests::spanbatch()
+{
+  TestGlom glom(10, true, CGlomOutput::earliest);
+  TestFragment frags[2];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 105, PHYSICS_EVENT, 2);
+  TestFragment saved = frags[0];
+
+  EvbFragments batch;
+  batch.push_back(std::make_pair(time_t(0), &frags[0].s_fragment));
+  glom(batch);
+  EQ(size_t(0), glom.m_items.size());
+
+  makeFragment(frags[0], 500, PHYSICS_EVENT, 0xdead);  // Storage reused.
+  batch.clear();
+  batch.push_back(std::make_pair(time_t(0), &frags[1].s_fragment));
+  batch.push_back(std::make_pair(time_t(0), &frags[0].s_fragment));
+  glom(batch);
+
+  EQ(size_t(1), glom.m_items.size());
+  TestFragment expected[2] = {saved, frags[1]};
+  expected[0].s_fragment.s_pBody = &expected[0].s_item;
+  checkEvent(glom.m_items[0], 100, expected, 2);
+}
+// Not building - each fragment is an event.
+
+void GlomOutputTests::nobuild()
+{
+  TestGlom glom(10, false, CGlomOutput::earliest);
+  TestFragment frags[3];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 101, PHYSICS_EVENT, 2);
+  makeFragment(frags[2], 102, PHYSICS_EVENT, 3);
+
+  EvbFragments batch;
+  for (int i = 0; i < 3; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(2), glom.m_items.size());       // Last one is still pending.
+  checkEvent(glom.m_items[0], 100, frags, 1);
+  checkEvent(glom.m_items[1], 101, frags+1, 1);
+}
+// Average timestamp policy.
+
+void GlomOutputTests::average()
+{
+  TestGlom glom(10, true, CGlomOutput::average);
+  TestFragment frags[4];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 104, PHYSICS_EVENT, 2);
+  makeFragment(frags[2], 107, PHYSICS_EVENT, 3);
+  makeFragment(frags[3], 200, PHYSICS_EVENT, 4);
+
+  EvbFragments batch;
+  for (int i = 0; i < 4; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(1), glom.m_items.size());
+  checkEvent(glom.m_items[0], 103, frags, 3);
+}
+// A begin run barrier flushes the event, is output as is and is
+// followed by a glom parameters item.
+
+void GlomOutputTests::beginbarrier()
+{
+  TestGlom glom(10, true, CGlomOutput::latest);
+  TestFragment frags[2];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 101, BEGIN_RUN, 2, BARRIER_START);
+
+  EvbFragments batch;
+  for (int i = 0; i < 2; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(3), glom.m_items.size());
+  checkEvent(glom.m_items[0], 100, frags, 1);
+
+  EQ(sizeof(frags[1].s_item), glom.m_items[1].size());
+  EQ(0, memcmp(&frags[1].s_item, glom.m_items[1].data(), sizeof(frags[1].s_item)));
+
+  pGlomParameters pParams = reinterpret_cast<pGlomParameters>(glom.m_items[2].data());
+  EQ(EVB_GLOM_INFO, pParams->s_header.s_type);
+  EQ(uint64_t(10), pParams->s_coincidenceTicks);
+  EQ(uint16_t(1), pParams->s_isBuilding);
+  EQ(GLOM_TIMESTAMP_LAST, pParams->s_timestampPolicy);
+}
+// Timestamp policy names.
+
+void GlomOutputTests::policy()
+{
+  EQ(CGlomOutput::earliest, CGlomOutput::policyFromString("earliest"));
+  EQ(CGlomOutput::latest, CGlomOutput::policyFromString("latest"));
+  EQ(CGlomOutput::average, CGlomOutput::policyFromString("average"));
+
+  bool thrown(false);
+  try {
+    CGlomOutput::policyFromString("junk");
+  }
+  catch (std::string msg) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+}
+// An event too big for the ring is dropped; building goes on.
+
+void GlomOutputTests::toobig()
+{
+  TestGlom glom(10, true, CGlomOutput::earliest);
+  TestFragment frags[4];
+  makeFragment(frags[0], 100, PHYSICS_EVENT, 1);
+  makeFragment(frags[1], 105, PHYSICS_EVENT, 2);
+  makeFragment(frags[2], 200, PHYSICS_EVENT, 3);
+  makeFragment(frags[3], 300, PHYSICS_EVENT, 4);
+
+  size_t fragBytes = sizeof(EVB::FragmentHeader) + sizeof(frags[0].s_item);
+  glom.m_maxItem   = sizeof(RingItemHeader) + sizeof(BodyHeader) +
+    sizeof(uint32_t) + fragBytes;       // Only one fragment events fit.
+
+  EvbFragments batch;
+  for (int i = 0; i < 4; i++) {
+    batch.push_back(std::make_pair(time_t(0), &frags[i].s_fragment));
+  }
+  glom(batch);
+
+  EQ(size_t(1), glom.m_items.size());
+  checkEvent(glom.m_items[0], 200, frags+2, 1);
+}
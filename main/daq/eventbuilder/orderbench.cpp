@@ -0,0 +1,158 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Jeromy Tompkins
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+// Fragment ordering throughput as a function of the number of sources.
+// Two measurements are made for each source count:
+//   merge     - CSortThread::merge of one sorted list per source
+//               (the path every built event goes through).
+//   popOldest - Draining the fragment handler's source queues with
+//               CFragmentHandler::popOldest.
+// Timestamps are interleaved across the sources so that every fragment
+// changes which source is oldest (the worst case for the ordering).
+//
+// Usage:
+//    orderbench ?maxsources? ?fragments? ?mergethreads?
+//
+// Defaults are 256 sources, 1000000 fragments per measurement and
+// one merge thread (see CSortThread::setMergeThreads).
+// Source counts run 1, 2, 4 ... maxsources.
+//
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+#include <tcl.h>
+#include <sstream>
+#include <Thread.h>
+#include <CBufferQueue.h>
+
+// Same dodge as orderTests.cpp so that we can get at the
+// ordering methods and construct the handler without the singleton.
+
+#define private public
+#include "CFragmentHandler.h"
+#include "CSortThread.h"
+#undef private
+
+#include "fragment.h"
+
+using namespace std;
+
+static double
+now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
+
+// Make the fragments for a measurement.  Fragment i comes from
+// source i % nSources and has timestamp i.
+
+static void
+makeFragments(vector<EVB::Fragment>& frags, size_t nFrags)
+{
+  frags.resize(nFrags);
+  for (size_t i = 0; i < nFrags; i++) {
+    frags[i].s_header.s_timestamp = i;
+    frags[i].s_header.s_sourceId  = 0;
+    frags[i].s_header.s_size      = 0;
+    frags[i].s_header.s_barrier   = 0;
+    frags[i].s_pBody              = 0;
+  }
+}
+
+static double
+timeMerge(CSortThread& sorter, vector<EVB::Fragment>& frags, size_t nSources)
+{
+  CSortThread::Fragments lists;
+  for (size_t s = 0; s < nSources; s++) {
+    lists.push_back(new CSortThread::FragmentList);
+  }
+  for (size_t i = 0; i < frags.size(); i++) {
+    lists[i % nSources]->push_back(make_pair(time_t(0), &frags[i]));
+  }
+  CSortThread::FragmentList result;
+
+  double start = now();
+  sorter.merge(result, lists);
+  double end   = now();
+
+  for (size_t s = 0; s < nSources; s++) {
+    delete lists[s];
+  }
+  if (result.size() != frags.size()) {
+    cerr << "merge lost fragments!\n";
+  }
+  return frags.size()/(end - start);
+}
+
+static double
+timePopOldest(CFragmentHandler& handler, vector<EVB::Fragment>& frags, size_t nSources)
+{
+  handler.clearQueues();
+  for (size_t i = 0; i < frags.size(); i++) {
+    CFragmentHandler::SourceQueue& q =
+      handler.getSourceQueue("bench", i % nSources);
+    q.s_queue.push_back(make_pair(time_t(0), &frags[i]));
+  }
+  pair<time_t, EVB::pFragment> oldest;
+  size_t n = 0;
+
+  double start = now();
+  while (handler.popOldest(oldest)) {
+    n++;
+  }
+  double end   = now();
+
+  if (n != frags.size()) {
+    cerr << "popOldest lost fragments!\n";
+  }
+  handler.m_FragmentQueues.clear();        // Fragments aren't ours to delete.
+  return n/(end - start);
+}
+
+int main(int argc, char** argv)
+{
+  size_t maxSources = 256;
+  size_t nFrags     = 1000000;
+
+  if (argc > 1) maxSources = strtoul(argv[1], 0, 0);
+  if (argc > 2) nFrags     = strtoul(argv[2], 0, 0);
+  unsigned mergeThreads = 1;
+  if (argc > 3) mergeThreads = strtoul(argv[3], 0, 0);
+
+  Tcl_Interp* pInterp = Tcl_CreateInterp(); // Handler needs an event loop for its timer.
+  CFragmentHandler* pHandler = new CFragmentHandler();
+  CSortThread       sorter;                  // Not started, we call merge directly.
+  sorter.setMergeThreads(mergeThreads);
+
+  vector<EVB::Fragment> frags;
+  makeFragments(frags, nFrags);
+
+  cout << "sources  merge frags/sec  popOldest frags/sec\n";
+  for (size_t nSources = 1; nSources <= maxSources; nSources *= 2) {
+    double mergeRate = timeMerge(sorter, frags, nSources);
+    double popRate   = timePopOldest(*pHandler, frags, nSources);
+    cout << nSources << "  " << mergeRate << "  " << popRate << endl;
+  }
+
+  Tcl_DeleteInterp(pInterp);
+  return 0;
+}
+void* gpTCLApplication(0);
@@ -0,0 +1,181 @@
+// Tests of the sort thread merges.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include <sstream>
+#include <Thread.h>
+#include <CBufferQueue.h>
+
+// Get at the merge methods and parameters:
+
+#define private public
+#include "CSortThread.h"
+#undef private
+
+#include "fragment.h"
+#include <vector>
+#include <stdlib.h>
+
+class SortThreadTests : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(SortThreadTests);
+  CPPUNIT_TEST(serial);
+  CPPUNIT_TEST(parallel_1);
+  CPPUNIT_TEST(parallel_2);
+  CPPUNIT_TEST(parallel_3);
+  CPPUNIT_TEST(unsorted);
+  CPPUNIT_TEST(bytes);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  CSortThread*               m_pSorter;
+  std::vector<EVB::Fragment> m_frags;
+  CSortThread::Fragments     m_lists;
+public:
+  void setUp() {
+    m_pSorter = new CSortThread;        // Not started, we call merge.
+    m_pSorter->m_nMinParallelFragments = 10;
+  }
+  void tearDown() {
+    for (int i = 0; i < m_lists.size(); i++) {
+      delete m_lists[i];
+    }
+    m_lists.clear();
+    delete m_pSorter;
+  }
+protected:
+  void serial();
+  void parallel_1();
+  void parallel_2();
+  void parallel_3();
+  void unsorted();
+  void bytes();
+private:
+  void makeLists(size_t nFrags, size_t nLists, int tsStep);
+  void checkMerge(CSortThread::FragmentList& result);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SortThreadTests);
+
+// Make nLists lists of fragments.  Fragment i goes to list i % nLists
+// with timestamp (i/tsStep), so tsStep > 1 makes ties across lists.
+// The fragment's size field holds i so order can be checked.
+
+void
+SortThreadTests::makeLists(size_t nFrags, size_t nLists, int tsStep)
+{
+  m_frags.resize(nFrags);
+  for (int i = 0; i < nLists; i++) {
+    m_lists.push_back(new CSortThread::FragmentList);
+  }
+  for (size_t i = 0; i < nFrags; i++) {
+    m_frags[i].s_header.s_timestamp = i/tsStep;
+    m_frags[i].s_header.s_sourceId  = i % nLists;
+    m_frags[i].s_header.s_size      = i;
+    m_frags[i].s_header.s_barrier   = 0;
+    m_frags[i].s_pBody              = 0;
+    m_lists[i % nLists]->push_back(std::make_pair(time_t(0), &m_frags[i]));
+  }
+}
+// The merged result must be the fragments in timestamp order, with ties
+// in list order (which, the way makeLists works, is fragment order).
+
+void
+SortThreadTests::checkMerge(CSortThread::FragmentList& result)
+{
+  EQ(m_frags.size(), result.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    EQ(uint32_t(i), result[i].second->s_header.s_size);
+  }
+}
+
+// One merge thread - no workers get started.
+
+void SortThreadTests::serial()
+{
+  makeLists(1000, 5, 1);
+  CSortThread::FragmentList result;
+  m_pSorter->merge(result, m_lists);
+
+  checkMerge(result);
+  EQ(size_t(0), m_pSorter->m_workers.size());
+}
+// Parallel merge gives the same order as the serial one.
+
+void SortThreadTests::parallel_1()
+{
+  m_pSorter->setMergeThreads(4);
+  makeLists(1000, 5, 1);
+  CSortThread::FragmentList result;
+  m_pSorter->merge(result, m_lists);
+
+  checkMerge(result);
+  EQ(size_t(3), m_pSorter->m_workers.size());
+}
+// Same with timestamp ties across lists.
+
+void SortThreadTests::parallel_2()
+{
+  m_pSorter->setMergeThreads(3);
+  makeLists(999, 3, 3);               // Each timestamp is in all lists.
+  CSortThread::FragmentList result;
+  m_pSorter->merge(result, m_lists);
+
+  checkMerge(result);
+}
+// Too few fragments to split across all the threads - and the
+// result already has something in it.
+
+void SortThreadTests::parallel_3()
+{
+  m_pSorter->setMergeThreads(8);
+  makeLists(25, 2, 1);                // Only room for 2 threads.
+  EVB::Fragment first;
+  first.s_header.s_timestamp = 0;
+  first.s_header.s_size      = 1234;
+  CSortThread::FragmentList result;
+  result.push_back(std::make_pair(time_t(0), &first));
+  m_pSorter->merge(result, m_lists);
+
+  EQ(size_t(1), m_pSorter->m_workers.size());
+  EQ(size_t(26), result.size());
+  EQ(uint32_t(1234), result[0].second->s_header.s_size);
+  result.pop_front();
+  checkMerge(result);
+}
+// A list that's out of order can't lose or duplicate fragments.
+
+void SortThreadTests::unsorted()
+{
+  m_pSorter->setMergeThreads(4);
+  makeLists(1000, 4, 1);
+  m_lists[2]->at(100).second->s_header.s_timestamp = 900;
+  m_lists[2]->at(200).second->s_header.s_timestamp = 5;
+
+  CSortThread::FragmentList result;
+  m_pSorter->merge(result, m_lists);
+
+  EQ(m_frags.size(), result.size());
+  std::vector<int> seen(m_frags.size(), 0);
+  for (size_t i = 0; i < result.size(); i++) {
+    seen[result[i].second->s_header.s_size]++;
+  }
+  for (size_t i = 0; i < seen.size(); i++) {
+    EQ(1, seen[i]);
+  }
+}
+// Queued bytes are tallied.
+
+void SortThreadTests::bytes()
+{
+  makeLists(10, 2, 1);
+  CSortThread::Fragments* pFrags = new CSortThread::Fragments(m_lists);
+  m_pSorter->queueFragments(*pFrags);
+
+  size_t expected = 10*sizeof(EVB::FragmentHeader) + 45;   // sizes are 0..9
+  EQ(size_t(10), m_pSorter->getInflightCount());
+  EQ(expected, m_pSorter->getInflightBytes());
+  EQ(uint64_t(expected), m_pSorter->getStatistics().s_nQueuedBytes);
+}
@@ -0,0 +1,117 @@
+// Tests for the timestamp min-heap used to order fragments.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include "CTimestampHeap.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+class TsHeapTests : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TsHeapTests);
+  CPPUNIT_TEST(empty);
+  CPPUNIT_TEST(ordered);
+  CPPUNIT_TEST(tiebreak);
+  CPPUNIT_TEST(replacetop);
+  CPPUNIT_TEST(kwaymerge);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  CTimestampHeap<int>* m_pHeap;
+public:
+  void setUp() {
+    m_pHeap = new CTimestampHeap<int>;
+  }
+  void tearDown() {
+    delete m_pHeap;
+  }
+protected:
+  void empty();
+  void ordered();
+  void tiebreak();
+  void replacetop();
+  void kwaymerge();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TsHeapTests);
+
+// A new heap is empty.
+
+void TsHeapTests::empty()
+{
+  ASSERT(m_pHeap->empty());
+  EQ(size_t(0), m_pHeap->size());
+}
+// Random keys come out smallest first.
+
+void TsHeapTests::ordered()
+{
+  for (int i = 0; i < 100; i++) {
+    m_pHeap->push(random() % 1000, i, i);
+  }
+  EQ(size_t(100), m_pHeap->size());
+
+  uint64_t last = 0;
+  while (!m_pHeap->empty()) {
+    ASSERT(m_pHeap->top().s_key >= last);
+    last = m_pHeap->top().s_key;
+    m_pHeap->pop();
+  }
+}
+// Equal keys come out in tiebreak order regardless of push order.
+
+void TsHeapTests::tiebreak()
+{
+  m_pHeap->push(10, 3, 3);
+  m_pHeap->push(10, 1, 1);
+  m_pHeap->push(10, 2, 2);
+
+  EQ(1, m_pHeap->top().s_value);
+  m_pHeap->pop();
+  EQ(2, m_pHeap->top().s_value);
+  m_pHeap->pop();
+  EQ(3, m_pHeap->top().s_value);
+}
+// replaceTop re-keys the top and moves it to where it belongs.
+
+void TsHeapTests::replacetop()
+{
+  m_pHeap->push(1, 0, 0);
+  m_pHeap->push(5, 1, 1);
+  m_pHeap->push(7, 2, 2);
+
+  m_pHeap->replaceTop(6);             // 0 now goes between 1 and 2.
+  EQ(1, m_pHeap->top().s_value);
+  m_pHeap->pop();
+  EQ(0, m_pHeap->top().s_value);
+  EQ(uint64_t(6), m_pHeap->top().s_key);
+  m_pHeap->pop();
+  EQ(2, m_pHeap->top().s_value);
+}
+// The merge pattern with interleaved sources produces all keys in order.
+
+void TsHeapTests::kwaymerge()
+{
+  const int nSources = 7;
+  const int nEach    = 50;
+  int       next[nSources];
+  for (int s = 0; s < nSources; s++) {
+    next[s] = 0;
+    m_pHeap->push(s, s, s);           // key of element i of source s: i*nSources+s
+  }
+  uint64_t expected = 0;
+  while (!m_pHeap->empty()) {
+    EQ(expected, m_pHeap->top().s_key);
+    expected++;
+    int s = m_pHeap->top().s_value;
+    next[s]++;
+    if (next[s] < nEach) {
+      m_pHeap->replaceTop(next[s]*nSources + s);
+    } else {
+      m_pHeap->pop();
+    }
+  }
+  EQ(uint64_t(nSources*nEach), expected);
+}
@@ -0,0 +1,146 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompiledRingSelection.cpp
+ *  @brief: Implement the table driven ring selection.
+ */
+#include "CCompiledRingSelection.h"
+#include "CRingSelectionPredicate.h"
+#include "DataFormat.h"
+
+#include <string.h>
+
+/**
+ * constructor
+ *
+ * @param predicate - the predicate to compile.
+ */
+CCompiledRingSelection::CCompiledRingSelection(CRingSelectionPredicate& predicate) :
+    m_predicate(predicate)
+{
+    compile();
+}
+/**
+ * compile
+ *    Build the tables from the predicate.  A type that's accepted with
+ *    no free space is always taken.  One that's only accepted with
+ *    unlimited free space is sampled.
+ */
+void
+CCompiledRingSelection::compile()
+{
+    memset(m_taken, 0, sizeof(m_taken));
+    memset(m_sampled, 0, sizeof(m_sampled));
+    m_highWaterMark = m_predicate.getHighWaterMark();
+    m_hasSampled    = false;
+
+    for (uint32_t type = 0; type < TABLE_TYPES; type++) {
+        uint64_t bit = uint64_t(1) << (type & 63);
+        if (m_predicate.acceptItem(type, 0)) {
+            m_taken[type >> 6] |= bit;
+        } else if (m_predicate.acceptItem(type, ~size_t(0))) {
+            m_sampled[type >> 6] |= bit;
+            m_hasSampled = true;
+        }
+    }
+}
+/**
+ * select
+ *    Evaluate the items in a chunk into a mask.
+ *
+ * @param chunk     - the chunk.
+ * @param freeSpace - ring put space with the chunk in the ring.
+ * @param mask      - (output) one element per item in the chunk, nonzero if
+ *                    the item is selected.
+ * @return size_t   - number of items selected.
+ */
+size_t
+CCompiledRingSelection::select(
+    CRingBufferChunkAccess::Chunk& chunk, size_t freeSpace,
+    std::vector<uint8_t>& mask
+) const
+{
+    mask.clear();
+    size_t nSelected = 0;
+    for (auto p = chunk.begin(); !(p == chunk.end()); ++p) {
+        pRingItem pItem = reinterpret_cast<pRingItem>(&(*p));
+        uint32_t  size  = itemSize(pItem);
+        bool      take  = accept(itemType(pItem), freeSpace);
+
+        mask.push_back(take);
+        if (take) nSelected++;
+        freeSpace += size;
+    }
+    return nSelected;
+}
+/**
+ * select
+ *    Evaluate the items in a chunk into the blocks that need to be written
+ *    to output them.
+ *
+ * @param chunk     - the chunk.
+ * @param freeSpace - ring put space with the chunk in the ring.
+ * @param selected  - (output) blocks of selected items.  Runs of adjacent
+ *                    selected items make a single block.
+ * @param stopAtEnd - if true, stop after the first selected END_RUN.
+ * @return bool     - true if stopAtEnd is true and an END_RUN was selected.
+ *                    It's then the last item in selected.
+ */
+bool
+CCompiledRingSelection::select(
+    CRingBufferChunkAccess::Chunk& chunk, size_t freeSpace,
+    std::vector<iovec>& selected, bool stopAtEnd
+) const
+{
+    selected.clear();
+
+    uint8_t* pEnd = nullptr;          // End of the last block.
+    for (auto p = chunk.begin(); !(p == chunk.end()); ++p) {
+        pRingItem pItem = reinterpret_cast<pRingItem>(&(*p));
+        uint32_t  size  = itemSize(pItem);
+        uint32_t  type  = itemType(pItem);
+        uint8_t*  pData = reinterpret_cast<uint8_t*>(pItem);
+
+        if (accept(type, freeSpace)) {
+            if (pData == pEnd) {
+                selected.back().iov_len += size;
+            } else {
+                iovec block;
+                block.iov_base = pData;
+                block.iov_len  = size;
+                selected.push_back(block);
+            }
+            pEnd = pData + size;
+
+            if (stopAtEnd && (type == END_RUN)) {
+                return true;
+            }
+        }
+        freeSpace += size;            // Free once this item is skipped.
+    }
+    return false;
+}
+
+/**
+ * lookup
+ *    Types that aren't in the tables go to the predicate.
+ */
+bool
+CCompiledRingSelection::lookup(uint32_t type, size_t freeSpace) const
+{
+    return m_predicate.acceptItem(type, freeSpace);
+}
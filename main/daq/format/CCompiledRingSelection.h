@@ -0,0 +1,106 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CCompiledRingSelection.h
+ *  @brief: Table driven form of a ring selection predicate.
+ */
+#ifndef CCOMPILEDRINGSELECTION_H
+#define CCOMPILEDRINGSELECTION_H
+
+#include <CRingBufferChunkAccess.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include <vector>
+
+class CRingSelectionPredicate;
+
+/**
+ * @class CCompiledRingSelection
+ *    Evaluating a CRingSelectionPredicate for an item means a virtual
+ *    selectThis call and a map lookup or two.  This class asks the predicate
+ *    once, for each item type below TABLE_TYPES, whether items of that type
+ *    are always taken, never taken or sampled and keeps the answers in two
+ *    bitmaps.  Deciding on an item is then a couple of bit tests.
+ *
+ *    Types at or above TABLE_TYPES (none are defined) are referred to the
+ *    predicate, which must therefore live as long as this object.  If the
+ *    predicate's selections or high water mark are changed, call
+ *    compile() again.
+ *
+ *    Whole chunks from CRingBufferChunkAccess can be evaluated at once
+ *    either into a per item mask or into a list of iovecs that describe
+ *    the selected items (adjacent items are coalesced) for writev.
+ *
+ *    As with CRingSelectionPredicate::acceptItem, sampled types need to be
+ *    told the put space the ring would have with the item at its head.  For
+ *    a chunk the caller gives the put space with the chunk in the ring and
+ *    the space taken by earlier items in the chunk is added in.
+ */
+class CCompiledRingSelection
+{
+public:
+    static const uint32_t TABLE_TYPES = 0x10000;
+private:
+    static const size_t   TABLE_WORDS = TABLE_TYPES/64;
+
+    CRingSelectionPredicate& m_predicate;
+    uint64_t                 m_taken[TABLE_WORDS];    // Always selected.
+    uint64_t                 m_sampled[TABLE_WORDS];  // Selected below high water.
+    size_t                   m_highWaterMark;
+    bool                     m_hasSampled;
+public:
+    CCompiledRingSelection(CRingSelectionPredicate& predicate);
+
+    void compile();
+    bool hasSampledTypes() const { return m_hasSampled; }
+
+    bool accept(uint32_t type, size_t freeSpace) const;
+    size_t select(
+        CRingBufferChunkAccess::Chunk& chunk, size_t freeSpace,
+        std::vector<uint8_t>& mask
+    ) const;
+    bool select(
+        CRingBufferChunkAccess::Chunk& chunk, size_t freeSpace,
+        std::vector<iovec>& selected, bool stopAtEnd = false
+    ) const;
+private:
+    bool lookup(uint32_t type, size_t freeSpace) const;
+};
+
+/**
+ * accept
+ *    Decide on an item.
+ *
+ * @param type      - the item type.
+ * @param freeSpace - ring put space with the item at the head of the ring
+ *                    (only matters for sampled types).
+ * @return bool - true if the item is selected.
+ */
+inline bool
+CCompiledRingSelection::accept(uint32_t type, size_t freeSpace) const
+{
+    if (type < TABLE_TYPES) {
+        uint64_t bit = uint64_t(1) << (type & 63);
+        if (m_taken[type >> 6] & bit) return true;
+        if (m_sampled[type >> 6] & bit) return freeSpace >= m_highWaterMark;
+        return false;
+    }
+    return lookup(type, freeSpace);
+}
+
+#endif
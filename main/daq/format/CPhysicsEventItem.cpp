@@ -48,6 +48,10 @@ CPhysicsEventItem::CPhysicsEventItem(
   CRingItem(PHYSICS_EVENT, timestamp, sourceId, barrierType, maxBody, pRing)
 {}
 
+CPhysicsEventItem::CPhysicsEventItem(size_t maxBody, CRingBuffer* pRing) :
+  CRingItem(PHYSICS_EVENT, maxBody, pRing)
+{}
+
 CPhysicsEventItem::CPhysicsEventItem(const CRingItem& rhs) 
   : CRingItem(rhs)
 {
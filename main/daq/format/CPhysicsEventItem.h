@@ -44,6 +44,7 @@ public:
         uint64_t timestamp, uint32_t sourceId,  
         uint32_t barrierType, size_t maxBody, CRingBuffer* pRing
     );
+    CPhysicsEventItem(size_t maxBody, CRingBuffer* pRing);
     CPhysicsEventItem(const CRingItem& rhs) ;
     CPhysicsEventItem(const CPhysicsEventItem& rhs);
     virtual ~CPhysicsEventItem();
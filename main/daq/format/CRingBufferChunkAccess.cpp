@@ -139,6 +139,8 @@ CRingBufferChunkAccess::waitChunk(size_t maxChunk, int polls, int usecPoll)
  *    - The first ring item wraps. In that case, m_pWrappedItem is sized
  *      to hold the wrapped item and the chunk consists only of the
  *      wrapped item.
+ *    For mirrored rings nothing wraps, so the chunk is always in place and
+ *    holds all of the complete ring items that are available.
  *
  * @note   If there are not sufficient bytes in the ring buffer to hold a ring
  *         item, this throws std::logic_error.
@@ -167,15 +169,18 @@ CRingBufferChunkAccess::nextChunk()
     
     // Distinguish between the cases described in the comment header:
     
-    if (firstItemWraps())  {
+    if (!m_pRingBuffer->isMirrored() && firstItemWraps())  {
         makeWrappedItemChunk();
         
     } else {
         // The max data we want to give the chunk is the min of
         // the distance to wrap and the available data:
         
-        size_t distToWrap= m_pRingBuffer->bytesToTop();
-        size_t chunkMax  = availData < distToWrap ? availData : distToWrap;
+        size_t chunkMax  = availData;
+        if (!m_pRingBuffer->isMirrored()) {
+            size_t distToWrap= m_pRingBuffer->bytesToTop();
+            chunkMax  = availData < distToWrap ? availData : distToWrap;
+        }
         
         void *pItems = m_pRingBuffer->getPointer();
         size_t fullItemSize = sizeChunk(pItems, chunkMax);
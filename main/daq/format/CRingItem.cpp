@@ -96,13 +96,15 @@ CRingItem::CRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,
   
 }
 /**
- * constructor for zero copy attempt.
- *    If the ring item buffer fits without wrappingh into the
- *    underlying ring buffer, the data for the ring item get located
- *    directly in the ring buffer so that no additiona copying of data
- *    other than into the item is required.
- *    If the buffer wraps, this is the same as the ring item constructor
- *    with a body header.
+ * constructor for zero copy.
+ *    Space for the item is reserved in the ring buffer (see
+ *    CRingBuffer::reserve) and the item is built directly in that space.
+ *    If the item does not wrap the top of the ring, no copy of its data is
+ *    ever done.  If it would wrap, the item is built in the ring's
+ *    reservation scratch area and copied when it's committed.
+ *    The constructor blocks until there's space in the ring.  If maxBody
+ *    is too big to ever be reserved, the item is built off the ring and
+ *    commitToRing puts it.
  *
  * @param type item type.
  * @param timestamp - body header timestamp.
@@ -118,25 +120,28 @@ CRingItem::CRingItem(
   m_pItem(nullptr), m_pCursor(nullptr), m_storageSize(maxBody),
   m_swapNeeded(false), m_fZeroCopy(false), m_pRingBuffer(nullptr)
 {
-  if   (pRing->bytesToTop() > (maxBody +100)) {
-    // Wait until there's sufficient free space as well as the
-    // get pointers could be well behind us:
-    
-    while (pRing->availablePutSpace() < (maxBody+100)) {
-      usleep(10);
-    }
-    
-    
-    m_pItem = static_cast<pRingItem>(pRing->getPointer());
-    m_storageSize = maxBody;
-    m_fZeroCopy   = true;
-    m_pRingBuffer = pRing;
-    initItem(type, timestamp, sourceId, barrierType);
-  } else {
-    m_fZeroCopy  = false;
-    newIfNecessary(maxBody);
-    initItem(type, timestamp, sourceId, barrierType);
-  }
+  reserveInRing(maxBody, pRing);
+  initItem(type, timestamp, sourceId, barrierType);
+}
+/**
+ * Zero copy constructor for items without a body header.
+ * See the prior constructor for how the storage is handled.
+ *
+ * @param type    - Ring item type.
+ * @param maxBody - Maximum size of the ring item body.
+ * @param pRing   - Ring buffer the item will be committed to.  We must
+ *                  be its producer.
+ */
+CRingItem::CRingItem(uint16_t type, size_t maxBody, CRingBuffer* pRing) :
+  m_pItem(nullptr), m_pCursor(nullptr), m_storageSize(maxBody),
+  m_swapNeeded(false), m_fZeroCopy(false), m_pRingBuffer(nullptr)
+{
+  reserveInRing(maxBody, pRing);
+  uint32_t* pAfter = static_cast<uint32_t*>(fillRingHeader(m_pItem, 0, type)); 
+  *pAfter++ = sizeof(uint32_t);                 // NO body header.
+  
+  setBodyCursor(pAfter);
+  updateSize();
 }
 /*!
   Copy construct.  This is actually the same as the construction above, 
@@ -497,7 +502,7 @@ CRingItem::commitToRing(CRingBuffer& ring)
       throw std::logic_error("Zero copy ring commit done on a different ring");
     }
     updateSize();
-    ring.skip(itemSize(m_pItem));
+    ring.commit(itemSize(m_pItem));
   
   } else {
     updateSize();
@@ -706,6 +711,29 @@ CRingItem::newIfNecessary(size_t size)
 
 }
 
+/*
+ *  Reserve storage for a zero copy item in a ring buffer and point
+ *  m_pItem at it.  The reservation allows for the same overhead as
+ *  newIfNecessary.  If that could never fit in the ring the item is
+ *  built in ordinary storage instead and commitToRing puts it; an item
+ *  that's actually too big will then get put's CRangeError.
+ */
+void
+CRingItem::reserveInRing(size_t maxBody, CRingBuffer* pRing)
+{
+  size_t nBytes = maxBody + sizeof(RingItemHeader) + 100;
+  if (nBytes > pRing->maxReserve()) {
+    newIfNecessary(maxBody);
+    m_storageSize = maxBody;
+    return;
+  }
+  m_pItem = static_cast<pRingItem>(pRing->reserve(nBytes));
+  m_storageSize = maxBody;
+  m_fZeroCopy   = true;
+  m_pRingBuffer = pRing;
+  m_pCursor     = reinterpret_cast<uint8_t*>(&(m_pItem->s_body));
+}
+
 /**
  * bodyHeaderToString
  *
@@ -70,6 +70,7 @@ public:
   
   CRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,  
       uint32_t barrierType, size_t maxBody, CRingBuffer* pRing);
+  CRingItem(uint16_t type, size_t maxBody, CRingBuffer* pRing);
   
   
   
@@ -140,6 +141,7 @@ private:
     uint16_t type, uint64_t timestamp, uint32_t sourceId,  
     uint32_t barrierType
   );
+  void reserveInRing(size_t maxBody, CRingBuffer* pRing);
  
 };
 #endif
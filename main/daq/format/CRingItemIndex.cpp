@@ -0,0 +1,318 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemIndex.cpp
+ *  @brief: Implement the event file ring item index.
+ */
+#include "CRingItemIndex.h"
+#include <DataFormat.h>
+#include <io.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+static const char MAGIC[8] = {'N', 'S', 'C', 'L', 'R', 'I', 'D', 'X'};
+
+// Enough of an item to get its header and body header:
+
+static const size_t HEADER_BYTES = sizeof(RingItemHeader) + sizeof(BodyHeader);
+
+/**
+ * constructor
+ *
+ * @param interval - Every interval'th physics event is indexed.
+ */
+CRingItemIndex::CRingItemIndex(unsigned interval) :
+    m_nInterval(interval ? interval : 1)
+{
+    clear();
+}
+
+/**
+ * indexFileName
+ *    @param eventFile - name of an event file.
+ *    @return std::string - name of its index sidecar.
+ */
+std::string
+CRingItemIndex::indexFileName(const std::string& eventFile)
+{
+    return eventFile + ".idx";
+}
+
+/**
+ * clear
+ *    Empty the index to start a new file.
+ */
+void
+CRingItemIndex::clear()
+{
+    m_entries.clear();
+    m_nItems        = 0;
+    m_nBytes        = 0;
+    m_nPhysicsItems = 0;
+    m_itemHeader.clear();
+    m_nSkip         = 0;
+    m_nItemOffset   = 0;
+}
+/**
+ * add
+ *    Index more of the file's data.  The data need not start or end on
+ *    ring item boundaries.
+ *
+ * @param pData  - the data.
+ * @param nBytes - how many bytes.
+ * @throw std::runtime_error - the data are not ring items.
+ */
+void
+CRingItemIndex::add(const void* pData, size_t nBytes)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(pData);
+    m_nBytes += nBytes;
+
+    while (nBytes) {
+        if (m_nSkip) {
+            size_t n = std::min(m_nSkip, uint64_t(nBytes));
+            m_nSkip -= n;
+            p       += n;
+            nBytes  -= n;
+            continue;
+        }
+        size_t n = std::min(headerBytesWanted() - m_itemHeader.size(), nBytes);
+        m_itemHeader.insert(m_itemHeader.end(), p, p + n);
+        p      += n;
+        nBytes -= n;
+        if (m_itemHeader.size() == headerBytesWanted()) {
+            indexItem();
+        }
+    }
+}
+/**
+ * write
+ *    Write the index sidecar.
+ *
+ * @param filename - where to write it.
+ * @throw std::system_error on failure.
+ */
+void
+CRingItemIndex::write(const std::string& filename) const
+{
+    Header header;
+    memcpy(header.s_magic, MAGIC, sizeof(header.s_magic));
+    header.s_version  = VERSION;
+    header.s_interval = m_nInterval;
+    header.s_nItems   = m_nItems;
+    header.s_nBytes   = m_nBytes;
+    header.s_nEntries = m_entries.size();
+
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Creating ring item index");
+    }
+    try {
+        io::writeData(fd, &header, sizeof(header));
+        if (m_entries.size()) {
+            io::writeData(fd, m_entries.data(), m_entries.size()*sizeof(Entry));
+        }
+    }
+    catch (int err) {
+        close(fd);
+        throw std::system_error(err, std::generic_category(), "Writing ring item index");
+    }
+    close(fd);
+}
+/**
+ * read
+ *    Read an index sidecar.
+ *
+ * @param filename - the sidecar.
+ * @return bool - false if it doesn't exist or isn't a valid index, in
+ *                which case the index is empty.
+ */
+bool
+CRingItemIndex::read(const std::string& filename)
+{
+    clear();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    bool ok = false;
+    Header header;
+    try {
+        if ((io::readData(fd, &header, sizeof(header)) == sizeof(header)) &&
+            (memcmp(header.s_magic, MAGIC, sizeof(MAGIC)) == 0)             &&
+            (header.s_version == VERSION)) {
+            m_entries.resize(header.s_nEntries);
+            size_t nBytes = header.s_nEntries*sizeof(Entry);
+            ok = (io::readData(fd, m_entries.data(), nBytes) == nBytes);
+        }
+    }
+    catch (int err) {
+        ok = false;
+    }
+    close(fd);
+
+    if (ok) {
+        m_nInterval = header.s_interval;
+        m_nItems    = header.s_nItems;
+        m_nBytes    = header.s_nBytes;
+    } else {
+        clear();
+    }
+    return ok;
+}
+/**
+ * findItem
+ *    @param item - an item number.
+ *    @return const Entry* - the last entry at or before the item, nullptr
+ *                           if there is none (start at the beginning).
+ */
+const CRingItemIndex::Entry*
+CRingItemIndex::findItem(uint64_t item) const
+{
+    auto p = std::upper_bound(
+        m_entries.begin(), m_entries.end(), item,
+        [](uint64_t n, const Entry& e) { return n < e.s_itemNumber; }
+    );
+    if (p == m_entries.begin()) return nullptr;
+    return &(*(p - 1));
+}
+/**
+ * findTimestamp
+ *    Find where to start looking for the first item whose timestamp is at
+ *    least the one given: the entry before the first indexed item that
+ *    has a big enough timestamp.  If none do, it's the last entry with a
+ *    timestamp as the item could be after it.  Only entries that have
+ *    timestamps are considered.
+ *
+ * @param timestamp - the timestamp.
+ * @return const Entry* - where to start scanning, nullptr to start at the
+ *                        beginning of the file.
+ */
+const CRingItemIndex::Entry*
+CRingItemIndex::findTimestamp(uint64_t timestamp) const
+{
+    const Entry* pResult = nullptr;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const Entry& e(m_entries[i]);
+        if (e.s_timestamp == NO_TIMESTAMP) continue;
+        if (e.s_timestamp >= timestamp) break;
+        pResult = &e;
+    }
+    return pResult;
+}
+/**
+ * findType
+ *    Find the next indexed item of a type, e.g. the next BEGIN_RUN or
+ *    PERIODIC_SCALERS item.
+ *
+ * @param type   - item type.
+ * @param pAfter - If not null, search starts after this entry.
+ * @return const Entry* - nullptr if there's none.
+ */
+const CRingItemIndex::Entry*
+CRingItemIndex::findType(uint32_t type, const Entry* pAfter) const
+{
+    size_t i = pAfter ? (pAfter - m_entries.data()) + 1 : 0;
+    for (; i < m_entries.size(); i++) {
+        if (m_entries[i].s_type == type) return &m_entries[i];
+    }
+    return nullptr;
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * headerBytesWanted
+ *    @return size_t - how much of the current item we need to index it:
+ *                     its size first, then the header and body header
+ *                     (or all of it if it's smaller).
+ */
+size_t
+CRingItemIndex::headerBytesWanted() const
+{
+    if (m_itemHeader.size() < sizeof(uint32_t)) return sizeof(uint32_t);
+
+    uint32_t size;
+    memcpy(&size, m_itemHeader.data(), sizeof(uint32_t));
+    if (size < sizeof(RingItemHeader)) {
+        throw std::runtime_error("Ring item index - data are not ring items");
+    }
+    return std::min(size_t(size), HEADER_BYTES);
+}
+/**
+ * indexItem
+ *    We have the start of an item.  Make an entry if it's to be indexed
+ *    and set up to skip the rest of it.
+ */
+void
+CRingItemIndex::indexItem()
+{
+    uint8_t buffer[HEADER_BYTES];
+    memset(buffer, 0, sizeof(buffer));
+    memcpy(buffer, m_itemHeader.data(), m_itemHeader.size());
+    pRingItem pItem = reinterpret_cast<pRingItem>(buffer);
+    uint32_t  size  = pItem->s_header.s_size;
+    uint32_t  type  = pItem->s_header.s_type;
+
+    if (wanted(type)) {
+        Entry e;
+        e.s_offset     = m_nItemOffset;
+        e.s_itemNumber = m_nItems;
+        e.s_type       = type;
+        e.s_timestamp  = NO_TIMESTAMP;
+        e.s_sourceId   = 0;
+        if ((m_itemHeader.size() == HEADER_BYTES) && hasBodyHeader(pItem)) {
+            e.s_timestamp = pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_timestamp;
+            e.s_sourceId  = pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId;
+        }
+        m_entries.push_back(e);
+    }
+    m_nSkip        = size - m_itemHeader.size();
+    m_nItemOffset += size;
+    m_itemHeader.clear();
+    m_nItems++;
+}
+/**
+ * wanted
+ *    @param type - type of an item.
+ *    @return bool - true if an item of that type should be indexed.
+ */
+bool
+CRingItemIndex::wanted(uint32_t type)
+{
+    switch (type) {
+    case BEGIN_RUN:
+    case END_RUN:
+    case PAUSE_RUN:
+    case RESUME_RUN:
+    case ABNORMAL_ENDRUN:
+    case PERIODIC_SCALERS:
+        return true;
+    case PHYSICS_EVENT:
+        return (m_nPhysicsItems++ % m_nInterval) == 0;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,113 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemIndex.h
+ *  @brief: Random access index of the ring items in an event file.
+ */
+#ifndef CRINGITEMINDEX_H
+#define CRINGITEMINDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * @class CRingItemIndex
+ *    An index of the ring items in an event file.  It's kept in a sidecar
+ *    file (the event file name with .idx appended) so offline programs can
+ *    position to a run segment, scaler period, timestamp or item number
+ *    without reading the file from the start.
+ *
+ *    Every state change, abnormal end and scaler item is indexed, as is
+ *    every Nth physics event.  Each entry has the byte offset of the item
+ *    (in the uncompressed data if the file is a compressed segment), its
+ *    number in the file, its type and, if it has a body header, its
+ *    timestamp and source id.
+ *
+ *    The index is built by handing add() the file's data in order, in any
+ *    size pieces.  The eventlogger does this as it writes, evtindex does
+ *    it for existing files.
+ *
+ *    Sidecar layout: a Header followed by Header::s_nEntries Entries, in
+ *    the byte order of the writing system.
+ */
+class CRingItemIndex
+{
+public:
+    static const uint32_t VERSION          = 1;
+    static const unsigned DEFAULT_INTERVAL = 1000;
+    static const uint64_t NO_TIMESTAMP     = 0xffffffffffffffffULL;
+
+    typedef struct __attribute__((__packed__)) _Header {
+        char     s_magic[8];
+        uint32_t s_version;
+        uint32_t s_interval;        // Every s_interval'th physics item is indexed.
+        uint64_t s_nItems;          // Ring items in the file.
+        uint64_t s_nBytes;          // Bytes of (uncompressed) ring items.
+        uint64_t s_nEntries;
+    } Header, *pHeader;
+
+    typedef struct __attribute__((__packed__)) _Entry {
+        uint64_t s_offset;
+        uint64_t s_itemNumber;
+        uint64_t s_timestamp;       // NO_TIMESTAMP if no body header.
+        uint32_t s_type;
+        uint32_t s_sourceId;
+    } Entry, *pEntry;
+
+private:
+    unsigned            m_nInterval;
+    std::vector<Entry>  m_entries;
+    uint64_t            m_nItems;
+    uint64_t            m_nBytes;
+    uint64_t            m_nPhysicsItems;
+
+    // Building state: the start of the item being looked at, its offset
+    // and how much of it is still to be skipped once its header is in hand.
+
+    std::vector<uint8_t> m_itemHeader;
+    uint64_t             m_nItemOffset;
+    uint64_t             m_nSkip;
+
+public:
+    CRingItemIndex(unsigned interval = DEFAULT_INTERVAL);
+
+    static std::string indexFileName(const std::string& eventFile);
+
+    void clear();
+    void add(const void* pData, size_t nBytes);
+
+    void write(const std::string& filename) const;
+    bool read(const std::string& filename);
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+    unsigned getInterval() const  { return m_nInterval; }
+    uint64_t getItemCount() const { return m_nItems; }
+    uint64_t getByteCount() const { return m_nBytes; }
+
+    const Entry* findItem(uint64_t item) const;
+    const Entry* findTimestamp(uint64_t timestamp) const;
+    const Entry* findType(uint32_t type, const Entry* pAfter = nullptr) const;
+
+private:
+    size_t headerBytesWanted() const;
+    void   indexItem();
+    bool   wanted(uint32_t type);
+};
+
+#endif
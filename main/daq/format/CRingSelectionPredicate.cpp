@@ -277,6 +277,30 @@ CRingSelectionPredicate::selectItem(CRingBuffer& ring)
   ring.While(*this);
 
 }
+/*!
+  Decide if an item that's already been gotten out of the ring (e.g. as
+  part of a chunk from CRingBufferChunkAccess) would have been selected by
+  operator().  This gives the same answer operator() would for an item
+  of this type at the head of the ring.
+
+  \param type      - The item's type.
+  \param freeSpace - Put space the ring would have with the item at its head.
+                     Sampled types are only accepted when this is at least
+                     the high water mark.
+  \return bool - true if the item should be taken, false if skipped.
+*/
+bool
+CRingSelectionPredicate::acceptItem(uint32_t type, size_t freeSpace)
+{
+  if (selectThis(type)) {
+    return false;
+  }
+  SelectionMapIterator p = find(type);
+  if ((p != end()) && p->second.s_sampled) {
+    return freeSpace >= m_highWaterMark;
+  }
+  return true;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //
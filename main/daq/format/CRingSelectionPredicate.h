@@ -92,6 +92,7 @@ public:
   virtual bool operator()(CRingBuffer& ring);
   virtual bool selectThis(uint32_t type) = 0;
   void selectItem(CRingBuffer& ring);
+  bool acceptItem(uint32_t type, size_t freeSpace);
   size_t getNumberOfSelections() const { return m_selections.size(); }
 
   // Utilities for derived classes:
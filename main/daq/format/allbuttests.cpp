@@ -13,6 +13,7 @@ class allbuttests : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(allbuttests);
   CPPUNIT_TEST(notinlist);
   CPPUNIT_TEST(inlist);
+  CPPUNIT_TEST(acceptitem);
   //  CPPUNIT_TEST(sampledlast); /* Changed how sampling works */
   //  CPPUNIT_TEST(samplednotlast); /* Tests invalidated */
   CPPUNIT_TEST_SUITE_END();
@@ -37,6 +38,7 @@ public:
 protected:
   void notinlist();
   void inlist();
+  void acceptitem();
   void sampledlast();
   void samplednotlast();
 };
@@ -64,6 +66,21 @@ void allbuttests::inlist()
   p.addExceptionType(1234);
   ASSERT(p(*pCons));
 }
+// acceptItem agrees with the predicate: excluded types are never
+// taken, sampled ones only if there's enough free space.
+
+void allbuttests::acceptitem()
+{
+  CAllButPredicate p;
+  p.addExceptionType(1234);
+  p.addExceptionType(4321, true);
+  p.setHighWaterMark(1000);
+
+  ASSERT(p.acceptItem(1, 0));
+  ASSERT(!p.acceptItem(1234, 1000000));
+  ASSERT(p.acceptItem(4321, 1000));
+  ASSERT(!p.acceptItem(4321, 999));
+}
 // A sampled item in the list that is at the end of the
 // ring should give false.
 
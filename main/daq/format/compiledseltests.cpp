@@ -0,0 +1,203 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  compiledseltests.cpp
+ *  @brief: Tests for the table driven ring selection.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CCompiledRingSelection.h"
+#include "CAllButPredicate.h"
+#include "CDesiredTypesPredicate.h"
+#include "DataFormat.h"
+
+#include <string.h>
+#include <vector>
+
+class compiledseltest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(compiledseltest);
+    CPPUNIT_TEST(allbut_1);
+    CPPUNIT_TEST(desired_1);
+    CPPUNIT_TEST(bigtype_1);
+    CPPUNIT_TEST(recompile_1);
+    CPPUNIT_TEST(mask_1);
+    CPPUNIT_TEST(iovec_1);
+    CPPUNIT_TEST(iovec_2);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::vector<uint8_t>          m_data;
+    CRingBufferChunkAccess::Chunk m_chunk;
+public:
+    void setUp() {
+        // Items: type/size pairs.
+
+        uint32_t types[] = {BEGIN_RUN, PHYSICS_EVENT, PERIODIC_SCALERS,
+                            PERIODIC_SCALERS, PHYSICS_EVENT, PHYSICS_EVENT,
+                            BEGIN_RUN, END_RUN};
+        uint32_t sizes[] = {8, 16, 12, 8, 8, 20, 8, 8};
+        m_data.clear();
+        for (int i = 0; i < 8; i++) {
+            RingItemHeader h = {sizes[i], types[i]};
+            size_t offset = m_data.size();
+            m_data.resize(offset + sizes[i], 0);
+            memcpy(m_data.data() + offset, &h, sizeof(h));
+        }
+        m_chunk.setChunk(m_data.size(), m_data.data());
+    }
+    void tearDown() {
+    }
+protected:
+    void allbut_1();
+    void desired_1();
+    void bigtype_1();
+    void recompile_1();
+    void mask_1();
+    void iovec_1();
+    void iovec_2();
+private:
+    size_t offset(const iovec& v) {
+        return static_cast<uint8_t*>(v.iov_base) - m_data.data();
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(compiledseltest);
+
+// An all but predicate compiles to the same decisions it makes:
+
+void compiledseltest::allbut_1()
+{
+    CAllButPredicate p;
+    p.addExceptionType(PHYSICS_EVENT);
+    p.addExceptionType(PERIODIC_SCALERS, true);
+    p.setHighWaterMark(100);
+    CCompiledRingSelection s(p);
+
+    ASSERT(s.hasSampledTypes());
+    for (uint32_t type = 0; type < 100; type++) {
+        EQ(p.acceptItem(type, 0), s.accept(type, 0));
+        EQ(p.acceptItem(type, 100), s.accept(type, 100));
+    }
+    ASSERT(!s.accept(PHYSICS_EVENT, 1000));
+    ASSERT(s.accept(PERIODIC_SCALERS, 100));
+    ASSERT(!s.accept(PERIODIC_SCALERS, 99));
+}
+// So does a desired types predicate:
+
+void compiledseltest::desired_1()
+{
+    CDesiredTypesPredicate p;
+    p.addDesiredType(BEGIN_RUN);
+    p.addDesiredType(END_RUN);
+    CCompiledRingSelection s(p);
+
+    ASSERT(!s.hasSampledTypes());
+    ASSERT(s.accept(BEGIN_RUN, 0));
+    ASSERT(s.accept(END_RUN, 0));
+    ASSERT(!s.accept(PHYSICS_EVENT, 0));
+    ASSERT(!s.accept(FIRST_USER_ITEM_CODE, 0));
+}
+// Types past the table go to the predicate:
+
+void compiledseltest::bigtype_1()
+{
+    CDesiredTypesPredicate p;
+    p.addDesiredType(0x12345678);
+    CCompiledRingSelection s(p);
+
+    ASSERT(s.accept(0x12345678, 0));
+    ASSERT(!s.accept(0x12345679, 0));
+}
+// Changes to the predicate are seen after compile():
+
+void compiledseltest::recompile_1()
+{
+    CDesiredTypesPredicate p;
+    p.addDesiredType(BEGIN_RUN);
+    CCompiledRingSelection s(p);
+    ASSERT(!s.accept(END_RUN, 0));
+
+    p.addDesiredType(END_RUN);
+    s.compile();
+    ASSERT(s.accept(END_RUN, 0));
+}
+// Chunk evaluation into a mask; the free space grows with each item:
+
+void compiledseltest::mask_1()
+{
+    CAllButPredicate p;
+    p.addExceptionType(PHYSICS_EVENT);
+    p.addExceptionType(PERIODIC_SCALERS, true);
+    p.setHighWaterMark(30);
+    CCompiledRingSelection s(p);
+
+    std::vector<uint8_t> mask;
+    EQ(size_t(5), s.select(m_chunk, 10, mask));
+
+    uint8_t expected[] = {1, 0, 1, 1, 0, 0, 1, 1};   // 1st scaler has 34 free.
+    EQ(size_t(8), mask.size());
+    for (int i = 0; i < 8; i++) {
+        EQ(expected[i], mask[i]);
+    }
+    EQ(size_t(4), s.select(m_chunk, 0, mask));        // Only 1st scaler out.
+    EQ(uint8_t(0), mask[2]);
+    EQ(uint8_t(1), mask[3]);
+}
+// Chunk evaluation into iovecs coalesces adjacent items:
+
+void compiledseltest::iovec_1()
+{
+    CAllButPredicate p;
+    p.addExceptionType(PHYSICS_EVENT);
+    p.addExceptionType(PERIODIC_SCALERS, true);
+    p.setHighWaterMark(30);
+    CCompiledRingSelection s(p);
+
+    std::vector<iovec> selected;
+    ASSERT(!s.select(m_chunk, 10, selected));
+    EQ(size_t(3), selected.size());
+    EQ(size_t(0),  offset(selected[0]));
+    EQ(size_t(8),  selected[0].iov_len);
+    EQ(size_t(24), offset(selected[1]));
+    EQ(size_t(20), selected[1].iov_len);
+    EQ(size_t(72), offset(selected[2]));
+    EQ(size_t(16), selected[2].iov_len);
+}
+// stopAtEnd stops after the first selected end run:
+
+void compiledseltest::iovec_2()
+{
+    CDesiredTypesPredicate p;
+    p.addDesiredType(BEGIN_RUN);
+    p.addDesiredType(END_RUN);
+    CCompiledRingSelection s(p);
+
+    // Make the second begin run an end run:
+
+    pRingItemHeader h = reinterpret_cast<pRingItemHeader>(m_data.data() + 72);
+    h->s_type = END_RUN;
+
+    std::vector<iovec> selected;
+    ASSERT(s.select(m_chunk, 0, selected, true));
+    EQ(size_t(2), selected.size());
+    EQ(size_t(72), offset(selected[1]));
+    EQ(size_t(8),  selected[1].iov_len);
+
+    ASSERT(!s.select(m_chunk, 0, selected));
+    EQ(size_t(16), selected[1].iov_len);
+}
@@ -55,6 +55,7 @@ class rbchunkTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(nextchunk_4);
   CPPUNIT_TEST(nextchunk_5);
   CPPUNIT_TEST(nextchunk_6);  
+  CPPUNIT_TEST(nextchunk_mirrored);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -115,6 +116,7 @@ protected:
   void nextchunk_4();
   void nextchunk_5();
   void nextchunk_6();
+  void nextchunk_mirrored();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(rbchunkTest);
@@ -565,4 +567,44 @@ void rbchunkTest::nextchunk_6()
   
   auto c = a.nextChunk();
   EQ(size_t(0), c.size());
-}
\ No newline at end of file
+}
+
+// In a mirrored ring, an item that wraps is still gotten in place:
+
+void rbchunkTest::nextchunk_mirrored()
+{
+  delete m_producer;
+  delete m_consumer;
+  CRingBuffer::remove("chunktest");
+  CRingBuffer::create(
+    "chunktest", CRingBuffer::getDefaultRingSize(),
+    CRingBuffer::getDefaultMaxConsumers(), false, true
+  );
+  m_producer = new CRingBuffer("chunktest", CRingBuffer::producer);
+  m_consumer = new CRingBuffer("chunktest", CRingBuffer::consumer);
+  
+  CRingBufferChunkAccess a(m_consumer);
+  size_t skipSize = m_producer->bytesToTop() - 3;   // even the size wraps.
+  m_producer->skip(skipSize);
+  m_consumer->skip(skipSize);
+  
+  CRingItem item(PHYSICS_EVENT);
+  uint32_t* pBody = static_cast<uint32_t*>(item.getBodyCursor());
+  *pBody++ = 0x12345678;
+  item.setBodyCursor(pBody);
+  item.updateSize();
+  size_t itemSize = item.getItemPointer()->s_header.s_size;
+  item.commitToRing(*m_producer);
+  
+  size_t bufferedSize =  a.waitChunk(1000, 1, 0);
+  EQ(bufferedSize, itemSize);
+  
+  auto c = a.nextChunk();
+  EQ(m_consumer->getPointer(), c.getStorage());     // In place.
+  EQ(bufferedSize, c.size());
+  
+  uint32_t* pChunk = static_cast<uint32_t*>(c.getStorage());
+  EQ(uint32_t(itemSize), pChunk[0]);
+  EQ(PHYSICS_EVENT, pChunk[1]);
+  EQ(uint32_t(0x12345678), pChunk[3]);
+}
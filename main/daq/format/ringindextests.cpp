@@ -0,0 +1,286 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  ringindextests.cpp
+ *  @brief: Tests for the event file ring item index.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingItemIndex.h"
+#include "DataFormat.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <vector>
+#include <string>
+
+static const unsigned NEVENTS(2500);
+static const unsigned SCALERPERIOD(500);
+static const unsigned INTERVAL(100);
+
+class ringindextest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ringindextest);
+    CPPUNIT_TEST(entries_1);
+    CPPUNIT_TEST(offsets_1);
+    CPPUNIT_TEST(pieces_1);
+    CPPUNIT_TEST(file_1);
+    CPPUNIT_TEST(file_2);
+    CPPUNIT_TEST(find_1);
+    CPPUNIT_TEST(find_2);
+    CPPUNIT_TEST(find_3);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::vector<uint8_t> m_data;
+    unsigned             m_nItems;
+public:
+    void setUp() {
+        m_data.clear();
+        m_nItems = 0;
+        append(formatStateChange(time(nullptr), 0, 12, "Test run", BEGIN_RUN));
+        for (uint32_t i = 0; i < NEVENTS; i++) {
+            uint32_t payload[4] = {i, i, i, i};
+            append(formatTimestampedEventItem(
+                100*uint64_t(i), 2, 0, (i % 4 + 1)*sizeof(uint32_t), payload
+            ));
+            if ((i % SCALERPERIOD) == (SCALERPERIOD - 1)) {
+                uint32_t scalers[2] = {i, i};
+                append(formatTimestampedScalerItem(
+                    100*uint64_t(i), 3, 0, 1, 1, time(nullptr), 0, 10, 2, scalers
+                ));
+                const char* strings[] = {"a string"};
+                append(formatTextItem(1, time(nullptr), 10, strings, MONITORED_VARIABLES));
+            }
+        }
+        append(formatStateChange(time(nullptr), 10, 12, "Test run", END_RUN));
+        append(formatAbnormalEndItem());
+    }
+    void tearDown() {
+    }
+protected:
+    void entries_1();
+    void offsets_1();
+    void pieces_1();
+    void file_1();
+    void file_2();
+    void find_1();
+    void find_2();
+    void find_3();
+private:
+    void append(void* pItem) {
+        uint8_t* p = static_cast<uint8_t*>(pItem);
+        m_data.insert(m_data.end(), p, p + itemSize(static_cast<pRingItem>(pItem)));
+        m_nItems++;
+        free(pItem);
+    }
+    void checkSame(const CRingItemIndex& a, const CRingItemIndex& b) {
+        EQ(a.getItemCount(), b.getItemCount());
+        EQ(a.getByteCount(), b.getByteCount());
+        EQ(a.entries().size(), b.entries().size());
+        ASSERT(memcmp(
+            a.entries().data(), b.entries().data(),
+            a.entries().size()*sizeof(CRingItemIndex::Entry)) == 0
+        );
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ringindextest);
+
+// State changes, scalers and every INTERVAL'th event are indexed:
+
+void ringindextest::entries_1()
+{
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+
+    EQ(uint64_t(m_nItems), index.getItemCount());
+    EQ(uint64_t(m_data.size()), index.getByteCount());
+
+    const std::vector<CRingItemIndex::Entry>& e(index.entries());
+    EQ(size_t(1 + NEVENTS/INTERVAL + NEVENTS/SCALERPERIOD + 2), e.size());
+
+    EQ(BEGIN_RUN, e[0].s_type);
+    EQ(CRingItemIndex::NO_TIMESTAMP, e[0].s_timestamp);
+    EQ(PHYSICS_EVENT, e[1].s_type);
+    EQ(uint64_t(0), e[1].s_timestamp);
+    EQ(uint32_t(2), e[1].s_sourceId);
+    EQ(PHYSICS_EVENT, e[2].s_type);
+    EQ(uint64_t(100*INTERVAL), e[2].s_timestamp);
+
+    unsigned nScalers = 0;
+    for (int i = 0; i < e.size(); i++) {
+        if (e[i].s_type == PERIODIC_SCALERS) {
+            nScalers++;
+            EQ(uint32_t(3), e[i].s_sourceId);
+        }
+    }
+    EQ(NEVENTS/SCALERPERIOD, nScalers);
+    EQ(END_RUN, e[e.size() - 2].s_type);
+    EQ(ABNORMAL_ENDRUN, e.back().s_type);
+    EQ(uint64_t(m_nItems - 1), e.back().s_itemNumber);
+}
+// Offsets point at the items indexed:
+
+void ringindextest::offsets_1()
+{
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+
+    const std::vector<CRingItemIndex::Entry>& e(index.entries());
+    for (int i = 0; i < e.size(); i++) {
+        pRingItem pItem = reinterpret_cast<pRingItem>(&m_data[e[i].s_offset]);
+        EQ(e[i].s_type, pItem->s_header.s_type);
+    }
+    // Count items to check the item numbers of the physics events.
+
+    uint64_t offset = 0;
+    uint64_t n      = 0;
+    size_t   entry  = 0;
+    while (offset < m_data.size()) {
+        if ((entry < e.size()) && (e[entry].s_offset == offset)) {
+            EQ(n, e[entry].s_itemNumber);
+            entry++;
+        }
+        offset += itemSize(reinterpret_cast<pRingItem>(&m_data[offset]));
+        n++;
+    }
+    EQ(e.size(), entry);
+}
+// Data can be given in any size pieces:
+
+void ringindextest::pieces_1()
+{
+    CRingItemIndex whole(INTERVAL);
+    whole.add(m_data.data(), m_data.size());
+
+    size_t sizes[] = {1, 3, 7, 13, 31, 100, 4096};
+    for (int i = 0; i < sizeof(sizes)/sizeof(size_t); i++) {
+        CRingItemIndex pieces(INTERVAL);
+        size_t offset = 0;
+        while (offset < m_data.size()) {
+            size_t n = std::min(sizes[i], m_data.size() - offset);
+            pieces.add(&m_data[offset], n);
+            offset += n;
+        }
+        checkSame(whole, pieces);
+    }
+}
+// Written indices read back the same:
+
+void ringindextest::file_1()
+{
+    char name[] = "ringindexXXXXXX";
+    int fd = mkstemp(name);
+    close(fd);
+
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+    index.write(name);
+
+    CRingItemIndex readBack;
+    ASSERT(readBack.read(name));
+    unlink(name);
+
+    EQ(INTERVAL, readBack.getInterval());
+    checkSame(index, readBack);
+}
+// Missing or bad index files can't be read:
+
+void ringindextest::file_2()
+{
+    char name[] = "ringindexXXXXXX";
+    int fd = mkstemp(name);
+    write(fd, m_data.data(), 100);
+    close(fd);
+
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+    ASSERT(!index.read(name));
+    EQ(size_t(0), index.entries().size());
+
+    unlink(name);
+    ASSERT(!index.read(name));
+    EQ(std::string("run-0001-00.evt.idx"),
+       CRingItemIndex::indexFileName("run-0001-00.evt"));
+}
+// Finding by item number:
+
+void ringindextest::find_1()
+{
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+    const std::vector<CRingItemIndex::Entry>& e(index.entries());
+
+    EQ(&e[0], index.findItem(0));
+    EQ(&e[1], index.findItem(1));
+    EQ(&e[1], index.findItem(INTERVAL));           // Begin run is item 0.
+    EQ(&e[2], index.findItem(INTERVAL + 1));
+    EQ(&e.back(), index.findItem(m_nItems + 100));
+
+    CRingItemIndex empty;
+    ASSERT(!empty.findItem(10));
+}
+// Finding by timestamp:
+
+void ringindextest::find_2()
+{
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+
+    ASSERT(!index.findTimestamp(0));               // Start of the file.
+
+    const CRingItemIndex::Entry* p = index.findTimestamp(100*INTERVAL + 50);
+    ASSERT(p);
+    EQ(uint64_t(100*INTERVAL), p->s_timestamp);
+
+    // Exactly on an indexed event, start before it:
+
+    p = index.findTimestamp(2*100*INTERVAL);
+    ASSERT(p);
+    ASSERT(p->s_timestamp < 2*100*INTERVAL);
+
+    // Past the end, start at the last timestamped entry:
+
+    p = index.findTimestamp(100*NEVENTS*2);
+    ASSERT(p);
+    EQ(uint64_t(100*(NEVENTS - 1)), p->s_timestamp);
+}
+// Finding by type:
+
+void ringindextest::find_3()
+{
+    CRingItemIndex index(INTERVAL);
+    index.add(m_data.data(), m_data.size());
+
+    const CRingItemIndex::Entry* p = index.findType(PERIODIC_SCALERS);
+    unsigned n = 0;
+    while (p) {
+        EQ(PERIODIC_SCALERS, p->s_type);
+        n++;
+        p = index.findType(PERIODIC_SCALERS, p);
+    }
+    EQ(NEVENTS/SCALERPERIOD, n);
+
+    p = index.findType(END_RUN);
+    ASSERT(p);
+    ASSERT(!index.findType(END_RUN, p));
+    ASSERT(!index.findType(PHYSICS_EVENT_COUNT));
+}
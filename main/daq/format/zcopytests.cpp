@@ -24,6 +24,8 @@ class zcopytest : public CppUnit::TestFixture {
   CPPUNIT_TEST(construct_2);
   
   CPPUNIT_TEST(commit_3);
+  CPPUNIT_TEST(nobodyheader);
+  CPPUNIT_TEST(oversize);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -54,6 +56,8 @@ protected:
   void construct_2();
   
   void commit_3();
+  void nobodyheader();
+  void oversize();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(zcopytest);
@@ -115,7 +119,8 @@ void zcopytest::construct_2()
   CAllButPredicate all;
   
   // Push the pointers so that construction must wrap
-  // this should result in a ring item that's not zero copy:
+  // this should result in a ring item that's built in the ring's
+  // reservation scratch area and copied in at commit time:
   
   size_t nBytes = m_pProducer->availablePutSpace();
   size_t skip   = nBytes - sizeof(uint16_t);
@@ -123,7 +128,8 @@ void zcopytest::construct_2()
   m_pConsumer->skip(skip);
   
   CRingItem nozcopy(PHYSICS_EVENT, 0x1234, 1, 0, 128, m_pProducer);
-  ASSERT(!nozcopy.m_fZeroCopy);
+  ASSERT(nozcopy.m_fZeroCopy);
+  ASSERT(nozcopy.m_pItem != m_pProducer->getPointer());
   nozcopy.commitToRing(*m_pProducer);
   
   CRingItem* pGotten = CRingItem::getFromRing(*m_pConsumer, all);
@@ -148,4 +154,56 @@ void zcopytest::commit_3()
     zcopy.commitToRing(*m_pConsumer),
     std::logic_error
   );
-}
\ No newline at end of file
+}
+
+void zcopytest::nobodyheader()
+{
+  // Zero copy items without a body header:
+  
+  CAllButPredicate all;
+  CRingItem zcopy(PHYSICS_EVENT, 128, m_pProducer);
+  ASSERT(zcopy.m_fZeroCopy);
+  ASSERT(!zcopy.hasBodyHeader());
+  
+  uint32_t* p = static_cast<uint32_t*>(zcopy.getBodyCursor());
+  for (int i  = 0 ; i < 10; i++) {
+    *p++ = i;
+  }
+  zcopy.setBodyCursor(p);
+  zcopy.commitToRing(*m_pProducer);
+  
+  CRingItem* pGotten = CRingItem::getFromRing(*m_pConsumer, all);
+  EQ(
+    0,
+    memcmp(
+      zcopy.getItemPointer(), pGotten->getItemPointer(),
+      zcopy.getItemPointer()->s_header.s_size)
+  );
+  delete pGotten;
+}
+void zcopytest::oversize()
+{
+  // A maxBody that could never be reserved builds the item off the ring
+  // and commit puts it:
+
+  CAllButPredicate all;
+  size_t maxBody = m_pProducer->maxReserve();
+  CRingItem big(PHYSICS_EVENT, 0x1234, 1, 0, maxBody, m_pProducer);
+  ASSERT(!big.m_fZeroCopy);
+
+  uint32_t* p = static_cast<uint32_t*>(big.getBodyCursor());
+  for (int i  = 0 ; i < 10; i++) {
+    *p++ = i;
+  }
+  big.setBodyCursor(p);
+  big.commitToRing(*m_pProducer);
+
+  CRingItem* pGotten = CRingItem::getFromRing(*m_pConsumer, all);
+  EQ(
+    0,
+    memcmp(
+      big.getItemPointer(), pGotten->getItemPointer(),
+      big.getItemPointer()->s_header.s_size)
+  );
+  delete pGotten;
+}
@@ -64,3 +64,17 @@ CEventTrigger::operator()()	// = 0
 {
   return false;			// Null trigger.
 }
+/*!
+  Called after operator() reports a trigger to find out how many events
+  the hardware has buffered.  If this is more than one, the trigger loop
+  reads them as a batch via CExperiment::ReadEvents.
+
+  The default, supplied here, is one event per trigger.
+
+  \return unsigned - number of events to read for this trigger.
+*/
+unsigned
+CEventTrigger::eventCount()
+{
+  return 1;
+}
@@ -27,6 +27,10 @@
          override and implement oeprator() the function call operator that checks
 	 the trigger condition.
 
+   Triggers for hardware that buffers several events (e.g. a multi-event
+   FIFO) can override eventCount to report how many are ready.  The trigger loop
+   then reads them all as a batch which goes to the ring in one operation.
+
 */
 class CEventTrigger
 {
@@ -34,6 +38,7 @@ public:
   virtual void setup();
   virtual void teardown();
   virtual bool operator()() = 0;
+  virtual unsigned eventCount();
 };
 
 
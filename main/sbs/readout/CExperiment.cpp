@@ -43,6 +43,7 @@
 #include <TCLObject.h>
 #include <CBusy.h>
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <fragment.h>
 #include <os.h>
@@ -101,6 +102,7 @@ CExperiment::CExperiment(string ringName,
   m_pScalerTrigger(0),
   m_pTriggerLoop(0),
   m_nDataBufferSize(eventBufferSize),
+  m_nRingBytes(0),
   m_nDefaultSourceId(0),
   m_useBarriers(barriers),
   m_fWantZeroCopy(false),                // by default.
@@ -110,6 +112,7 @@ CExperiment::CExperiment(string ringName,
   try {
     m_pRing = CRingBuffer::createAndProduce(ringName);
     m_pRing->setPollInterval(0);
+    m_nRingBytes = m_pRing->getUsage().s_bufferSpace;
   } catch (CException& e) {
     std::cerr << "Could not attach ringbuffer : " << ringName << " "
       << e.ReasonText() << std::endl;
@@ -571,29 +574,7 @@ CExperiment::ReadEvent()
   // and put the resulting event in the ring buffer:
   //
   if (m_pReadout) {
-    do {
-      m_fHavemore = false;       // Read can set this true to do an other ringitem.
-      m_pReadout->keep();
-      m_needHeader = false;
-      m_nEventTimestamp = 0;
-      m_nSourceId  = m_nDefaultSourceId;
-      
-      if (m_fWantZeroCopy) {
-        CRingItem item(
-          PHYSICS_EVENT, 0, m_nSourceId, 0,
-          m_nDataBufferSize + 100, m_pRing
-        );
-        readEvent(item);    
-        
-      } else {
-        CRingItem item(PHYSICS_EVENT, m_nDataBufferSize + 100);
-        readEvent(item);
-        
-      }
-      m_pReadout->clear();	// do any post event clears.
-    } while(m_fHavemore);
-    
-
+    readEventItems();
   }
   if (m_pBusy) {
     m_pBusy->GoClear();
@@ -601,6 +582,88 @@ CExperiment::ReadEvent()
   // TODO: Need to keep track of trigger counts and from time to time emit a 
   //      trigger count item.
 }
+/*!
+   Reads a batch of events that the trigger says are buffered in the hardware.
+   Each event is read as for ReadEvent, but the ring items are built directly
+   in one reservation in the ring and committed together so consumers are
+   woken once per batch rather than once per event.  A reservation is
+   limited to a quarter of the ring so the batch never waits on a ring that
+   consumers can't drain, and larger batches are committed in pieces.  If
+   even one item would break that limit, the events are read as ReadEvent
+   does.  The busy is only cleared once the whole batch has been read.
+
+   \param nEvents - Number of events to read.
+*/
+void
+CExperiment::ReadEvents(unsigned nEvents)
+{
+  size_t itemSize = maxItemSize();
+  size_t maxBatch = std::min(m_nRingBytes/4, m_pRing->maxReserve());
+  if (m_pReadout && (itemSize > maxBatch)) {
+    for (unsigned i = 0; i < nEvents; i++) {
+      readEventItems();
+    }
+  } else if (m_pReadout) {
+    unsigned maxItems = maxBatch/itemSize;    // At least 1.
+
+    uint8_t* pRegion  = 0;
+    size_t   reserved = 0;
+    size_t   used     = 0;
+    for (unsigned i = 0; i < nEvents; i++) {
+      do {
+        m_fHavemore = false;
+        m_pReadout->keep();
+        m_needHeader = false;
+        m_nEventTimestamp = 0;
+        m_nSourceId  = m_nDefaultSourceId;
+
+        if ((reserved - used) < itemSize) {
+          if (pRegion) m_pRing->commit(used);
+          unsigned nItems = std::min(nEvents - i, maxItems);
+          reserved = nItems * itemSize;
+          pRegion  = reinterpret_cast<uint8_t*>(m_pRing->reserve(reserved));
+          used     = 0;
+        }
+        used += readEventInPlace(pRegion + used);
+        m_pReadout->clear();
+      } while (m_fHavemore);
+    }
+    if (pRegion) m_pRing->commit(used);
+  }
+  if (m_pBusy) {
+    m_pBusy->GoClear();
+  }
+}
+
+/*
+ * Read one event into as many ring items as the readout wants
+ * (see haveMore) and put them in the ring.
+ */
+void
+CExperiment::readEventItems()
+{
+  do {
+    m_fHavemore = false;       // Read can set this true to do an other ringitem.
+    m_pReadout->keep();
+    m_needHeader = false;
+    m_nEventTimestamp = 0;
+    m_nSourceId  = m_nDefaultSourceId;
+
+    if (m_fWantZeroCopy) {
+      CRingItem item(
+        PHYSICS_EVENT, 0, m_nSourceId, 0,
+        m_nDataBufferSize + 100, m_pRing
+      );
+      readEvent(item);
+
+    } else {
+      CRingItem item(PHYSICS_EVENT, m_nDataBufferSize + 100);
+      readEvent(item);
+
+    }
+    m_pReadout->clear();	// do any post event clears.
+  } while(m_fHavemore);
+}
 
 /*
  * Read the scalers.
@@ -959,6 +1022,63 @@ CExperiment::readEvent(CRingItem& item)
   }  
 }
 
+/**
+ * readEventInPlace
+ *    Read a physics event into a ring item built at a location in a ring
+ *    reservation.  The ring item is laid out exactly as readEvent does it.
+ *
+ * @param pItem - Where to build the item (must have maxItemSize() bytes).
+ * @return size_t - size of the ring item; 0 if the event was rejected.
+ */
+size_t
+CExperiment::readEventInPlace(uint8_t* pItem)
+{
+  pRingItem pRItem = reinterpret_cast<pRingItem>(pItem);
+  uint16_t* pBuffer =
+    reinterpret_cast<uint16_t*>(pRItem->s_body.u_noBodyHeader.s_body);
+
+  size_t nWords =
+    m_pReadout->read(pBuffer + 2, m_nDataBufferSize - sizeof(uint32_t));
+
+  m_statistics.s_cumulative.s_triggers++;
+  m_statistics.s_perRun.s_triggers++;
+
+  if (m_pReadout->getAcceptState() != CEventSegment::Keep) {
+    return 0;
+  }
+  *(reinterpret_cast<uint32_t*>(pBuffer)) = nWords + 2;
+  size_t nBytes = (nWords + 2)*sizeof(uint16_t);
+  size_t size;
+  if (m_needHeader) {
+    memmove(pRItem->s_body.u_hasBodyHeader.s_body, pBuffer, nBytes);
+    fillBodyHeader(pRItem, m_nEventTimestamp, m_nSourceId, 0);
+    size = sizeof(RingItemHeader) + sizeof(BodyHeader) + nBytes;
+  } else {
+    pRItem->s_body.u_noBodyHeader.s_empty = sizeof(uint32_t);
+    size = sizeof(RingItemHeader) + sizeof(uint32_t) + nBytes;
+  }
+  fillRingHeader(pRItem, size, PHYSICS_EVENT);
+  m_nEventsEmitted++;
+
+  m_statistics.s_cumulative.s_acceptedTriggers++;
+  m_statistics.s_perRun.s_acceptedTriggers++;
+  m_statistics.s_cumulative.s_bytes += nBytes;
+  m_statistics.s_perRun.s_bytes     += nBytes;
+
+  return size;
+}
+/**
+ * maxItemSize
+ *    The most bytes a physics event item can take; the same allowance
+ *    ReadEvent gives its ring items.
+ *
+ * @return size_t
+ */
+size_t
+CExperiment::maxItemSize() const
+{
+  return sizeof(RingItemHeader) + sizeof(BodyHeader) + m_nDataBufferSize + 100;
+}
 /**
  * clearCounters
  *    Given a reference to a set of statistics counters,
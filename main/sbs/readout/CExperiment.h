@@ -85,6 +85,7 @@ private:
   CTriggerLoop*          m_pTriggerLoop; //!< Thread that runs the trigger.
 
   size_t                 m_nDataBufferSize; //!< current event buffer size.
+  size_t                 m_nRingBytes;      //!< Data capacity of m_pRing.
 
   double                 m_nLastScalerTime; // last scaler time in ms since epoch (usually).
   uint64_t               m_nEventsEmitted;
@@ -138,6 +139,7 @@ public:
   void   setScalerTrigger(CEventTrigger* pScalerTrigger);
   void   EstablishBusy(CBusy*            pBusyModule);
   void   ReadEvent();
+  void   ReadEvents(unsigned nEvents);
   void   TriggerScalerReadout();
   void   DocumentPackets();
   void   ScheduleRunVariableDump();
@@ -155,7 +157,10 @@ public:
 	const Statistics& getStatistics() const {return m_statistics; } 
 private:
   void readScalers();
+  void readEventItems();
 	void readEvent(CRingItem& item);
+  size_t readEventInPlace(uint8_t* pItem);
+  size_t maxItemSize() const;
 	
   static int HandleEndRunEvent(Tcl_Event* evPtr, int flags);
   static int HandleTriggerLoopError(Tcl_Event* evPtr, int flags);
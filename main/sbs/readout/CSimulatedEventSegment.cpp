@@ -0,0 +1,72 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+#include <config.h>
+#include "CSimulatedEventSegment.h"
+#include <RangeError.h>
+#include <string.h>
+
+/*!
+   Construct the segment.
+   \param nWords     - Number of uint16_t's in each event (at least 4 for
+                       the event number).
+   \param timestamps - If true, each event is timestamped with its number.
+*/
+CSimulatedEventSegment::CSimulatedEventSegment(size_t nWords, bool timestamps) :
+  m_nWords(nWords < 4 ? 4 : nWords),
+  m_timestamps(timestamps),
+  m_nEvent(0)
+{}
+
+/*!
+   Restart the event numbering as data taking starts.
+*/
+void
+CSimulatedEventSegment::initialize()
+{
+  m_nEvent = 0;
+}
+/*!
+   Produce the next event.
+   \param pBuffer  - where the event goes.
+   \param maxwords - room in pBuffer.
+   \return size_t  - number of words read.
+   \throw CRangeError - the event is bigger than maxwords.
+*/
+size_t
+CSimulatedEventSegment::read(void* pBuffer, size_t maxwords)
+{
+  if (m_nWords > maxwords) {
+    throw CRangeError(0, maxwords, m_nWords, "Reading a simulated event");
+  }
+  uint16_t* p = reinterpret_cast<uint16_t*>(pBuffer);
+  memcpy(p, &m_nEvent, sizeof(m_nEvent));
+  for (size_t i = 4; i < m_nWords; i++) {
+    p[i] = i;
+  }
+  if (m_timestamps) {
+    setTimestamp(m_nEvent);
+  }
+  m_nEvent++;
+  return m_nWords;
+}
+/*!
+   \return uint64_t - number of events read since initialize.
+*/
+uint64_t
+CSimulatedEventSegment::eventCount() const
+{
+  return m_nEvent;
+}
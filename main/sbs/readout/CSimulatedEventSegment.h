@@ -0,0 +1,44 @@
+#ifndef CSIMULATEDEVENTSEGMENT_H
+#define CSIMULATEDEVENTSEGMENT_H
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#include "CEventSegment.h"
+
+/*!
+  An event segment that reads simulated data: a fixed number of 16 bit
+  words holding the event number followed by a counting pattern.
+  Optionally each event is given its event number as a timestamp so the
+  body header path is exercised too.  Use it with CSimulatedTrigger to
+  measure the readout overhead without hardware.
+*/
+class CSimulatedEventSegment : public CEventSegment
+{
+private:
+  size_t   m_nWords;
+  bool     m_timestamps;
+  uint64_t m_nEvent;
+
+public:
+  CSimulatedEventSegment(size_t nWords = 16, bool timestamps = false);
+
+  virtual void   initialize();
+  virtual size_t read(void* pBuffer, size_t maxwords);
+
+  uint64_t eventCount() const;
+};
+
+#endif
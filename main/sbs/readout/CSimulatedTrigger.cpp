@@ -0,0 +1,60 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+#include <config.h>
+#include "CSimulatedTrigger.h"
+
+/*!
+   Construct the trigger.
+   \param batchSize - Number of events reported per trigger (at least 1).
+*/
+CSimulatedTrigger::CSimulatedTrigger(unsigned batchSize) :
+  m_nBatchSize(batchSize ? batchSize : 1)
+{}
+
+/*!
+   Change the number of events reported per trigger.
+   \param batchSize - new batch size (0 is treated as 1).
+*/
+void
+CSimulatedTrigger::setBatchSize(unsigned batchSize)
+{
+  m_nBatchSize = batchSize ? batchSize : 1;
+}
+/*!
+   \return unsigned - the number of events reported per trigger.
+*/
+unsigned
+CSimulatedTrigger::getBatchSize() const
+{
+  return m_nBatchSize;
+}
+
+/*!
+   The simulated hardware always has events ready.
+*/
+bool
+CSimulatedTrigger::operator()()
+{
+  return true;
+}
+/*!
+   \return unsigned - the batch size.
+*/
+unsigned
+CSimulatedTrigger::eventCount()
+{
+  return m_nBatchSize;
+}
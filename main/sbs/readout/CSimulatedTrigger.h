@@ -0,0 +1,41 @@
+#ifndef CSIMULATEDTRIGGER_H
+#define CSIMULATEDTRIGGER_H
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Author:
+             Ron Fox
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#include <CEventTrigger.h>
+
+/*!
+  A trigger that always fires and reports a fixed number of buffered events
+  each time.  Paired with CSimulatedEventSegment it lets the readout
+  (batched or not) be benchmarked without any hardware.
+*/
+class CSimulatedTrigger : public CEventTrigger
+{
+private:
+  unsigned m_nBatchSize;
+
+public:
+  CSimulatedTrigger(unsigned batchSize = 1);
+
+  void     setBatchSize(unsigned batchSize);
+  unsigned getBatchSize() const;
+
+  virtual bool     operator()();
+  virtual unsigned eventCount();
+};
+
+#endif
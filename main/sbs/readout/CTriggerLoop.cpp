@@ -185,7 +185,12 @@ CTriggerLoop::mainLoop()
       for (int i =0; i < DWELL_COUNT; i++) {
         if ((*pEvent)()) {
 	  //std::cerr << "---- CTriggerLoop.cpp: event trigger received, reading event data ----" << std::endl;
-          m_pExperiment->ReadEvent();
+          unsigned nEvents = pEvent->eventCount();
+          if (nEvents > 1) {
+            m_pExperiment->ReadEvents(nEvents);
+          } else {
+            m_pExperiment->ReadEvent();
+          }
 
         }
         if ((*pScaler)()) {
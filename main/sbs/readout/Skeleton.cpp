@@ -83,6 +83,9 @@ CTCLApplication* gpTCLApplication = new Skeleton;
                      if you want a really high event rate.
    - CV262Trigger  - Uses the CAEN V262 as a trigger module.
    - CV977Trigger  - Uses the CAEN V977 as a trigger module.
+   - CSimulatedTrigger - Always true, reporting a settable number of buffered
+                     events per trigger.  With CSimulatedEventSegment this
+                     measures (batched) readout throughput without hardware.
 
    \param pExperiment - Pointer to the experiment object.
 
@@ -57,6 +57,8 @@ using namespace std;
 
 static const unsigned DRAINTIMEOUTS(5);	// # consecutive drain read timeouts before giving up.
 static const unsigned USBTIMEOUT(10);
+static const unsigned READAHEAD(4);     // Completed reads the reader can get ahead.
+static const int      COMMANDPOLL(100); // ms between command queue checks when idle.
 
 static const unsigned ReadoutStackNum(0);
 static const unsigned ScalerStackNum(1);
@@ -80,8 +82,10 @@ CAcquisitionThread* CAcquisitionThread::m_pTheInstance(0);
    important.
 */
 
-CAcquisitionThread::CAcquisitionThread() {
-
+CAcquisitionThread::CAcquisitionThread() :
+  m_pReader(0)
+{
+  m_pReader = new CUSBReader(*this, gFreeBuffers, READAHEAD, USBTIMEOUT*1000);
 }
  
 /*!
@@ -239,50 +243,37 @@ CAcquisitionThread::operator()()
 
 /*!
   The main loop is simply one that loops:
-  - Reading a buffer from the vm-usb and processing it if one comes in.
+  - Taking buffers the reader has read from the cc-usb and processing them.
+    The reader keeps the next read posted while we do this.
   - Checking for control commands and processing them if they come in.
 */
 void
 CAcquisitionThread::mainLoop()
 {
-  DataBuffer*     pBuffer   = gFreeBuffers.get();
   CControlQueues* pCommands = CControlQueues::getInstance(); 
-  try {
-    while (true) {
+  while (true) {
       
-      // Event data from the VM-usb.
-      if (m_Running) {
-	size_t bytesRead;
-	int status = m_pCamac->usbRead(pBuffer->s_rawData, pBuffer->s_storageSize,
-				       &bytesRead,
-				       USBTIMEOUT*1000 );
-	if (status == 0) {
-	  pBuffer->s_bufferSize = bytesRead;
-	  pBuffer->s_bufferType   = TYPE_EVENTS;
-	  processBuffer(pBuffer);	// Submitted to output thread so...
-	  pBuffer = gFreeBuffers.get(); // need a new one.
-	} 
-	else {
-	  if (errno != ETIMEDOUT) {
-      std::stringstream err;
-	    err << "Bad status from usbread: " << strerror(errno) << endl;
-	    err << "Ending the run .. check CAMAC crate.  If it tripped off ";
-	    err << " you'll need to restart this program\n";
-      throw err.str();
-	  }
-	}
-      // Commands from our command queue.
-      }
-      CControlQueues::opCode request;
-      bool   gotOne = pCommands->testRequest(request);
-      if (gotOne) {
-        processCommand(request);
+    // Event data from the CC-usb.
+    if (m_Running) {
+      DataBuffer* pBuffer = m_pReader->take(COMMANDPOLL);
+      if (pBuffer) {
+        processBuffer(pBuffer);	// Submitted to output thread.
+      } 
+      else if (m_pReader->getError()) {
+        std::stringstream err;
+        err << "Bad status from usbread: " << strerror(m_pReader->getError()) << endl;
+        err << "Ending the run .. check CAMAC crate.  If it tripped off ";
+        err << " you'll need to restart this program\n";
+        throw err.str();
       }
     }
-  }
-  catch (...) {
-    gFreeBuffers.queue(pBuffer);	// Don't lose buffers!!
-    throw;
+    // Commands from our command queue.
+
+    CControlQueues::opCode request;
+    bool   gotOne = pCommands->testRequest(request);
+    if (gotOne) {
+      processCommand(request);
+    }
   }
 }
 /*!
@@ -364,6 +355,43 @@ CAcquisitionThread::processBuffer(DataBuffer* pBuffer)
 
   gFilledBuffers.queue(pBuffer);	// Send it on to the output thread.
 }
+/*!
+  Stop the reader and process the buffers it read that we have not yet
+  taken so they come before any data drained from the CC-USB.
+*/
+void
+CAcquisitionThread::stopReader()
+{
+  m_pReader->stop();
+  DataBuffer* pBuffer;
+  while ((pBuffer = m_pReader->take(0))) {
+    processBuffer(pBuffer);
+  }
+}
+/*!
+  Read acquired data from the CC-USB into a buffer on behalf of the
+  reader, and set the buffer's size and type.  See CCCUSB::usbRead.
+*/
+int
+CAcquisitionThread::readBuffer(DataBuffer* pBuffer, size_t* pTransferred, int timeout)
+{
+  int status = m_pCamac->usbRead(
+    pBuffer->s_rawData, pBuffer->s_storageSize, pTransferred, timeout
+  );
+  if (status == 0) {
+    pBuffer->s_bufferSize = *pTransferred;
+    pBuffer->s_bufferType = TYPE_EVENTS;
+  }
+  return status;
+}
+/*!
+  \return CUSBReader::Statistics - the reader's statistics for this run.
+*/
+CUSBReader::Statistics
+CAcquisitionThread::getReaderStatistics()
+{
+  return m_pReader->getStatistics();
+}
 /*!
     startDaq start data acquisition from a standing stop. To do this we need to:
     - Emit a begin run buffer.
@@ -485,6 +513,8 @@ CAcquisitionThread::startDaq()
 void CAcquisitionThread::stopDaqImpl()
 {
   CTheApplication* pApp = CTheApplication::getInstance();
+    stopReader();
+    pApp->logProgress("USB reader stopped");
     int actionRegister = 0;
     if (m_haveScalerStack) {
       actionRegister |= CCCUSB::ActionRegister::scalerDump;
@@ -595,6 +625,7 @@ void
 CAcquisitionThread::CCusbToAutonomous()
 {
   m_pCamac->writeActionRegister(CCCUSB::ActionRegister::startDAQ);
+  m_pReader->start();
 }
 /*!
   Drain usb - We read buffers from the DAQ (with an extended timeout)
@@ -661,6 +692,7 @@ CAcquisitionThread::drainUsb()
 void
 CAcquisitionThread::beginRun()
 {
+  m_pReader->clearStatistics();
   DataBuffer* pBuffer   = gFreeBuffers.get();
   pBuffer->s_bufferSize = pBuffer->s_storageSize;
   pBuffer->s_bufferType = TYPE_START;
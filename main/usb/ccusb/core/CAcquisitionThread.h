@@ -23,6 +23,7 @@ using namespace std;		// required for spectrodaq includes.
 #include <vector>
 #include <string>
 #include "CControlQueues.h"
+#include "CUSBReader.h"
 
 #include <CSynchronizedThread.h>
 
@@ -41,7 +42,8 @@ struct DataBuffer;
    it gets started at the beginning of a run and politely requested to stop at
    the end of a run.
 */
-class CAcquisitionThread : public CSynchronizedThread
+class CAcquisitionThread : public CSynchronizedThread,
+                           public CUSBReader::Transport
 {
 private:
   static bool                   m_Running;	//!< thread is running.
@@ -50,6 +52,7 @@ private:
   bool                          m_haveScalerStack;
   bool                          m_reconnected;
   std:: string                  m_lastChecksum;
+  CUSBReader*                   m_pReader;      //!< Keeps reads posted.
   //Singleton pattern stuff:
 
 
@@ -72,12 +75,18 @@ public:
   void setReconnected(bool value) {
     m_reconnected = value;
   }
+  CUSBReader::Statistics getReaderStatistics();
+
+  // CUSBReader::Transport - reads go to the CC-USB:
+
+  virtual int readBuffer(DataBuffer* pBuffer, size_t* pTransferred, int timeout);
 protected:
   virtual void operator()();
 private:
   void mainLoop();
   void processCommand(CControlQueues::opCode command);
   void processBuffer(DataBuffer* pBuffer);
+  void stopReader();
   void startDaq();
 public:				// To allow exit handler to stop acquisition
   void stopDaq();
@@ -41,10 +41,13 @@
 #include <CRingTextItem.h>
 #include <dlfcn.h>
 #include <CStack.h>
+#include <DataFormat.h>
+#include <CWorkerPool.h>
 
 #include <fragment.h>
 
 #include <sys/time.h>
+#include <thread>
 
 
 using namespace std;
@@ -58,6 +61,23 @@ static uint64_t bufferNumber(0);
 
 static unsigned BUFFERS_BETWEEN_STATS(64);
 
+static const unsigned MAX_BUILDERS(4);          // Threads that build event ring items.
+static const size_t   PARALLEL_MINBYTES(16384); // Smaller batches are built serially.
+
+/*
+   Threads used to build event ring items: half the processors (the
+   reader, acquisition and Tcl server threads need the rest) but no more
+   than MAX_BUILDERS.
+*/
+static unsigned
+builderThreads()
+{
+  unsigned n = std::thread::hardware_concurrency()/2;
+  if (n < 1) n = 1;
+  if (n > MAX_BUILDERS) n = MAX_BUILDERS;
+  return n;
+}
+
 ////////////////////////////////////////////////////////////////////////
 //   mytimersub - since BSD timeval is not the same as POSIX timespec:
 ////////////////////////////////////////////////////////////////////////
@@ -103,13 +123,18 @@ COutputThread::COutputThread(const char* pRing, CSystemControl& sysControl) :
   m_pRing(0),
   m_pBuffer(0),
   m_pCursor(0),
+  m_nWordsInBuffer(0),
   m_nEventsSeen(0),
   m_pEvtTimestampExtractor(0),
   m_pSclrTimestampExtractor(0),
   m_pBeginRunCallback(nullptr),
-  m_systemControl(sysControl)
+  m_fParallelTimestamps(false),
+  m_systemControl(sysControl),
+  m_nPendingBytes(0),
+  m_nMaxBatchBytes(0),
+  m_pBuilders(0)
 {
-  
+  m_pBuilders = new CWorkerPool(builderThreads());
 }
 /*!
   Destruction is a no-op at this time.
@@ -117,6 +142,7 @@ COutputThread::COutputThread(const char* pRing, CSystemControl& sysControl) :
 COutputThread::~COutputThread()
 {
   delete m_pRing;
+  delete m_pBuilders;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -605,6 +631,8 @@ COutputThread::events(DataBuffer& inBuffer)
     nEvents--;
   }
 
+  flushEvents();
+
   // I've seen the CCUSB hand me a bogus event count...but never a bogus
   // buffer word count.  This is non fatal but reported.
 
@@ -628,9 +656,11 @@ COutputThread::newOutputBuffer()
 /**
 /**
  * Process a single event:
- * - If necessary create the event assembly buffer and initialize its
- *   cursor.
- * - Put the segment in the event assembly buffer.
+ * - If this is a complete event (no continuation and nothing assembled yet)
+ *   it's queued to have its ring item built directly from the CCUSB
+ *   buffer (see flushEvents); this is the usual case.
+ * - Otherwise, if necessary create the event assembly buffer and initialize its
+ *   cursor and put the segment in the event assembly buffer.
  * - If there is a continuation segment we're done for now..as we'll get called again with the next
  *   segment
  * - If there is no continuation segment then we create and submit the output
@@ -646,14 +676,6 @@ COutputThread::newOutputBuffer()
 void 
 COutputThread::event(void* pData)
 {
-  // If necessary make an new output buffer
-
-  if (!m_pBuffer) {
-    m_pBuffer        = newOutputBuffer();
-    m_pCursor        = m_pBuffer;
-    m_nWordsInBuffer = 0;	  
-  }
-
   // Initialize the pointers to event bits and pieces.
 
   uint16_t* pSegment = reinterpret_cast<uint16_t*>(pData);
@@ -664,9 +686,26 @@ COutputThread::event(void* pData)
   size_t segmentSize = header & CCUSBEventLengthMask;
   bool   haveMore    = (header & CCUSBContinuation) != 0;
   
+  segmentSize += 1;		// Size is not self inclusive
+
+  // A single segment event needs no assembly.  It's built from where it
+  // is in the CCUSB buffer along with the rest of the buffer's events:
+
+  if (!haveMore && (m_nWordsInBuffer == 0)) {
+    queueEvent(pData, segmentSize);
+    return;
+  }
+
+  // If necessary make an new output buffer
+
+  if (!m_pBuffer) {
+    m_pBuffer        = newOutputBuffer();
+    m_pCursor        = m_pBuffer;
+    m_nWordsInBuffer = 0;	  
+  }
+
   // Events must currently fit in the buffer...otherwise we throw an error.
 
-  segmentSize += 1;		// Size is not self inclusive
   if ((segmentSize + m_nWordsInBuffer) >= m_nOutputBufferSize/sizeof(uint16_t)) {
     std::string msg = 
       "An event would not fit in the output buffer, adjust bufferMultiplier in your config file";
@@ -685,47 +724,153 @@ COutputThread::event(void* pData)
   // If that was the last segment submit it and reset cursors and counters.
 
   if (!haveMore) {			    // Ending segment:
-    
-    // Note that if we were given a timestamp extractor we create event
-    // with the timestamp otherwise we create it with a null body header.
-    
-    CRingItem* pEvent;
-    
-    
-    if (m_pEvtTimestampExtractor) {
-        pEvent = new CRingItem(
-            PHYSICS_EVENT, m_pEvtTimestampExtractor(m_pBuffer), Globals::sourceId,
-            0, m_nWordsInBuffer*sizeof(uint16_t) + 100
-        );
-    } else {
-        pEvent = new CRingItem(
-            PHYSICS_EVENT, m_nWordsInBuffer*sizeof(uint16_t) + 100
-        ); // +100 really needed?
-    }
-    CRingItem& event(*pEvent);
-    
-    // Put the data in the event and figure out where the end pointer is.
-
-    void* pDest = event.getBodyPointer();
-    memcpy(pDest, m_pBuffer, m_nWordsInBuffer*sizeof(uint16_t));
-    uint8_t* pEnd = reinterpret_cast<uint8_t*>(pDest);
-    pEnd += m_nWordsInBuffer*sizeof(uint16_t); // Where the new body cursor goes.
-
-    event.setBodyCursor(pEnd);
-    event.updateSize();
-    event.commitToRing(*m_pRing);
-
-    delete pEvent;
+    flushEvents();                          // Events before this one go first.
+    emitEvent(m_pBuffer, m_nWordsInBuffer);
 
     // Reset the cursor and word count in the assembly buffer:
 
     m_nWordsInBuffer = 0;
     m_pCursor        = m_pBuffer;
-    
-    m_nEventsSeen++;
   }
 
 }
+/**
+ * emitEvent
+ *    Build a physics event ring item directly in ring memory (see
+ *    CRingBuffer::reserve) and commit it.  Events queued by queueEvent
+ *    must have been flushed first.
+ *
+ * @param pEvent - Pointer to the complete event.
+ * @param nWords - Number of uint16_t's in the event.
+ *
+ * @throws std::string - Errors from the ring buffer classes.
+ */
+void
+COutputThread::emitEvent(void* pEvent, size_t nWords)
+{
+  size_t itemSize = eventItemSize(nWords);
+  void*  pItem    = m_pRing->reserve(itemSize);
+  buildEvent(pItem, pEvent, nWords, eventTimestamp(pEvent));
+  m_pRing->commit(itemSize);
+
+  m_nEventsSeen++;
+}
+/**
+ * queueEvent
+ *    Add a complete event to the batch whose ring items are built in
+ *    parallel by flushEvents.  The event must stay where it is until
+ *    the batch is flushed.
+ *
+ * @param pEvent - Pointer to the complete event.
+ * @param nWords - Number of uint16_t's in the event.
+ */
+void
+COutputThread::queueEvent(void* pEvent, size_t nWords)
+{
+  size_t itemSize = eventItemSize(nWords);
+  if (!m_pending.empty() && (m_nPendingBytes + itemSize > m_nMaxBatchBytes)) {
+    flushEvents();
+  }
+  uint64_t timestamp = m_fParallelTimestamps ? 0 : eventTimestamp(pEvent);
+  PendingEvent e = {pEvent, nWords, m_nPendingBytes, timestamp};
+  m_pending.push_back(e);
+  m_nPendingBytes += itemSize;
+}
+/**
+ * flushEvents
+ *    Put the queued events in the ring:
+ *    - Space for all of their ring items is reserved in the ring at once.
+ *      Each item's place in the reservation was fixed when it was queued.
+ *    - The builder threads build the items (copying the event data and
+ *      the timestamps queueEvent extracted, or extracting them if the
+ *      extractor is reentrant) in their places, in parallel.  Small
+ *      batches aren't worth handing out and are built here.
+ *    - The reservation is committed, publishing the items in the order
+ *      they were queued.
+ *
+ * @throws std::string - Errors from the ring buffer classes.
+ */
+void
+COutputThread::flushEvents()
+{
+  if (m_pending.empty()) return;
+
+  uint8_t* pBatch = reinterpret_cast<uint8_t*>(m_pRing->reserve(m_nPendingBytes));
+  CWorkerPool::Work build = [this, pBatch](size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+      const PendingEvent& e(m_pending[i]);
+      uint64_t timestamp = m_fParallelTimestamps ?
+        eventTimestamp(e.s_pEvent) : e.s_timestamp;
+      buildEvent(pBatch + e.s_offset, e.s_pEvent, e.s_nWords, timestamp);
+    }
+  };
+  if (m_nPendingBytes >= PARALLEL_MINBYTES) {
+    m_pBuilders->run(m_pending.size(), build);
+  } else {
+    build(0, m_pending.size());
+  }
+  m_pRing->commit(m_nPendingBytes);
+
+  m_nEventsSeen  += m_pending.size();
+  m_pending.clear();
+  m_nPendingBytes = 0;
+}
+/**
+ * eventItemSize
+ *
+ * @param nWords  - Number of uint16_t's in an event.
+ * @return size_t - Size of the ring item that holds the event.
+ */
+size_t
+COutputThread::eventItemSize(size_t nWords)
+{
+  return sizeof(RingItemHeader) + nWords*sizeof(uint16_t) +
+    (m_pEvtTimestampExtractor ? sizeof(BodyHeader) : sizeof(uint32_t));
+}
+/**
+ * eventTimestamp
+ *    Run the user's timestamp extractor, if there is one, on an event.
+ *    The extractor is user code that need not be reentrant, so this is
+ *    only called from the builder threads if m_fParallelTimestamps.
+ *
+ * @param pEvent    - Pointer to the complete event.
+ * @return uint64_t - The event's timestamp (0 if there's no extractor).
+ */
+uint64_t
+COutputThread::eventTimestamp(void* pEvent)
+{
+  return m_pEvtTimestampExtractor ? m_pEvtTimestampExtractor(pEvent) : 0;
+}
+/**
+ * buildEvent
+ *    Build the physics event ring item for an event.  If we were given a
+ *    timestamp extractor the item has a body header with the timestamp
+ *    otherwise it has none.  This runs in the builder threads, so it
+ *    touches nothing but the item and the event.
+ *
+ * @param pItem  - Where to build the item (eventItemSize bytes).
+ * @param pEvent - Pointer to the complete event.
+ * @param nWords - Number of uint16_t's in the event.
+ * @param timestamp - Event timestamp (see eventTimestamp).
+ */
+void
+COutputThread::buildEvent(
+  void* pItem, void* pEvent, size_t nWords, uint64_t timestamp
+)
+{
+  pRingItem pRItem = reinterpret_cast<pRingItem>(pItem);
+  void*     pBody;
+  if (m_pEvtTimestampExtractor) {
+    pBody = fillBodyHeader(
+      pRItem, timestamp, Globals::sourceId, 0
+    );
+  } else {
+    pRItem->s_body.u_noBodyHeader.s_empty = sizeof(uint32_t);
+    pBody = pRItem->s_body.u_noBodyHeader.s_body;
+  }
+  memcpy(pBody, pEvent, nWords*sizeof(uint16_t));
+  fillRingHeader(pRItem, eventItemSize(nWords), PHYSICS_EVENT);
+}
 
 
 /**
@@ -742,6 +887,11 @@ COutputThread::attachRing()
 {
   try {
     m_pRing = CRingBuffer::createAndProduce(m_ringName);
+
+    // Batches are published all at once so keep them small relative
+    // to the ring:
+
+    m_nMaxBatchBytes = m_pRing->getUsage().s_bufferSpace/4;
   } catch (CException& e) {
     std::cerr << "Unable to attach ring buffer  " << m_ringName << " "
       << e.ReasonText() << std::endl;
@@ -856,6 +1006,15 @@ COutputThread::getTimestampExtractor()
             exit(EXIT_FAILURE);
         }
         m_pBeginRunCallback = reinterpret_cast<StateChangeCallback>(dlsym(pDllHandle, "onBeginRun"));
+
+        // The builder threads can extract timestamps if the library
+        // says getEventTimestamp is reentrant:
+
+        void* pReentrant = dlsym(pDllHandle, "eventTimestampIsReentrant");
+        if (pReentrant && m_pEvtTimestampExtractor) {
+            m_fParallelTimestamps =
+                (*reinterpret_cast<ReentrancyQuery>(pReentrant))() != 0;
+        }
         dlclose(pDllHandle);
         
     }
@@ -23,6 +23,7 @@ using namespace std;
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 // Forward definitions:
 
@@ -30,6 +31,7 @@ struct DataBuffer;
 typedef struct _StringsBuffer StringsBuffer;
 class CRingBuffer;
 class CSystemControl;
+class CWorkerPool;
 
 /*!
     This class bridges the gap between the buffer format of the
@@ -71,12 +73,19 @@ class CSystemControl;
        the VMUSB.
 
  \note  This class is a separate thread of execution.
- \note  A global variable: gFilledBuffers is a CBufferQueue that contains
+ \note  A global variable: gFilledBuffers is a CRingQueue that contains
         the data shown above and is used to receive raw data buffers from
 	the readout thread.
   \note There is no need to start/stop thread each run.   Once a run is over,
         this thread will simply block on the buffer queue until the next run
         emits the begin run buffer.
+  \note The events of a buffer are built into ring items by a pool
+        of builder threads.  This thread scans the buffer for events and
+        reserves ring space for them in order; the builders copy the events
+        into the items and the items are committed in the order of the
+        buffer.  The timestamp extractor is called by this thread unless
+        its library says it is reentrant (eventTimestampIsReentrant), in
+        which case the builders call it.
 */
 
 class COutputThread  : public CSynchronizedThread
@@ -85,6 +94,14 @@ class COutputThread  : public CSynchronizedThread
   
   typedef uint64_t (*TimestampExtractor)(void*);
   typedef void      (*StateChangeCallback)();
+  typedef int       (*ReentrancyQuery)();
+
+  typedef struct _PendingEvent {
+    void*    s_pEvent;          // Complete event in the CCUSB buffer.
+    size_t   s_nWords;          // uint16_t's in the event.
+    size_t   s_offset;          // Offset to its ring item in the batch.
+    uint64_t s_timestamp;       // From the timestamp extractor if any.
+  } PendingEvent;
   
   // Thread local data:
 private:
@@ -114,7 +131,15 @@ private:
   TimestampExtractor m_pEvtTimestampExtractor;
   TimestampExtractor m_pSclrTimestampExtractor;
   StateChangeCallback m_pBeginRunCallback;
+  bool        m_fParallelTimestamps;  // Builders call m_pEvtTimestampExtractor.
   CSystemControl&   m_systemControl;
+
+  // Events whose ring items are built in parallel (see flushEvents):
+
+  std::vector<PendingEvent> m_pending;
+  size_t       m_nPendingBytes;     // Ring item bytes for m_pending.
+  size_t       m_nMaxBatchBytes;    // Most bytes in a batch.
+  CWorkerPool* m_pBuilders;         // Threads that build ring items.
   
   // Constuctors and other canonicals.
 
@@ -156,6 +181,12 @@ private:
 
  
   void event(void* pData);
+  void emitEvent(void* pEvent, size_t nWords);
+  void queueEvent(void* pEvent, size_t nWords);
+  void flushEvents();
+  size_t eventItemSize(size_t nWords);
+  uint64_t eventTimestamp(void* pEvent);
+  void buildEvent(void* pItem, void* pEvent, size_t nWords, uint64_t timestamp);
 
   void attachRing();
   uint8_t* newOutputBuffer();
@@ -13,6 +13,9 @@
 	     Michigan State University
 	     East Lansing, MI 48824-1321
 */
+#ifndef DATABUFFER_H
+#define DATABUFFER_H
+
 #ifndef __CRT_STDINT_H
 #include <stdint.h>
 #ifndef __CRT_STDINT_H
@@ -34,8 +37,8 @@
 #endif
 #endif
 
-#ifndef __CBUFFERQUEUE_h
-#include <CBufferQueue.h>
+#ifndef CRINGQUEUE_H
+#include <CRingQueue.h>
 #endif
 
 /*!
@@ -69,8 +72,13 @@ struct DataBuffer {
 };
 
 
-extern CBufferQueue<DataBuffer*>  gFilledBuffers;
-extern CBufferQueue<DataBuffer*>  gFreeBuffers;
+// The buffer pool is small and fixed so the lock free CRingQueue is used.
+// Its capacity must be at least the number of buffers in the pool.
+
+typedef CRingQueue<DataBuffer*> DataBufferQueue;
+
+extern DataBufferQueue  gFilledBuffers;
+extern DataBufferQueue  gFreeBuffers;
 
 //  A couple of useful unbound functions:
 
@@ -98,3 +106,5 @@ static const int TYPE_EVENTS(3);
 static const int TYPE_STRINGS(4);
 static const int TYPE_PAUSE(5);           // Pause/resume for Bug #5882
 static const int TYPE_RESUME(6);
+
+#endif
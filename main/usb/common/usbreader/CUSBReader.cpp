@@ -0,0 +1,235 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CUSBReader.cpp
+ *  @brief: Implement the pipelined reader of acquired data.
+ */
+#include "CUSBReader.h"
+
+#include <chrono>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+// How long to wait for the acquisition thread to catch up before
+// looking again.
+
+static const std::chrono::microseconds CATCHUPPOLL(200);
+
+// ms to wait for a free buffer before checking for a stop:
+
+static const int FREEBUFFERWAIT(100);
+
+/**
+ * constructor
+ *
+ * @param transport   - gets data from the device.
+ * @param freeBuffers - queue of empty buffers to read into.
+ * @param depth       - most completed buffers waiting to be taken.
+ * @param timeout     - ms timeout for each read.
+ */
+CUSBReader::CUSBReader(
+  Transport& transport, DataBufferQueue& freeBuffers, unsigned depth, int timeout
+) :
+  m_transport(transport), m_freeBuffers(freeBuffers),
+  m_completed(depth ? depth : 1), m_depth(depth ? depth : 1),
+  m_timeout(timeout), m_stopping(false), m_running(false), m_errno(0),
+  m_startedAt(0.0)
+{
+  clearStatistics();
+}
+/**
+ * destructor
+ *    Stop the reader and give back the buffers nobody took.
+ */
+CUSBReader::~CUSBReader()
+{
+  stop();
+  discardCompleted();
+}
+
+/**
+ * start
+ *    Start reading.  Buffers left from an earlier start that have not
+ *    been taken are still delivered, in order, ahead of the new ones.
+ */
+void
+CUSBReader::start()
+{
+  if (m_running) return;
+  if (m_thread.joinable()) {
+    m_thread.join();                   // Reader that stopped on an error.
+  }
+  m_stopping  = false;
+  m_errno     = 0;
+  {
+    std::lock_guard<std::mutex> guard(m_statsLock);
+    m_startedAt = now();
+    m_running   = true;
+  }
+  m_thread = std::thread(&CUSBReader::readLoop, this);
+}
+/**
+ * stop
+ *    Stop reading.  This waits for a transfer in progress to complete.
+ *    Completed buffers stay queued for take so data isn't lost.
+ */
+void
+CUSBReader::stop()
+{
+  m_stopping = true;
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+/**
+ * take
+ *    Get the next completed buffer.
+ *
+ * @param timeout - ms to wait for one.
+ * @return DataBuffer* - the buffer (s_bufferSize and s_bufferType are set)
+ *                       or null if none arrived in time.  If the reader
+ *                       has failed, getError then returns the errno.
+ */
+DataBuffer*
+CUSBReader::take(int timeout)
+{
+  Completion c;
+  if (!m_completed.getnow(c)) {
+    if (timeout <= 0) return 0;
+    m_completed.wait(timeout);
+    if (!m_completed.getnow(c)) return 0;
+  }
+  double latency = now() - c.s_completedAt;
+
+  std::lock_guard<std::mutex> guard(m_statsLock);
+  m_stats.s_latencySum += latency;
+  if (latency > m_stats.s_maxLatency) m_stats.s_maxLatency = latency;
+
+  return c.s_pBuffer;
+}
+/**
+ * getStatistics
+ *
+ * @return Statistics - snapshot of the statistics.  The run time includes
+ *                      the current run of the reader.
+ */
+CUSBReader::Statistics
+CUSBReader::getStatistics()
+{
+  std::lock_guard<std::mutex> guard(m_statsLock);
+  Statistics result = m_stats;
+  if (m_running) {
+    result.s_runTime += now() - m_startedAt;
+  }
+  return result;
+}
+/**
+ * clearStatistics
+ *    Zero the statistics (e.g. at the start of a run).
+ */
+void
+CUSBReader::clearStatistics()
+{
+  std::lock_guard<std::mutex> guard(m_statsLock);
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_startedAt = now();
+}
+
+/*---------------------------------------------------------------------------
+ * Private methods:
+ */
+
+/**
+ * readLoop
+ *    Reader thread: keep a read posted until told to stop or a read fails
+ *    with something other than a timeout.
+ */
+void
+CUSBReader::readLoop()
+{
+  while (!m_stopping) {
+
+    // Don't get more than the depth ahead of the acquisition thread:
+
+    if (m_completed.size() >= m_depth) {
+      std::this_thread::sleep_for(CATCHUPPOLL);
+      continue;
+    }
+    DataBuffer* pBuffer;
+    if (!m_freeBuffers.getnow(pBuffer)) {
+      m_freeBuffers.wait(FREEBUFFERWAIT);
+      continue;
+    }
+
+    size_t nRead;
+    double posted = now();
+    int    status = m_transport.readBuffer(pBuffer, &nRead, m_timeout);
+    int    reason = errno;
+    double done   = now();
+    {
+      std::lock_guard<std::mutex> guard(m_statsLock);
+      m_stats.s_readTime += done - posted;
+      if (status == 0) {
+        m_stats.s_buffers++;
+        m_stats.s_bytes += nRead;
+      } else if (reason == ETIMEDOUT) {
+        m_stats.s_timeouts++;
+      }
+    }
+
+    if (status == 0) {
+      Completion c = {pBuffer, done};
+      m_completed.queue(c);            // Depth check means there's room.
+    } else {
+      m_freeBuffers.queue(pBuffer);
+      if (reason != ETIMEDOUT) {
+        m_errno = reason;
+        break;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(m_statsLock);
+    m_stats.s_runTime += now() - m_startedAt;
+    m_running = false;
+  }
+  m_completed.wake();                  // A take waiting for data may care.
+}
+/**
+ * discardCompleted
+ *    Return completed buffers that were never taken to the free queue.
+ */
+void
+CUSBReader::discardCompleted()
+{
+  Completion c;
+  while (m_completed.getnow(c)) {
+    m_freeBuffers.queue(c.s_pBuffer);
+  }
+}
+/**
+ * now
+ *    @return double - monotonic clock in seconds.
+ */
+double
+CUSBReader::now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
@@ -0,0 +1,132 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CUSBReader.h
+ *  @brief: Keeps a bulk read of acquired data posted to the controller.
+ */
+#ifndef CUSBREADER_H
+#define CUSBREADER_H
+
+#include <CRingQueue.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// The VM-USB and CC-USB each have their own DataBuffer; the reader only
+// passes pointers to them around:
+
+struct DataBuffer;
+typedef CRingQueue<DataBuffer*> DataBufferQueue;
+
+/**
+ * @class CUSBReader
+ *    Pipelines the reads of acquired data from the controller.  A reader
+ *    thread takes buffers from the free buffer queue and reads into them,
+ *    posting the next read as soon as one completes.  Completed buffers are
+ *    queued for the acquisition thread which time stamps and routes them
+ *    (and handles control requests) while the next transfer is already
+ *    under way, so the bus isn't left idle between transfers.
+ *
+ *    The controller is reached through the abstract Transport so the reader
+ *    can be run against a simulated device.  The Transport also fills in
+ *    the buffers, so the reader works with either controller's DataBuffer.  The controller classes use
+ *    libusb-0.1 whose bulk reads are synchronous, so there's one transfer
+ *    in flight at a time; the depth is the number of completed buffers that
+ *    can wait for the acquisition thread before the reader stops posting
+ *    reads.
+ *
+ *    The reader also measures how long buffers wait between the end of their
+ *    transfer and being taken (latency) and the fraction of the time it runs
+ *    that a transfer is posted (bus utilization).
+ */
+class CUSBReader
+{
+public:
+  /**
+   * Interface to the device.  readBuffer reads into a buffer and, on
+   * success, sets its size and type (TYPE_EVENTS).  It returns what the
+   * controller usbRead methods do: 0 on success, else -1 with the reason
+   * in errno (ETIMEDOUT if no data arrived in time).
+   */
+  class Transport {
+  public:
+    virtual ~Transport() {}
+    virtual int readBuffer(
+      DataBuffer* pBuffer, size_t* pTransferred, int timeout
+    ) = 0;
+  };
+
+  typedef struct _Statistics {
+    uint64_t s_buffers;         // Buffers read.
+    uint64_t s_bytes;           // Bytes read.
+    uint64_t s_timeouts;        // Reads that timed out.
+    double   s_latencySum;      // Seconds from transfer end to take, summed.
+    double   s_maxLatency;      // Worst of those.
+    double   s_readTime;        // Seconds a transfer was posted.
+    double   s_runTime;         // Seconds the reader was running.
+  } Statistics;
+
+private:
+  typedef struct _Completion {
+    DataBuffer* s_pBuffer;
+    double      s_completedAt;
+  } Completion;
+
+  Transport&              m_transport;
+  DataBufferQueue&        m_freeBuffers;
+  CRingQueue<Completion>  m_completed;
+  unsigned                m_depth;
+  int                     m_timeout;
+  std::thread             m_thread;
+  std::atomic<bool>       m_stopping;
+  std::atomic<bool>       m_running;
+  std::atomic<int>        m_errno;
+  std::mutex              m_statsLock;
+  Statistics              m_stats;
+  double                  m_startedAt;
+
+public:
+  CUSBReader(
+    Transport& transport, DataBufferQueue& freeBuffers,
+    unsigned depth = 4, int timeout = 2000
+  );
+  virtual ~CUSBReader();
+
+private:
+  CUSBReader(const CUSBReader&);
+  CUSBReader& operator=(const CUSBReader&);
+
+public:
+  void        start();
+  void        stop();
+  bool        isRunning() const { return m_running; }
+  DataBuffer* take(int timeout);
+  int         getError() const { return m_errno; }
+
+  Statistics  getStatistics();
+  void        clearStatistics();
+
+private:
+  void   readLoop();
+  void   discardCompleted();
+  static double now();
+};
+
+#endif
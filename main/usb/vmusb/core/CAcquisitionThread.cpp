@@ -63,6 +63,9 @@ static const unsigned ScalerStackNum(1);
 
 static const unsigned HungCount(3); // Hung if HungCount * USBTimeout seconds without data.
 
+static const unsigned READAHEAD(4);     // Completed reads the reader can get ahead.
+static const int      COMMANDPOLL(100); // ms between command queue checks when idle.
+
 
 // buffer types:
 //
@@ -82,8 +85,10 @@ unsigned long CAcquisitionThread::m_tid; // Thread id of the running thread.
   important.
  */
 
-CAcquisitionThread::CAcquisitionThread() {
-
+CAcquisitionThread::CAcquisitionThread() :
+  m_pReader(0)
+{
+  m_pReader = new CUSBReader(*this, gFreeBuffers, READAHEAD, USBTIMEOUT);
 }
 
 /*!
@@ -258,66 +263,36 @@ void CAcquisitionThread::operator()()
 
 /*!
   The main loop is simply one that loops:
-  - Reading a buffer from the vm-usb and processing it if one comes in.
+  - Taking buffers the reader has read from the vm-usb and processing them.
+    The reader keeps the next read posted while we do this.
   - Checking for control commands and processing them if they come in.
  */
   void
 CAcquisitionThread::mainLoop()
 {
-  DataBuffer*     pBuffer   = gFreeBuffers.get();
   CControlQueues* pCommands = CControlQueues::getInstance();
   CTheApplication* pApp = CTheApplication::getInstance();
   pApp->logProgress("Acquisition main loop started");
-  try {
-    unsigned int consecutiveTimeouts = 0;
-    while (true) {
-
-      // Event data from the VM-usb.
-
-      size_t bytesRead;
-      int status = m_pVme->usbRead(pBuffer->s_rawData, pBuffer->s_storageSize,
-          &bytesRead,
-          USBTIMEOUT );
-      if (status == 0) {
-        consecutiveTimeouts = 0;
-        pBuffer->s_bufferSize = bytesRead;
-        pBuffer->s_bufferType   = TYPE_EVENTS;
-        processBuffer(pBuffer); // Submitted to output thread so...
-        pBuffer = gFreeBuffers.get(); // need a new one.
-      } 
-      else {
-        if (errno != ETIMEDOUT) {
-          cerr << "Bad status from usbread: " << strerror(errno) << endl;
-          cerr << "Ending the run... check the VME Crate.. If it power cycled restart this program\n";
-          throw 1;
-        }
-
-        consecutiveTimeouts++;
-        // 
-        // The VM-USB can drop out of data taking mode.
-        // in that case all our reads will time out.
-        // so if we have a bunch of of timeouts in a row, restart the VM-USB
-
-        if((consecutiveTimeouts > HungCount) && 0) { // disable hung reset.
-          cerr << "Looks like VM-USB may be hung.. attempting to restart\n";
-          stopDaq();
-          startDaq();
-          consecutiveTimeouts = 0;
-
-        }
-      }
-      // Commands from our command queue.
+  while (true) {
 
-      CControlQueues::opCode request;
-      bool   gotOne = pCommands->testRequest(request);
-      if (gotOne) {
-        processCommand(request);
-      }
+    // Event data from the VM-usb.
+
+    DataBuffer* pBuffer = m_pReader->take(COMMANDPOLL);
+    if (pBuffer) {
+      processBuffer(pBuffer); // Submitted to output thread.
+    }
+    else if (m_pReader->getError()) {
+      cerr << "Bad status from usbread: " << strerror(m_pReader->getError()) << endl;
+      cerr << "Ending the run... check the VME Crate.. If it power cycled restart this program\n";
+      throw 1;
+    }
+    // Commands from our command queue.
+
+    CControlQueues::opCode request;
+    bool   gotOne = pCommands->testRequest(request);
+    if (gotOne) {
+      processCommand(request);
     }
-  }
-  catch (...) {
-    gFreeBuffers.queue(pBuffer);  // Don't lose buffers!!
-    throw;
   }
   pApp->logProgress("Application main loope exiting");
 }
@@ -409,6 +384,43 @@ CAcquisitionThread::processBuffer(DataBuffer* pBuffer)
     gFilledBuffers.queue(pBuffer);  // Send it on to be routed to spectrodaq in another thread.
   }
 }
+/*!
+  Stop the reader and process the buffers it read that we have not yet
+  taken so they come before any data drained from the VM-USB.
+ */
+  void
+CAcquisitionThread::stopReader()
+{
+  m_pReader->stop();
+  DataBuffer* pBuffer;
+  while ((pBuffer = m_pReader->take(0))) {
+    processBuffer(pBuffer);
+  }
+}
+/*!
+  Read acquired data from the VM-USB into a buffer on behalf of the
+  reader, and set the buffer's size and type.  See CVMUSB::usbRead.
+ */
+  int
+CAcquisitionThread::readBuffer(DataBuffer* pBuffer, size_t* pTransferred, int timeout)
+{
+  int status = m_pVme->usbRead(
+    pBuffer->s_rawData, pBuffer->s_storageSize, pTransferred, timeout
+  );
+  if (status == 0) {
+    pBuffer->s_bufferSize = *pTransferred;
+    pBuffer->s_bufferType = TYPE_EVENTS;
+  }
+  return status;
+}
+/*!
+  \return CUSBReader::Statistics - the reader's statistics for this run.
+ */
+  CUSBReader::Statistics
+CAcquisitionThread::getReaderStatistics()
+{
+  return m_pReader->getStatistics();
+}
 /*!
   startDaq start data acquisition from a standing stop. To do this we need to:
   - Emit a begin run buffer.
@@ -550,6 +562,8 @@ CAcquisitionThread::startDaq()
   void CAcquisitionThread::stopDaqImpl()
   {
     CTheApplication* pApp = CTheApplication::getInstance();
+      stopReader();
+      pApp->logProgress("USB reader stopped");
     
       if (m_haveScalerStack) {
           m_pVme->writeActionRegister(CVMUSB::ActionRegister::scalerDump);
@@ -673,6 +687,7 @@ CAcquisitionThread::VMusbToAutonomous()
     CRunState* pState = CRunState::getInstance();
 
     m_pVme->writeActionRegister(CVMUSB::ActionRegister::startDAQ);
+    m_pReader->start();
     pState->setState(CRunState::Active);
 }
 /*!
@@ -733,6 +748,7 @@ CAcquisitionThread::drainUsb()
   void
 CAcquisitionThread::beginRun()
 {
+  m_pReader->clearStatistics();
   DataBuffer* pBuffer   = gFreeBuffers.get();
   pBuffer->s_bufferSize = pBuffer->s_storageSize;
   pBuffer->s_bufferType = TYPE_START;
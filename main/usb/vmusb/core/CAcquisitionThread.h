@@ -18,6 +18,7 @@
 #define CACQUISITIONTHREAD_H
 
 #include "CControlQueues.h"
+#include "CUSBReader.h"
 #include <CSynchronizedThread.h>
 
 #include <vector>
@@ -38,7 +39,8 @@ struct DataBuffer;
    it gets started at the beginning of a run and politely requested to stop at
    the end of a run.
 */
-class CAcquisitionThread : public CSynchronizedThread
+class CAcquisitionThread : public CSynchronizedThread,
+                           public CUSBReader::Transport
 {
     // Static member data.
     
@@ -55,6 +57,7 @@ private:
   bool                         m_haveScalerStack;
   bool                         m_controllerReset;
   std::string                  m_lastChecksum;
+  CUSBReader*                  m_pReader;       //!< Keeps reads posted.
 
   //Singleton pattern stuff:
 private:
@@ -75,6 +78,11 @@ public:
   void setControllerResetState(bool value) {
     m_controllerReset = value;
   }
+  CUSBReader::Statistics getReaderStatistics();
+
+  // CUSBReader::Transport - reads go to the VM-USB:
+
+  virtual int readBuffer(DataBuffer* pBuffer, size_t* pTransferred, int timeout);
   
 protected:
   virtual void operator()();
@@ -82,6 +90,7 @@ private:
   void mainLoop();
   void processCommand(CControlQueues::opCode command);
   void processBuffer(DataBuffer* pBuffer);
+  void stopReader();
   void startDaq();
 public:
   void stopDaq();		// public for the exit handler.
@@ -32,6 +32,8 @@
 #endif
 #endif
 
+#include <vector>
+
 #ifndef __THREAD_H
 #include <Thread.h>
 #ifndef __THREAD_H
@@ -46,6 +48,7 @@ typedef struct _StringsBuffer StringsBuffer;
 
 class  CRingBuffer;
 class CSystemControl;
+class CWorkerPool;
 
 /*!
     This class bridges the gap between the buffer format of the
@@ -87,7 +90,7 @@ class CSystemControl;
        the VMUSB.
 
  \note  This class is a separate thread of execution.
- \note  A global variable: gFilledBuffers is a CBufferQueue that contains
+ \note  A global variable: gFilledBuffers is a CRingQueue that contains
         the data shown above and is used to receive raw data buffers from
 	the readout thread.
   \note There is no need to start/stop thread each run.   Once a run is over,
@@ -97,6 +100,13 @@ class CSystemControl;
         The output buffersize is bufferMultiplier*26*1024+32  
         the 26*1024 represent the size of a single VM-USB buffer (note that we are assuming
         mixed mode and event spanning on.
+  \note The physics events of a buffer are built into ring items by a pool
+        of builder threads.  This thread scans the buffer for events and
+        reserves ring space for them in order; the builders copy the events
+        into the items and the items are committed in the order of the
+        buffer.  The timestamp extractor is called by this thread unless
+        its library says it is reentrant (eventTimestampIsReentrant), in
+        which case the builders call it.
 */
 
 class COutputThread  : public Thread
@@ -116,6 +126,14 @@ private:
    
    typedef uint64_t (*TimestampExtractor)(void*);
    typedef void     (*StateChangeCallback)();
+   typedef int      (*ReentrancyQuery)();
+
+   typedef struct _PendingEvent {
+     void*    s_pEvent;          // Complete event in the VM-USB buffer.
+     size_t   s_nWords;          // uint16_t's in the event.
+     size_t   s_offset;          // Offset to its ring item in the batch.
+     uint64_t s_timestamp;       // From the timestamp extractor if any.
+   } PendingEvent;
    
   // Thread local data:
 private:
@@ -142,7 +160,12 @@ private:
   TimestampExtractor m_pEvtTimestampExtractor;
   TimestampExtractor m_pSclrTimestampExtractor;
   StateChangeCallback m_pBeginRunCallback;
+  bool        m_fParallelTimestamps; //!< Builders call m_pEvtTimestampExtractor.
   CSystemControl& m_systemControl;
+  std::vector<PendingEvent> m_pending;  //!< Events to build (see flushEvents).
+  size_t      m_nPendingBytes;      //!< Ring item bytes for m_pending.
+  size_t      m_nMaxBatchBytes;     //!< Most bytes in a batch.
+  CWorkerPool* m_pBuilders;         //!< Threads that build ring items.
 
 
   // Constuctors and other canonicals.
@@ -182,6 +205,13 @@ private:
   void pauseRun(DataBuffer& buffer);   //  Bug #5882
   void resumeRun(DataBuffer& buffer);  //  Bug #5882
   void event(void* pData);      //
+  void emitEvent(void* pEvent, size_t nWords);
+  void queueEvent(void* pEvent, size_t nWords);
+  void flushEvents();
+  size_t eventItemSize(size_t nWords);
+  uint64_t eventTimestamp(void* pEvent);
+  void buildEvent(void* pItem, void* pEvent, size_t nWords, uint64_t timestamp);
+  void countEvent(size_t nBytes);
   void scaler(void* pData);	//
   void sendToTclServer(uint16_t* pEvent);
   void attachRing();
@@ -20,6 +20,7 @@
  */
 #include "CStatisticsCommand.h"
 #include "CTheApplication.h"
+#include "CAcquisitionThread.h"
 #include "TCLInterpreter.h"
 #include "TCLObject.h"
 #include "Exception.h"
@@ -76,6 +77,13 @@ CStatisticsCommand::operator()(
         formatCounters(perRun, stats.s_perRun);
         result += cumulative;
         result += perRun;
+        
+        CTCLObject reader;
+        reader.Bind(interp);
+        formatReader(
+            reader, CAcquisitionThread::getInstance()->getReaderStatistics()
+        );
+        result += reader;
         interp.setResult(result);
     }
     catch (CException& e) {
@@ -114,4 +122,27 @@ CStatisticsCommand::formatCounters(
     result += (double)(counters.s_acceptedTriggers);
     result += (double)(counters.s_bytes);
 
+}
+/**
+ * Format the USB reader statistics list.
+ *   @param result - output result.
+ *   @param stats  - the reader statistics.
+ */
+void
+CStatisticsCommand::formatReader(
+    CTCLObject& result, const CUSBReader::Statistics& stats
+)
+{
+    double meanLatency = 0.0;
+    if (stats.s_buffers) {
+        meanLatency = stats.s_latencySum/stats.s_buffers;
+    }
+    double utilization = 0.0;
+    if (stats.s_runTime > 0.0) {
+        utilization = stats.s_readTime/stats.s_runTime;
+    }
+    result += (double)(stats.s_buffers);
+    result += meanLatency*1000.0;
+    result += stats.s_maxLatency*1000.0;
+    result += utilization;
 }
\ No newline at end of file
@@ -22,6 +22,7 @@
 #define CSTATISTICSCOMMAND_H
 #include <TCLObjectProcessor.h>
 #include "COutputThread.h"
+#include "CUSBReader.h"
 
 class CTCLInterpreter;
 class CTCLObject;
@@ -29,7 +30,7 @@ class CTCLObject;
 /**
  * @class CStatisticsCommand
  *    Creates on demand statistics of trigger and sizes:
- *    The command returns two lists. THe first list contains the
+ *    The command returns three lists. THe first list contains the
  *    cumulative statistics while the second list contains the statistics
  *    from the run in progress or most recent run if the run is not active.
  *    Each of the lists has three elements that are, in order:
@@ -38,6 +39,14 @@ class CTCLObject;
  *        rejecting triggers so this will be the same as the number of triggers.
  *    -   The number of bytes of event data put into the ring buffer.  This
  *        is exclusive of body headers and ring item headers.
+ *
+ *    The third list describes the USB reads of the run in progress or most
+ *    recent run:
+ *    -   The number of buffers read.
+ *    -   The mean time in ms buffers waited between being read and being
+ *        taken by the acquisition thread.
+ *    -   The longest such wait (ms).
+ *    -   The bus utilization: the fraction of the time a read was posted.
  */
 class CStatisticsCommand : public CTCLObjectProcessor
 {
@@ -48,5 +57,6 @@ public:
     int operator()(CTCLInterpreter& interp, std::vector<CTCLObject>& objv);
 private:
     void formatCounters(CTCLObject& result, const COutputThread::Counters& c);
+    void formatReader(CTCLObject& result, const CUSBReader::Statistics& s);
 };
 #endif
\ No newline at end of file
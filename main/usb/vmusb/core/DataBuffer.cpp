@@ -29,8 +29,8 @@
 
 // Buffer queues that communicate between the readout and routing threads:
 
-CBufferQueue<DataBuffer*> gFilledBuffers; 
-CBufferQueue<DataBuffer*> gFreeBuffers;
+DataBufferQueue gFilledBuffers; 
+DataBufferQueue gFreeBuffers;
 
 /*!
    Create a new data buffer.  
@@ -38,8 +38,8 @@
 #endif
 #endif
 
-#ifndef __CBUFFERQUEUE_h
-#include <CBufferQueue.h>
+#ifndef CRINGQUEUE_H
+#include <CRingQueue.h>
 #endif
 
 /*!
@@ -71,8 +71,13 @@ typedef struct _StringsBuffer {
 
 
 
-extern CBufferQueue<DataBuffer*>  gFilledBuffers;
-extern CBufferQueue<DataBuffer*>  gFreeBuffers;
+// The buffer pool is small and fixed so the lock free CRingQueue is used.
+// Its capacity must be at least the number of buffers in the pool.
+
+typedef CRingQueue<DataBuffer*> DataBufferQueue;
+
+extern DataBufferQueue  gFilledBuffers;
+extern DataBufferQueue  gFreeBuffers;
 
 //  A couple of useful unbound functions:
 
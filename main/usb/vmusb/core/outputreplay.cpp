@@ -0,0 +1,232 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+// Replay VM-USB buffers through COutputThread::processBuffer and report
+// the events per second that make it into the ring.
+//
+// Usage:
+//    outputreplay ?passes? ?file?
+//
+// The buffers are replayed passes times (default 100) between a begin and
+// an end run.  file contains recorded buffers, each a uint32_t byte count
+// followed by the bytes as read from the VM-USB.  Without a file, buffers
+// of 20 word events are synthesized; every fourth buffer ends in an event
+// whose continuation segment starts the next buffer.
+//
+// The events go to the ring 'outputreplay' which is drained by a consumer
+// thread.  Stack 7 (monitor) events are discarded.
+//
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <fstream>
+
+#include "DataBuffer.h"
+#include <CSystemControl.h>
+#include <TclServer.h>
+#include <Globals.h>
+#include <CMockVMUSB.h>
+#include <CRingBuffer.h>
+#include <Thread.h>
+
+#define private public
+#include "COutputThread.h"
+#undef private
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char*    RINGNAME("outputreplay");
+static const unsigned BUFFERWORDS(13*1024);
+static const unsigned EVENTWORDS(20);         // Synthetic event size.
+static const unsigned SYNTHETICBUFFERS(64);
+
+// Globals the output thread uses:
+
+namespace Globals {
+  CConfiguration*    pConfig(0);
+  std::string        configurationFilename;
+  std::string        controlConfigFilename;
+  CVMUSB*            pUSBController(0);
+  bool               running(false);
+  TclServer*         pTclServer(0);
+  unsigned           scalerPeriod(2);
+  size_t             usbBufferSize(BUFFERWORDS*sizeof(uint16_t));
+  unsigned           sourceId(0);
+  char*              pTimestampExtractor(0);
+  Tcl_ThreadId       mainThreadId(0);
+  CTCLInterpreter*   pMainInterpreter(0);
+  CTheApplication*   pApplication(0);
+};
+
+// No Tcl server or main interpreter in the harness:
+
+void TclServer::QueueBuffer(void* pBuffer) {}
+int  CSystemControl::scheduleExit(int status) { exit(status); }
+
+static double
+now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
+
+static DataBuffer*
+newBuffer(uint32_t type)
+{
+  DataBuffer* p    = createDataBuffer(BUFFERWORDS);
+  p->s_bufferType  = type;
+  p->s_bufferSize  = 0;
+  return p;
+}
+
+// Read recorded buffers.
+
+static void
+readBuffers(const char* file, std::vector<DataBuffer*>& buffers)
+{
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    std::cerr << "Unable to open " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  uint32_t nBytes;
+  while (in.read(reinterpret_cast<char*>(&nBytes), sizeof(nBytes))) {
+    if (nBytes > BUFFERWORDS*sizeof(uint16_t)) {
+      std::cerr << "Recorded buffer of " << nBytes << " bytes is too big\n";
+      exit(EXIT_FAILURE);
+    }
+    DataBuffer* p = newBuffer(TYPE_EVENTS);
+    in.read(reinterpret_cast<char*>(p->s_rawData), nBytes);
+    p->s_bufferSize = nBytes;
+    buffers.push_back(p);
+  }
+}
+
+// Synthesize buffers.  Event bodies are a sequence number so they're
+// distinct.
+
+static void
+makeBuffers(std::vector<DataBuffer*>& buffers)
+{
+  unsigned perBuffer = (BUFFERWORDS - 3)/(EVENTWORDS + 1) - 1;
+  bool     continued = false;
+  uint16_t sequence  = 0;
+  for (unsigned b = 0; b < SYNTHETICBUFFERS; b++) {
+    DataBuffer* p      = newBuffer(TYPE_EVENTS);
+    uint16_t*   pWord  = p->s_rawData + 1;
+    unsigned    nEvents = 0;
+
+    // The tail of an event split across the prior buffer:
+
+    if (continued) {
+      *pWord++ = EVENTWORDS/2;
+      for (unsigned i = 0; i < EVENTWORDS/2; i++) *pWord++ = sequence;
+      sequence++;
+      nEvents++;
+      continued = false;
+    }
+    for (unsigned e = 0; e < perBuffer; e++) {
+      *pWord++ = EVENTWORDS;
+      for (unsigned i = 0; i < EVENTWORDS; i++) *pWord++ = sequence;
+      sequence++;
+      nEvents++;
+    }
+    if ((b % 4) == 3) {
+      *pWord++ = (EVENTWORDS/2) | VMUSBContinuation;
+      for (unsigned i = 0; i < EVENTWORDS/2; i++) *pWord++ = sequence;
+      nEvents++;
+      continued = true;
+    }
+    *pWord++ = 0xffff;
+    *pWord++ = 0xffff;
+    p->s_rawData[0] = nEvents;
+    p->s_bufferSize = (pWord - p->s_rawData)*sizeof(uint16_t);
+    buffers.push_back(p);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned passes = 100;
+  if (argc > 1) passes = strtoul(argv[1], 0, 0);
+
+  std::vector<DataBuffer*> buffers;
+  if (argc > 2) {
+    readBuffers(argv[2], buffers);
+  } else {
+    makeBuffers(buffers);
+  }
+
+  CMockVMUSB     controller;
+  CSystemControl control;
+  Globals::pUSBController = &controller;
+
+  COutputThread router(RINGNAME, control);
+  router.attachRing();
+
+  // Keep the ring drained:
+
+  std::atomic<bool> done(false);
+  std::thread consumer([&]() {
+    CRingBuffer ring(RINGNAME, CRingBuffer::consumer);
+    while (!done) {
+      size_t n = ring.availableData();
+      if (n) {
+        ring.skip(n);
+      } else {
+        usleep(100);
+      }
+    }
+  });
+
+  DataBuffer* pBegin = newBuffer(TYPE_START);
+  DataBuffer* pEnd   = newBuffer(TYPE_STOP);
+  router.processBuffer(*pBegin);
+
+  double start = now();
+  for (unsigned pass = 0; pass < passes; pass++) {
+    for (size_t i = 0; i < buffers.size(); i++) {
+      router.processBuffer(*buffers[i]);
+    }
+  }
+  double elapsed = now() - start;
+  router.processBuffer(*pEnd);
+
+  done = true;
+  consumer.join();
+
+  const COutputThread::Statistics& stats = router.getStatistics();
+  std::cout << "buffers events bytes seconds events/s\n";
+  std::cout << buffers.size()*passes << " "
+            << stats.s_perRun.s_triggers << " "
+            << stats.s_perRun.s_bytes << " "
+            << elapsed << " "
+            << stats.s_perRun.s_triggers/elapsed << std::endl;
+
+  for (size_t i = 0; i < buffers.size(); i++) {
+    destroyDataBuffer(buffers[i]);
+  }
+  destroyDataBuffer(pBegin);
+  destroyDataBuffer(pEnd);
+  return EXIT_SUCCESS;
+}
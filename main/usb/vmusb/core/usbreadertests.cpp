@@ -0,0 +1,200 @@
+// Tests for the pipelined USB reader (usb/common/usbreader) against a
+// simulated device.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include "CUSBReader.h"
+#include "DataBuffer.h"
+
+#include <vector>
+#include <atomic>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const unsigned POOLSIZE(8);
+static const unsigned BUFFERWORDS(128);
+
+// Simulated device: each read delivers a buffer whose first word is a
+// sequence number.  Every timeoutEvery'th read times out and after
+// nBuffers the device fails with EIO (0 means never).
+
+class SimulatedDevice : public CUSBReader::Transport
+{
+public:
+  unsigned              m_nBuffers;
+  unsigned              m_timeoutEvery;
+  std::atomic<unsigned> m_reads;
+  uint16_t              m_sequence;
+  SimulatedDevice(unsigned nBuffers, unsigned timeoutEvery) :
+    m_nBuffers(nBuffers), m_timeoutEvery(timeoutEvery), m_reads(0),
+    m_sequence(0)
+  {}
+  virtual int readBuffer(DataBuffer* pBuffer, size_t* pTransferred, int timeout)
+  {
+    m_reads++;
+    usleep(100);                        // The transfer.
+    if (m_timeoutEvery && ((m_reads % m_timeoutEvery) == 0)) {
+      *pTransferred = 0;
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (m_nBuffers && (m_sequence >= m_nBuffers)) {
+      *pTransferred = 0;
+      errno = EIO;
+      return -1;
+    }
+    pBuffer->s_rawData[0] = m_sequence++;
+    pBuffer->s_bufferSize = pBuffer->s_storageSize;
+    pBuffer->s_bufferType = TYPE_EVENTS;
+    *pTransferred = pBuffer->s_bufferSize;
+    return 0;
+  }
+};
+
+class USBReaderTests : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(USBReaderTests);
+  CPPUNIT_TEST(order);
+  CPPUNIT_TEST(error);
+  CPPUNIT_TEST(stopkeeps);
+  CPPUNIT_TEST(depth);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  DataBufferQueue* m_pFree;
+public:
+  void setUp() {
+    m_pFree = new DataBufferQueue(POOLSIZE);
+    for (unsigned i = 0; i < POOLSIZE; i++) {
+      m_pFree->queue(createDataBuffer(BUFFERWORDS));
+    }
+  }
+  void tearDown() {
+    EQ(size_t(POOLSIZE), m_pFree->size());   // No buffers lost.
+    DataBuffer* p;
+    while (m_pFree->getnow(p)) {
+      destroyDataBuffer(p);
+    }
+    delete m_pFree;
+  }
+protected:
+  void order();
+  void error();
+  void stopkeeps();
+  void depth();
+private:
+  DataBuffer* takeOne(CUSBReader& reader);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(USBReaderTests);
+
+// Take a buffer, giving up after a few seconds or if the reader stopped.
+
+DataBuffer*
+USBReaderTests::takeOne(CUSBReader& reader)
+{
+  for (int i = 0; i < 50; i++) {
+    DataBuffer* p = reader.take(100);
+    if (p) return p;
+    if (!reader.isRunning()) return reader.take(0);
+  }
+  return 0;
+}
+
+// Buffers come out in order with their sizes set; timeouts are
+// counted and skipped.
+
+void
+USBReaderTests::order()
+{
+  SimulatedDevice device(0, 5);
+  CUSBReader      reader(device, *m_pFree, 4, 10);
+  reader.start();
+  for (uint16_t i = 0; i < 100; i++) {
+    DataBuffer* p = takeOne(reader);
+    ASSERT(p);
+    EQ(i, p->s_rawData[0]);
+    EQ(uint32_t(TYPE_EVENTS), p->s_bufferType);
+    EQ(p->s_storageSize, p->s_bufferSize);
+    m_pFree->queue(p);
+  }
+  reader.stop();
+  EQ(0, reader.getError());
+
+  CUSBReader::Statistics stats = reader.getStatistics();
+  ASSERT(stats.s_buffers >= 100);
+  ASSERT(stats.s_timeouts >= 100/5);
+  ASSERT(stats.s_readTime > 0.0);
+  ASSERT(stats.s_readTime <= stats.s_runTime);
+  ASSERT(stats.s_maxLatency >= 0.0);
+}
+
+// A device error is reported only after the data read before it.
+
+void
+USBReaderTests::error()
+{
+  SimulatedDevice device(10, 0);
+  CUSBReader      reader(device, *m_pFree, 4, 10);
+  reader.start();
+  for (uint16_t i = 0; i < 10; i++) {
+    DataBuffer* p = takeOne(reader);
+    ASSERT(p);
+    EQ(i, p->s_rawData[0]);
+    m_pFree->queue(p);
+  }
+  ASSERT(!takeOne(reader));
+  EQ(EIO, reader.getError());
+  ASSERT(!reader.isRunning());
+}
+
+// Stopping keeps the completed buffers and a restart continues after them.
+
+void
+USBReaderTests::stopkeeps()
+{
+  SimulatedDevice device(0, 0);
+  CUSBReader      reader(device, *m_pFree, 4, 10);
+  reader.start();
+  while (device.m_reads < 4) {
+    usleep(100);
+  }
+  reader.stop();
+  ASSERT(!reader.isRunning());
+
+  uint16_t    expected = 0;
+  DataBuffer* p;
+  while ((p = reader.take(0))) {
+    EQ(expected++, p->s_rawData[0]);
+    m_pFree->queue(p);
+  }
+  ASSERT(expected > 0);
+
+  reader.start();
+  p = takeOne(reader);
+  ASSERT(p);
+  EQ(expected, p->s_rawData[0]);
+  m_pFree->queue(p);
+}
+
+// The reader doesn't get more than depth buffers ahead.
+
+void
+USBReaderTests::depth()
+{
+  SimulatedDevice device(0, 0);
+  CUSBReader      reader(device, *m_pFree, 2, 10);
+  reader.start();
+  usleep(100*1000);
+  EQ(2u, device.m_reads.load());
+  EQ(size_t(POOLSIZE - 2), m_pFree->size());
+  reader.stop();
+  DataBuffer* p;
+  while ((p = reader.take(0))) {
+    m_pFree->queue(p);
+  }
+}
@@ -0,0 +1,282 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CAsyncWriter.cpp
+ *  @brief: Implement the event logger's write behind thread.
+ */
+#include "CAsyncWriter.h"
+#include <io.h>
+
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+/**
+ * constructor
+ *    Allocates the buffer pool.  The thread is not started; that's up to
+ *    the creator.  Since it's a CSynchronizedThread, once start returns
+ *    the thread is running and the destructor's join is sure to wait for it.
+ *
+ * @param nBuffers   - Number of buffers (maximum writes outstanding).
+ * @param bufferSize - Bytes per buffer; rounded up to ALIGNMENT.
+ * @param checksum   - If not empty, called with the data as it's written.
+ */
+CAsyncWriter::CAsyncWriter(
+    unsigned nBuffers, size_t bufferSize, Checksummer checksum
+) :
+    m_nBufferSize(((bufferSize + ALIGNMENT - 1)/ALIGNMENT)*ALIGNMENT),
+    m_nBuffers(nBuffers ? nBuffers : 1),
+    m_checksum(checksum),
+    m_pCurrent(nullptr),
+    m_nQueued(0), m_nBytes(0), m_nWrites(0), m_nWriteNs(0),
+    m_nMaxQueueDepth(0), m_nDepthSum(0), m_nSubmits(0), m_nStalls(0),
+    m_startNs(now())
+{
+    m_flushMarker.s_type = flushMarker;
+    m_exitMarker.s_type  = exitMarker;
+    for (unsigned i = 0; i < m_nBuffers; i++) {
+        Buffer* pBuffer = new Buffer;
+        pBuffer->s_type   = dataBuffer;
+        pBuffer->s_fd     = -1;
+        pBuffer->s_nBytes = 0;
+        void* pData;
+        if (posix_memalign(&pData, ALIGNMENT, m_nBufferSize)) {
+            delete pBuffer;
+            throw std::bad_alloc();
+        }
+        pBuffer->s_pData = static_cast<uint8_t*>(pData);
+        m_freeBuffers.queue(pBuffer);
+    }
+}
+/**
+ * destructor
+ *    Writes anything that's been queued, stops the thread and releases the
+ *    buffers.
+ */
+CAsyncWriter::~CAsyncWriter()
+{
+    if (m_pCurrent) submit();
+    m_fullBuffers.queue(&m_exitMarker);
+    join();
+
+    Buffer* pBuffer;
+    while (m_fullBuffers.getnow(pBuffer)) {      // If never started.
+        if (pBuffer->s_type == dataBuffer) m_freeBuffers.queue(pBuffer);
+    }
+    while (m_freeBuffers.getnow(pBuffer)) {
+        free(pBuffer->s_pData);
+        delete pBuffer;
+    }
+}
+
+/**
+ * write
+ *    Copy data into the buffers, queueing each one to the writer as it
+ *    fills.  Blocks only if all buffers are queued to be written.
+ *
+ * @param fd     - File the data go to.
+ * @param pData  - The data.
+ * @param nBytes - Number of bytes of data.
+ */
+void
+CAsyncWriter::write(int fd, const void* pData, size_t nBytes)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(pData);
+
+    if (m_pCurrent && (m_pCurrent->s_fd != fd)) submit();
+
+    while (nBytes) {
+        if (!m_pCurrent) {
+            if (!m_freeBuffers.getnow(m_pCurrent)) {
+                m_nStalls++;
+                m_pCurrent = m_freeBuffers.get();
+            }
+            m_pCurrent->s_fd     = fd;
+            m_pCurrent->s_nBytes = 0;
+        }
+        size_t n = m_nBufferSize - m_pCurrent->s_nBytes;
+        if (n > nBytes) n = nBytes;
+        memcpy(m_pCurrent->s_pData + m_pCurrent->s_nBytes, p, n);
+        m_pCurrent->s_nBytes += n;
+        p      += n;
+        nBytes -= n;
+
+        if (m_pCurrent->s_nBytes == m_nBufferSize) submit();
+    }
+}
+/**
+ * flush
+ *    Queue the partially filled buffer and wait until everything queued
+ *    so far is on its way to disk.  Must be called before the file is
+ *    closed.  The writer thread must be running.
+ */
+void
+CAsyncWriter::flush()
+{
+    if (m_pCurrent) submit();
+    m_fullBuffers.queue(&m_flushMarker);
+    m_flushed.get();
+}
+/**
+ * getStatistics
+ *    @return Statistics - what the writer's done since the last reset.
+ */
+CAsyncWriter::Statistics
+CAsyncWriter::getStatistics() const
+{
+    Statistics result;
+    result.s_nBytes            = m_nBytes;
+    result.s_nWrites           = m_nWrites;
+    result.s_elapsedTime       = (now() - m_startNs)/1.0e9;
+    result.s_writeTime         = m_nWriteNs/1.0e9;
+    result.s_nBuffers          = m_nBuffers;
+    result.s_maxQueueDepth     = m_nMaxQueueDepth;
+    result.s_averageQueueDepth =
+        m_nSubmits ? double(m_nDepthSum)/m_nSubmits : 0.0;
+    result.s_nStalls           = m_nStalls;
+    return result;
+}
+/**
+ * resetStatistics
+ *    Start a new statistics interval (e.g. at the start of a run).
+ */
+void
+CAsyncWriter::resetStatistics()
+{
+    m_nBytes         = 0;
+    m_nWrites        = 0;
+    m_nWriteNs       = 0;
+    m_nMaxQueueDepth = 0;
+    m_nDepthSum      = 0;
+    m_nSubmits       = 0;
+    m_nStalls        = 0;
+    m_startNs        = now();
+}
+
+/**
+ * operator()
+ *    Writer thread: write buffers in the order they were queued until
+ *    told to exit.  Write failures are fatal as they are in the
+ *    synchronous event logger.
+ */
+void
+CAsyncWriter::operator()()
+{
+    while (1) {
+        Buffer* pBuffer = m_fullBuffers.get();
+        if (pBuffer->s_type == exitMarker) {
+            return;
+        } else if (pBuffer->s_type == flushMarker) {
+            m_flushed.queue(pBuffer);
+        } else {
+            writeBuffer(pBuffer);
+            m_nQueued--;
+            m_freeBuffers.queue(pBuffer);
+        }
+    }
+}
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * submit
+ *    Queue the current buffer to the writer thread and keep track of the
+ *    queue depth.
+ */
+void
+CAsyncWriter::submit()
+{
+    unsigned depth = ++m_nQueued;
+    if (depth > m_nMaxQueueDepth) m_nMaxQueueDepth = depth;
+    m_nDepthSum += depth;
+    m_nSubmits++;
+
+    m_fullBuffers.queue(m_pCurrent);
+    m_pCurrent = nullptr;
+}
+/**
+ * writeBuffer
+ *    Checksum and write a buffer.  Only a buffer that was flushed can be
+ *    partial; it's written with writeTail in case the file is O_DIRECT.
+ *
+ * @param pBuffer - the buffer.
+ */
+void
+CAsyncWriter::writeBuffer(Buffer* pBuffer)
+{
+    if (m_checksum) m_checksum(pBuffer->s_pData, pBuffer->s_nBytes);
+
+    uint64_t start = now();
+    try {
+        if (pBuffer->s_nBytes == m_nBufferSize) {
+            io::writeData(pBuffer->s_fd, pBuffer->s_pData, pBuffer->s_nBytes);
+        } else {
+            writeTail(pBuffer->s_fd, pBuffer->s_pData, pBuffer->s_nBytes);
+        }
+    }
+    catch (int err) {
+        if (err) {
+            std::cerr << "Unable to output a ringbuffer item : "
+                << strerror(err) << std::endl;
+        } else {
+            std::cerr << "Output file closed out from underneath us\n";
+        }
+        exit(EXIT_FAILURE);
+    }
+    m_nWriteNs += now() - start;
+    m_nBytes   += pBuffer->s_nBytes;
+    m_nWrites++;
+}
+/**
+ * writeTail
+ *    Write data whose size may not be a multiple of ALIGNMENT.  If the
+ *    file is open O_DIRECT the aligned part is written that way, then
+ *    O_DIRECT is turned off for the rest.
+ *
+ * @param fd     - file descriptor.
+ * @param pData  - aligned data.
+ * @param nBytes - number of bytes.
+ */
+void
+CAsyncWriter::writeTail(int fd, uint8_t* pData, size_t nBytes)
+{
+    int flags = fcntl(fd, F_GETFL);
+    if ((flags != -1) && (flags & O_DIRECT) && (nBytes % ALIGNMENT)) {
+        size_t aligned = (nBytes/ALIGNMENT)*ALIGNMENT;
+        if (aligned) io::writeData(fd, pData, aligned);
+        fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+        pData  += aligned;
+        nBytes -= aligned;
+    }
+    if (nBytes) io::writeData(fd, pData, nBytes);
+}
+/**
+ * now
+ *   @return uint64_t - monotonic clock in ns.
+ */
+uint64_t
+CAsyncWriter::now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return uint64_t(t.tv_sec)*1000000000 + t.tv_nsec;
+}
@@ -0,0 +1,123 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CAsyncWriter.h
+ *  @brief: Write behind thread for the event logger.
+ */
+#ifndef CASYNCWRITER_H
+#define CASYNCWRITER_H
+
+#include <CSynchronizedThread.h>
+#include <CBufferQueue.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+
+/**
+ * @class CAsyncWriter
+ *    Decouples draining the ring buffer from writing the event file.
+ *    Data handed to write() are copied into a pool of page aligned buffers.
+ *    Full buffers are queued to a writer thread, so up to the pool size
+ *    writes can be outstanding while the main thread goes back to the
+ *    ring.  The main thread only blocks when every buffer is waiting on the
+ *    disk.
+ *
+ *    Since buffers are always filled before they are written, every write
+ *    but the last one of a segment is a full, aligned buffer at an aligned
+ *    offset.  That makes the writer usable with files opened O_DIRECT; the
+ *    unaligned tail written by flush() has O_DIRECT turned off first.
+ *
+ *    If a checksum function is supplied it's called by the writer thread
+ *    with the data in file order, taking the hashing off the thread that
+ *    drains the ring as well.
+ */
+class CAsyncWriter : public CSynchronizedThread
+{
+public:
+    typedef std::function<void(void*, size_t)> Checksummer;
+
+    static const size_t ALIGNMENT = 4096;
+
+    typedef struct _Statistics {
+        uint64_t s_nBytes;            //< Bytes written.
+        uint64_t s_nWrites;           //< Buffers written.
+        double   s_elapsedTime;       //< Seconds since reset.
+        double   s_writeTime;         //< Seconds spent in write(2).
+        unsigned s_nBuffers;          //< Size of the buffer pool.
+        unsigned s_maxQueueDepth;     //< Most buffers queued at once.
+        double   s_averageQueueDepth; //< Average queue depth at submit.
+        uint64_t s_nStalls;           //< Times write() waited for a buffer.
+    } Statistics;
+private:
+    typedef enum _BufferType {dataBuffer, flushMarker, exitMarker} BufferType;
+    typedef struct _Buffer {
+        BufferType s_type;
+        int        s_fd;
+        size_t     s_nBytes;
+        uint8_t*   s_pData;
+    } Buffer;
+
+    size_t                 m_nBufferSize;
+    unsigned               m_nBuffers;
+    Checksummer            m_checksum;
+    CBufferQueue<Buffer*>  m_freeBuffers;
+    CBufferQueue<Buffer*>  m_fullBuffers;
+    CBufferQueue<Buffer*>  m_flushed;
+    Buffer*                m_pCurrent;
+    Buffer                 m_flushMarker;
+    Buffer                 m_exitMarker;
+
+    // Statistics - the counters the writer thread updates are atomic.
+
+    std::atomic<unsigned>  m_nQueued;
+    std::atomic<uint64_t>  m_nBytes;
+    std::atomic<uint64_t>  m_nWrites;
+    std::atomic<uint64_t>  m_nWriteNs;
+    unsigned               m_nMaxQueueDepth;
+    uint64_t               m_nDepthSum;
+    uint64_t               m_nSubmits;
+    uint64_t               m_nStalls;
+    uint64_t               m_startNs;
+
+public:
+    CAsyncWriter(
+        unsigned nBuffers, size_t bufferSize, Checksummer checksum = Checksummer()
+    );
+    virtual ~CAsyncWriter();
+private:
+    CAsyncWriter(const CAsyncWriter&);
+    CAsyncWriter& operator=(const CAsyncWriter&);
+public:
+    void write(int fd, const void* pData, size_t nBytes);
+    void flush();
+
+    Statistics getStatistics() const;
+    void       resetStatistics();
+
+protected:
+    virtual void operator()();
+
+private:
+    void submit();
+    void writeBuffer(Buffer* pBuffer);
+    static void writeTail(int fd, uint8_t* pData, size_t nBytes);
+    static uint64_t now();
+};
+
+#endif
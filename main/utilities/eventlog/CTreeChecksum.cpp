@@ -0,0 +1,232 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CTreeChecksum.cpp
+ *  @brief: Implement the chunked SHA-512 checksum.
+ */
+#include "CTreeChecksum.h"
+#include <openssl/evp.h>
+
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * constructor
+ *    Allocates two chunk buffers per worker, so one can be filled
+ *    while the workers hash the others, and starts the workers.
+ *
+ * @param nThreads  - number of worker threads (at least 1).
+ * @param chunkSize - bytes per chunk.
+ */
+CTreeChecksum::CTreeChecksum(unsigned nThreads, size_t chunkSize) :
+    m_nChunkSize(chunkSize), m_pCurrent(nullptr), m_nChunks(0), m_nCollected(0)
+{
+    if (!nThreads) nThreads = 1;
+    for (unsigned i = 0; i < 2*nThreads; i++) {
+        Job* pJob = new Job;
+        pJob->s_nBytes = 0;
+        pJob->s_pData  = static_cast<uint8_t*>(malloc(m_nChunkSize));
+        if (!pJob->s_pData) {
+            delete pJob;
+            throw std::bad_alloc();
+        }
+        m_allJobs.push_back(pJob);
+        m_freeJobs.queue(pJob);
+    }
+    for (unsigned i = 0; i < nThreads; i++) {
+        Worker* pWorker = new Worker(*this);
+        m_workers.push_back(pWorker);
+        pWorker->start();
+    }
+}
+/**
+ * destructor
+ *    A null job stops a worker.
+ */
+CTreeChecksum::~CTreeChecksum()
+{
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_jobs.queue(nullptr);
+    }
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->join();
+        delete m_workers[i];
+    }
+    for (int i = 0; i < m_allJobs.size(); i++) {
+        free(m_allJobs[i]->s_pData);
+        delete m_allJobs[i];
+    }
+}
+
+/**
+ * update
+ *    Add data to the checksum.
+ *
+ * @param pData  - the data.
+ * @param nBytes - number of bytes.
+ */
+void
+CTreeChecksum::update(const void* pData, size_t nBytes)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(pData);
+    while (nBytes) {
+        if (!m_pCurrent) {
+
+            // Collect what's done while waiting for a free chunk buffer:
+
+            Job* pJob;
+            while (!m_freeJobs.getnow(pJob)) {
+                collect(m_doneJobs.get());
+            }
+            m_pCurrent = pJob;
+            m_pCurrent->s_index  = m_nChunks;
+            m_pCurrent->s_nBytes = 0;
+        }
+        size_t n = m_nChunkSize - m_pCurrent->s_nBytes;
+        if (n > nBytes) n = nBytes;
+        memcpy(m_pCurrent->s_pData + m_pCurrent->s_nBytes, p, n);
+        m_pCurrent->s_nBytes += n;
+        p      += n;
+        nBytes -= n;
+
+        if (m_pCurrent->s_nBytes == m_nChunkSize) submit();
+    }
+}
+/**
+ * finish
+ *    Wait for all chunks to be hashed and compute the run digest.  The
+ *    object is then reset for the next run; the chunk digests stay
+ *    available via getChunkDigests until the next update.
+ *
+ * @return Digest - SHA-512 of the concatenated chunk digests.
+ */
+CTreeChecksum::Digest
+CTreeChecksum::finish()
+{
+    if (m_pCurrent) submit();
+    while (m_nCollected < m_nChunks) {
+        collect(m_doneJobs.get());
+    }
+    if (!m_nChunks) m_digests.clear();       // Empty run.
+
+    // Jobs come back in any order, but collect() filled in the slots by
+    // index, and they're all in now.
+
+    std::vector<uint8_t> leaves;
+    for (int i = 0; i < m_digests.size(); i++) {
+        leaves.insert(leaves.end(), m_digests[i].begin(), m_digests[i].end());
+    }
+    Digest result = sha512(leaves.data(), leaves.size());
+
+    m_nChunks    = 0;
+    m_nCollected = 0;
+    return result;
+}
+/**
+ * sha512
+ *    One shot SHA-512.
+ *
+ * @param pData  - data to hash.
+ * @param nBytes - number of bytes.
+ * @return Digest
+ */
+CTreeChecksum::Digest
+CTreeChecksum::sha512(const void* pData, size_t nBytes)
+{
+    Digest result(DIGEST_SIZE);
+    unsigned int len;
+    if (EVP_Digest(pData, nBytes, result.data(), &len, EVP_sha512(), NULL) != 1) {
+        throw std::string("Failed to compute a sha512 digest");
+    }
+    return result;
+}
+/**
+ * toHex
+ *    @param digest - a digest.
+ *    @return std::string - the digest as hex the way sha512sum shows it.
+ */
+std::string
+CTreeChecksum::toHex(const Digest& digest)
+{
+    std::string result;
+    char byte[3];
+    for (int i = 0; i < digest.size(); i++) {
+        sprintf(byte, "%02x", digest[i]);
+        result += byte;
+    }
+    return result;
+}
+/*---------------------------------------------------------------------------
+ * Private utilities
+ */
+
+/**
+ * submit
+ *    Queue the current chunk to the workers.  The first chunk of a run
+ *    clears the digests of the previous one.
+ */
+void
+CTreeChecksum::submit()
+{
+    if (m_nChunks == 0) m_digests.clear();
+    m_nChunks++;
+    m_jobs.queue(m_pCurrent);
+    m_pCurrent = nullptr;
+}
+/**
+ * collect
+ *    Save the digest of a hashed chunk and free its buffer.
+ *
+ * @param pJob - the finished job.
+ */
+void
+CTreeChecksum::collect(Job* pJob)
+{
+    if (m_digests.size() <= pJob->s_index) m_digests.resize(pJob->s_index + 1);
+    m_digests[pJob->s_index].assign(pJob->s_digest, pJob->s_digest + DIGEST_SIZE);
+    m_nCollected++;
+    m_freeJobs.queue(pJob);
+}
+
+/*---------------------------------------------------------------------------
+ * Worker thread.
+ */
+CTreeChecksum::Worker::Worker(CTreeChecksum& owner) :
+    m_owner(owner)
+{}
+/**
+ * operator()
+ *    Hash chunks until a null one arrives.
+ */
+void
+CTreeChecksum::Worker::operator()()
+{
+    while (1) {
+        Job* pJob = m_owner.m_jobs.get();
+        if (!pJob) return;
+        unsigned int len;
+        EVP_Digest(
+            pJob->s_pData, pJob->s_nBytes, pJob->s_digest, &len,
+            EVP_sha512(), NULL
+        );
+        m_owner.m_doneJobs.queue(pJob);
+    }
+}
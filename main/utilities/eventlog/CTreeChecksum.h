@@ -0,0 +1,99 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CTreeChecksum.h
+ *  @brief: Chunked SHA-512 checksum computed by worker threads.
+ */
+#ifndef CTREECHECKSUM_H
+#define CTREECHECKSUM_H
+
+#include <CSynchronizedThread.h>
+#include <CBufferQueue.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+/**
+ * @class CTreeChecksum
+ *    A plain SHA-512 of a run can only be computed one byte after another
+ *    on one thread.  This computes a two level hash instead:
+ *    - The data are cut into fixed size chunks and the SHA-512 of each
+ *      chunk is computed by a pool of worker threads.
+ *    - The run digest is the SHA-512 of the concatenated (binary) chunk
+ *      digests, in order.
+ *    The chunk digests are kept as well so a bad chunk can be located.
+ *
+ *    update() only copies the data into a chunk buffer, so the caller's
+ *    cost is a memcpy.  It blocks if all chunk buffers are waiting to be
+ *    hashed.
+ */
+class CTreeChecksum
+{
+public:
+    static const size_t DIGEST_SIZE = 64;        // SHA-512.
+    typedef std::vector<uint8_t> Digest;
+private:
+    typedef struct _Job {
+        size_t   s_index;              // Chunk number.
+        size_t   s_nBytes;
+        uint8_t* s_pData;
+        uint8_t  s_digest[DIGEST_SIZE];
+    } Job;
+
+    class Worker : public CSynchronizedThread {
+        CTreeChecksum& m_owner;
+    public:
+        Worker(CTreeChecksum& owner);
+        virtual void operator()();
+    };
+
+    size_t                m_nChunkSize;
+    std::vector<Worker*>  m_workers;
+    CBufferQueue<Job*>    m_freeJobs;
+    CBufferQueue<Job*>    m_jobs;
+    CBufferQueue<Job*>    m_doneJobs;
+    std::vector<Job*>     m_allJobs;
+
+    Job*                  m_pCurrent;
+    size_t                m_nChunks;         // Chunks submitted.
+    size_t                m_nCollected;      // Chunk digests collected.
+    std::vector<Digest>   m_digests;         // Chunk digests by index.
+
+public:
+    CTreeChecksum(unsigned nThreads, size_t chunkSize);
+    virtual ~CTreeChecksum();
+private:
+    CTreeChecksum(const CTreeChecksum&);
+    CTreeChecksum& operator=(const CTreeChecksum&);
+public:
+    void   update(const void* pData, size_t nBytes);
+    Digest finish();
+
+    size_t getChunkSize() const { return m_nChunkSize; }
+    const std::vector<Digest>& getChunkDigests() const { return m_digests; }
+
+    static Digest sha512(const void* pData, size_t nBytes);
+    static std::string toHex(const Digest& digest);
+
+private:
+    void submit();
+    void collect(Job* pJob);
+};
+
+#endif
@@ -19,6 +19,8 @@
  *  @brief: Implement the ring chunk class.
  */
 #include "RingChunk.h"
+#include "CAsyncWriter.h"
+#include <CCompressedSegmentWriter.h>
 #include <CRingBuffer.h>
 #include <DataFormat.h>
 #include <iostream>
@@ -38,7 +40,9 @@ CRingChunk::CRingChunk(CRingBuffer* pBuffer, bool combine) :
     m_pRing(pBuffer),
     m_fChangeRunOk(combine),
     m_nRunNumber(0),
-    m_nFd(-1)
+    m_nFd(-1),
+    m_pWriter(nullptr),
+    m_pCompressor(nullptr)
 {}
 
 /**
@@ -64,6 +68,30 @@ CRingChunk::setFd(int newFd)
 {
     m_nFd = newFd;
 }
+/**
+ * setWriter
+ *    Sets the write behind thread (if any) that must be flushed before
+ *    an event segment is closed.
+ *
+ * @param pWriter - the writer, nullptr if writes are synchronous.
+ */
+void
+CRingChunk::setWriter(CAsyncWriter* pWriter)
+{
+    m_pWriter = pWriter;
+}
+/**
+ * setCompressor
+ *    Sets the compressor (if any) whose segment must be finished before
+ *    an event segment is closed.
+ *
+ * @param pCompressor - the compressor, nullptr if segments aren't compressed.
+ */
+void
+CRingChunk::setCompressor(CCompressedSegmentWriter* pCompressor)
+{
+    m_pCompressor = pCompressor;
+}
 
 /**
  * getChunk
@@ -156,6 +184,8 @@ CRingChunk::nextItemWraps()
 void
 CRingChunk::closeEventSegment()
 {
+  if (m_pCompressor) m_pCompressor->close(); // Last block and the index.
+  if (m_pWriter) m_pWriter->flush();        // Data must be in the file.
   off_t fileSize = lseek(m_nFd, 0, SEEK_CUR);  // Tricky way to get the offset.
   ftruncate(m_nFd, fileSize);
   close(m_nFd);
@@ -39,6 +39,8 @@ typedef struct _Chunk {
 // Forward definitions:
 
 class CRingBuffer;
+class CAsyncWriter;
+class CCompressedSegmentWriter;
 
 /**
  * @class RingChunk
@@ -66,6 +68,8 @@ private:
     bool         m_fChangeRunOk;      //< True if --combine-runs is set.
     uint32_t     m_nRunNumber;        //< Current run number.
     int          m_nFd;               //< Current file descriptor.
+    CAsyncWriter* m_pWriter;          //< Write behind thread if any.
+    CCompressedSegmentWriter* m_pCompressor; //< Segment compressor if any.
 public:
     CRingChunk(CRingBuffer* pBuffer, bool combine=false);
     
@@ -73,6 +77,8 @@ public:
     
     void setRunNumber(uint32_t newRun);
     void setFd(int newFd);
+    void setWriter(CAsyncWriter* pWriter);
+    void setCompressor(CCompressedSegmentWriter* pCompressor);
     
     // What used to be in eventlogMain
     
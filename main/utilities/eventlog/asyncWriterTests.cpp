@@ -0,0 +1,166 @@
+// Tests of the event logger's write behind thread.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include "CAsyncWriter.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+class asyncWriterTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(asyncWriterTest);
+  CPPUNIT_TEST(write_1);
+  CPPUNIT_TEST(write_2);
+  CPPUNIT_TEST(checksum);
+  CPPUNIT_TEST(twofiles);
+  CPPUNIT_TEST(stats);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  std::string m_name;
+  int         m_fd;
+public:
+  void setUp() {
+    char name[] = "/tmp/asyncwriterXXXXXX";
+    m_fd   = mkstemp(name);
+    m_name = name;
+  }
+  void tearDown() {
+    close(m_fd);
+    unlink(m_name.c_str());
+  }
+protected:
+  void write_1();
+  void write_2();
+  void checksum();
+  void twofiles();
+  void stats();
+private:
+  std::vector<uint8_t> pattern(size_t nBytes, uint8_t seed = 0);
+  std::vector<uint8_t> contents(int fd);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(asyncWriterTest);
+
+std::vector<uint8_t>
+asyncWriterTest::pattern(size_t nBytes, uint8_t seed)
+{
+  std::vector<uint8_t> result(nBytes);
+  for (size_t i = 0; i < nBytes; i++) {
+    result[i] = uint8_t(i*7 + seed);
+  }
+  return result;
+}
+std::vector<uint8_t>
+asyncWriterTest::contents(int fd)
+{
+  struct stat info;
+  fstat(fd, &info);
+  std::vector<uint8_t> result(info.st_size);
+  pread(fd, result.data(), result.size(), 0);
+  return result;
+}
+
+// Less than a buffer only gets to the file on flush.
+
+void asyncWriterTest::write_1()
+{
+  CAsyncWriter writer(2, CAsyncWriter::ALIGNMENT);
+  writer.start();
+  std::vector<uint8_t> data = pattern(100);
+
+  writer.write(m_fd, data.data(), data.size());
+  writer.flush();
+
+  ASSERT(data == contents(m_fd));
+}
+// Writes spanning several buffers, more than there are buffers,
+// with an unaligned tail:
+
+void asyncWriterTest::write_2()
+{
+  CAsyncWriter writer(2, CAsyncWriter::ALIGNMENT);
+  writer.start();
+  std::vector<uint8_t> data = pattern(10*CAsyncWriter::ALIGNMENT + 123);
+
+  size_t chunk = 1000;
+  for (size_t i = 0; i < data.size(); i += chunk) {
+    size_t n = data.size() - i;
+    if (n > chunk) n = chunk;
+    writer.write(m_fd, &data[i], n);
+  }
+  writer.flush();
+
+  ASSERT(data == contents(m_fd));
+}
+// The checksum function sees all the data in order:
+
+void asyncWriterTest::checksum()
+{
+  std::vector<uint8_t> summed;
+  CAsyncWriter writer(
+    3, CAsyncWriter::ALIGNMENT,
+    [&summed](void* p, size_t n) {
+      uint8_t* pData = static_cast<uint8_t*>(p);
+      summed.insert(summed.end(), pData, pData + n);
+    }
+  );
+  writer.start();
+  std::vector<uint8_t> data = pattern(5*CAsyncWriter::ALIGNMENT + 17);
+  writer.write(m_fd, data.data(), data.size());
+  writer.flush();
+
+  ASSERT(data == summed);
+}
+// Changing files sends the partial buffer to the old file:
+
+void asyncWriterTest::twofiles()
+{
+  char name[] = "/tmp/asyncwriterXXXXXX";
+  int fd2 = mkstemp(name);
+
+  CAsyncWriter writer(2, CAsyncWriter::ALIGNMENT);
+  writer.start();
+  std::vector<uint8_t> data1 = pattern(300, 1);
+  std::vector<uint8_t> data2 = pattern(500, 2);
+  writer.write(m_fd, data1.data(), data1.size());
+  writer.write(fd2, data2.data(), data2.size());
+  writer.flush();
+
+  ASSERT(data1 == contents(m_fd));
+  ASSERT(data2 == contents(fd2));
+
+  close(fd2);
+  unlink(name);
+}
+// Statistics:
+
+void asyncWriterTest::stats()
+{
+  CAsyncWriter writer(4, CAsyncWriter::ALIGNMENT);
+  writer.start();
+  std::vector<uint8_t> data = pattern(3*CAsyncWriter::ALIGNMENT + 1);
+  writer.write(m_fd, data.data(), data.size());
+  writer.flush();
+
+  CAsyncWriter::Statistics s = writer.getStatistics();
+  EQ(uint64_t(data.size()), s.s_nBytes);
+  EQ(uint64_t(4), s.s_nWrites);
+  EQ(unsigned(4), s.s_nBuffers);
+  ASSERT(s.s_maxQueueDepth >= 1);
+  ASSERT(s.s_maxQueueDepth <= 4);
+  ASSERT(s.s_elapsedTime >= s.s_writeTime);
+
+  writer.resetStatistics();
+  s = writer.getStatistics();
+  EQ(uint64_t(0), s.s_nBytes);
+  EQ(unsigned(0), s.s_maxQueueDepth);
+}
@@ -19,6 +19,10 @@
 #include "eventlogargs.h"
 
 #include "RingChunk.h"
+#include "CAsyncWriter.h"
+#include "CTreeChecksum.h"
+#include <CCompressedSegmentWriter.h>
+#include <CRingItemIndex.h>
 
 #include <CRingBuffer.h>
 
@@ -59,6 +63,7 @@ static const uint64_t G(K*M);
 static const int RING_TIMEOUT(5);	// seconds in timeout for end of run segments...need no data in that time.
 
 static const size_t BUFFERSIZE(M);   // ZFS Blocksize - let's write blocks that size:
+static const size_t TREE_CHUNKSIZE(16*M);  // Chunks hashed in parallel by --checksum-mode=tree
 
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -90,12 +95,23 @@ class noData :  public CRingBuffer::CRingBufferPredicate
    m_prefix("run"),
    m_pItem(nullptr),
    m_nItemSize(0),
-   m_pChunker(0)
+   m_pChunker(0),
+   m_pWriter(0),
+   m_fDirect(false),
+   m_pTreeChecksum(0),
+   m_pCompressor(0),
+   m_nSegmentFd(-1),
+   m_pIndex(0)
  {
  }
 
  EventLogMain::~EventLogMain()
- {}
+ {
+   delete m_pCompressor;            // Writes through m_pWriter.
+   delete m_pWriter;                // Stops the writer thread.
+   delete m_pTreeChecksum;
+   delete m_pIndex;
+ }
  //////////////////////////////////////////////////////////////////////////////////
  //
  // Object member functions:
@@ -159,14 +175,37 @@ class noData :  public CRingBuffer::CRingBufferPredicate
    sprintf(nameString, "/%s-%04d-%02d.evt", m_prefix.c_str(), runNumber, segment);
    fullPath += nameString;
 
-   int fd = open(fullPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 
-		 S_IWUSR | S_IRUSR | S_IRGRP);
+   int flags = O_RDWR | O_CREAT | O_EXCL;
+   int fd    = -1;
+   if (m_fDirect) {
+     fd = open(fullPath.c_str(), flags | O_DIRECT, S_IWUSR | S_IRUSR | S_IRGRP);
+     if ((fd == -1) && (errno == EINVAL)) {
+       cerr << "**Warning - " << m_eventDirectory
+	    << " does not support O_DIRECT, using buffered writes\n";
+       m_fDirect = false;
+     }
+   }
+   if (fd == -1) {
+     fd = open(fullPath.c_str(), flags, S_IWUSR | S_IRUSR | S_IRGRP);
+   }
    if (fd == -1) {
      perror("Open failed for event file segment"); 
      exit(EXIT_FAILURE);
    }
    
    m_pChunker->setFd(fd);
+   m_nSegmentFd   = fd;
+   m_segmentName  = fullPath;
+   if (m_pIndex) m_pIndex->clear();
+   if (m_pCompressor) {
+     try {
+       m_pCompressor->open(fd);
+     }
+     catch (int err) {
+       cerr << "Unable to write compressed segment header: " << strerror(err) << endl;
+       exit(EXIT_FAILURE);
+     }
+   }
    return fd;
 
  } 
@@ -317,6 +356,7 @@ class noData :  public CRingBuffer::CRingBufferPredicate
       fd         = openEventSegment(runNumber, segment);
       pItem      = new CRingStateChangeItem(item);
     }
+    if (m_pWriter) m_pWriter->resetStatistics();
     if (pItem->type() == BEGIN_RUN) {
       std::cerr << "Begin run in recordRun \n";
       m_nBeginsSeen++;
@@ -338,6 +378,9 @@ class noData :  public CRingBuffer::CRingBufferPredicate
     // Note that when writeInterior returns the last event segment is
     // closed.
     
+    if (m_pWriter) reportWriteStatistics(runNumber);
+    if (m_pTreeChecksum) writeTreeChecksum(runNumber);
+    
     // If requested, write the checksum file:
     
     if (m_pChecksumContext) {
@@ -411,6 +454,11 @@ class noData :  public CRingBuffer::CRingBufferPredicate
      std::cerr << "--oneshot is required to specify --run\n";
      exit(EXIT_FAILURE);
    }
+   if (parsed.index_flag && parsed.compress_flag) {
+     std::cerr << "--index can't be used with --compress; compressed segments "
+               << "have their own block index\n";
+     exit(EXIT_FAILURE);
+   }
    if (parsed.run_given) {
      m_fRunNumberOverride = true;
      m_nOverrideRunNumber = parsed.run_arg;
@@ -450,9 +498,47 @@ class noData :  public CRingBuffer::CRingBufferPredicate
 
    m_fChecksum = (parsed.checksum_flag != 0);
    m_fChangeRunOk = (parsed.combine_runs_flag != 0);
+   if (m_fChecksum && (std::string(parsed.checksum_mode_arg) == "tree")) {
+     m_pTreeChecksum = new CTreeChecksum(parsed.checksum_threads_arg, TREE_CHUNKSIZE);
+   }
    
    m_pChunker = new CRingChunk(m_pRing, m_fChangeRunOk);
 
+   // Write behind thread.  Checksumming moves into it too:
+
+   if (parsed.direct_flag && (parsed.write_buffers_arg <= 0)) {
+     cerr << "--direct requires --write-buffers\n";
+     exit(EXIT_FAILURE);
+   }
+   if (parsed.write_buffers_arg > 0) {
+     CAsyncWriter::Checksummer checksum;
+     if (m_fChecksum) {
+       checksum = [this](void* pData, size_t nBytes) {
+         checksumData(pData, nBytes);
+       };
+     }
+     m_pWriter = new CAsyncWriter(parsed.write_buffers_arg, BUFFERSIZE, checksum);
+     m_pWriter->start();
+     m_pChunker->setWriter(m_pWriter);
+     m_fDirect = (parsed.direct_flag != 0);
+   }
+   // Compression.  The compressed data go where uncompressed data
+   // would have (write behind thread, checksum) so checksums are of the
+   // files as written.
+
+   if (parsed.compress_flag) {
+     m_pCompressor = new CCompressedSegmentWriter(
+       parsed.compress_threads_arg, BUFFERSIZE, 1,
+       [this](const void* pData, size_t nBytes) {
+         writeFileData(m_nSegmentFd, const_cast<void*>(pData), nBytes);
+       }
+     );
+     m_pChunker->setCompressor(m_pCompressor);
+   }
+   if (parsed.index_flag) {
+     m_pIndex = new CRingItemIndex(parsed.index_interval_arg);
+   }
+
  }
 
  /*
@@ -573,26 +659,10 @@ EventLogMain::writeItem(int fd, CRingItem& item)
       void*    pItem = item.getItemPointer();
       uint32_t nBytes= itemSize(item);
 
-      // If necessary create the checksum context
-      // If checksumming add the ring item to the sum.
-
-      if (m_fChecksum) {
-        if (!m_pChecksumContext) {
-          m_pChecksumContext = EVP_MD_CTX_create();
-          if (!m_pChecksumContext) throw errno;
-          if(EVP_DigestInit_ex(
-              reinterpret_cast<EVP_MD_CTX*>(m_pChecksumContext), EVP_sha512(), NULL) != 1) {
-            EVP_MD_CTX_destroy(reinterpret_cast<EVP_MD_CTX*>(m_pChecksumContext));
-            m_pChecksumContext = 0;
-            throw std::string("Unable to initialize the checksum digest");
-          }
-      
-        }
-        EVP_DigestUpdate(
-               reinterpret_cast<EVP_MD_CTX*>(m_pChecksumContext), pItem, nBytes);
-      }
-      io::writeData(fd, pItem, nBytes);
-      //io::writeData(fd, pItem, nBytes);
+      // writeData checksums if needed and goes through the write behind
+      // thread if there is one so the items stay in order.
+
+      writeData(fd, pItem, nBytes);
     }
     catch(int err) {
       if(err) {
@@ -624,11 +694,12 @@ EventLogMain::itemSize(CRingItem& item) const
  *    Compute the filename for the checksum for a run.
  *
  * @param run - Run number
+ * @param suffix - File type.
  * 
  * @return std::string - the filename.
  */
 std::string
-EventLogMain::shaFile(int run) const
+EventLogMain::shaFile(int run, const char* suffix) const
 {
   char runNumber[100];
   sprintf(runNumber, "%04d", run);
@@ -636,7 +707,7 @@ EventLogMain::shaFile(int run) const
   std::string fileName = m_eventDirectory;
   fileName+= ("/" + m_prefix + "-");
   fileName+= runNumber;
-  fileName += ".sha512";
+  fileName += suffix;
 
   return fileName;
 }
@@ -700,7 +771,7 @@ EventLogMain::writeInterior(int fd, uint32_t runNumber, uint64_t bytesSoFar)
       m_pRing->skip(nextChunk.s_nBytes);
       bytesSoFar += nextChunk.s_nBytes;
       if (bytesSoFar >= m_segmentSize) {
-        m_pChunker->closeEventSegment();
+        closeEventSegment();
         fd = openEventSegment(runNumber, ++segno);
         bytesSoFar  = 0;
       }
@@ -710,13 +781,13 @@ EventLogMain::writeInterior(int fd, uint32_t runNumber, uint64_t bytesSoFar)
     // See if we've got a balanced set of begins/ends:
     
     if(endsSeen >= m_nBeginsSeen) {
-      m_pChunker->closeEventSegment();
+      closeEventSegment();
       return;                      // The run is recorded.
     } else if (endsSeen && dataTimeout()) {
       
       // If we time out on data, then end abnormally:
       
-      m_pChunker->closeEventSegment();
+      closeEventSegment();
       std::cerr << " Timed out with " << m_nBeginsSeen - endsSeen
         << " ends still not seen\n";
       return;
@@ -726,6 +797,62 @@ EventLogMain::writeInterior(int fd, uint32_t runNumber, uint64_t bytesSoFar)
     }
   }
 }
+/**
+ * writeTreeChecksum
+ *    Write the --checksum-mode=tree file for a run.  The first line
+ *    gives the chunk size, then there's a line with the sha512 of each
+ *    chunk of the run's data (as if the segments were concatenated) and
+ *    the last line is the run digest: the sha512 of the binary chunk
+ *    digests.
+ *
+ * @param runNumber - the run just recorded.
+ */
+void
+EventLogMain::writeTreeChecksum(uint32_t runNumber)
+{
+  CTreeChecksum::Digest runDigest = m_pTreeChecksum->finish();
+  const std::vector<CTreeChecksum::Digest>& chunks =
+    m_pTreeChecksum->getChunkDigests();
+  
+  std::string digestFilename = shaFile(runNumber, ".sha512tree");
+  FILE* shafp = fopen(digestFilename.c_str(), "w");
+  
+  // As with the sha512 file not sure what to do if the open failed.
+  
+  if (shafp) {
+    fprintf(shafp, "chunksize %lu\n", (unsigned long)m_pTreeChecksum->getChunkSize());
+    for (int i = 0; i < chunks.size(); i++) {
+      fprintf(shafp, "%s  %d\n", CTreeChecksum::toHex(chunks[i]).c_str(), i);
+    }
+    fprintf(shafp, "%s  run\n", CTreeChecksum::toHex(runDigest).c_str());
+    fclose(shafp);
+  }
+}
+/**
+ * reportWriteStatistics
+ *    Report how the write behind thread did for the run.  The sustained
+ *    rate is over the whole run, the disk rate is over the time actually
+ *    spent writing.  A max queue depth at the number of buffers (and
+ *    stalls) means the disk fell behind and the ring had to absorb it.
+ *
+ * @param runNumber - the run just recorded.
+ */
+void
+EventLogMain::reportWriteStatistics(uint32_t runNumber)
+{
+  CAsyncWriter::Statistics stats = m_pWriter->getStatistics();
+  double mBytes = double(stats.s_nBytes)/M;
+  
+  std::cerr << "Run " << runNumber << ": wrote " << mBytes << " MB in "
+    << stats.s_elapsedTime << " s: "
+    << (stats.s_elapsedTime > 0 ? mBytes/stats.s_elapsedTime : 0.0)
+    << " MB/s sustained, "
+    << (stats.s_writeTime > 0 ? mBytes/stats.s_writeTime : 0.0)
+    << " MB/s to disk. Write queue depth max " << stats.s_maxQueueDepth
+    << " average " << stats.s_averageQueueDepth
+    << " of " << stats.s_nBuffers << " buffers, "
+    << stats.s_nStalls << " stalls waiting for a buffer\n";
+}
 /**
  *  WaitForLotsOfData
  *      Wait for lots of data to be available on a ring buffer.
@@ -780,7 +907,7 @@ EventLogMain::writeWrappedItem(int fd, int& ends)
   if (pH->s_type == BEGIN_RUN) {
     m_nBeginsSeen++;
     if(badBegin(pH)) {
-        m_pChunker->closeEventSegment();
+        closeEventSegment();
         std::cerr << " Begin run changed run number without --combine-runs "
           << " or too many begin runs for the data source count\n";
         exit(EXIT_FAILURE);
@@ -793,6 +920,48 @@ EventLogMain::writeWrappedItem(int fd, int& ends)
 }
 /**
  * writeData
+ *    Writes ring items to the file.  If the segments are compressed the
+ *    data go to the compressor, which passes compressed blocks on to
+ *    writeFileData.
+ *
+ *  @param pData - pointer to the data to write.
+ *  @param nBytes - Number of bytes of data to write.
+ */
+void
+EventLogMain::writeData(int fd, void* pData, size_t nBytes)
+{
+  if (m_pIndex) {
+    m_pIndex->add(pData, nBytes);
+  }
+  if (m_pCompressor) {
+    m_pCompressor->write(pData, nBytes);
+  } else {
+    writeFileData(fd, pData, nBytes);
+  }
+}
+/**
+ * closeEventSegment
+ *    Close the current event segment and, if requested, write its ring
+ *    item index.  Failing to write the index is not fatal; it can be
+ *    made later with evtindex.
+ */
+void
+EventLogMain::closeEventSegment()
+{
+  m_pChunker->closeEventSegment();
+  if (m_pIndex) {
+    try {
+      m_pIndex->write(CRingItemIndex::indexFileName(m_segmentName));
+    }
+    catch (std::exception& e) {
+      std::cerr << "**Warning - unable to write the index for " << m_segmentName
+		<< ": " << e.what() << std::endl;
+    }
+    m_pIndex->clear();
+  }
+}
+/**
+ * writeFileData
  *    Writes data to the file.  If checksumming is enabled the checksum
  *    is updated.
  *
@@ -800,8 +969,15 @@ EventLogMain::writeWrappedItem(int fd, int& ends)
  *  @param nBytes - Number of bytes of data to write.
  */
 void
-EventLogMain::writeData(int fd, void* pData, size_t nBytes)
+EventLogMain::writeFileData(int fd, void* pData, size_t nBytes)
 {
+  // The write behind thread does the checksum as it writes:
+  
+  if (m_pWriter) {
+    m_pWriter->write(fd, pData, nBytes);
+    return;
+  }
+  
   uint8_t* p = static_cast<uint8_t*>(pData);
   size_t  nLeft = nBytes;
   while (nLeft > BUFFERSIZE) {
@@ -830,6 +1006,13 @@ EventLogMain::writeData(int fd, void* pData, size_t nBytes)
 void
 EventLogMain::checksumData(void* pData, size_t nBytes)
 {
+  // The tree checksum just queues the data to its threads:
+  
+  if (m_pTreeChecksum) {
+    m_pTreeChecksum->update(pData, nBytes);
+    return;
+  }
+  
   // If we need to make the checksum context:
   
   if(!m_pChecksumContext) {
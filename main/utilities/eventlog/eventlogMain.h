@@ -33,6 +33,10 @@ class CRingItem;
 class CRingStateChangeItem;
 class CZCopyRingBuffer;
 class CRingChunk;
+class CAsyncWriter;
+class CTreeChecksum;
+class CCompressedSegmentWriter;
+class CRingItemIndex;
 
 
 /*!
@@ -61,6 +65,13 @@ private:
   size_t            m_nItemSize;
   uint32_t          m_nRunNumber;
   CRingChunk*        m_pChunker;
+  CAsyncWriter*     m_pWriter;
+  bool              m_fDirect;
+  CTreeChecksum*    m_pTreeChecksum;
+  CCompressedSegmentWriter* m_pCompressor;
+  int               m_nSegmentFd;
+  std::string       m_segmentName;
+  CRingItemIndex*   m_pIndex;
   
 
   
@@ -93,15 +104,19 @@ private:
   bool  dirOk(std::string dirname) const;
   bool  dataTimeout();
   size_t itemSize(CRingItem& item) const;
-  std::string shaFile(int runNumber) const;
+  std::string shaFile(int runNumber, const char* suffix = ".sha512") const;
+  void writeTreeChecksum(uint32_t runNumber);
   
 
 
   void writeInterior(int fd, uint32_t runNumber, uint64_t bytesSoFar);  
+  void reportWriteStatistics(uint32_t runNumber);
   void waitForLotsOfData(); 
 
   size_t writeWrappedItem(int fd, int& ends);
   void writeData(int fd, void* pData, size_t nBytes);
+  void writeFileData(int fd, void* pData, size_t nBytes);
+  void closeEventSegment();
   void checksumData(void* pData, size_t nBytes);
   bool badBegin(void* p);
 };
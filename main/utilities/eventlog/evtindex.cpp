@@ -0,0 +1,119 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  evtindex.cpp
+ *  @brief: Make ring item index sidecars for existing event files.
+ *
+ *  Usage:
+ *     evtindex [-i interval] file...
+ *
+ *  For each file, file.idx is written (see CRingItemIndex.h).  Compressed
+ *  event segments are refused: index offsets are into the uncompressed
+ *  data, which can't be seeked to, and the segments have their own block
+ *  index.
+ */
+#include <CRingItemIndex.h>
+#include <CRingFileBlockReader.h>
+#include <CCompressedSegment.h>
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <stdlib.h>
+#include <fcntl.h>
+
+static const size_t BLOCKSIZE(16*1024*1024);     // Must hold the biggest item.
+
+static void usage()
+{
+  std::cerr << "Usage:\n";
+  std::cerr << "   evtindex [-i interval] file...\n";
+  std::cerr << "      -i  - every interval'th physics item is indexed (default "
+            << CRingItemIndex::DEFAULT_INTERVAL << ")\n";
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * indexFile
+ *    Index one file.
+ *
+ * @param index    - the index to fill (emptied first).
+ * @param filename - the event file.
+ */
+static void
+indexFile(CRingItemIndex& index, const std::string& filename)
+{
+  CompressedSegment::FileHeader header;
+  ssize_t n  = -1;
+  int     fd = open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    n = pread(fd, &header, sizeof(header), 0);
+    close(fd);
+  }
+  if ((n >= 0) && CompressedSegment::isCompressed(&header, n)) {
+    throw std::runtime_error(
+      "compressed segments have their own block index; not indexed"
+    );
+  }
+  index.clear();
+  CRingFileBlockReader reader(filename.c_str());
+  while (1) {
+    CRingBlockReader::DataDescriptor d = reader.read(BLOCKSIZE);
+    if (!d.s_nBytes) {
+      free(d.s_pData);
+      break;
+    }
+    index.add(d.s_pData, d.s_nBytes);
+    free(d.s_pData);
+  }
+  index.write(CRingItemIndex::indexFileName(filename));
+}
+
+int
+main(int argc, char** argv)
+{
+  unsigned interval = CRingItemIndex::DEFAULT_INTERVAL;
+  int      opt;
+  while ((opt = getopt(argc, argv, "i:")) != -1) {
+    switch (opt) {
+    case 'i':
+      interval = atoi(optarg);
+      if (!interval) usage();
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind >= argc) usage();
+
+  CRingItemIndex index(interval);
+  int status = EXIT_SUCCESS;
+  for (int i = optind; i < argc; i++) {
+    try {
+      indexFile(index, argv[i]);
+      std::cout << argv[i] << ": " << index.getItemCount() << " items, "
+                << index.entries().size() << " indexed\n";
+    }
+    catch (std::exception& e) {
+      std::cerr << argv[i] << ": " << e.what() << std::endl;
+      status = EXIT_FAILURE;
+    }
+  }
+  return status;
+}
@@ -0,0 +1,132 @@
+// Tests of the chunked (tree) checksum.
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+
+#include "CTreeChecksum.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+class treeChecksumTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(treeChecksumTest);
+  CPPUNIT_TEST(hex);
+  CPPUNIT_TEST(chunks);
+  CPPUNIT_TEST(pieces);
+  CPPUNIT_TEST(reuse);
+  CPPUNIT_TEST(empty);
+  CPPUNIT_TEST_SUITE_END();
+
+
+private:
+  CTreeChecksum* m_pTestObj;
+public:
+  void setUp() {
+    m_pTestObj = new CTreeChecksum(3, 1000);
+  }
+  void tearDown() {
+    delete m_pTestObj;
+  }
+protected:
+  void hex();
+  void chunks();
+  void pieces();
+  void reuse();
+  void empty();
+private:
+  std::vector<uint8_t> pattern(size_t nBytes, uint8_t seed = 0);
+  void check(std::vector<uint8_t>& data, CTreeChecksum::Digest& digest);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(treeChecksumTest);
+
+std::vector<uint8_t>
+treeChecksumTest::pattern(size_t nBytes, uint8_t seed)
+{
+  std::vector<uint8_t> result(nBytes);
+  for (size_t i = 0; i < nBytes; i++) {
+    result[i] = uint8_t(i*13 + seed);
+  }
+  return result;
+}
+// Compute the tree checksum of data serially and compare with digest
+// and the chunk digests.
+
+void
+treeChecksumTest::check(std::vector<uint8_t>& data, CTreeChecksum::Digest& digest)
+{
+  size_t chunk = m_pTestObj->getChunkSize();
+  std::vector<uint8_t> leaves;
+  const std::vector<CTreeChecksum::Digest>& chunks = m_pTestObj->getChunkDigests();
+  EQ((data.size() + chunk - 1)/chunk, chunks.size());
+  
+  for (size_t i = 0; i < data.size(); i += chunk) {
+    size_t n = data.size() - i;
+    if (n > chunk) n = chunk;
+    CTreeChecksum::Digest leaf = CTreeChecksum::sha512(&data[i], n);
+    ASSERT(leaf == chunks[i/chunk]);
+    leaves.insert(leaves.end(), leaf.begin(), leaf.end());
+  }
+  ASSERT(CTreeChecksum::sha512(leaves.data(), leaves.size()) == digest);
+}
+
+// sha512 of "abc" is a well known test vector:
+
+void treeChecksumTest::hex()
+{
+  CTreeChecksum::Digest d = CTreeChecksum::sha512("abc", 3);
+  EQ(std::string(
+    "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+    "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"),
+    CTreeChecksum::toHex(d)
+  );
+}
+// Data that's several chunks, more than there are buffers:
+
+void treeChecksumTest::chunks()
+{
+  std::vector<uint8_t> data = pattern(10500);
+  m_pTestObj->update(data.data(), data.size());
+  CTreeChecksum::Digest d = m_pTestObj->finish();
+  check(data, d);
+}
+// Chunking doesn't depend on how the data are handed in:
+
+void treeChecksumTest::pieces()
+{
+  std::vector<uint8_t> data = pattern(7777);
+  for (size_t i = 0; i < data.size(); i += 333) {
+    size_t n = data.size() - i;
+    if (n > 333) n = 333;
+    m_pTestObj->update(&data[i], n);
+  }
+  CTreeChecksum::Digest d = m_pTestObj->finish();
+  check(data, d);
+}
+// After finish the next run starts from scratch:
+
+void treeChecksumTest::reuse()
+{
+  std::vector<uint8_t> data1 = pattern(5000, 1);
+  m_pTestObj->update(data1.data(), data1.size());
+  m_pTestObj->finish();
+
+  std::vector<uint8_t> data2 = pattern(2500, 2);
+  m_pTestObj->update(data2.data(), data2.size());
+  CTreeChecksum::Digest d = m_pTestObj->finish();
+  check(data2, d);
+}
+// No data - the run digest is the sha512 of nothing.
+
+void treeChecksumTest::empty()
+{
+  std::vector<uint8_t> data = pattern(100);
+  m_pTestObj->update(data.data(), data.size());
+  m_pTestObj->finish();
+  
+  CTreeChecksum::Digest d = m_pTestObj->finish();
+  EQ(size_t(0), m_pTestObj->getChunkDigests().size());
+  ASSERT(CTreeChecksum::sha512("", 0) == d);
+}
@@ -22,6 +22,9 @@ static const char* Copyright = "(C) Copyright Michigan State University 2014, Al
 #include "CMediator.h"
 #include "COneShotMediator.h"
 #include "CInfiniteMediator.h"
+#include "CParallelMediator.h"
+#include "CViewMediator.h"
+#include "CFilterViewAdapter.h"
 #include "CDataSourceFactory.h"
 #include "CDataSinkFactory.h"
 #include <string>
@@ -48,6 +51,7 @@ bool CFilterMain::m_testing(false);
 */
 CFilterMain::CFilterMain(int argc, char** argv)
   : m_mediator(0),
+  m_viewMediator(0),
   m_argsInfo(new gengetopt_args_info),
   m_pSink(nullptr)
 {
@@ -58,6 +62,9 @@ CFilterMain::CFilterMain(int argc, char** argv)
     if (m_argsInfo->oneshot_given) {
       m_mediator = new COneShotMediator(0,new CCompositeFilter,0,
           m_argsInfo->number_of_sources_arg); 
+    } else if (m_argsInfo->threads_arg > 1) {
+      m_mediator = new CParallelMediator(0,new CCompositeFilter,0,
+          m_argsInfo->threads_arg);
     } else {
       m_mediator = new CInfiniteMediator(0,new CCompositeFilter,0);
     }
@@ -102,6 +109,7 @@ CFilterMain::~CFilterMain()
 {
   delete m_argsInfo;
   delete m_mediator;
+  delete m_viewMediator;
 }
 
 /**! Append a filter to the mediator's ccomposite filter
@@ -113,12 +121,48 @@ CFilterMain::~CFilterMain()
  */
 void CFilterMain::registerFilter(const CFilter* filter)
 {
+  if (m_viewMediator) {
+    CFilterViewAdapter adapter(filter->clone());
+    m_viewMediator->registerFilter(&adapter);
+    return;
+  }
   // We will always have a composite filter in this main
   CCompositeFilter* main_filter=0;
   main_filter = dynamic_cast<CCompositeFilter*>(m_mediator->getFilter());
 
   main_filter->registerFilter(filter);
 }
+/**! Append a zero copy filter.
+  On the first one, the source, sink, counts and any filters registered
+  so far are moved from the mediator into a CViewMediator which is used
+  from then on.
+
+  \param filter a template of the filter to register
+*/
+void CFilterMain::registerViewFilter(const CViewFilter* filter)
+{
+  if (!m_viewMediator) {
+    if (m_argsInfo->oneshot_given) {
+      std::cerr << "Zero copy filters can't be used with --oneshot\n";
+      throw CFatalException();
+    }
+    std::unique_ptr<CDataSource> source;
+    std::unique_ptr<CDataSink>   sink;
+    m_mediator->setDataSource(source);
+    m_mediator->setDataSink(sink);
+    m_viewMediator = new CViewMediator(std::move(source), std::move(sink));
+    m_viewMediator->setSkipCount(m_mediator->getSkipCount());
+    m_viewMediator->setProcessCount(m_mediator->getProcessCount());
+
+    CCompositeFilter* legacy =
+      dynamic_cast<CCompositeFilter*>(m_mediator->getFilter());
+    if (legacy->size()) {
+      CFilterViewAdapter adapter(legacy->clone());
+      m_viewMediator->registerFilter(&adapter);
+    }
+  }
+  m_viewMediator->registerFilter(filter);
+}
 /**
  * putRingItem
  *    Puts a ring item to the data sink.  This is our solution to
@@ -126,11 +170,17 @@ void CFilterMain::registerFilter(const CFilter* filter)
  *    per input ring item.
  *
  * @param pRingItem - pointer to the ring item to put to the sink.
+ *
+ * @note With --threads the filter may be running on a worker thread; the
+ *       item is then handed to the parallel mediator so it's written in
+ *       order from the main thread.
  */
  void
  CFilterMain::putRingItem(CRingItem* pRingItem)
  {
-  m_pSink->putItem(*pRingItem);
+  if (!CParallelMediator::captureItem(*pRingItem)) {
+    m_pSink->putItem(*pRingItem);
+  }
  }
 
 /////////////////////////////////////////////////////////
@@ -161,8 +211,9 @@ CDataSource* CFilterMain::constructDataSource()
   // Set up the excludes
   std::vector<uint16_t> exclude = constructExcludesList();
   
-  CDataSource* source=0;
-  return CDataSourceFactory().makeSource(source_name,sample,exclude);
+  // Event files are mapped rather than read when possible:
+
+  return CDataSourceFactory().makeMappedSource(source_name,sample,exclude);
  }
 }
 
@@ -192,14 +243,16 @@ CDataSink* CFilterMain::constructDataSink()
     that the processing occurs in the application. */
 void CFilterMain::operator()()
 {
+  CBaseMediator* mediator = m_viewMediator ?
+    static_cast<CBaseMediator*>(m_viewMediator) : m_mediator;
   try {
-    m_mediator->initialize();
+    mediator->initialize();
 
     // allow the finalize operations to be called if an exception is 
     // thrown from the main loop. Consider the arrival of an 
     // ABNORMAL_ENDRUN
     try {
-      m_mediator->mainLoop();
+      mediator->mainLoop();
     } catch (CException& exc) {
       std::cerr << exc.WasDoing() << " : " << exc.ReasonText() << std::endl;
     } catch (...) {
@@ -207,7 +260,7 @@ void CFilterMain::operator()()
       std::cerr << "Shutting down filter." << std::endl;
     }
 
-    m_mediator->finalize();
+    mediator->finalize();
   } catch (CException& exc) {
     std::cerr << exc.WasDoing() << " : " << exc.ReasonText() << std::endl;
     throw CFatalException(); 
@@ -25,8 +25,10 @@
 #include <CFatalException.h>
 
 class CMediator;
+class CViewMediator;
 class CDataSource;
 class CFilter;
+class CViewFilter;
 class CDataSink;
 class CRingItem;
 struct gengetopt_args_info;
@@ -36,6 +38,7 @@ class CFilterMain
   
   private:
     CMediator* m_mediator; //!< The mediator
+    CViewMediator* m_viewMediator; //!< Replaces it once view filters are registered.
     struct gengetopt_args_info* m_argsInfo; //!< The parsed options
     CDataSink* m_pSink;    //!< data sink.
 public:
@@ -74,6 +77,17 @@ public:
     */
     void registerFilter(const CFilter* filter);
 
+    /**! Append a zero copy filter.
+      The first of these switches processing to a CViewMediator.  Filters
+      registered before that are run, in order, through a
+      CFilterViewAdapter, as are any CFilter registered afterwards.
+      Not supported with --oneshot.
+
+      \param filter a template of the filter to register
+      \throw CFatalException in oneshot mode.
+    */
+    void registerViewFilter(const CViewFilter* filter);
+
     /**! Retrieve the mediator
      *
      * Ownership of the mediator remains with the CFilterMain instance.
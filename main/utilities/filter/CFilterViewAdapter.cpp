@@ -0,0 +1,107 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CFilterViewAdapter.cpp
+ *  @brief: Implement the CFilter to CViewFilter adapter.
+ */
+#include "CFilterViewAdapter.h"
+#include "CFilter.h"
+#include "CMediator.h"
+
+#include <CRingItem.h>
+#include <string.h>
+
+/**
+ * constructor
+ *   @param pFilter - the filter to adapt, must be dynamically allocated.
+ */
+CFilterViewAdapter::CFilterViewAdapter(CFilter* pFilter) :
+  m_pFilter(pFilter)
+{}
+/**
+ * copy constructor
+ *   The filter is cloned; the input item isn't shared.
+ */
+CFilterViewAdapter::CFilterViewAdapter(const CFilterViewAdapter& rhs) :
+  CViewFilter(rhs), m_pFilter(rhs.m_pFilter->clone())
+{}
+/**
+ * destructor
+ */
+CFilterViewAdapter::~CFilterViewAdapter()
+{}
+
+/**
+ * clone
+ */
+CFilterViewAdapter*
+CFilterViewAdapter::clone() const
+{
+  return new CFilterViewAdapter(*this);
+}
+/**
+ * handleItem
+ *    Run the item through the filter.
+ *
+ * @param pItem  - raw item.
+ * @param output - where what the filter returns is put.
+ * @return Disposition - drop if the filter returned null, else replace.
+ */
+CViewFilter::Disposition
+CFilterViewAdapter::handleItem(const RingItem* pItem, CFilterOutputBuffer& output)
+{
+  CRingItem* pInput  = inputItem(pItem);
+  CRingItem* pResult = CMediator::dispatchItem(*m_pFilter, pInput);
+  if (!pResult) return drop;
+
+  output.copy(pResult->getItemPointer());
+  if (pResult != pInput) {
+    delete pResult;
+  }
+  return replace;
+}
+void
+CFilterViewAdapter::initialize()
+{
+  m_pFilter->initialize();
+}
+void
+CFilterViewAdapter::finalize()
+{
+  m_pFilter->finalize();
+}
+
+/**
+ * inputItem
+ *    Copy a raw item into the reused CRingItem, making a bigger one
+ *    if it won't fit.
+ *
+ * @param pItem - the raw item.
+ * @return CRingItem* - the filled in item.
+ */
+CRingItem*
+CFilterViewAdapter::inputItem(const RingItem* pItem)
+{
+  uint32_t size = itemSize(pItem);
+  if (!m_pItem || (m_pItem->getStorageSize() < size)) {
+    m_pItem.reset(new CRingItem(itemType(pItem), size));
+  }
+  uint8_t* pDest = reinterpret_cast<uint8_t*>(m_pItem->getItemPointer());
+  memcpy(pDest, pItem, size);
+  m_pItem->setBodyCursor(pDest + size);
+  return m_pItem.get();
+}
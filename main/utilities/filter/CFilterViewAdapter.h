@@ -0,0 +1,66 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CFilterViewAdapter.h
+ *  @brief: Run a CFilter as a CViewFilter.
+ */
+#ifndef CFILTERVIEWADAPTER_H
+#define CFILTERVIEWADAPTER_H
+
+#include "CViewFilter.h"
+#include <memory>
+
+class CFilter;
+class CRingItem;
+
+/**! \class CFilterViewAdapter
+  Lets CFilter subclasses run in a view filter pipeline.  Each item is
+  copied into a CRingItem that's reused from item to item (it's only
+  reallocated when an item bigger than any before comes along) and handed
+  to the filter's handler for its type, just as CMediator does.  Whatever
+  the filter returns is copied to the output buffer.
+
+  The filter itself may still allocate a new item each time it's called;
+  only filters written to the CViewFilter interface avoid that.
+*/
+class CFilterViewAdapter : public CViewFilter
+{
+  private:
+    std::unique_ptr<CFilter>   m_pFilter;
+    std::unique_ptr<CRingItem> m_pItem;     // Reused input item.
+
+  public:
+    CFilterViewAdapter(CFilter* pFilter);   // We own the filter.
+    CFilterViewAdapter(const CFilterViewAdapter& rhs);
+    virtual ~CFilterViewAdapter();
+
+  private:
+    CFilterViewAdapter& operator=(const CFilterViewAdapter&);
+
+  public:
+    virtual CFilterViewAdapter* clone() const;
+    virtual Disposition handleItem(const RingItem* pItem, CFilterOutputBuffer& output);
+    virtual void initialize();
+    virtual void finalize();
+
+    CFilter* getFilter() { return m_pFilter.get(); }
+
+  private:
+    CRingItem* inputItem(const RingItem* pItem);
+};
+
+#endif
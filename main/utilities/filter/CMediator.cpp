@@ -72,6 +72,18 @@ CMediator::~CMediator()
 }
 
 CRingItem* CMediator::handleItem(CRingItem* item)
+{
+  return dispatchItem(*m_pFilter, item);
+}
+
+/**! Pass an item to the handler of a filter for its type.
+  This is shared with CFilterViewAdapter.
+
+  \param filter the filter
+  \param item   the item to handle
+  \return whatever the handler returns
+*/
+CRingItem* CMediator::dispatchItem(CFilter& filter, CRingItem* item)
 {
   // initial pointer to filtered item
   CRingItem* fitem = item;
@@ -82,40 +94,40 @@ CRingItem* CMediator::handleItem(CRingItem* item)
     case END_RUN:
     case PAUSE_RUN:
     case RESUME_RUN:
-      fitem = m_pFilter->handleStateChangeItem(static_cast<CRingStateChangeItem*>(item));
+      fitem = filter.handleStateChangeItem(static_cast<CRingStateChangeItem*>(item));
       break;
 
       // Documentation items
     case PACKET_TYPES:
     case MONITORED_VARIABLES:
-      fitem = m_pFilter->handleTextItem(static_cast<CRingTextItem*>(item));
+      fitem = filter.handleTextItem(static_cast<CRingTextItem*>(item));
       break;
 
       // Scaler items
     case PERIODIC_SCALERS:
-      fitem = m_pFilter->handleScalerItem(static_cast<CRingScalerItem*>(item));
+      fitem = filter.handleScalerItem(static_cast<CRingScalerItem*>(item));
       break;
 
       // Physics event item
     case PHYSICS_EVENT:
-      fitem = m_pFilter->handlePhysicsEventItem(static_cast<CPhysicsEventItem*>(item));
+      fitem = filter.handlePhysicsEventItem(static_cast<CPhysicsEventItem*>(item));
       break;
 
       // Physics event count
     case PHYSICS_EVENT_COUNT:
-      fitem = m_pFilter->handlePhysicsEventCountItem(static_cast<CRingPhysicsEventCountItem*>(item));
+      fitem = filter.handlePhysicsEventCountItem(static_cast<CRingPhysicsEventCountItem*>(item));
       break;
 
       // Event builder fragment handlers
     case EVB_FRAGMENT:
     case EVB_UNKNOWN_PAYLOAD:
-      fitem = m_pFilter->handleFragmentItem(static_cast<CRingFragmentItem*>(item));
+      fitem = filter.handleFragmentItem(static_cast<CRingFragmentItem*>(item));
       break;
 
       // Handle any other generic ring item...this can be 
       // the hook for handling user-defined items
     default:
-      fitem = m_pFilter->handleRingItem(item);
+      fitem = filter.handleRingItem(item);
       break;
   }
 
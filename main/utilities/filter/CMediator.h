@@ -107,6 +107,11 @@ class CMediator : public CBaseMediator
     */
     virtual CRingItem* handleItem(CRingItem* item); 
 
+  public:
+    /**! Delegate item to proper handler of a filter
+    */
+    static CRingItem* dispatchItem(CFilter& filter, CRingItem* item);
+
 };
 
 #endif
@@ -0,0 +1,398 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CParallelMediator.cpp
+ *  @brief: Implement the multi-threaded filter mediator.
+ */
+#include "CParallelMediator.h"
+
+#include <CDataSource.h>
+#include <CDataSink.h>
+#include <CFilter.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+
+// Where captureItem puts items emitted by the filter this thread is
+// running; null if they should go straight to the sink.
+
+static thread_local std::vector<CRingItem*>* pCaptured(nullptr);
+
+namespace {
+  // Captures emitted items for a scope:
+
+  class Capture {
+  public:
+    Capture(std::vector<CRingItem*>* pItems) { pCaptured = pItems; }
+    ~Capture() { pCaptured = nullptr; }
+  };
+}
+
+/**
+ * constructor
+ *
+ * @param source    - data source (owned).
+ * @param filter    - the filter; it's the template for the per thread
+ *                    clones (owned).
+ * @param sink      - data sink (owned).
+ * @param nThreads  - number of filter threads (at least 1).
+ * @param batchSize - physics events handed to a thread at a time.
+ */
+CParallelMediator::CParallelMediator(
+  CDataSource* source, CFilter* filter, CDataSink* sink,
+  unsigned nThreads, size_t batchSize
+) :
+  CMediator(source, filter, sink),
+  m_nThreads(nThreads ? nThreads : 1), m_nBatchSize(batchSize ? batchSize : 1),
+  m_pCurrent(nullptr), m_nSubmitted(0), m_nWritten(0)
+{
+  for (unsigned i = 0; i < 2*m_nThreads; i++) {
+    Batch* pBatch = new Batch;
+    pBatch->s_items.reserve(m_nBatchSize);
+    m_allBatches.push_back(pBatch);
+    m_freeBatches.queue(pBatch);
+  }
+}
+/**
+ * destructor
+ *    Stop the workers and get rid of any items still in batches
+ *    (only if the main loop exited with an exception).
+ */
+CParallelMediator::~CParallelMediator()
+{
+  stopWorkers();
+  for (int i = 0; i < m_allBatches.size(); i++) {
+    std::vector<CRingItem*>& items(m_allBatches[i]->s_items);
+    for (int j = 0; j < items.size(); j++) {
+      delete items[j];
+    }
+    delete m_allBatches[i];
+  }
+}
+
+/**
+ * mainLoop
+ *    Same as CInfiniteMediator::mainLoop but physics events are filtered
+ *    by the workers.
+ */
+void
+CParallelMediator::mainLoop()
+{
+  startWorkers();
+
+  CDataSource& source = *getDataSource();
+
+  int tot_iter=0, proc_iter=0;
+  int nskip    = getSkipCount();
+  int nprocess = getProcessCount();
+
+  while (1) {
+    if (proc_iter>=nprocess && nprocess>=0) {
+      break;
+    }
+    CRingItem* item = source.getItem();
+    if (item==0) {
+      break;
+    }
+
+    if (tot_iter>=nskip) {
+      if (isBarrier(item)) {
+        handleBarrier(item);
+      } else {
+        addItem(item);
+      }
+      ++proc_iter;
+    } else {
+      delete item;
+    }
+    ++tot_iter;
+
+    writeCompleted(false);
+  }
+  drain();
+}
+/**
+ * initialize
+ *    Make the workers (and clones) if needed and initialize the clones.
+ */
+void
+CParallelMediator::initialize()
+{
+  startWorkers();
+  for (int i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->getFilter()->initialize();
+  }
+}
+/**
+ * finalize
+ *    Finalize all of the clones.
+ */
+void
+CParallelMediator::finalize()
+{
+  for (int i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->getFilter()->finalize();
+  }
+}
+
+/**
+ * captureItem
+ *    Called for an item a filter emits on its own.  If the calling thread
+ *    is filtering for a parallel mediator, a copy of the item is kept
+ *    to be written in order with the rest of the output.
+ *
+ * @param item  - the item; the caller still owns it.
+ * @return bool - true if captured, false if the caller should write it.
+ */
+bool
+CParallelMediator::captureItem(const CRingItem& item)
+{
+  if (!pCaptured) return false;
+  pCaptured->push_back(new CRingItem(item));
+  return true;
+}
+
+/*---------------------------------------------------------------------------
+ * Private utilities.
+ */
+
+/**
+ * startWorkers
+ *    If they don't exist yet, make the worker threads, each with a
+ *    clone of the filter.
+ */
+void
+CParallelMediator::startWorkers()
+{
+  if (!m_workers.empty()) return;
+
+  for (unsigned i = 0; i < m_nThreads; i++) {
+    Worker* pWorker = new Worker(*this, getFilter()->clone());
+    m_workers.push_back(pWorker);
+    pWorker->start();
+  }
+}
+/**
+ * stopWorkers
+ *    A null batch stops a worker.
+ */
+void
+CParallelMediator::stopWorkers()
+{
+  for (int i = 0; i < m_workers.size(); i++) {
+    m_batches.queue(nullptr);
+  }
+  for (int i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->join();
+    delete m_workers[i];
+  }
+  m_workers.clear();
+}
+/**
+ * addItem
+ *    Add a physics event to the batch being built, starting a batch
+ *    if needed.  Full batches are submitted.  If all batches are in use,
+ *    this waits until the oldest has been written.
+ *
+ * @param pItem - the item.
+ */
+void
+CParallelMediator::addItem(CRingItem* pItem)
+{
+  if (!m_pCurrent) {
+    while (!m_freeBatches.getnow(m_pCurrent)) {
+      writeCompleted(true);
+    }
+    m_pCurrent->s_index = m_nSubmitted;
+    m_pCurrent->s_error = std::exception_ptr();
+  }
+  m_pCurrent->s_items.push_back(pItem);
+  if (m_pCurrent->s_items.size() >= m_nBatchSize) {
+    submit();
+  }
+}
+/**
+ * submit
+ *    Queue the batch being built to the workers.
+ */
+void
+CParallelMediator::submit()
+{
+  if (m_pCurrent) {
+    m_batches.queue(m_pCurrent);
+    m_pCurrent = nullptr;
+    m_nSubmitted++;
+  }
+}
+/**
+ * drain
+ *    Submit the current batch and wait until all batches are written.
+ */
+void
+CParallelMediator::drain()
+{
+  submit();
+  while (m_nWritten < m_nSubmitted) {
+    writeCompleted(true);
+  }
+}
+/**
+ * writeCompleted
+ *    Write filtered batches that are next in order.
+ *
+ * @param wait - if true, block until at least one batch is done.
+ */
+void
+CParallelMediator::writeCompleted(bool wait)
+{
+  Batch* pBatch;
+  if (wait) {
+    pBatch = m_doneBatches.get();
+    m_outOfOrder[pBatch->s_index] = pBatch;
+  }
+  while (m_doneBatches.getnow(pBatch)) {
+    m_outOfOrder[pBatch->s_index] = pBatch;
+  }
+  while (!m_outOfOrder.empty() &&
+         (m_outOfOrder.begin()->first == m_nWritten)) {
+    pBatch = m_outOfOrder.begin()->second;
+    m_outOfOrder.erase(m_outOfOrder.begin());
+    m_nWritten++;
+    writeBatch(pBatch);
+  }
+}
+/**
+ * writeBatch
+ *    Write the items a worker left in a batch and free it.  If the
+ *    filter threw, the items are just deleted and the exception rethrown.
+ *
+ * @param pBatch - the batch.
+ */
+void
+CParallelMediator::writeBatch(Batch* pBatch)
+{
+  CDataSink& sink = *getDataSink();
+  std::exception_ptr error = pBatch->s_error;
+
+  std::vector<CRingItem*>& items(pBatch->s_items);
+  for (int i = 0; i < items.size(); i++) {
+    if (items[i]) {
+      if (!error) sink.putItem(*items[i]);
+      delete items[i];
+    }
+  }
+  items.clear();
+  m_freeBatches.queue(pBatch);
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+/**
+ * handleBarrier
+ *    Write everything before the item then give it to each clone.
+ *    The first clone goes last so what's written is what it returns
+ *    even if another clone modified the item in place.  Items the other
+ *    clones emit are discarded; the first clone's go to the sink.
+ *
+ * @param pItem - the item (deleted when done).
+ */
+void
+CParallelMediator::handleBarrier(CRingItem* pItem)
+{
+  drain();
+
+  CRingItem* pResult = 0;
+  std::vector<CRingItem*> discards;
+  for (int i = m_workers.size() - 1; i >= 0; i--) {
+    {
+      Capture capture(i ? &discards : nullptr);
+      pResult = CMediator::dispatchItem(*m_workers[i]->getFilter(), pItem);
+    }
+    if (i && (pResult != pItem)) {
+      delete pResult;
+    }
+    for (int j = 0; j < discards.size(); j++) {
+      delete discards[j];
+    }
+    discards.clear();
+  }
+  if (pResult) {
+    getDataSink()->putItem(*pResult);
+  }
+  if (pResult != pItem) {
+    delete pResult;
+  }
+  delete pItem;
+}
+/**
+ * isBarrier
+ *    Only physics events are filtered in parallel.
+ */
+bool
+CParallelMediator::isBarrier(CRingItem* pItem)
+{
+  return pItem->type() != PHYSICS_EVENT;
+}
+
+/*---------------------------------------------------------------------------
+ * Worker thread.
+ */
+CParallelMediator::Worker::Worker(CParallelMediator& owner, CFilter* pFilter) :
+  m_owner(owner), m_pFilter(pFilter)
+{}
+CParallelMediator::Worker::~Worker()
+{
+  delete m_pFilter;
+}
+/**
+ * operator()
+ *    Filter batches until a null one arrives.  Each input item is
+ *    replaced by any items the filter emitted for it followed by what
+ *    it returns (the input is deleted if that's something else).
+ *    If the filter throws, the unfiltered items are kept so they get
+ *    deleted with the rest.
+ */
+void
+CParallelMediator::Worker::operator()()
+{
+  while (1) {
+    Batch* pBatch = m_owner.m_batches.get();
+    if (!pBatch) return;
+
+    std::vector<CRingItem*>& items(pBatch->s_items);
+    std::vector<CRingItem*>  output;
+    output.reserve(items.size());
+    size_t i = 0;
+    try {
+      Capture capture(&output);
+      for (; i < items.size(); i++) {
+        CRingItem* pItem   = items[i];
+        CRingItem* pResult = CMediator::dispatchItem(*m_pFilter, pItem);
+        if (pResult != pItem) {
+          delete pItem;
+        }
+        output.push_back(pResult);
+      }
+    }
+    catch (...) {
+      output.insert(output.end(), items.begin() + i, items.end());
+      pBatch->s_error = std::current_exception();
+    }
+    items.swap(output);
+    m_owner.m_doneBatches.queue(pBatch);
+  }
+}
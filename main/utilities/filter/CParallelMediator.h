@@ -0,0 +1,126 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CParallelMediator.h
+ *  @brief: Mediator that runs the filter on several threads.
+ */
+#ifndef CPARALLELMEDIATOR_H
+#define CPARALLELMEDIATOR_H
+
+#include <CMediator.h>
+#include <CSynchronizedThread.h>
+#include <CBufferQueue.h>
+
+#include <vector>
+#include <map>
+#include <exception>
+#include <stdint.h>
+
+class CDataSource;
+class CFilter;
+class CDataSink;
+class CRingItem;
+
+/**! \brief A CInfiniteMediator that filters physics events in parallel.
+ *
+ *  Each worker thread gets its own clone of the filter (made when
+ *  initialize() is called, so filters can be registered up to then).
+ *  Physics events are collected into batches which are filtered by
+ *  whichever worker is free.  Finished batches are written to the sink in
+ *  the order they were read, so the output order is the same as for
+ *  CInfiniteMediator.
+ *
+ *  Every other item type (state changes, scalers, text...) is a barrier:
+ *  all earlier batches are filtered and written, then the item is given
+ *  to every clone so they all see e.g. the begin run.  What the first clone
+ *  returns is written to the sink; the other results are discarded.
+ *
+ *  Since each clone only sees some of the events, filters that
+ *  accumulate across events (sums, histograms) get partial results per
+ *  clone; initialize() and finalize() are called for each clone.
+ *  An exception thrown by a filter on a worker is rethrown from mainLoop
+ *  when its batch comes up for output.
+ *
+ *  Items a filter emits itself (CFilterMain::putRingItem) while a worker
+ *  runs it are copied into the batch (see captureItem) and written just
+ *  before that event's result, as they would be by CInfiniteMediator.
+ *  For barriers, only what the first clone emits is written.
+ */
+class CParallelMediator : public CMediator
+{
+  private:
+    typedef struct _Batch {
+      uint64_t                 s_index;     // Batch number.
+      std::vector<CRingItem*>  s_items;     // Input then filter output.
+      std::exception_ptr       s_error;
+    } Batch;
+
+    class Worker : public CSynchronizedThread {
+      CParallelMediator& m_owner;
+      CFilter*           m_pFilter;
+    public:
+      Worker(CParallelMediator& owner, CFilter* pFilter);
+      virtual ~Worker();
+      virtual void operator()();
+      CFilter* getFilter() { return m_pFilter; }
+    };
+
+    unsigned                 m_nThreads;
+    size_t                   m_nBatchSize;
+    std::vector<Worker*>     m_workers;
+    std::vector<Batch*>      m_allBatches;
+    CBufferQueue<Batch*>     m_freeBatches;
+    CBufferQueue<Batch*>     m_batches;
+    CBufferQueue<Batch*>     m_doneBatches;
+
+    Batch*                   m_pCurrent;
+    uint64_t                 m_nSubmitted;
+    uint64_t                 m_nWritten;
+    std::map<uint64_t, Batch*> m_outOfOrder;
+
+  public:
+    CParallelMediator(CDataSource* source, CFilter* filter, CDataSink* sink,
+                      unsigned nThreads, size_t batchSize = 256);
+    virtual ~CParallelMediator();
+
+  private:
+    CParallelMediator(const CParallelMediator&);
+    CParallelMediator& operator=(const CParallelMediator&);
+
+  public:
+    virtual void mainLoop();
+    virtual void initialize();
+    virtual void finalize();
+
+    unsigned getThreadCount() const { return m_nThreads; }
+    size_t getBatchSize() const { return m_nBatchSize; }
+
+    static bool captureItem(const CRingItem& item);
+
+  private:
+    void startWorkers();
+    void stopWorkers();
+    void addItem(CRingItem* pItem);
+    void submit();
+    void drain();
+    void writeCompleted(bool wait);
+    void writeBatch(Batch* pBatch);
+    void handleBarrier(CRingItem* pItem);
+    static bool isBarrier(CRingItem* pItem);
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CViewFilter.h
+ *  @brief: Base class for filters that work on views of raw ring items.
+ */
+#ifndef CVIEWFILTER_H
+#define CVIEWFILTER_H
+
+#include <DataFormat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+/**! \class CFilterOutputBuffer
+  A reusable buffer a CViewFilter builds replacement items in.  Storage
+  grows to the largest item ever put in it and is never given back, so
+  after the first few items no memory is allocated.
+*/
+class CFilterOutputBuffer
+{
+  private:
+    void*  m_pStorage;
+    size_t m_nCapacity;
+
+  public:
+    CFilterOutputBuffer() : m_pStorage(0), m_nCapacity(0) {}
+    ~CFilterOutputBuffer() { free(m_pStorage); }
+
+  private:
+    CFilterOutputBuffer(const CFilterOutputBuffer&);
+    CFilterOutputBuffer& operator=(const CFilterOutputBuffer&);
+
+  public:
+    /**! Get storage for an item of at least nBytes.
+      The contents are not preserved if the buffer has to grow.
+    */
+    RingItem* reserve(size_t nBytes)
+    {
+      if (nBytes > m_nCapacity) {
+        void* p = realloc(m_pStorage, nBytes);
+        if (!p) throw std::bad_alloc();
+        m_pStorage  = p;
+        m_nCapacity = nBytes;
+      }
+      return static_cast<RingItem*>(m_pStorage);
+    }
+    /**! Copy an item into the buffer. */
+    RingItem* copy(const RingItem* pItem)
+    {
+      uint32_t size = itemSize(pItem);
+      RingItem* p   = reserve(size);
+      memcpy(p, pItem, size);
+      return p;
+    }
+
+    /**! The item in the buffer */
+    RingItem* getItem() { return static_cast<RingItem*>(m_pStorage); }
+    size_t capacity() const { return m_nCapacity; }
+};
+
+/**! \class CViewFilter
+  Base class for zero copy filters.  Rather than getting a newly
+  allocated CRingItem, handleItem is given a pointer to the raw item
+  where it lies (e.g. in a memory mapped file) and says what to do
+  with it:
+
+  - pass    - send the item on unmodified.
+  - drop    - don't send the item on.
+  - replace - send on the item the filter built in the output buffer
+              (see CFilterOutputBuffer) instead.
+
+  The input item must not be modified and the pointer must not be kept
+  after handleItem returns.  The default handler passes everything, so
+  like CFilter, this can be used as a transparent filter.
+
+  Existing CFilter subclasses can be used where a CViewFilter is needed
+  by wrapping them in a CFilterViewAdapter.
+*/
+class CViewFilter
+{
+  public:
+    enum Disposition { pass, drop, replace };
+
+  public:
+    virtual ~CViewFilter() {}
+
+    // Virtual constructor
+    virtual CViewFilter* clone() const = 0;
+
+    // The handler
+    virtual Disposition handleItem(const RingItem* pItem, CFilterOutputBuffer& output)
+    {
+      return pass;
+    }
+
+    // Initialization procedures to run before any ring items are processed
+    virtual void initialize() {}
+    // Finalization procedures to run after all ring items have been processed
+    virtual void finalize() {}
+};
+
+/**! \class CTransparentViewFilter
+  Passes everything through.
+*/
+class CTransparentViewFilter : public CViewFilter
+{
+  public:
+    virtual CTransparentViewFilter* clone() const
+    {
+      return new CTransparentViewFilter(*this);
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CViewMediator.cpp
+ *  @brief: Implement the zero copy filter mediator.
+ */
+#include "CViewMediator.h"
+
+#include <CDataSource.h>
+#include <CDataSink.h>
+#include <CMappedFileDataSource.h>
+#include <CRingItem.h>
+
+/**
+ * constructor
+ *   @param source - the data source (owned).
+ *   @param sink   - the data sink (owned).
+ */
+CViewMediator::CViewMediator(
+  std::unique_ptr<CDataSource> source, std::unique_ptr<CDataSink> sink
+) :
+  CBaseMediator(std::move(source), std::move(sink)),
+  m_nToProcess(-1),
+  m_nToSkip(-1)
+{}
+/**
+ * destructor
+ */
+CViewMediator::~CViewMediator()
+{
+  for (int i = 0; i < m_filters.size(); i++) {
+    delete m_filters[i];
+  }
+}
+
+/**
+ * registerFilter
+ *    @param filter - template of the filter; a clone is put on the end
+ *                    of the chain.
+ */
+void
+CViewMediator::registerFilter(const CViewFilter* filter)
+{
+  m_filters.push_back(filter->clone());
+}
+/**
+ * mainLoop
+ *    Items are read from the source, run through the filters and
+ *    whatever survives goes to the sink.
+ */
+void
+CViewMediator::mainLoop()
+{
+  CDataSource& source = *getDataSource();
+  CDataSink&   sink   = *getDataSink();
+  CMappedFileDataSource* pMapped = dynamic_cast<CMappedFileDataSource*>(&source);
+
+  int tot_iter=0, proc_iter=0;
+  int nskip    = getSkipCount();
+  int nprocess = getProcessCount();
+
+  while (1) {
+    if (proc_iter>=nprocess && nprocess>=0) {
+      break;
+    }
+
+    const RingItem* pItem;
+    CRingItem*      pOwned = 0;
+    if (pMapped) {
+      pItem = pMapped->nextItem();
+    } else {
+      pOwned = source.getItem();
+      pItem  = pOwned ? pOwned->getItemPointer() : 0;
+    }
+    if (!pItem) {
+      break;
+    }
+
+    if (tot_iter>=nskip) {
+      const RingItem* pOutput = filterItem(pItem);
+      if (pOutput) {
+        sink.put(pOutput, itemSize(pOutput));
+      }
+      ++proc_iter;
+    }
+    delete pOwned;
+    ++tot_iter;
+  }
+}
+void
+CViewMediator::initialize()
+{
+  for (int i = 0; i < m_filters.size(); i++) {
+    m_filters[i]->initialize();
+  }
+}
+void
+CViewMediator::finalize()
+{
+  for (int i = 0; i < m_filters.size(); i++) {
+    m_filters[i]->finalize();
+  }
+}
+
+/**
+ * filterItem
+ *    Run an item through the chain.  Replacements alternate between the
+ *    two output buffers so a filter can read the item the previous
+ *    one built while building its own.
+ *
+ * @param pItem - the item from the source.
+ * @return const RingItem* - item to send on, null if it was dropped.
+ */
+const RingItem*
+CViewMediator::filterItem(const RingItem* pItem)
+{
+  int buffer = 0;
+  for (int i = 0; i < m_filters.size(); i++) {
+    switch (m_filters[i]->handleItem(pItem, m_buffers[buffer])) {
+    case CViewFilter::drop:
+      return 0;
+    case CViewFilter::replace:
+      pItem  = m_buffers[buffer].getItem();
+      buffer = 1 - buffer;
+      break;
+    case CViewFilter::pass:
+      break;
+    }
+  }
+  return pItem;
+}
@@ -0,0 +1,89 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CViewMediator.h
+ *  @brief: Mediator for zero copy (CViewFilter) filters.
+ */
+#ifndef CVIEWMEDIATOR_H
+#define CVIEWMEDIATOR_H
+
+#include <CBaseMediator.h>
+#include <CViewFilter.h>
+#include <memory>
+#include <vector>
+
+class CDataSource;
+class CDataSink;
+
+/**! \brief Runs items through a chain of CViewFilter objects.
+ *
+ *  Like CInfiniteMediator, this runs until the count is satisfied or the
+ *  source ends.  Items are never turned into CRingItem objects:
+ *
+ *  - If the source is a CMappedFileDataSource, each filter sees the item
+ *    where it is in the mapped file.  Otherwise the source's getItem is
+ *    used and filters see that item's storage.
+ *  - A filter that replaces an item builds it in one of two output
+ *    buffers that are reused for every item, the next filter sees
+ *    the replacement.
+ *  - Whatever comes out of the last filter is written to the sink with
+ *    CDataSink::put.
+ *
+ *  With a mapped source and filters that pass or drop items, nothing at
+ *  all is allocated per item.
+ */
+class CViewMediator : public CBaseMediator
+{
+  private:
+    std::vector<CViewFilter*> m_filters;     //!< Owned, run in order.
+    CFilterOutputBuffer       m_buffers[2];
+    int  m_nToProcess; //!< number to process
+    int  m_nToSkip; //!< number to skip
+
+  public:
+    CViewMediator(std::unique_ptr<CDataSource> source = std::unique_ptr<CDataSource>(),
+                  std::unique_ptr<CDataSink> sink = std::unique_ptr<CDataSink>());
+    virtual ~CViewMediator();
+
+  private:
+    CViewMediator(const CViewMediator&);
+    CViewMediator& operator=(const CViewMediator&);
+
+  public:
+    /**! Append a clone of a filter to the chain */
+    void registerFilter(const CViewFilter* filter);
+    size_t filterCount() const { return m_filters.size(); }
+
+    virtual void mainLoop();
+    virtual void initialize();
+    virtual void finalize();
+
+    /**! Set the number to skip */
+    void setSkipCount(int nEvents) { m_nToSkip = nEvents; }
+    /**! Get the number to skip */
+    int getSkipCount(void) const { return m_nToSkip; }
+
+    /**! Set the number to process */
+    void setProcessCount(int nEvents) { m_nToProcess = nEvents; }
+    /**! Get the number to process */
+    int getProcessCount(void) const { return m_nToProcess; }
+
+  protected:
+    const RingItem* filterItem(const RingItem* pItem);
+};
+
+#endif
@@ -0,0 +1,146 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+// Transparent filter throughput for the two filter APIs.
+// An event file of small physics items is written and then filtered
+// three ways, all reading through a CMappedFileDataSource into a sink that
+// throws the data away:
+//   legacy  - CInfiniteMediator running CTransparentFilter (a CRingItem
+//             is allocated for each item).
+//   adapter - CViewMediator running CTransparentFilter through a
+//             CFilterViewAdapter.
+//   view    - CViewMediator running CTransparentViewFilter.
+//
+// Usage:
+//    filterbench ?items? ?bodybytes?
+//
+// Defaults are 2000000 items with 64 byte bodies.
+//
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <CDataSink.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <CMappedFileDataSource.h>
+#include <io.h>
+
+#include "CInfiniteMediator.h"
+#include "CViewMediator.h"
+#include "CTransparentFilter.h"
+#include "CFilterViewAdapter.h"
+
+using namespace std;
+
+// Sink that counts and discards:
+
+class CNullSink : public CDataSink
+{
+public:
+  size_t m_nBytes;
+  CNullSink() : m_nBytes(0) {}
+  void putItem(const CRingItem& item) { m_nBytes += item.size(); }
+  void put(const void* pData, size_t nBytes) { m_nBytes += nBytes; }
+};
+
+static double
+now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1.0e9;
+}
+
+static void
+makeFile(const char* name, size_t nItems, size_t bodyBytes)
+{
+  vector<uint8_t> body(bodyBytes, 0xa5);
+  vector<uint8_t> block;
+  int fd = creat(name, 0600);
+  for (size_t i = 0; i < nItems; i++) {
+    pPhysicsEventItem p = formatTimestampedEventItem(i, 1, 0, bodyBytes, body.data());
+    uint8_t* pBytes = reinterpret_cast<uint8_t*>(p);
+    block.insert(block.end(), pBytes, pBytes + itemSize(reinterpret_cast<pRingItem>(p)));
+    free(p);
+    if (block.size() > 1024*1024) {
+      io::writeData(fd, block.data(), block.size());
+      block.clear();
+    }
+  }
+  io::writeData(fd, block.data(), block.size());
+  close(fd);
+}
+
+static void
+report(const char* what, size_t nItems, double start, double end)
+{
+  cout << what << "  " << nItems/(end - start) << " items/sec\n";
+}
+
+int main(int argc, char** argv)
+{
+  size_t nItems    = 2000000;
+  size_t bodyBytes = 64;
+  if (argc > 1) nItems    = strtoul(argv[1], 0, 0);
+  if (argc > 2) bodyBytes = strtoul(argv[2], 0, 0);
+
+  char name[] = "/tmp/filterbenchXXXXXX";
+  close(mkstemp(name));
+  makeFile(name, nItems, bodyBytes);
+  vector<uint16_t> none;
+
+  {
+    CInfiniteMediator mediator(
+      new CMappedFileDataSource(open(name, O_RDONLY), none),
+      new CTransparentFilter, new CNullSink
+    );
+    double start = now();
+    mediator.mainLoop();
+    report("legacy ", nItems, start, now());
+  }
+  {
+    CViewMediator mediator(
+      unique_ptr<CDataSource>(new CMappedFileDataSource(open(name, O_RDONLY), none)),
+      unique_ptr<CDataSink>(new CNullSink)
+    );
+    CFilterViewAdapter adapter(new CTransparentFilter);
+    mediator.registerFilter(&adapter);
+    double start = now();
+    mediator.mainLoop();
+    report("adapter", nItems, start, now());
+  }
+  {
+    CViewMediator mediator(
+      unique_ptr<CDataSource>(new CMappedFileDataSource(open(name, O_RDONLY), none)),
+      unique_ptr<CDataSink>(new CNullSink)
+    );
+    CTransparentViewFilter filter;
+    mediator.registerFilter(&filter);
+    double start = now();
+    mediator.mainLoop();
+    report("view   ", nItems, start, now());
+  }
+
+  unlink(name);
+  return 0;
+}
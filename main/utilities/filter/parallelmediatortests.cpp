@@ -0,0 +1,282 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  parallelmediatortests.cpp
+ *  @brief: Tests for the multi-threaded filter mediator.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <unistd.h>
+
+#include <CRingItem.h>
+#include <CPhysicsEventItem.h>
+#include <CRingStateChangeItem.h>
+#include <DataFormat.h>
+#include <CFilter.h>
+#include "CFilterTestSource.h"
+#include "CFilterTestSink.h"
+#include <CSynchronizedThread.h>
+#include <CBufferQueue.h>
+#include <CMediator.h>
+
+#define private public
+#include "CParallelMediator.h"
+#undef private
+
+// Makes a new event with the body word doubled and
+// counts the state changes it sees.  Drops events whose word is
+// a multiple of dropEvery and throws on throwAt:
+
+class CDoubler : public CFilter
+{
+public:
+  unsigned m_nStateChanges;
+  unsigned m_nInitialized;
+  unsigned m_dropEvery;
+  unsigned m_throwAt;
+
+  CDoubler(unsigned dropEvery = 0, unsigned throwAt = 0xffffffff) :
+    m_nStateChanges(0), m_nInitialized(0),
+    m_dropEvery(dropEvery), m_throwAt(throwAt) {}
+  CDoubler* clone() const { return new CDoubler(*this); }
+
+  CRingItem* handlePhysicsEventItem(CPhysicsEventItem* pItem) {
+    uint32_t word = *static_cast<uint32_t*>(pItem->getBodyPointer());
+    if (word == m_throwAt) throw std::runtime_error("Bad event");
+    if (m_dropEvery && ((word % m_dropEvery) == 0)) return 0;
+    if (word % 7 == 0) usleep(100);       // Make batches finish out of order.
+
+    CPhysicsEventItem* pResult = new CPhysicsEventItem(100);
+    uint32_t* p = static_cast<uint32_t*>(pResult->getBodyCursor());
+    *p++ = 2*word;
+    pResult->setBodyCursor(p);
+    pResult->updateSize();
+    return pResult;
+  }
+  CRingItem* handleStateChangeItem(CRingStateChangeItem* pItem) {
+    m_nStateChanges++;
+    return pItem;
+  }
+  void initialize() { m_nInitialized++; }
+};
+
+// Emits a copy of each item itself the way CFilterMain::putRingItem does,
+// then passes the item on:
+
+class CEmitter : public CFilter
+{
+public:
+  CDataSink* m_pSink;
+
+  CEmitter(CDataSink* pSink) : m_pSink(pSink) {}
+  CEmitter* clone() const { return new CEmitter(*this); }
+
+  void emit(CRingItem* pItem) {
+    if (!CParallelMediator::captureItem(*pItem)) {
+      m_pSink->putItem(*pItem);
+    }
+  }
+  CRingItem* handlePhysicsEventItem(CPhysicsEventItem* pItem) {
+    if (*static_cast<uint32_t*>(pItem->getBodyPointer()) % 7 == 0) usleep(100);
+    emit(pItem);
+    return pItem;
+  }
+  CRingItem* handleStateChangeItem(CRingStateChangeItem* pItem) {
+    emit(pItem);
+    return pItem;
+  }
+};
+
+class CParallelMediatorTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CParallelMediatorTest);
+  CPPUNIT_TEST(order_1);
+  CPPUNIT_TEST(barrier_1);
+  CPPUNIT_TEST(drop_1);
+  CPPUNIT_TEST(skip_1);
+  CPPUNIT_TEST(exception_1);
+  CPPUNIT_TEST(init_1);
+  CPPUNIT_TEST(emit_1);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CFilterTestSource* m_pSource;
+  CFilterTestSink*   m_pSink;
+
+public:
+  void setUp() {
+    m_pSource = new CFilterTestSource;
+    m_pSink   = new CFilterTestSink;
+  }
+  void tearDown() {
+  }
+protected:
+  void order_1();
+  void barrier_1();
+  void drop_1();
+  void skip_1();
+  void exception_1();
+  void init_1();
+  void emit_1();
+private:
+  void addEvents(uint32_t first, uint32_t n) {
+    for (uint32_t i = first; i < first + n; i++) {
+      CPhysicsEventItem event(100);
+      uint32_t* p = static_cast<uint32_t*>(event.getBodyCursor());
+      *p++ = i;
+      event.setBodyCursor(p);
+      event.updateSize();
+      m_pSource->addItem(&event);
+    }
+  }
+  void addStateChange(uint16_t type) {
+    CRingStateChangeItem item(type);
+    m_pSource->addItem(&item);
+  }
+  uint32_t word(CRingItem* pItem) {
+    return *static_cast<uint32_t*>(pItem->getBodyPointer());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CParallelMediatorTest);
+
+// Events come out in the order they went in:
+
+void CParallelMediatorTest::order_1()
+{
+  addEvents(0, 1000);
+  CParallelMediator mediator(m_pSource, new CDoubler, m_pSink, 4, 7);
+  mediator.mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(1000), m_pSink->m_sink.size());
+  for (int i = 0; i < 1000; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2*i), word(m_pSink->m_sink[i]));
+  }
+}
+// State changes are written after all earlier events, before all
+// later ones and are seen by each clone:
+
+void CParallelMediatorTest::barrier_1()
+{
+  addStateChange(BEGIN_RUN);
+  addEvents(0, 500);
+  addStateChange(PAUSE_RUN);
+  addStateChange(RESUME_RUN);
+  addEvents(500, 500);
+  addStateChange(END_RUN);
+  CParallelMediator mediator(m_pSource, new CDoubler, m_pSink, 3, 16);
+  mediator.mainLoop();
+
+  std::vector<CRingItem*>& out(m_pSink->m_sink);
+  CPPUNIT_ASSERT_EQUAL(size_t(1004), out.size());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(BEGIN_RUN), out[0]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(PAUSE_RUN), out[501]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(RESUME_RUN), out[502]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(END_RUN), out[1003]->type());
+  for (int i = 0; i < 500; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2*i), word(out[i + 1]));
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2*(i + 500)), word(out[i + 503]));
+  }
+  for (int i = 0; i < mediator.m_workers.size(); i++) {
+    CDoubler* pClone = dynamic_cast<CDoubler*>(mediator.m_workers[i]->getFilter());
+    CPPUNIT_ASSERT_EQUAL(unsigned(4), pClone->m_nStateChanges);
+  }
+}
+// Dropped events aren't written:
+
+void CParallelMediatorTest::drop_1()
+{
+  addEvents(0, 100);
+  CParallelMediator mediator(m_pSource, new CDoubler(2), m_pSink, 2, 5);
+  mediator.mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(50), m_pSink->m_sink.size());
+  for (int i = 0; i < 50; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2*(2*i + 1)), word(m_pSink->m_sink[i]));
+  }
+}
+// Skip and count work as for CInfiniteMediator:
+
+void CParallelMediatorTest::skip_1()
+{
+  addEvents(0, 100);
+  CParallelMediator mediator(m_pSource, new CDoubler, m_pSink, 2, 5);
+  mediator.setSkipCount(10);
+  mediator.setProcessCount(20);
+  mediator.mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(20), m_pSink->m_sink.size());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(20), word(m_pSink->m_sink[0]));
+  CPPUNIT_ASSERT_EQUAL(uint32_t(58), word(m_pSink->m_sink[19]));
+}
+// Exceptions in workers come out of mainLoop:
+
+void CParallelMediatorTest::exception_1()
+{
+  addEvents(0, 100);
+  CParallelMediator mediator(m_pSource, new CDoubler(0, 50), m_pSink, 2, 5);
+  bool thrown = false;
+  try {
+    mediator.mainLoop();
+  }
+  catch (std::runtime_error& e) {
+    thrown = true;
+  }
+  CPPUNIT_ASSERT(thrown);
+  CPPUNIT_ASSERT_EQUAL(size_t(50), m_pSink->m_sink.size());
+}
+// initialize goes to each clone:
+
+void CParallelMediatorTest::init_1()
+{
+  CParallelMediator mediator(m_pSource, new CDoubler, m_pSink, 3);
+  mediator.initialize();
+  CPPUNIT_ASSERT_EQUAL(size_t(3), mediator.m_workers.size());
+  for (int i = 0; i < 3; i++) {
+    CDoubler* pClone = dynamic_cast<CDoubler*>(mediator.m_workers[i]->getFilter());
+    CPPUNIT_ASSERT_EQUAL(unsigned(1), pClone->m_nInitialized);
+  }
+  mediator.mainLoop();
+  CPPUNIT_ASSERT_EQUAL(size_t(3), mediator.m_workers.size());
+}
+// Items filters emit themselves come out in order, just before the
+// item they were emitted for.  Barriers only get one clone's:
+
+void CParallelMediatorTest::emit_1()
+{
+  addStateChange(BEGIN_RUN);
+  addEvents(0, 500);
+  addStateChange(END_RUN);
+  CParallelMediator mediator(m_pSource, new CEmitter(m_pSink), m_pSink, 3, 16);
+  mediator.mainLoop();
+
+  std::vector<CRingItem*>& out(m_pSink->m_sink);
+  CPPUNIT_ASSERT_EQUAL(size_t(2*502), out.size());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(BEGIN_RUN), out[0]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(BEGIN_RUN), out[1]->type());
+  for (int i = 0; i < 500; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), word(out[2*i + 2]));
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), word(out[2*i + 3]));
+  }
+  CPPUNIT_ASSERT_EQUAL(uint32_t(END_RUN), out[1002]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(END_RUN), out[1003]->type());
+}
@@ -0,0 +1,255 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     NSCL
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  viewmediatortests.cpp
+ *  @brief: Tests for the zero copy filter mediator and its adapter.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string.h>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include <CRingItem.h>
+#include <CPhysicsEventItem.h>
+#include <CRingPhysicsEventCountItem.h>
+#include <DataFormat.h>
+#include <CTransparentFilter.h>
+#include "CViewFilter.h"
+#include "CFilterViewAdapter.h"
+#include "CFilterTestSource.h"
+#include "CFilterTestSink.h"
+
+#define private public
+#include "CViewMediator.h"
+#include "CTestFilter.h"
+#undef private
+
+// Drops physics events:
+
+class CDropPhysics : public CViewFilter
+{
+public:
+  CDropPhysics* clone() const { return new CDropPhysics(*this); }
+  Disposition handleItem(const RingItem* pItem, CFilterOutputBuffer& output) {
+    return itemType(pItem) == PHYSICS_EVENT ? drop : pass;
+  }
+};
+// Replaces items with a copy that has a body word appended:
+
+class CAppendWord : public CViewFilter
+{
+  uint32_t m_word;
+public:
+  CAppendWord(uint32_t word) : m_word(word) {}
+  CAppendWord* clone() const { return new CAppendWord(*this); }
+  Disposition handleItem(const RingItem* pItem, CFilterOutputBuffer& output) {
+    uint32_t size = itemSize(pItem);
+    RingItem* p = output.reserve(size + sizeof(uint32_t));
+    memcpy(p, pItem, size);
+    memcpy(reinterpret_cast<uint8_t*>(p) + size, &m_word, sizeof(uint32_t));
+    p->s_header.s_size = size + sizeof(uint32_t);
+    return replace;
+  }
+};
+// Legacy filter that drops physics and generic items:
+
+class CNullLegacyFilter : public CFilter
+{
+public:
+  CNullLegacyFilter* clone() const { return new CNullLegacyFilter(*this); }
+  CRingItem* handleRingItem(CRingItem* pItem) { return 0; }
+  CRingItem* handlePhysicsEventItem(CPhysicsEventItem* pItem) { return 0; }
+};
+
+class CViewMediatorTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CViewMediatorTest);
+  CPPUNIT_TEST(pass_1);
+  CPPUNIT_TEST(drop_1);
+  CPPUNIT_TEST(replace_1);
+  CPPUNIT_TEST(skip_1);
+  CPPUNIT_TEST(adapter_1);
+  CPPUNIT_TEST(adapter_2);
+  CPPUNIT_TEST(adapter_3);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CFilterTestSource* m_pSource;
+  CFilterTestSink*   m_pSink;
+  CViewMediator*     m_pMediator;
+
+public:
+  void setUp() {
+    m_pSource = new CFilterTestSource;
+    m_pSink   = new CFilterTestSink;
+    m_pMediator = new CViewMediator(
+      std::unique_ptr<CDataSource>(m_pSource), std::unique_ptr<CDataSink>(m_pSink)
+    );
+    for (int i = 0; i < 10; i++) {
+      CPhysicsEventItem event(100);
+      uint32_t* p = static_cast<uint32_t*>(event.getBodyCursor());
+      *p++ = i;
+      event.setBodyCursor(p);
+      event.updateSize();
+      m_pSource->addItem(&event);
+
+      CRingPhysicsEventCountItem count(uint64_t(1000 + i), uint32_t(i));
+      m_pSource->addItem(&count);
+    }
+  }
+  void tearDown() {
+    delete m_pMediator;
+  }
+protected:
+  void pass_1();
+  void drop_1();
+  void replace_1();
+  void skip_1();
+  void adapter_1();
+  void adapter_2();
+  void adapter_3();
+private:
+  const uint32_t* lastWord(CRingItem* pItem) {
+    uint8_t* p = reinterpret_cast<uint8_t*>(pItem->getItemPointer());
+    return reinterpret_cast<uint32_t*>(p + pItem->size() - sizeof(uint32_t));
+  }
+  uint64_t eventCount(CRingItem* pItem) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(PHYSICS_EVENT_COUNT), pItem->type());
+    return CRingPhysicsEventCountItem(*pItem).getEventCount();
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CViewMediatorTest);
+
+// Items go through a transparent filter unchanged:
+
+void CViewMediatorTest::pass_1()
+{
+  CTransparentViewFilter filter;
+  m_pMediator->registerFilter(&filter);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(20), m_pSink->m_sink.size());
+  for (int i = 0; i < 10; i++) {
+    CRingItem* pEvent = m_pSink->m_sink[2*i];
+    CPPUNIT_ASSERT_EQUAL(uint32_t(PHYSICS_EVENT), pEvent->type());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), *lastWord(pEvent));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000 + i), eventCount(m_pSink->m_sink[2*i + 1]));
+  }
+}
+// Dropped items don't get to the sink:
+
+void CViewMediatorTest::drop_1()
+{
+  CDropPhysics filter;
+  m_pMediator->registerFilter(&filter);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(10), m_pSink->m_sink.size());
+  for (int i = 0; i < 10; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000 + i), eventCount(m_pSink->m_sink[i]));
+  }
+}
+// Replacements chain from filter to filter (through both buffers).
+// Only the events are checked: a word on the end of a count item is
+// harmless.
+
+void CViewMediatorTest::replace_1()
+{
+  CAppendWord one(1), two(2), three(3);
+  m_pMediator->registerFilter(&one);
+  m_pMediator->registerFilter(&two);
+  m_pMediator->registerFilter(&three);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(20), m_pSink->m_sink.size());
+  for (int i = 0; i < 10; i++) {
+    CRingItem* pEvent = m_pSink->m_sink[2*i];
+    const uint32_t* p = lastWord(pEvent);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(3), p[0]);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2), p[-1]);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1), p[-2]);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), p[-3]);
+  }
+}
+// Skip and count work as for CInfiniteMediator:
+
+void CViewMediatorTest::skip_1()
+{
+  CTransparentViewFilter filter;
+  m_pMediator->registerFilter(&filter);
+  m_pMediator->setSkipCount(4);
+  m_pMediator->setProcessCount(3);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(3), m_pSink->m_sink.size());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(PHYSICS_EVENT), m_pSink->m_sink[0]->type());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(2), *lastWord(m_pSink->m_sink[0]));
+  CPPUNIT_ASSERT_EQUAL(uint64_t(1002), eventCount(m_pSink->m_sink[1]));
+}
+// Legacy transparent filters pass items unchanged:
+
+void CViewMediatorTest::adapter_1()
+{
+  CFilterViewAdapter adapter(new CTransparentFilter);
+  m_pMediator->registerFilter(&adapter);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(20), m_pSink->m_sink.size());
+  for (int i = 0; i < 10; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint32_t(i), *lastWord(m_pSink->m_sink[2*i]));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000 + i), eventCount(m_pSink->m_sink[2*i + 1]));
+  }
+}
+// Legacy filters that make new items are dispatched by type and
+// their items sent on:
+
+void CViewMediatorTest::adapter_2()
+{
+  CFilterViewAdapter adapter(new CTestFilter);
+  m_pMediator->registerFilter(&adapter);
+  m_pMediator->initialize();
+  m_pMediator->mainLoop();
+  m_pMediator->finalize();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(20), m_pSink->m_sink.size());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(PHYSICS_EVENT), m_pSink->m_sink[0]->type());
+  CPPUNIT_ASSERT_EQUAL(uint64_t(4), eventCount(m_pSink->m_sink[1]));
+
+  CTestFilter* pFilter = dynamic_cast<CTestFilter*>(
+    dynamic_cast<CFilterViewAdapter*>(m_pMediator->m_filters[0])->getFilter()
+  );
+  CPPUNIT_ASSERT_EQUAL(20, pFilter->getNProcessed());
+  CPPUNIT_ASSERT(pFilter->m_initCalled);
+  CPPUNIT_ASSERT(pFilter->m_finalCalled);
+}
+// Legacy filters returning null drop the item (CNullLegacyFilter
+// lets count items through):
+
+void CViewMediatorTest::adapter_3()
+{
+  CFilterViewAdapter adapter(new CNullLegacyFilter);
+  m_pMediator->registerFilter(&adapter);
+  m_pMediator->mainLoop();
+
+  CPPUNIT_ASSERT_EQUAL(size_t(10), m_pSink->m_sink.size());
+  for (int i = 0; i < 10; i++) {
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000 + i), eventCount(m_pSink->m_sink[i]));
+  }
+}
@@ -32,7 +32,8 @@ static  CRingItem* EMPTY(reinterpret_cast<CRingItem*>(0xffffffff));
  * Constructor
  *  @param nFree - number of queue elements to initially put in the free queue.
  */
-Queues::Queues(int nFree) 
+Queues::Queues(int nFree) :
+  m_Free(nFree), m_InTransit(nFree)
 {
   CRingItem* anItem(EMPTY);
   for (int i =0; i < nFree; i++) {
@@ -25,15 +25,15 @@
 #ifndef RINGBUFFERQUEUE_H
 #define RINGBUFFERQUEUE_H
 
-#include <CBufferQueue.h>
+#include <CRingQueue.h>
 #include <CRingItem.h>
 
 /*
- *  A RingBuffer queue is a CBufferQueue whose elements are pointers
+ *  A RingBuffer queue is a (lock free) CRingQueue whose elements are pointers
  *  to CRingItems.
  */
 
-typedef CBufferQueue<CRingItem*> RingBufferQueue, *pRingBufferQueue;
+typedef CRingQueue<CRingItem*> RingBufferQueue, *pRingBufferQueue;
 
 /**
  *  @class Queues
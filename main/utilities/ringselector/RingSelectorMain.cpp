@@ -22,6 +22,8 @@
 #include <StringsToIntegers.h>
 #include <CRemoteAccess.h>
 #include <CRingItem.h>
+#include <CRingBufferChunkAccess.h>
+#include <CCompiledRingSelection.h>
 #include <DataFormat.h>
 #include <ErrnoException.h>
 #include <io.h>
@@ -47,6 +49,7 @@
 RingSelectorMain::RingSelectorMain() :
   m_pRing(0),
   m_pPredicate(0),
+  m_chunked(false),
   m_queues(1000)		// # of ring items that can be in transit.
 {}
 
@@ -79,11 +82,21 @@ RingSelectorMain::operator()(int argc, char** argv)
   m_formatted  = parsedArgs.formatted_given;
   m_exitOnEnd  = parsedArgs.exitonend_given;
   m_nonBlocking= parsedArgs.non_blocking_given;
+  m_chunked    = parsedArgs.chunked_given;
+
+  if (m_chunked && m_nonBlocking) {
+    std::cerr << "Error, the --chunked and --non-blocking switches cannot both be given\n";
+    exit(EXIT_FAILURE);
+  }
 
   m_pPredicate = createPredicate(&parsedArgs);
 
   m_pRing      = selectRing(&parsedArgs);
-  processData();
+  if (m_chunked) {
+    processChunks();
+  } else {
+    processData();
+  }
 
   return 0;
 }
@@ -226,6 +239,63 @@ RingSelectorMain::processData()
   }
 }
 
+/*
+** Process the data from the ring a chunk at a time.  The predicate is
+** compiled into a CCompiledRingSelection which is applied to the items
+** in each chunk where they sit and the selected items are written to
+** stdout directly from the ring (no CRingItem, no output thread).  Runs of
+** adjacent selected items go out as a single block.
+**
+** Since an item is only consumed when the next chunk is gotten, the
+** free space seen for sampled types is the put space plus what's in the
+** chunk ahead of the item - what the predicate would have seen with the
+** item at the head of the ring.
+**
+** We take whatever complete items are there.  When there are none we
+** block in the ring (woken by the producer's put on notifying rings)
+** rather than polling.
+*/
+void
+RingSelectorMain::processChunks()
+{
+  class NoFullItem : public CRingBuffer::CRingBufferPredicate {
+  public:
+    bool operator()(CRingBuffer& ring) {
+      RingItemHeader header;
+      if (ring.availableData() < sizeof(header)) return true;
+      ring.peek(&header, sizeof(header));
+      return ring.availableData() <
+        itemSize(reinterpret_cast<pRingItem>(&header)); // May be swapped.
+    }
+  };
+
+  CRingBufferChunkAccess chunker(m_pRing);
+  CCompiledRingSelection selection(*m_pPredicate);
+  CRingBuffer::Usage usage = m_pRing->getUsage();
+  size_t maxChunk = usage.s_bufferSpace/4;
+  std::vector<iovec> selected;
+  NoFullItem noItem;
+
+  while(1) {
+    if (!chunker.waitChunk(maxChunk, 1)) {  // Skips the last chunk too.
+      m_pRing->blockWhile(noItem);
+    } else {
+      CRingBufferChunkAccess::Chunk c = chunker.nextChunk();
+      if (c.size() > 0) {
+        size_t freeSpace = 0;
+        if (selection.hasSampledTypes()) {
+          freeSpace = m_pRing->getUsage().s_putSpace;
+        }
+        bool sawEnd = selection.select(c, freeSpace, selected, m_exitOnEnd);
+        writeBlocks(STDOUT_FILENO, selected);
+        if (sawEnd) {
+          exit(0);
+        }
+      }
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //
 // Utilities
@@ -257,6 +327,30 @@ RingSelectorMain::writeBlock(int fd, void* pData, size_t size)
   }
 
 }
+/*
+** Write a set of blocks to an output file.  Errors are reported as for
+** writeBlock.
+** Parameters:
+**   fd      - file descriptor on which to write the data.
+**   blocks  - Descriptions of the blocks to write.
+*/
+void
+RingSelectorMain::writeBlocks(int fd, std::vector<iovec>& blocks)
+{
+  if (blocks.empty()) return;
+
+  try {
+    io::writeDataVUnlimited(fd, blocks.data(), blocks.size());
+  }
+  catch(int e) {
+    if (e) {
+      errno = e;
+      throw CErrnoException("Writing data to output file");
+    } else {
+      throw std::string("Output file closed");
+    }
+  }
+}
 /**
  * addTypes
  *    Add desired0 types to an all but predicate
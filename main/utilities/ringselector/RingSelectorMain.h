@@ -20,6 +20,7 @@
 #include "RingBufferQueue.h"
 #include <unistd.h>
 #include <vector>
+#include <sys/uio.h>
 
 
 class CRingBuffer;
@@ -40,6 +41,7 @@ private:
   bool                      m_formatted;      // Format output.
   bool                      m_exitOnEnd;      // If true exit when end run seen.
   bool                      m_nonBlocking;    // IF true use non-blocking mode.
+  bool                      m_chunked;        // If true write chunks in place.
   Queues                    m_queues;         // inter-thread communication.
   // Constructors..
 public:
@@ -64,11 +66,13 @@ public:
   CRingSelectionPredicate*  createPredicate(struct gengetopt_args_info* parse);
   CRingBuffer*              selectRing(struct gengetopt_args_info* parse);
   void                      processData();
+  void                      processChunks();
 
 
   // Utilities:
 
   void        writeBlock(int fd, void* pData, size_t size);
+  void        writeBlocks(int fd, std::vector<iovec>& blocks);
   void        addTypes(
       CDesiredTypesPredicate& p, std::vector<int>& types, bool sample=false
   );
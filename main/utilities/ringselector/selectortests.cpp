@@ -330,6 +330,7 @@ class rseltests : public CppUnit::TestFixture {
   CPPUNIT_TEST(all);
   CPPUNIT_TEST(exclude);
   CPPUNIT_TEST(only);
+  CPPUNIT_TEST(chunked);
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -347,6 +348,7 @@ protected:
   void all();
   void exclude();
   void only();
+  void chunked();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(rseltests);
@@ -466,5 +468,37 @@ void rseltests::only()
   wait(&s);
   close(fd);
 }
+// --chunked selects the same items as the default mode.
+
+void rseltests::chunked()
+{
+  string programName = BINDIR;
+  programName       += "/ringselector --chunked --exclude=BEGIN_RUN";
+  int fd             = spawn(programName.c_str());
+
+  try {
+    CRingBuffer prod(Os::whoami(), CRingBuffer::producer);
+
+    beginRun(prod, fd, false);
+    for (int i = 0; i < 100; i++) {
+      event(prod, fd);
+    }
+    eventCount(prod, fd, 100);
+    scaler(prod, fd);
+    beginRun(prod, fd, false);
+    endRun(prod, fd);
+  }
+  catch (...) {
+    kill (childpid*-1, SIGTERM);
+    int s;
+    wait(&s);
+    throw;
+  }
+
+  kill (childpid*-1, SIGTERM);
+  int s;
+  wait(&s);
+  close(fd);
+}
 // don't know how to test for sampling.
 